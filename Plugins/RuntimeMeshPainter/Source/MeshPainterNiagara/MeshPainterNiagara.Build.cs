@@ -0,0 +1,12 @@
+using UnrealBuildTool;
+
+public class MeshPainterNiagara : ModuleRules
+{
+	public MeshPainterNiagara(ReadOnlyTargetRules Target) : base(Target)
+	{
+		PCHUsage = ModuleRules.PCHUsageMode.UseExplicitOrSharedPCHs;
+
+		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "Niagara", "RuntimeMeshPainter" });
+		PrivateDependencyModuleNames.AddRange(new string[] { "MeshPainterShaderCore", "NiagaraCore", "VectorVM", "RenderCore", "RHI" });
+	}
+}
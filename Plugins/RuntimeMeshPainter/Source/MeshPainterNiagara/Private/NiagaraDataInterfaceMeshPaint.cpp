@@ -0,0 +1,426 @@
+#include "NiagaraDataInterfaceMeshPaint.h"
+#include "MeshPainterFunctionLibrary.h"
+#include "MeshPainterRender.h"
+#include "MeshPainterStats.h"
+#include "MeshPaintDecaySubsystem.h"
+#include "MeshPaintResidencySubsystem.h"
+#include "Components/MeshPaintSurfaceComponent.h"
+#include "Components/PrimitiveComponent.h"
+#include "Materials/MaterialInterface.h"
+#include "NiagaraCompileHashVisitor.h"
+#include "NiagaraShaderParametersBuilder.h"
+#include "NiagaraSystemInstance.h"
+#include "NiagaraTypes.h"
+#include "RenderGraphBuilder.h"
+#include "RenderGraphUtils.h"
+
+#include UE_INLINE_GENERATED_CPP_BY_NAME(NiagaraDataInterfaceMeshPaint)
+
+namespace NDIMeshPaint
+{
+	static const FName PaintStampName(TEXT("PaintStamp"));
+	static const TCHAR* TemplateShaderFilePath = TEXT("/Plugin/RuntimeMeshPainter/Private/NiagaraDataInterfaceMeshPaintTemplate.ush");
+
+	/** Count followed by the stamp bounds in the counter buffer, see the template shader */
+	static constexpr uint32 NumCounterValues = 7;
+
+	struct FStamp
+	{
+		FMeshPaintBrushStamp Brush;
+		int32 SurfaceId = 0;
+	};
+
+	/** Brush pass of one surface, the stamps come from the GPU buffer of the system instance */
+	struct FSurfacePass
+	{
+		FMeshPaintRenderTargets Targets;
+		FMeshPaintRenderParameters Params;
+	};
+
+	/** Game thread data of a system instance */
+	struct FInstanceData
+	{
+		TWeakObjectPtr<UWorld> World;
+
+		/** World position of the simulation space origin, Niagara positions are relative to the LWC tile of the system */
+		FVector LWCOrigin = FVector::ZeroVector;
+
+		/** Stamps of CPU emitters, VM batches of an emitter may run in parallel */
+		FCriticalSection StampsLock;
+		TArray<FStamp> PendingStamps;
+	};
+
+	/** Render thread data of a system instance */
+	struct FRenderInstanceData
+	{
+		uint32 MaxStamps = 0;
+
+		/** Stamps appended by simulations and their counter, which also holds the bounds of the stamps */
+		TRefCountPtr<FRDGPooledBuffer> Stamps;
+		TRefCountPtr<FRDGPooledBuffer> Counter;
+	};
+
+	struct FProxy : public FNiagaraDataInterfaceProxy
+	{
+		virtual int32 PerInstanceDataPassedToRenderThreadSize() const override { return 0; }
+
+		/** Buffers are created on first use, systems without GPU emitters never allocate them */
+		void AllocateBuffers(FRDGBuilder& GraphBuilder, FRenderInstanceData& InstanceData)
+		{
+			if (InstanceData.Stamps.IsValid()) return;
+
+			FRDGBufferRef Stamps = GraphBuilder.CreateBuffer(FRDGBufferDesc::CreateStructuredDesc(sizeof(FVector4f), InstanceData.MaxStamps * 3), TEXT("NiagaraMeshPaint.Stamps"));
+			FRDGBufferRef Counter = GraphBuilder.CreateBuffer(FRDGBufferDesc::CreateBufferDesc(sizeof(uint32), NumCounterValues), TEXT("NiagaraMeshPaint.StampCount"));
+			AddClearUAVPass(GraphBuilder, GraphBuilder.CreateUAV(Stamps), 0u);
+			AddClearUAVPass(GraphBuilder, GraphBuilder.CreateUAV(Counter, PF_R32_UINT), 0u);
+			InstanceData.Stamps = GraphBuilder.ConvertToExternalBuffer(Stamps);
+			InstanceData.Counter = GraphBuilder.ConvertToExternalBuffer(Counter);
+		}
+
+		/**
+		 * Paints the stamps appended by the previous simulation, runs before the scene renderer of the frame.
+		 * Nothing is read back: the passes cover every surface within the system bounds, the counter ends the stamp loops and
+		 * collapses the draws of surfaces the stamp bounds miss. Only the counter is cleared, stamps past it are never read.
+		 */
+		void PaintStamps(FRHICommandListImmediate& RHICmdList, const FNiagaraSystemInstanceID& SystemInstanceID, TArray<FSurfacePass>& Passes, const FVector& LWCOrigin)
+		{
+			FRenderInstanceData* InstanceData = SystemInstances.Find(SystemInstanceID);
+			if (!InstanceData || !InstanceData->Stamps.IsValid()) return;
+
+			MESH_PAINT_TRACE_SCOPE(NiagaraPaintStamps);
+
+			FRDGBuilder GraphBuilder(RHICmdList);
+			for (FSurfacePass& Pass : Passes)
+			{
+				Pass.Params.GPUBrushStamps = InstanceData->Stamps;
+				Pass.Params.GPUBrushStampCounter = InstanceData->Counter;
+				Pass.Params.MaxGPUBrushStamps = InstanceData->MaxStamps;
+				Pass.Params.GPUBrushStampOrigin = LWCOrigin;
+				MeshPaintRender::AddMeshPaintPass(GraphBuilder, Pass.Targets, Pass.Params);
+			}
+
+			// Stamps are dropped even without surfaces in range, they would land on surfaces arriving later otherwise
+			AddClearUAVPass(GraphBuilder, GraphBuilder.CreateUAV(GraphBuilder.RegisterExternalBuffer(InstanceData->Counter), PF_R32_UINT), 0u);
+			GraphBuilder.Execute();
+		}
+
+		TMap<FNiagaraSystemInstanceID, FRenderInstanceData> SystemInstances;
+	};
+
+	/** Targets of a surface and the 2D ones among them, array targets are painted but not tracked by residency and decay */
+	static bool GetSurfaceTargets(UMeshPaintSurfaceComponent* Surface, FMeshPaintRenderTargets& OutTargets, TArray<UTextureRenderTarget2D*, TInlineAllocator<3>>& OutTargets2D)
+	{
+		UTextureRenderTarget* SurfaceTargets[] = { Surface->GetBaseColor(), Surface->GetEmissive(), Surface->GetNormalMap() };
+		for (UTextureRenderTarget* Target : SurfaceTargets)
+		{
+			if (UTextureRenderTarget2D* Target2D = Cast<UTextureRenderTarget2D>(Target))
+			{
+				OutTargets2D.Add(Target2D);
+			}
+		}
+		UMeshPaintResidencySubsystem::EnsureTargetsResident(Surface->GetWorld(), OutTargets2D);
+
+		OutTargets.SetRenderTarget(SurfaceTargets[0], FMeshPaintRenderTargets::RT_BaseColor);
+		OutTargets.SetRenderTarget(SurfaceTargets[1], FMeshPaintRenderTargets::RT_Emissive);
+		OutTargets.SetRenderTarget(SurfaceTargets[2], FMeshPaintRenderTargets::RT_NormalMap);
+		return OutTargets.IsValidForRendering();
+	}
+}
+
+UNiagaraDataInterfaceMeshPaint::UNiagaraDataInterfaceMeshPaint(FObjectInitializer const& ObjectInitializer)
+	: Super(ObjectInitializer)
+	, PaintMaterial(nullptr)
+	, BlendMode(EMeshPaintBlendMode::AlphaBlend)
+	, BlendThreshold(0.5f)
+	, MaxStampsPerFrame(1024)
+	, bUpdatePaintMirrors(true)
+{
+	Proxy.Reset(new NDIMeshPaint::FProxy());
+}
+
+void UNiagaraDataInterfaceMeshPaint::PostInitProperties()
+{
+	Super::PostInitProperties();
+
+	if (HasAnyFlags(RF_ClassDefaultObject))
+	{
+		ENiagaraTypeRegistryFlags Flags = ENiagaraTypeRegistryFlags::AllowAnyVariable | ENiagaraTypeRegistryFlags::AllowParameter;
+		FNiagaraTypeRegistry::Register(FNiagaraTypeDefinition(GetClass()), Flags);
+	}
+}
+
+bool UNiagaraDataInterfaceMeshPaint::InitPerInstanceData(void* PerInstanceData, FNiagaraSystemInstance* SystemInstance)
+{
+	NDIMeshPaint::FInstanceData* InstanceData = new(PerInstanceData) NDIMeshPaint::FInstanceData();
+	InstanceData->World = SystemInstance->GetWorld();
+
+	ENQUEUE_RENDER_COMMAND(InitNiagaraMeshPaint)(
+	[RTProxy = GetProxyAs<NDIMeshPaint::FProxy>(), SystemInstanceID = SystemInstance->GetId(), MaxStamps = (uint32)FMath::Max(MaxStampsPerFrame, 1)](FRHICommandListImmediate&)
+	{
+		RTProxy->SystemInstances.FindOrAdd(SystemInstanceID).MaxStamps = MaxStamps;
+	});
+	return true;
+}
+
+void UNiagaraDataInterfaceMeshPaint::DestroyPerInstanceData(void* PerInstanceData, FNiagaraSystemInstance* SystemInstance)
+{
+	static_cast<NDIMeshPaint::FInstanceData*>(PerInstanceData)->~FInstanceData();
+
+	ENQUEUE_RENDER_COMMAND(DestroyNiagaraMeshPaint)(
+	[RTProxy = GetProxyAs<NDIMeshPaint::FProxy>(), SystemInstanceID = SystemInstance->GetId()](FRHICommandListImmediate&)
+	{
+		RTProxy->SystemInstances.Remove(SystemInstanceID);
+	});
+}
+
+int32 UNiagaraDataInterfaceMeshPaint::PerInstanceDataSize() const
+{
+	return sizeof(NDIMeshPaint::FInstanceData);
+}
+
+bool UNiagaraDataInterfaceMeshPaint::PerInstanceTick(void* PerInstanceData, FNiagaraSystemInstance* SystemInstance, float DeltaSeconds)
+{
+	NDIMeshPaint::FInstanceData* InstanceData = static_cast<NDIMeshPaint::FInstanceData*>(PerInstanceData);
+	UWorld* World = InstanceData->World.Get();
+	if (!World) return false;
+
+	InstanceData->LWCOrigin = FVector(SystemInstance->GetLWCTile()) * FLargeWorldRenderScalar::GetTileSize();
+
+	// GPU stamps can land anywhere within the system bounds, passes cover the surfaces and texels under a sphere enclosing them.
+	// One pass per surface, the pass skips stamps tagged with other surfaces and the GPU culls the draws the stamps miss
+	TArray<NDIMeshPaint::FSurfacePass> Passes;
+	const FBox SystemBounds = SystemInstance->GetLocalBounds().TransformBy(SystemInstance->GetWorldTransform());
+	if (SystemInstance->HasGPUEmitters() && SystemBounds.IsValid)
+	{
+		FMeshPaintBrushStamp BoundingStamp;
+		BoundingStamp.Location = SystemBounds.GetCenter();
+		BoundingStamp.Radius = (float)SystemBounds.GetExtent().Size();
+
+		TArray<UMeshPaintSurfaceComponent*> Surfaces;
+		UMeshPaintSurfaceComponent::FindSurfacesInStamps(World, MakeArrayView(&BoundingStamp, 1), Surfaces);
+		for (UMeshPaintSurfaceComponent* Surface : Surfaces)
+		{
+			NDIMeshPaint::FSurfacePass Pass;
+			TArray<UTextureRenderTarget2D*, TInlineAllocator<3>> Targets2D;
+			if (!NDIMeshPaint::GetSurfaceTargets(Surface, Pass.Targets, Targets2D)) continue;
+
+			const FRenderMaterialOnMeshPrimitive Primitive = Surface->MakePaintPrimitive();
+			if (!UMeshPainterFunctionLibrary::MakeBrushRenderParameters(World, MakeArrayView(&Primitive, 1), PaintMaterial, Pass.Targets.GetPrimaryRenderTarget()->GetSizeXY(), BlendMode, BlendThreshold, Pass.Params, MakeArrayView(&BoundingStamp, 1))) continue;
+
+			// Whether stamps landed is only known on the GPU, the texels they can reach stay active for decay
+			const FBox2D& PaintUVBounds = Pass.Params.PrimitivesToRender[0].PaintUVBounds;
+			UMeshPaintDecaySubsystem::MarkTargetsPainted(World, Targets2D, PaintUVBounds.bIsValid ? PaintUVBounds : Primitive.UVRegion);
+			Pass.Params.BrushSurfaceId = (uint32)Surface->GetSurfaceId();
+			Passes.Add(MoveTemp(Pass));
+		}
+	}
+
+	ENQUEUE_RENDER_COMMAND(NiagaraMeshPaintStamps)(
+	[RTProxy = GetProxyAs<NDIMeshPaint::FProxy>(), SystemInstanceID = SystemInstance->GetId(), Passes = MoveTemp(Passes), LWCOrigin = InstanceData->LWCOrigin](FRHICommandListImmediate& RHICmdList) mutable
+	{
+		RTProxy->PaintStamps(RHICmdList, SystemInstanceID, Passes, LWCOrigin);
+	});
+	return false;
+}
+
+bool UNiagaraDataInterfaceMeshPaint::PerInstanceTickPostSimulate(void* PerInstanceData, FNiagaraSystemInstance* SystemInstance, float DeltaSeconds)
+{
+	NDIMeshPaint::FInstanceData* InstanceData = static_cast<NDIMeshPaint::FInstanceData*>(PerInstanceData);
+
+	TArray<NDIMeshPaint::FStamp> Stamps;
+	{
+		FScopeLock Lock(&InstanceData->StampsLock);
+		Swap(Stamps, InstanceData->PendingStamps);
+	}
+	UWorld* World = InstanceData->World.Get();
+	if (Stamps.IsEmpty() || !World) return false;
+
+	TArray<FMeshPaintBrushStamp> BrushStamps;
+	TArray<int32> SurfaceIds;
+	BrushStamps.Reserve(Stamps.Num());
+	SurfaceIds.Reserve(Stamps.Num());
+	for (const NDIMeshPaint::FStamp& Stamp : Stamps)
+	{
+		BrushStamps.Add(Stamp.Brush);
+		SurfaceIds.Add(Stamp.SurfaceId);
+	}
+	PaintCPUStamps(World, BrushStamps, SurfaceIds);
+	return false;
+}
+
+int32 UNiagaraDataInterfaceMeshPaint::PaintCPUStamps(UWorld* World, TConstArrayView<FMeshPaintBrushStamp> Stamps, TConstArrayView<int32> SurfaceIds) const
+{
+	check(Stamps.Num() == SurfaceIds.Num());
+	MESH_PAINT_TRACE_SCOPE(NiagaraPaintCPUStamps);
+
+	TArray<UMeshPaintSurfaceComponent*> Surfaces;
+	UMeshPaintSurfaceComponent::FindSurfacesInStamps(World, Stamps, Surfaces);
+
+	// One pass per surface, stamps differ between surfaces. Mirrors get the stamps of the surface they mirror once
+	int32 NumPainted = 0;
+	TArray<FMeshPaintBrushStamp> SurfaceStamps;
+	for (UMeshPaintSurfaceComponent* Surface : Surfaces)
+	{
+		const FBox SurfaceBounds = Surface->GetPaintedComponent()->Bounds.GetBox();
+		SurfaceStamps.Reset();
+		for (int32 StampIndex = 0; StampIndex < Stamps.Num(); ++StampIndex)
+		{
+			const FMeshPaintBrushStamp& Stamp = Stamps[StampIndex];
+			if ((SurfaceIds[StampIndex] == 0 || SurfaceIds[StampIndex] == Surface->GetSurfaceId()) && SurfaceBounds.ComputeSquaredDistanceToPoint(Stamp.Location) <= FMath::Square(Stamp.Radius))
+			{
+				SurfaceStamps.Add(Stamp);
+			}
+		}
+		if (SurfaceStamps.IsEmpty()) continue;
+
+		NumPainted += UMeshPainterFunctionLibrary::RenderBrushStampsOnSurfaces(World, MakeArrayView(&Surface, 1), PaintMaterial, SurfaceStamps, BlendMode, BlendThreshold, bUpdatePaintMirrors) ? 1 : 0;
+	}
+	return NumPainted;
+}
+
+void UNiagaraDataInterfaceMeshPaint::VMPaintStamp(FVectorVMExternalFunctionContext& Context)
+{
+	VectorVM::FUserPtrHandler<NDIMeshPaint::FInstanceData> InstanceData(Context);
+	FNDIInputParam<FNiagaraBool> InExecute(Context);
+	FNDIInputParam<FNiagaraPosition> InPosition(Context);
+	FNDIInputParam<float> InRadius(Context);
+	FNDIInputParam<float> InHardness(Context);
+	FNDIInputParam<float> InStrength(Context);
+	FNDIInputParam<int32> InSurfaceId(Context);
+	FNDIOutputParam<FNiagaraBool> OutSuccess(Context);
+
+	TArray<NDIMeshPaint::FStamp, TInlineAllocator<64>> Stamps;
+	for (int32 InstanceIndex = 0; InstanceIndex < Context.GetNumInstances(); ++InstanceIndex)
+	{
+		const bool bExecute = InExecute.GetAndAdvance();
+		const FVector3f Position = InPosition.GetAndAdvance();
+		const float Radius = InRadius.GetAndAdvance();
+		const float Hardness = InHardness.GetAndAdvance();
+		const float Strength = InStrength.GetAndAdvance();
+		const int32 SurfaceId = InSurfaceId.GetAndAdvance();
+
+		const bool bSuccess = bExecute && Radius > 0.0f && Strength > 0.0f;
+		if (bSuccess)
+		{
+			NDIMeshPaint::FStamp& Stamp = Stamps.AddDefaulted_GetRef();
+			Stamp.Brush.Location = InstanceData->LWCOrigin + FVector(Position);
+			Stamp.Brush.Radius = Radius;
+			Stamp.Brush.Hardness = FMath::Clamp(Hardness, 0.0f, 1.0f);
+			Stamp.Brush.Strength = FMath::Clamp(Strength, 0.0f, 1.0f);
+			Stamp.SurfaceId = FMath::Max(SurfaceId, 0);
+		}
+		OutSuccess.SetAndAdvance(bSuccess);
+	}
+
+	if (!Stamps.IsEmpty())
+	{
+		FScopeLock Lock(&InstanceData->StampsLock);
+		InstanceData->PendingStamps.Append(Stamps);
+	}
+}
+
+void UNiagaraDataInterfaceMeshPaint::GetVMExternalFunction(const FVMExternalFunctionBindingInfo& BindingInfo, void* InstanceData, FVMExternalFunction& OutFunc)
+{
+	if (BindingInfo.Name == NDIMeshPaint::PaintStampName)
+	{
+		OutFunc = FVMExternalFunction::CreateUObject(this, &UNiagaraDataInterfaceMeshPaint::VMPaintStamp);
+	}
+}
+
+#if WITH_EDITORONLY_DATA
+void UNiagaraDataInterfaceMeshPaint::GetFunctionsInternal(TArray<FNiagaraFunctionSignature>& OutFunctions) const
+{
+	FNiagaraFunctionSignature& Signature = OutFunctions.AddDefaulted_GetRef();
+	Signature.Name = NDIMeshPaint::PaintStampName;
+	Signature.bMemberFunction = true;
+	Signature.bRequiresContext = false;
+	Signature.bRequiresExecPin = true;
+	Signature.bWriteFunction = true;
+	Signature.bSupportsCPU = true;
+	Signature.bSupportsGPU = true;
+	Signature.Inputs.Add(FNiagaraVariable(FNiagaraTypeDefinition(GetClass()), TEXT("MeshPaint")));
+	Signature.Inputs.Add(FNiagaraVariable(FNiagaraTypeDefinition::GetBoolDef(), TEXT("Execute")));
+	Signature.Inputs.Add(FNiagaraVariable(FNiagaraTypeDefinition::GetPositionDef(), TEXT("Position")));
+	Signature.Inputs.Add(FNiagaraVariable(FNiagaraTypeDefinition::GetFloatDef(), TEXT("Radius")));
+	Signature.Inputs.Add(FNiagaraVariable(FNiagaraTypeDefinition::GetFloatDef(), TEXT("Hardness")));
+	Signature.Inputs.Add(FNiagaraVariable(FNiagaraTypeDefinition::GetFloatDef(), TEXT("Strength")));
+	Signature.Inputs.Add(FNiagaraVariable(FNiagaraTypeDefinition::GetIntDef(), TEXT("SurfaceId")));
+	Signature.Outputs.Add(FNiagaraVariable(FNiagaraTypeDefinition::GetBoolDef(), TEXT("Success")));
+	Signature.SetDescription(NSLOCTEXT("MeshPaint", "PaintStampDescription", "Paints a brush stamp into the mesh paint surface with SurfaceId, or into every surface it touches when SurfaceId is 0."));
+}
+
+bool UNiagaraDataInterfaceMeshPaint::AppendCompileHash(FNiagaraCompileHashVisitor* InVisitor) const
+{
+	bool bSuccess = Super::AppendCompileHash(InVisitor);
+	bSuccess &= InVisitor->UpdateShaderFile(NDIMeshPaint::TemplateShaderFilePath);
+	bSuccess &= InVisitor->UpdateShaderParameters<FShaderParameters>();
+	return bSuccess;
+}
+
+void UNiagaraDataInterfaceMeshPaint::GetParameterDefinitionHLSL(const FNiagaraDataInterfaceGPUParamInfo& ParamInfo, FString& OutHLSL)
+{
+	const TMap<FString, FStringFormatArg> TemplateArgs =
+	{
+		{TEXT("ParameterName"), ParamInfo.DataInterfaceHLSLSymbol},
+	};
+	AppendTemplateHLSL(OutHLSL, NDIMeshPaint::TemplateShaderFilePath, TemplateArgs);
+}
+
+bool UNiagaraDataInterfaceMeshPaint::GetFunctionHLSL(const FNiagaraDataInterfaceGPUParamInfo& ParamInfo, const FNiagaraDataInterfaceGeneratedFunction& FunctionInfo, int FunctionInstanceIndex, FString& OutHLSL)
+{
+	return FunctionInfo.DefinitionName == NDIMeshPaint::PaintStampName;
+}
+#endif
+
+void UNiagaraDataInterfaceMeshPaint::BuildShaderParameters(FNiagaraShaderParametersBuilder& ShaderParametersBuilder) const
+{
+	ShaderParametersBuilder.AddNestedStruct<FShaderParameters>();
+}
+
+void UNiagaraDataInterfaceMeshPaint::SetShaderParameters(const FNiagaraDataInterfaceSetShaderParametersContext& Context) const
+{
+	NDIMeshPaint::FProxy& DIProxy = Context.GetProxy<NDIMeshPaint::FProxy>();
+	NDIMeshPaint::FRenderInstanceData* InstanceData = DIProxy.SystemInstances.Find(Context.GetSystemInstanceID());
+	FRDGBuilder& GraphBuilder = Context.GetGraphBuilder();
+	FShaderParameters* ShaderParameters = Context.GetParameterNestedStruct<FShaderParameters>();
+
+	if (InstanceData && InstanceData->MaxStamps > 0)
+	{
+		DIProxy.AllocateBuffers(GraphBuilder, *InstanceData);
+		ShaderParameters->Stamps = GraphBuilder.CreateUAV(GraphBuilder.RegisterExternalBuffer(InstanceData->Stamps));
+		ShaderParameters->StampCount = GraphBuilder.CreateUAV(GraphBuilder.RegisterExternalBuffer(InstanceData->Counter), PF_R32_UINT);
+		ShaderParameters->MaxStamps = InstanceData->MaxStamps;
+	}
+	else
+	{
+		FRDGBufferRef DummyStamps = GraphBuilder.CreateBuffer(FRDGBufferDesc::CreateStructuredDesc(sizeof(FVector4f), 2), TEXT("NiagaraMeshPaint.DummyStamps"));
+		ShaderParameters->Stamps = GraphBuilder.CreateUAV(DummyStamps);
+		ShaderParameters->StampCount = Context.GetComputeDispatchInterface().GetEmptyBufferUAV(GraphBuilder, PF_R32_UINT);
+		ShaderParameters->MaxStamps = 0;
+	}
+}
+
+bool UNiagaraDataInterfaceMeshPaint::Equals(const UNiagaraDataInterface* Other) const
+{
+	if (!Super::Equals(Other)) return false;
+
+	const UNiagaraDataInterfaceMeshPaint* OtherTyped = CastChecked<const UNiagaraDataInterfaceMeshPaint>(Other);
+	return OtherTyped->PaintMaterial == PaintMaterial
+		&& OtherTyped->BlendMode == BlendMode
+		&& OtherTyped->BlendThreshold == BlendThreshold
+		&& OtherTyped->MaxStampsPerFrame == MaxStampsPerFrame
+		&& OtherTyped->bUpdatePaintMirrors == bUpdatePaintMirrors;
+}
+
+bool UNiagaraDataInterfaceMeshPaint::CopyToInternal(UNiagaraDataInterface* Destination) const
+{
+	if (!Super::CopyToInternal(Destination)) return false;
+
+	UNiagaraDataInterfaceMeshPaint* DestinationTyped = CastChecked<UNiagaraDataInterfaceMeshPaint>(Destination);
+	DestinationTyped->PaintMaterial = PaintMaterial;
+	DestinationTyped->BlendMode = BlendMode;
+	DestinationTyped->BlendThreshold = BlendThreshold;
+	DestinationTyped->MaxStampsPerFrame = MaxStampsPerFrame;
+	DestinationTyped->bUpdatePaintMirrors = bUpdatePaintMirrors;
+	return true;
+}
@@ -0,0 +1,121 @@
+#include "NiagaraDataInterfaceMeshPaint.h"
+#include "Components/MeshPaintMirrorComponent.h"
+#include "Components/MeshPaintSurfaceComponent.h"
+#include "Components/StaticMeshComponent.h"
+#include "Engine/Engine.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/StaticMeshActor.h"
+#include "Engine/TextureRenderTarget2D.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "MeshPaintMeshDataCache.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace NiagaraMeshPaintTests
+{
+	/** Builds mesh data in the lookup for the duration of a test */
+	class FScopedSyncMeshDataBuild
+	{
+	public:
+		FScopedSyncMeshDataBuild()
+			: Variable(IConsoleManager::Get().FindConsoleVariable(TEXT("r.MeshPaint.MeshData.AsyncBuild")))
+			, PreviousValue(Variable ? Variable->GetInt() : 0)
+		{
+			if (Variable) Variable->Set(0, ECVF_SetByCode);
+		}
+		~FScopedSyncMeshDataBuild()
+		{
+			if (Variable) Variable->Set(PreviousValue, ECVF_SetByCode);
+		}
+
+	private:
+		IConsoleVariable* Variable;
+		int32 PreviousValue;
+	};
+
+	/** Game world with its mesh paint subsystems for the duration of a test */
+	class FScopedTestWorld
+	{
+	public:
+		FScopedTestWorld()
+			: World(UWorld::CreateWorld(EWorldType::Game, false))
+		{
+			GEngine->CreateNewWorldContext(EWorldType::Game).SetCurrentWorld(World);
+		}
+		~FScopedTestWorld()
+		{
+			FlushRenderingCommands();
+			GEngine->DestroyWorldContext(World);
+			World->DestroyWorld(false);
+		}
+
+		UWorld* const World;
+	};
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNiagaraMeshPaintCPUStampsMirrorTest, "MeshPaint.Niagara.CPUStampsReachMirrorOnce",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FNiagaraMeshPaintCPUStampsMirrorTest::RunTest(const FString& Parameters)
+{
+	// Engine plane, 100 units centered on the origin with UVs over the unit square
+	UStaticMesh* Plane = LoadObject<UStaticMesh>(nullptr, TEXT("/Engine/BasicShapes/Plane.Plane"));
+	if (!TestNotNull(TEXT("Engine plane mesh"), Plane)) return false;
+
+	NiagaraMeshPaintTests::FScopedSyncMeshDataBuild SyncBuild;
+	NiagaraMeshPaintTests::FScopedTestWorld TestWorld;
+	UWorld* World = TestWorld.World;
+
+	AStaticMeshActor* Actor = World->SpawnActor<AStaticMeshActor>();
+	if (!TestNotNull(TEXT("Painted actor"), Actor)) return false;
+	Actor->SetMobility(EComponentMobility::Movable);
+	Actor->GetStaticMeshComponent()->SetStaticMesh(Plane);
+
+	UTextureRenderTarget2D* BaseColor = NewObject<UTextureRenderTarget2D>(GetTransientPackage());
+	BaseColor->InitAutoFormat(64, 64);
+	BaseColor->UpdateResourceImmediate(true);
+
+	UMeshPaintSurfaceComponent* Surface = NewObject<UMeshPaintSurfaceComponent>(Actor);
+	Surface->SetPaintTargets(BaseColor, nullptr, nullptr, FBox2D(FVector2D::Zero(), FVector2D::One()), 0);
+	Surface->RegisterComponent();
+	UMeshPaintMirrorComponent* Mirror = NewObject<UMeshPaintMirrorComponent>(Actor);
+	Mirror->RegisterComponent();
+
+	// Half strength, a second application of the same stamp would raise the coverage to three quarters
+	FMeshPaintBrushStamp Stamp;
+	Stamp.Location = FVector(-25.0, -25.0, 0.0);
+	Stamp.Radius = 15.0f;
+	Stamp.Hardness = 1.0f;
+	Stamp.Strength = 0.5f;
+	const FVector QueryLocation(-25.0, -25.0, 1.0);
+
+	UNiagaraDataInterfaceMeshPaint* DataInterface = NewObject<UNiagaraDataInterfaceMeshPaint>(GetTransientPackage());
+	const int32 AnySurface[] = { 0 };
+	TestEqual(TEXT("Surfaces painted"), DataInterface->PaintCPUStamps(World, MakeArrayView(&Stamp, 1), AnySurface), 1);
+
+	float Coverage = 0.0f;
+	uint8 OwnerId = 0;
+	if (TestTrue(TEXT("Query under the stamp"), Mirror->QueryPaintAtLocation(QueryLocation, 5.0f, Coverage, OwnerId)))
+	{
+		TestEqual(TEXT("Stamp reaches the mirror once"), Coverage, 0.5f, 0.01f);
+	}
+
+	// Stamps naming another surface leave this surface and its mirror alone
+	const int32 OtherSurface[] = { Surface->GetSurfaceId() + 1 };
+	TestEqual(TEXT("Surfaces painted by stamps of another surface"), DataInterface->PaintCPUStamps(World, MakeArrayView(&Stamp, 1), OtherSurface), 0);
+
+	DataInterface->bUpdatePaintMirrors = false;
+	TestEqual(TEXT("Surfaces painted without mirrors"), DataInterface->PaintCPUStamps(World, MakeArrayView(&Stamp, 1), AnySurface), 1);
+
+	if (TestTrue(TEXT("Query after the other stamps"), Mirror->QueryPaintAtLocation(QueryLocation, 5.0f, Coverage, OwnerId)))
+	{
+		TestEqual(TEXT("Mirror keeps its coverage"), Coverage, 0.5f, 0.01f);
+	}
+
+	FMeshPaintMeshDataCache::Get().Invalidate(Plane);
+	return true;
+}
+
+#endif
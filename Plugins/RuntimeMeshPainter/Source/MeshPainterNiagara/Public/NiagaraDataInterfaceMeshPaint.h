@@ -0,0 +1,87 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "NiagaraDataInterface.h"
+#include "MeshPaintBlendMode.h"
+#include "MeshPaintBrushTypes.h"
+#include "NiagaraDataInterfaceMeshPaint.generated.h"
+
+class UMaterialInterface;
+
+/**
+ * Paints brush stamps from particles, typically from collision events, into mesh paint surfaces (UMeshPaintSurfaceComponent).
+ * A stamp names its surface by id, zero paints every surface it touches.
+ * GPU emitters append stamps to a buffer the brush pass reads directly at the start of the next frame, nothing goes back to the CPU.
+ * Passes are recorded for the surfaces within the system bounds, the GPU culls the draws of surfaces the appended stamps miss.
+ * CPU emitters collect stamps and paint them at the end of the system tick, they also reach the paint mirrors of the painted surfaces.
+ */
+UCLASS(EditInlineNew, Category = "Mesh Paint", meta = (DisplayName = "Mesh Paint"))
+class MESHPAINTERNIAGARA_API UNiagaraDataInterfaceMeshPaint : public UNiagaraDataInterface
+{
+	GENERATED_UCLASS_BODY()
+
+	BEGIN_SHADER_PARAMETER_STRUCT(FShaderParameters, )
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWStructuredBuffer<float4>, Stamps)
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWBuffer<uint>, StampCount)
+		SHADER_PARAMETER(uint32, MaxStamps)
+	END_SHADER_PARAMETER_STRUCT()
+
+public:
+	/** Material painted, the surface materials are used when empty */
+	UPROPERTY(EditAnywhere, Category = "Mesh Paint")
+	UMaterialInterface* PaintMaterial;
+
+	UPROPERTY(EditAnywhere, Category = "Mesh Paint")
+	EMeshPaintBlendMode BlendMode;
+
+	UPROPERTY(EditAnywhere, Category = "Mesh Paint")
+	float BlendThreshold;
+
+	/** Stamps a GPU system instance can hold until the next paint pass, further stamps of the frame are dropped */
+	UPROPERTY(EditAnywhere, Category = "Mesh Paint", meta = (ClampMin = "1"))
+	int32 MaxStampsPerFrame;
+
+	/** Also applies stamps of CPU emitters to the paint mirror components of the surfaces they paint */
+	UPROPERTY(EditAnywhere, Category = "Mesh Paint")
+	bool bUpdatePaintMirrors;
+
+	/**
+	 * Paints stamps of CPU emitters into the surfaces they touch, a stamp with a non zero surface id only into that surface.
+	 * Runs at the end of the system tick with the stamps collected by the VM, returns the number of surfaces painted.
+	 */
+	int32 PaintCPUStamps(UWorld* World, TConstArrayView<FMeshPaintBrushStamp> Stamps, TConstArrayView<int32> SurfaceIds) const;
+
+	//~ Begin UObject Interface
+	virtual void PostInitProperties() override;
+	//~ End UObject Interface
+
+	//~ Begin UNiagaraDataInterface Interface
+	virtual bool InitPerInstanceData(void* PerInstanceData, FNiagaraSystemInstance* SystemInstance) override;
+	virtual void DestroyPerInstanceData(void* PerInstanceData, FNiagaraSystemInstance* SystemInstance) override;
+	virtual int32 PerInstanceDataSize() const override;
+	virtual bool PerInstanceTick(void* PerInstanceData, FNiagaraSystemInstance* SystemInstance, float DeltaSeconds) override;
+	virtual bool PerInstanceTickPostSimulate(void* PerInstanceData, FNiagaraSystemInstance* SystemInstance, float DeltaSeconds) override;
+	virtual bool HasPostSimulateTick() const override { return true; }
+	virtual void GetVMExternalFunction(const FVMExternalFunctionBindingInfo& BindingInfo, void* InstanceData, FVMExternalFunction& OutFunc) override;
+	virtual bool CanExecuteOnTarget(ENiagaraSimTarget Target) const override { return true; }
+	virtual bool Equals(const UNiagaraDataInterface* Other) const override;
+#if WITH_EDITORONLY_DATA
+	virtual bool AppendCompileHash(FNiagaraCompileHashVisitor* InVisitor) const override;
+	virtual void GetParameterDefinitionHLSL(const FNiagaraDataInterfaceGPUParamInfo& ParamInfo, FString& OutHLSL) override;
+	virtual bool GetFunctionHLSL(const FNiagaraDataInterfaceGPUParamInfo& ParamInfo, const FNiagaraDataInterfaceGeneratedFunction& FunctionInfo, int FunctionInstanceIndex, FString& OutHLSL) override;
+#endif
+	virtual void BuildShaderParameters(FNiagaraShaderParametersBuilder& ShaderParametersBuilder) const override;
+	virtual void SetShaderParameters(const FNiagaraDataInterfaceSetShaderParametersContext& Context) const override;
+	//~ End UNiagaraDataInterface Interface
+
+protected:
+	//~ Begin UNiagaraDataInterface Interface
+#if WITH_EDITORONLY_DATA
+	virtual void GetFunctionsInternal(TArray<FNiagaraFunctionSignature>& OutFunctions) const override;
+#endif
+	virtual bool CopyToInternal(UNiagaraDataInterface* Destination) const override;
+	//~ End UNiagaraDataInterface Interface
+
+private:
+	void VMPaintStamp(FVectorVMExternalFunctionContext& Context);
+};
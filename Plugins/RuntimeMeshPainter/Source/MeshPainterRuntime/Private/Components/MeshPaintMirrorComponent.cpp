@@ -0,0 +1,265 @@
+#include "Components/MeshPaintMirrorComponent.h"
+#include "Components/StaticMeshComponent.h"
+#include "GameFramework/Actor.h"
+#include "MeshPaintMeshDataCache.h"
+#include "MeshPaintTriangleBVH.h"
+#include "MeshPaintUVRasterizer.h"
+#include "MeshPaintContextSubsystem.h"
+#include "Engine/World.h"
+
+DECLARE_CYCLE_STAT(TEXT("MeshPaintMirror ApplyBrushStamp"), STAT_MeshPaintMirrorApplyBrushStamp, STATGROUP_Component);
+DECLARE_CYCLE_STAT(TEXT("MeshPaintMirror QueryPaint"), STAT_MeshPaintMirrorQueryPaint, STATGROUP_Component);
+
+UMeshPaintMirrorComponent::UMeshPaintMirrorComponent()
+	: Resolution(64)
+	, LOD(0)
+	, UVChannel(0)
+	, OwnershipThreshold(0.5f)
+	, PaintedComponent(nullptr)
+{
+	PrimaryComponentTick.bCanEverTick = false;
+}
+
+void UMeshPaintMirrorComponent::OnRegister()
+{
+	Super::OnRegister();
+
+	if (!PaintedComponent && GetOwner())
+	{
+		PaintedComponent = GetOwner()->FindComponentByClass<UStaticMeshComponent>();
+	}
+	if (UMeshPaintContextSubsystem* Context = UMeshPaintContextSubsystem::Get(this))
+	{
+		Context->RegisterMirror(this);
+	}
+
+	// Starts building the triangle hierarchy so it is ready by the first stamp
+	ResolveTriangleBVH();
+}
+
+void UMeshPaintMirrorComponent::OnUnregister()
+{
+	if (UMeshPaintContextSubsystem* Context = UMeshPaintContextSubsystem::Get(this))
+	{
+		Context->UnregisterMirror(this);
+	}
+	Super::OnUnregister();
+}
+
+void UMeshPaintMirrorComponent::SetPaintedComponent(UStaticMeshComponent* InComponent)
+{
+	PaintedComponent = InComponent;
+	TriangleBVH.Reset();
+	TriangleBVHMesh.Reset();
+}
+
+UStaticMeshComponent* UMeshPaintMirrorComponent::GetPaintedComponent() const
+{
+	return PaintedComponent;
+}
+
+const FMeshPaintTriangleBVH* UMeshPaintMirrorComponent::ResolveTriangleBVH() const
+{
+	if (!IsValid(PaintedComponent)) return nullptr;
+
+	UStaticMesh* StaticMesh = PaintedComponent->GetStaticMesh();
+	if (TriangleBVHMesh.Get() != StaticMesh || !TriangleBVH.IsValid())
+	{
+		TriangleBVH = UMeshPaintContextSubsystem::UseMeshData(this, StaticMesh).FindOrBuildTriangleBVH(StaticMesh, LOD, UVChannel);
+		TriangleBVHMesh = StaticMesh;
+	}
+	return TriangleBVH.Get();
+}
+
+void UMeshPaintMirrorComponent::EnsureGrid()
+{
+	const int32 NumTexels = Resolution * Resolution;
+	if (Coverage.Num() != NumTexels)
+	{
+		Coverage.Init(0, NumTexels);
+		Owners.Init(0, NumTexels);
+	}
+}
+
+void UMeshPaintMirrorComponent::ClearPaint()
+{
+	Coverage.Reset();
+	Owners.Reset();
+}
+
+bool UMeshPaintMirrorComponent::ApplyBrushStamp(const FMeshPaintBrushStamp& Stamp)
+{
+	SCOPE_CYCLE_COUNTER(STAT_MeshPaintMirrorApplyBrushStamp);
+
+	const FMeshPaintTriangleBVH* BVH = ResolveTriangleBVH();
+	if (!BVH || Stamp.Radius <= 0.0f || Stamp.Strength <= 0.0f) return false;
+
+	EnsureGrid();
+
+	// Brush is evaluated in component space, non uniform scale is approximated by the largest axis
+	const FTransform& ComponentToWorld = PaintedComponent->GetComponentTransform();
+	const FVector3f Center = FVector3f(ComponentToWorld.InverseTransformPosition(Stamp.Location));
+	const float Radius = Stamp.Radius / FMath::Max((float)ComponentToWorld.GetMaximumAxisScale(), UE_SMALL_NUMBER);
+	const float HardRadius = Radius * FMath::Clamp(Stamp.Hardness, 0.0f, 1.0f);
+	const float InvFalloff = 1.0f / FMath::Max(Radius - HardRadius, UE_SMALL_NUMBER);
+
+	const VectorRegister4Float CenterX = VectorSetFloat1(Center.X);
+	const VectorRegister4Float CenterY = VectorSetFloat1(Center.Y);
+	const VectorRegister4Float CenterZ = VectorSetFloat1(Center.Z);
+	const VectorRegister4Float RadiusV = VectorSetFloat1(Radius);
+	const VectorRegister4Float InvFalloffV = VectorSetFloat1(InvFalloff);
+	const VectorRegister4Float StrengthV = VectorSetFloat1(FMath::Min(Stamp.Strength, 1.0f));
+
+	const FIntRect GridRect(0, 0, Resolution, Resolution);
+	const float GridScale = (float)Resolution;
+	bool bChanged = false;
+
+	BVH->ForEachTriangleInBox(FBox3f(Center - FVector3f(Radius), Center + FVector3f(Radius)), [&](int32 TriangleIndex)
+	{
+		FVector3f P0, P1, P2;
+		FVector2f UV0, UV1, UV2;
+		BVH->GetTrianglePositions(TriangleIndex, P0, P1, P2);
+		BVH->GetTriangleUVs(TriangleIndex, UV0, UV1, UV2);
+
+		MeshPaintUVRaster::RasterizeTriangle(UV0 * GridScale, UV1 * GridScale, UV2 * GridScale, GridRect,
+			[&](int32 X, int32 Y, int32 LaneMask, const VectorRegister4Float& B0, const VectorRegister4Float& B1, const VectorRegister4Float& B2)
+			{
+				const VectorRegister4Float DX = VectorSubtract(MeshPaintUVRaster::Interpolate(B0, B1, B2, P0.X, P1.X, P2.X), CenterX);
+				const VectorRegister4Float DY = VectorSubtract(MeshPaintUVRaster::Interpolate(B0, B1, B2, P0.Y, P1.Y, P2.Y), CenterY);
+				const VectorRegister4Float DZ = VectorSubtract(MeshPaintUVRaster::Interpolate(B0, B1, B2, P0.Z, P1.Z, P2.Z), CenterZ);
+				const VectorRegister4Float Distance = VectorSqrt(VectorMultiplyAdd(DX, DX, VectorMultiplyAdd(DY, DY, VectorMultiply(DZ, DZ))));
+
+				// Strength * saturate((Radius - Distance) / (Radius - HardRadius))
+				const VectorRegister4Float Falloff = VectorMultiply(VectorSubtract(RadiusV, Distance), InvFalloffV);
+				const VectorRegister4Float Alpha = VectorMultiply(StrengthV, VectorMin(VectorMax(Falloff, VectorZeroFloat()), VectorOneFloat()));
+
+				alignas(16) float Alphas[MeshPaintUVRaster::LaneCount];
+				VectorStoreAligned(Alpha, Alphas);
+
+				const int32 RowStart = Y * Resolution + X;
+				for (int32 Lane = 0; Lane < MeshPaintUVRaster::LaneCount; ++Lane)
+				{
+					if (!(LaneMask & (1 << Lane)) || Alphas[Lane] <= 0.0f) continue;
+					bChanged |= BlendTexel(RowStart + Lane, Alphas[Lane], Stamp.OwnerId);
+				}
+			});
+	});
+
+	return bChanged;
+}
+
+bool UMeshPaintMirrorComponent::ApplyFill(float Opacity, uint8 OwnerId)
+{
+	return ApplyFill(Opacity, OwnerId, [](int32) { return true; });
+}
+
+bool UMeshPaintMirrorComponent::ApplyFill(float Opacity, uint8 OwnerId, TFunctionRef<bool(int32 TriangleIndex)> TriangleFilter)
+{
+	SCOPE_CYCLE_COUNTER(STAT_MeshPaintMirrorApplyBrushStamp);
+
+	const FMeshPaintTriangleBVH* BVH = ResolveTriangleBVH();
+	const float Alpha = FMath::Min(Opacity, 1.0f);
+	if (!BVH || Alpha <= 0.0f) return false;
+
+	EnsureGrid();
+
+	const FIntRect GridRect(0, 0, Resolution, Resolution);
+	const float GridScale = (float)Resolution;
+	bool bChanged = false;
+
+	for (int32 TriangleIndex = 0; TriangleIndex < BVH->GetNumTriangles(); ++TriangleIndex)
+	{
+		if (!TriangleFilter(TriangleIndex)) continue;
+
+		FVector2f UV0, UV1, UV2;
+		BVH->GetTriangleUVs(TriangleIndex, UV0, UV1, UV2);
+		MeshPaintUVRaster::RasterizeTriangle(UV0 * GridScale, UV1 * GridScale, UV2 * GridScale, GridRect,
+			[&](int32 X, int32 Y, int32 LaneMask, const VectorRegister4Float&, const VectorRegister4Float&, const VectorRegister4Float&)
+			{
+				for (int32 Lane = 0; Lane < MeshPaintUVRaster::LaneCount; ++Lane)
+				{
+					if (LaneMask & (1 << Lane))
+					{
+						bChanged |= BlendTexel(Y * Resolution + X + Lane, Alpha, OwnerId);
+					}
+				}
+			});
+	}
+
+	return bChanged;
+}
+
+bool UMeshPaintMirrorComponent::BlendTexel(int32 TexelIndex, float Alpha, uint8 OwnerId)
+{
+	// Same as alpha blending an opaque color: Dst = Dst + (1 - Dst) * Alpha
+	uint8& TexelCoverage = Coverage[TexelIndex];
+	const uint8 NewCoverage = (uint8)FMath::Min(255, FMath::RoundToInt32(TexelCoverage + (255 - TexelCoverage) * Alpha));
+	bool bChanged = NewCoverage != TexelCoverage;
+	TexelCoverage = NewCoverage;
+
+	if (Alpha >= OwnershipThreshold && Owners[TexelIndex] != OwnerId)
+	{
+		Owners[TexelIndex] = OwnerId;
+		bChanged = true;
+	}
+	return bChanged;
+}
+
+bool UMeshPaintMirrorComponent::QueryPaintAtLocation(const FVector& WorldLocation, float MaxDistance, float& OutCoverage, uint8& OutOwnerId) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_MeshPaintMirrorQueryPaint);
+
+	OutCoverage = 0.0f;
+	OutOwnerId = 0;
+
+	const FMeshPaintTriangleBVH* BVH = ResolveTriangleBVH();
+	if (!BVH) return false;
+
+	const FTransform& ComponentToWorld = PaintedComponent->GetComponentTransform();
+	const FVector3f LocalPoint = FVector3f(ComponentToWorld.InverseTransformPosition(WorldLocation));
+	const float LocalMaxDistance = MaxDistance / FMath::Max((float)ComponentToWorld.GetMinimumAxisScale(), UE_SMALL_NUMBER);
+
+	FMeshPaintTriangleBVH::FHit Hit;
+	if (!BVH->FindClosestTriangle(LocalPoint, LocalMaxDistance, Hit)) return false;
+
+	if (Coverage.IsEmpty()) return true;
+
+	const FVector2f UV = BVH->GetHitUV(Hit);
+	const int32 X = FMath::Clamp(FMath::FloorToInt32(UV.X * Resolution), 0, Resolution - 1);
+	const int32 Y = FMath::Clamp(FMath::FloorToInt32(UV.Y * Resolution), 0, Resolution - 1);
+	OutCoverage = Coverage[Y * Resolution + X] / 255.0f;
+	OutOwnerId = Owners[Y * Resolution + X];
+	return true;
+}
+
+float UMeshPaintMirrorComponent::GetOwnerCoverage(uint8 OwnerId) const
+{
+	if (Coverage.IsEmpty()) return 0.0f;
+
+	int32 NumOwned = 0;
+	for (int32 TexelIndex = 0; TexelIndex < Coverage.Num(); ++TexelIndex)
+	{
+		NumOwned += (Coverage[TexelIndex] != 0 && Owners[TexelIndex] == OwnerId) ? 1 : 0;
+	}
+	return (float)NumOwned / Coverage.Num();
+}
+
+void UMeshPaintMirrorComponent::BroadcastBrushStamp(UWorld* World, const FMeshPaintBrushStamp& Stamp)
+{
+	UMeshPaintContextSubsystem* Context = World ? World->GetSubsystem<UMeshPaintContextSubsystem>() : nullptr;
+	if (!Context) return;
+
+	// Stamping may register or unregister components through gameplay callbacks, iterate over a copy
+	TArray<UMeshPaintMirrorComponent*, TInlineAllocator<16>> Mirrors;
+	for (UMeshPaintMirrorComponent* Mirror : Context->GetMirrors())
+	{
+		if (!IsValid(Mirror->PaintedComponent)) continue;
+		if (Mirror->PaintedComponent->Bounds.GetBox().ComputeSquaredDistanceToPoint(Stamp.Location) > FMath::Square(Stamp.Radius)) continue;
+		Mirrors.Add(Mirror);
+	}
+
+	for (UMeshPaintMirrorComponent* Mirror : Mirrors)
+	{
+		Mirror->ApplyBrushStamp(Stamp);
+	}
+}
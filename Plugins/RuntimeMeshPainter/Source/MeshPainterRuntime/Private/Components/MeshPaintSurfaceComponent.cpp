@@ -0,0 +1,211 @@
+#include "Components/MeshPaintSurfaceComponent.h"
+#include "Components/MeshComponent.h"
+#include "Components/StaticMeshComponent.h"
+#include "Engine/TextureRenderTarget2D.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "MeshPaintResidencySubsystem.h"
+#include "MeshPaintContextSubsystem.h"
+#include "MeshPaintMeshDataCache.h"
+
+namespace MeshPaintSurface
+{
+	static int32 NextSurfaceId = 1;
+}
+
+UMeshPaintSurfaceComponent::UMeshPaintSurfaceComponent()
+	: BaseColor(nullptr)
+	, Emissive(nullptr)
+	, NormalMap(nullptr)
+	, UVRegion(FVector2D::Zero(), FVector2D::One())
+	, ArraySlice(0)
+	, LOD(0)
+	, UVChannel(0)
+	, bReferencePose(false)
+	, DescriptorDataIndex(INDEX_NONE)
+	, PaintedComponent(nullptr)
+	, SurfaceId(0)
+{
+	PrimaryComponentTick.bCanEverTick = false;
+}
+
+void UMeshPaintSurfaceComponent::OnRegister()
+{
+	Super::OnRegister();
+
+	if (!PaintedComponent && GetOwner())
+	{
+		PaintedComponent = GetOwner()->FindComponentByClass<UMeshComponent>();
+	}
+	if (SurfaceId == 0)
+	{
+		SurfaceId = MeshPaintSurface::NextSurfaceId++;
+	}
+	if (UMeshPaintContextSubsystem* Context = UMeshPaintContextSubsystem::Get(this))
+	{
+		Context->RegisterSurface(this);
+	}
+	RegisterResidency();
+	UpdateSurfaceDescriptor();
+	PrefetchMeshData();
+}
+
+void UMeshPaintSurfaceComponent::OnUnregister()
+{
+	UnregisterResidency();
+	if (UMeshPaintContextSubsystem* Context = UMeshPaintContextSubsystem::Get(this))
+	{
+		Context->UnregisterSurface(this);
+	}
+	Super::OnUnregister();
+}
+
+void UMeshPaintSurfaceComponent::SetPaintedComponent(UPrimitiveComponent* InComponent)
+{
+	UnregisterResidency();
+	PaintedComponent = InComponent;
+	RegisterResidency();
+	UpdateSurfaceDescriptor();
+	PrefetchMeshData();
+}
+
+UPrimitiveComponent* UMeshPaintSurfaceComponent::GetPaintedComponent() const
+{
+	return PaintedComponent;
+}
+
+void UMeshPaintSurfaceComponent::SetPaintTargets(UTextureRenderTarget* InBaseColor, UTextureRenderTarget* InEmissive, UTextureRenderTarget* InNormalMap, const FBox2D& InUVRegion, int32 InArraySlice)
+{
+	UnregisterResidency();
+	BaseColor = InBaseColor;
+	Emissive = InEmissive;
+	NormalMap = InNormalMap;
+	UVRegion = InUVRegion;
+	ArraySlice = InArraySlice;
+	RegisterResidency();
+	UpdateSurfaceDescriptor();
+	PrefetchMeshData();
+}
+
+FRenderMaterialOnMeshPrimitive UMeshPaintSurfaceComponent::MakePaintPrimitive() const
+{
+	FRenderMaterialOnMeshPrimitive Primitive;
+	Primitive.MeshComponent = PaintedComponent;
+	Primitive.DesiredLOD = LOD;
+	Primitive.DesiredUV = UVChannel;
+	Primitive.UVRegion = UVRegion;
+	Primitive.ArraySlice = ArraySlice;
+	Primitive.bReferencePose = bReferencePose;
+	return Primitive;
+}
+
+bool UMeshPaintSurfaceComponent::SharesTargetsWith(const UMeshPaintSurfaceComponent& Other) const
+{
+	return BaseColor == Other.BaseColor && Emissive == Other.Emissive && NormalMap == Other.NormalMap;
+}
+
+void UMeshPaintSurfaceComponent::FindSurfacesInSphere(UWorld* World, const FVector& Center, float Radius, TArray<UMeshPaintSurfaceComponent*>& OutSurfaces)
+{
+	UMeshPaintContextSubsystem* Context = World ? World->GetSubsystem<UMeshPaintContextSubsystem>() : nullptr;
+	if (!Context) return;
+
+	const float RadiusSquared = FMath::Square(Radius);
+	for (UMeshPaintSurfaceComponent* Surface : Context->GetSurfaces())
+	{
+		if (!IsValid(Surface->PaintedComponent)) continue;
+		if (Surface->PaintedComponent->Bounds.GetBox().ComputeSquaredDistanceToPoint(Center) > RadiusSquared) continue;
+		OutSurfaces.Add(Surface);
+	}
+}
+
+void UMeshPaintSurfaceComponent::FindSurfacesInStamps(UWorld* World, TConstArrayView<FMeshPaintBrushStamp> Stamps, TArray<UMeshPaintSurfaceComponent*>& OutSurfaces)
+{
+	UMeshPaintContextSubsystem* Context = World ? World->GetSubsystem<UMeshPaintContextSubsystem>() : nullptr;
+	if (!Context || Stamps.IsEmpty()) return;
+
+	// Surfaces away from every stamp are rejected against the bounds of all stamps before the stamps are tested one by one
+	FBox StampsBounds(ForceInit);
+	for (const FMeshPaintBrushStamp& Stamp : Stamps)
+	{
+		StampsBounds += FBox::BuildAABB(Stamp.Location, FVector(Stamp.Radius));
+	}
+
+	for (UMeshPaintSurfaceComponent* Surface : Context->GetSurfaces())
+	{
+		if (!IsValid(Surface->PaintedComponent)) continue;
+
+		const FBox SurfaceBounds = Surface->PaintedComponent->Bounds.GetBox();
+		if (!SurfaceBounds.Intersect(StampsBounds)) continue;
+
+		for (const FMeshPaintBrushStamp& Stamp : Stamps)
+		{
+			if (SurfaceBounds.ComputeSquaredDistanceToPoint(Stamp.Location) <= FMath::Square(Stamp.Radius))
+			{
+				OutSurfaces.Add(Surface);
+				break;
+			}
+		}
+	}
+}
+
+void UMeshPaintSurfaceComponent::RegisterResidency()
+{
+	UWorld* World = GetWorld();
+	UMeshPaintResidencySubsystem* Residency = World && IsRegistered() ? World->GetSubsystem<UMeshPaintResidencySubsystem>() : nullptr;
+	if (!Residency || !IsValid(PaintedComponent)) return;
+
+	for (UTextureRenderTarget* Target : { BaseColor, Emissive, NormalMap })
+	{
+		if (UTextureRenderTarget2D* Target2D = Cast<UTextureRenderTarget2D>(Target))
+		{
+			Residency->RegisterTarget(Target2D, PaintedComponent);
+		}
+	}
+}
+
+void UMeshPaintSurfaceComponent::UnregisterResidency()
+{
+	UWorld* World = GetWorld();
+	UMeshPaintResidencySubsystem* Residency = World && IsRegistered() ? World->GetSubsystem<UMeshPaintResidencySubsystem>() : nullptr;
+	if (!Residency) return;
+
+	for (UTextureRenderTarget* Target : { BaseColor, Emissive, NormalMap })
+	{
+		if (UTextureRenderTarget2D* Target2D = Cast<UTextureRenderTarget2D>(Target))
+		{
+			Residency->UnregisterTarget(Target2D, PaintedComponent);
+		}
+	}
+}
+
+void UMeshPaintSurfaceComponent::UpdateSurfaceDescriptor()
+{
+	if (DescriptorDataIndex != INDEX_NONE && IsValid(PaintedComponent))
+	{
+		UMeshPainterFunctionLibrary::SetPaintSurfaceDescriptor(PaintedComponent, UVRegion, ArraySlice, DescriptorDataIndex);
+	}
+}
+
+void UMeshPaintSurfaceComponent::PrefetchMeshData()
+{
+	UWorld* World = GetWorld();
+	UStaticMeshComponent* StaticMeshComponent = Cast<UStaticMeshComponent>(PaintedComponent);
+	UStaticMesh* StaticMesh = IsValid(StaticMeshComponent) ? StaticMeshComponent->GetStaticMesh() : nullptr;
+	if (!World || !World->IsGameWorld() || !StaticMesh) return;
+
+	FMeshPaintMeshDataCache& MeshDataCache = UMeshPaintContextSubsystem::UseMeshData(this, StaticMesh);
+	if (LOD < 0)
+	{
+		MeshDataCache.FindOrBuildLODStats(StaticMesh, UVChannel);
+		return;
+	}
+
+	MeshDataCache.FindOrBuildTriangleBVH(StaticMesh, LOD, UVChannel);
+
+	// Island fills build coverage at the texel size of the atlas cell
+	if (UTextureRenderTarget2D* BaseColor2D = Cast<UTextureRenderTarget2D>(BaseColor))
+	{
+		const FVector2D CellSize = UVRegion.GetSize().GetAbs() * FVector2D(BaseColor2D->SizeX, BaseColor2D->SizeY);
+		MeshDataCache.FindOrBuildCoverageMap(StaticMesh, LOD, UVChannel, FIntPoint(FMath::RoundToInt32(CellSize.X), FMath::RoundToInt32(CellSize.Y)));
+	}
+}
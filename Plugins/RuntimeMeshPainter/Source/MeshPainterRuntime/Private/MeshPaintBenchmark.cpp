@@ -0,0 +1,423 @@
+#include "CoreMinimal.h"
+#include "MeshPainterFunctionLibrary.h"
+#include "MeshPainterStats.h"
+#include "RuntimeMeshPainter.h"
+#include "Components/StaticMeshComponent.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "HAL/IConsoleManager.h"
+#include "Materials/Material.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+#include "RenderingThread.h"
+#include "Algo/IndexOf.h"
+#include "Async/Async.h"
+#include "Tickable.h"
+#include "UObject/GCObject.h"
+#include "UObject/Package.h"
+
+class FMeshPaintBenchmark;
+static TUniquePtr<FMeshPaintBenchmark> GMeshPaintBenchmark;
+
+namespace MeshPaintBenchmark
+{
+	/** Names of the three targets of RenderMaterialOnMeshUVAtlasMulti, in parameter order */
+	static const TCHAR* const TargetNames[3] = { TEXT("BC"), TEXT("E"), TEXT("N") };
+
+	/**
+	 * Parses a '+' separated target set like BC+E+N into a mask of TargetNames. Tokens are compared whole and case
+	 * insensitive, so E never matches inside another name. Fails on unknown tokens and empty sets.
+	 */
+	static bool ParseTargetSet(const FString& TargetSet, uint8& OutTargetMask, FString& OutNormalized)
+	{
+		TArray<FString> Tokens;
+		TargetSet.ParseIntoArray(Tokens, TEXT("+"));
+		OutTargetMask = 0;
+		for (const FString& Token : Tokens)
+		{
+			const int32 TargetIndex = Algo::IndexOfByPredicate(TargetNames, [&Token](const TCHAR* Name) { return Token.TrimStartAndEnd().Equals(Name, ESearchCase::IgnoreCase); });
+			if (TargetIndex == INDEX_NONE) return false;
+			OutTargetMask |= 1 << TargetIndex;
+		}
+
+		OutNormalized.Reset();
+		for (int32 TargetIndex = 0; TargetIndex < UE_ARRAY_COUNT(TargetNames); ++TargetIndex)
+		{
+			if (!(OutTargetMask & (1 << TargetIndex))) continue;
+			OutNormalized += OutNormalized.IsEmpty() ? TargetNames[TargetIndex] : FString(TEXT("+")) + TargetNames[TargetIndex];
+		}
+		return OutTargetMask != 0;
+	}
+}
+
+/**
+ * Runs parameterized paint workloads over several frames and records time spent in every stage of a paint call.
+ * Game thread stages are timed around the calls, render thread stages are collected through MeshPaintStats.
+ */
+class FMeshPaintBenchmark : public FTickableGameObject, public FGCObject
+{
+public:
+	struct FCase
+	{
+		int32 NumPrimitives;
+		int32 TargetSize;
+		FString Targets;
+		int32 CallsPerFrame;
+		uint8 TargetMask;
+	};
+
+	struct FResult
+	{
+		FCase Case;
+		int32 NumFrames;
+		int64 NumCalls;
+		double GameThreadSeconds;
+		double StageSeconds[(int32)MeshPaintStats::EStage::Num];
+	};
+
+	FMeshPaintBenchmark(UWorld* InWorld, TArray<FCase>&& InCases, int32 InFrames, int32 InWarmupFrames, UMaterialInterface* InMaterial, const FString& InOutputBase, const FString& InTag)
+		: World(InWorld)
+		, Cases(MoveTemp(InCases))
+		, NumFrames(InFrames)
+		, NumWarmupFrames(InWarmupFrames)
+		, Material(InMaterial)
+		, OutputBase(InOutputBase)
+		, Tag(InTag)
+		, CaseIndex(INDEX_NONE)
+		, FrameIndex(0)
+		, bFinished(false)
+	{
+		FMemory::Memzero(RenderTargets);
+		MeshPaintStats::SetStageTimingEnabled(true);
+	}
+
+	virtual ~FMeshPaintBenchmark()
+	{
+		ReleaseCase();
+		MeshPaintStats::SetStageTimingEnabled(false);
+	}
+
+	bool IsFinished() const { return bFinished; }
+
+	//~ Begin FTickableGameObject Interface
+	virtual void Tick(float DeltaTime) override
+	{
+		if (!World.IsValid())
+		{
+			Finish();
+			return;
+		}
+
+		if (CaseIndex == INDEX_NONE || FrameIndex >= NumWarmupFrames + NumFrames)
+		{
+			if (CaseIndex != INDEX_NONE)
+			{
+				EndCase();
+			}
+			if (++CaseIndex >= Cases.Num())
+			{
+				Finish();
+				return;
+			}
+			BeginCase();
+		}
+
+		if (FrameIndex == NumWarmupFrames)
+		{
+			// Render thread may still be working on warmup frames
+			FlushRenderingCommands();
+			MeshPaintStats::ResetStageTotals();
+			GameThreadSeconds = 0.0;
+			NumCalls = 0;
+		}
+
+		const FCase& Case = Cases[CaseIndex];
+		const double StartTime = FPlatformTime::Seconds();
+		for (int32 CallIndex = 0; CallIndex < Case.CallsPerFrame; ++CallIndex)
+		{
+			UMeshPainterFunctionLibrary::RenderMaterialOnMeshUVAtlasMulti(World.Get(), MakeArrayView(Primitives), Material,
+				RenderTargets[0], RenderTargets[1], RenderTargets[2], FRenderMaterialOnMeshViewConfiguration(), false);
+		}
+		GameThreadSeconds += FPlatformTime::Seconds() - StartTime;
+		NumCalls += Case.CallsPerFrame;
+		++FrameIndex;
+	}
+
+	virtual bool IsTickable() const override { return !bFinished; }
+	virtual bool IsTickableWhenPaused() const override { return true; }
+	virtual bool IsTickableInEditor() const override { return true; }
+	virtual TStatId GetStatId() const override { RETURN_QUICK_DECLARE_CYCLE_STAT(FMeshPaintBenchmark, STATGROUP_Tickables); }
+	//~ End FTickableGameObject Interface
+
+	//~ Begin FGCObject Interface
+	virtual void AddReferencedObjects(FReferenceCollector& Collector) override
+	{
+		Collector.AddReferencedObject(Material);
+		Collector.AddReferencedObjects(Components);
+		for (UTextureRenderTarget2D*& RenderTarget : RenderTargets)
+		{
+			Collector.AddReferencedObject(RenderTarget);
+		}
+	}
+	virtual FString GetReferencerName() const override { return TEXT("FMeshPaintBenchmark"); }
+	//~ End FGCObject Interface
+
+private:
+	void BeginCase()
+	{
+		const FCase& Case = Cases[CaseIndex];
+		FrameIndex = 0;
+
+		UStaticMesh* Mesh = LoadObject<UStaticMesh>(nullptr, TEXT("/Engine/BasicShapes/Sphere.Sphere"));
+		HostActor = World->SpawnActor<AActor>();
+		USceneComponent* Root = NewObject<USceneComponent>(HostActor.Get());
+		HostActor->SetRootComponent(Root);
+		Root->RegisterComponent();
+
+		// Every primitive gets its own atlas cell, so the workload matches atlas painting
+		const int32 CellsPerRow = FMath::CeilToInt32(FMath::Sqrt((float)FMath::Max(Case.NumPrimitives, 1)));
+		const FVector2D CellSize(1.0 / CellsPerRow);
+		for (int32 PrimitiveIndex = 0; PrimitiveIndex < Case.NumPrimitives; ++PrimitiveIndex)
+		{
+			const FIntPoint Cell(PrimitiveIndex % CellsPerRow, PrimitiveIndex / CellsPerRow);
+			UStaticMeshComponent* Component = NewObject<UStaticMeshComponent>(HostActor.Get());
+			Component->SetStaticMesh(Mesh);
+			Component->SetupAttachment(Root);
+			Component->SetRelativeLocation(FVector(Cell.X * 200.0, Cell.Y * 200.0, 0.0));
+			Component->RegisterComponent();
+			Components.Add(Component);
+
+			FRenderMaterialOnMeshPrimitive& Primitive = Primitives.AddDefaulted_GetRef();
+			Primitive.MeshComponent = Component;
+			Primitive.UVRegion = FBox2D(CellSize * FVector2D(Cell), CellSize * FVector2D(Cell + FIntPoint(1)));
+		}
+
+		for (int32 TargetIndex = 0; TargetIndex < 3; ++TargetIndex)
+		{
+			if (!(Case.TargetMask & (1 << TargetIndex))) continue;
+			UTextureRenderTarget2D* RenderTarget = NewObject<UTextureRenderTarget2D>(GetTransientPackage());
+			RenderTarget->RenderTargetFormat = RTF_RGBA8;
+			RenderTarget->InitAutoFormat(Case.TargetSize, Case.TargetSize);
+			RenderTarget->UpdateResourceImmediate(true);
+			RenderTargets[TargetIndex] = RenderTarget;
+		}
+
+		GameThreadSeconds = 0.0;
+		NumCalls = 0;
+	}
+
+	void EndCase()
+	{
+		FlushRenderingCommands();
+
+		FResult& Result = Results.AddDefaulted_GetRef();
+		Result.Case = Cases[CaseIndex];
+		Result.NumFrames = NumFrames;
+		Result.NumCalls = NumCalls;
+		Result.GameThreadSeconds = GameThreadSeconds;
+		uint64 Counts[(int32)MeshPaintStats::EStage::Num];
+		MeshPaintStats::GetStageTotals(Result.StageSeconds, Counts);
+
+		ReleaseCase();
+	}
+
+	void ReleaseCase()
+	{
+		if (HostActor.IsValid())
+		{
+			HostActor->Destroy();
+		}
+		HostActor.Reset();
+		Components.Reset();
+		Primitives.Reset();
+		for (UTextureRenderTarget2D*& RenderTarget : RenderTargets)
+		{
+			if (RenderTarget)
+			{
+				RenderTarget->ReleaseResource();
+			}
+			RenderTarget = nullptr;
+		}
+	}
+
+	void Finish()
+	{
+		if (CaseIndex != INDEX_NONE && CaseIndex < Cases.Num() && FrameIndex > 0)
+		{
+			EndCase();
+		}
+		ReleaseCase();
+		WriteResults();
+		MeshPaintStats::SetStageTimingEnabled(false);
+		bFinished = true;
+
+		// Can't delete ourselves while being ticked
+		AsyncTask(ENamedThreads::GameThread, []()
+		{
+			if (GMeshPaintBenchmark.IsValid() && GMeshPaintBenchmark->IsFinished())
+			{
+				GMeshPaintBenchmark.Reset();
+			}
+		});
+	}
+
+	void WriteResults() const
+	{
+		const int32 NumStages = (int32)MeshPaintStats::EStage::Num;
+
+		FString Csv = TEXT("Tag,Primitives,TargetSize,Targets,CallsPerFrame,Frames,GameThreadMsPerFrame");
+		for (int32 StageIndex = 0; StageIndex < NumStages; ++StageIndex)
+		{
+			Csv += FString::Printf(TEXT(",%sMsPerFrame"), MeshPaintStats::GetStageName((MeshPaintStats::EStage)StageIndex));
+		}
+		Csv += LINE_TERMINATOR;
+
+		TArray<TSharedPtr<FJsonValue>> JsonCases;
+		for (const FResult& Result : Results)
+		{
+			const double MsPerFrame = 1000.0 / FMath::Max(Result.NumFrames, 1);
+			Csv += FString::Printf(TEXT("%s,%d,%d,%s,%d,%d,%.4f"), *Tag, Result.Case.NumPrimitives, Result.Case.TargetSize, *Result.Case.Targets, Result.Case.CallsPerFrame, Result.NumFrames, Result.GameThreadSeconds * MsPerFrame);
+
+			TSharedRef<FJsonObject> JsonCase = MakeShared<FJsonObject>();
+			JsonCase->SetStringField(TEXT("Tag"), Tag);
+			JsonCase->SetNumberField(TEXT("Primitives"), Result.Case.NumPrimitives);
+			JsonCase->SetNumberField(TEXT("TargetSize"), Result.Case.TargetSize);
+			JsonCase->SetStringField(TEXT("Targets"), Result.Case.Targets);
+			JsonCase->SetNumberField(TEXT("CallsPerFrame"), Result.Case.CallsPerFrame);
+			JsonCase->SetNumberField(TEXT("Frames"), Result.NumFrames);
+			JsonCase->SetNumberField(TEXT("GameThreadMsPerFrame"), Result.GameThreadSeconds * MsPerFrame);
+
+			TSharedRef<FJsonObject> JsonStages = MakeShared<FJsonObject>();
+			for (int32 StageIndex = 0; StageIndex < NumStages; ++StageIndex)
+			{
+				Csv += FString::Printf(TEXT(",%.4f"), Result.StageSeconds[StageIndex] * MsPerFrame);
+				JsonStages->SetNumberField(MeshPaintStats::GetStageName((MeshPaintStats::EStage)StageIndex), Result.StageSeconds[StageIndex] * MsPerFrame);
+			}
+			JsonCase->SetObjectField(TEXT("StageMsPerFrame"), JsonStages);
+			JsonCases.Add(MakeShared<FJsonValueObject>(JsonCase));
+			Csv += LINE_TERMINATOR;
+
+			UE_LOG(LogMeshPainter, Display, TEXT("MeshPaint.Benchmark: %d primitives, %dx%d %s, %d calls/frame: %.3f ms/frame on the game thread"),
+				Result.Case.NumPrimitives, Result.Case.TargetSize, Result.Case.TargetSize, *Result.Case.Targets, Result.Case.CallsPerFrame, Result.GameThreadSeconds * MsPerFrame);
+		}
+
+		TSharedRef<FJsonObject> JsonRoot = MakeShared<FJsonObject>();
+		JsonRoot->SetStringField(TEXT("Tag"), Tag);
+		JsonRoot->SetArrayField(TEXT("Cases"), JsonCases);
+		FString Json;
+		FJsonSerializer::Serialize(JsonRoot, TJsonWriterFactory<>::Create(&Json));
+
+		FFileHelper::SaveStringToFile(Csv, *(OutputBase + TEXT(".csv")));
+		FFileHelper::SaveStringToFile(Json, *(OutputBase + TEXT(".json")));
+		UE_LOG(LogMeshPainter, Display, TEXT("MeshPaint.Benchmark: results written to %s.csv/.json"), *OutputBase);
+	}
+
+	TWeakObjectPtr<UWorld> World;
+	TArray<FCase> Cases;
+	int32 NumFrames;
+	int32 NumWarmupFrames;
+	UMaterialInterface* Material;
+	FString OutputBase;
+	FString Tag;
+
+	int32 CaseIndex;
+	int32 FrameIndex;
+	bool bFinished;
+
+	TWeakObjectPtr<AActor> HostActor;
+	TArray<UStaticMeshComponent*> Components;
+	TArray<FRenderMaterialOnMeshPrimitive> Primitives;
+	UTextureRenderTarget2D* RenderTargets[3];
+
+	double GameThreadSeconds;
+	int64 NumCalls;
+	TArray<FResult> Results;
+};
+
+/**
+ * MeshPaint.Benchmark [Primitives=1,16] [Size=512,2048] [Targets=BC,BC+E+N] [Calls=1,8] [Frames=120] [Warmup=10] [Material=/Game/Path] [Tag=CommitId] [Out=Path/Base]
+ * Every comma separated list is a sweep, all combinations are benchmarked. Results go to <Out>.csv and <Out>.json.
+ */
+static FAutoConsoleCommandWithWorldArgsAndOutputDevice GMeshPaintBenchmarkCommand(
+	TEXT("MeshPaint.Benchmark"),
+	TEXT("Benchmarks paint calls and reports time per stage"),
+	FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar)
+	{
+		if (GMeshPaintBenchmark.IsValid() && !GMeshPaintBenchmark->IsFinished())
+		{
+			Ar.Logf(ELogVerbosity::Warning, TEXT("MeshPaint.Benchmark: a benchmark is already running"));
+			return;
+		}
+		if (!World)
+		{
+			Ar.Logf(ELogVerbosity::Error, TEXT("MeshPaint.Benchmark: no world to run in"));
+			return;
+		}
+
+		const FString CommandLine = FString::Join(Args, TEXT(" "));
+		auto ParseIntList = [&CommandLine](const TCHAR* Key, const TCHAR* Default)
+		{
+			FString Value = Default;
+			FParse::Value(*CommandLine, Key, Value, false);
+			TArray<FString> Items;
+			Value.ParseIntoArray(Items, TEXT(","));
+			TArray<int32> Result;
+			for (const FString& Item : Items)
+			{
+				Result.Add(FMath::Max(1, FCString::Atoi(*Item)));
+			}
+			return Result;
+		};
+
+		FString TargetList = TEXT("BC");
+		FParse::Value(*CommandLine, TEXT("Targets="), TargetList, false);
+		TArray<FString> TargetSetList;
+		TargetList.ParseIntoArray(TargetSetList, TEXT(","));
+		TArray<TPair<FString, uint8>> TargetSets;
+		for (const FString& TargetSet : TargetSetList)
+		{
+			FString Normalized;
+			uint8 TargetMask = 0;
+			if (!MeshPaintBenchmark::ParseTargetSet(TargetSet, TargetMask, Normalized))
+			{
+				Ar.Logf(ELogVerbosity::Error, TEXT("MeshPaint.Benchmark: invalid target set '%s', expected '+' separated BC, E and N"), *TargetSet);
+				return;
+			}
+			TargetSets.Emplace(Normalized, TargetMask);
+		}
+
+		TArray<FMeshPaintBenchmark::FCase> Cases;
+		for (const int32 NumPrimitives : ParseIntList(TEXT("Primitives="), TEXT("16")))
+		{
+			for (const int32 Size : ParseIntList(TEXT("Size="), TEXT("1024")))
+			{
+				for (const TPair<FString, uint8>& Targets : TargetSets)
+				{
+					for (const int32 Calls : ParseIntList(TEXT("Calls="), TEXT("1")))
+					{
+						Cases.Add({ NumPrimitives, Size, Targets.Key, Calls, Targets.Value });
+					}
+				}
+			}
+		}
+
+		int32 Frames = 120;
+		int32 Warmup = 10;
+		FString MaterialPath, Tag, OutputBase;
+		FParse::Value(*CommandLine, TEXT("Frames="), Frames);
+		FParse::Value(*CommandLine, TEXT("Warmup="), Warmup);
+		FParse::Value(*CommandLine, TEXT("Material="), MaterialPath);
+		FParse::Value(*CommandLine, TEXT("Tag="), Tag);
+		if (!FParse::Value(*CommandLine, TEXT("Out="), OutputBase))
+		{
+			OutputBase = FPaths::Combine(FPaths::ProfilingDir(), TEXT("MeshPaint"), FString::Printf(TEXT("Benchmark-%s"), *FDateTime::Now().ToString()));
+		}
+
+		UMaterialInterface* Material = MaterialPath.IsEmpty() ? UMaterial::GetDefaultMaterial(MD_Surface) : LoadObject<UMaterialInterface>(nullptr, *MaterialPath);
+		GMeshPaintBenchmark = MakeUnique<FMeshPaintBenchmark>(World, MoveTemp(Cases), FMath::Max(Frames, 1), FMath::Max(Warmup, 0), Material, OutputBase, Tag);
+		Ar.Logf(TEXT("MeshPaint.Benchmark: started"));
+	}));
@@ -0,0 +1,72 @@
+#include "MeshPaintContextSubsystem.h"
+#include "MeshPaintMeshDataCache.h"
+#include "MeshPainterStats.h"
+#include "Engine/World.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Shared paint meshes"), STAT_MeshPaint_SharedMeshes, STATGROUP_MeshPaint);
+
+void UMeshPaintContextSubsystem::Deinitialize()
+{
+	Surfaces.Reset();
+	Mirrors.Reset();
+
+	FMeshPaintMeshDataCache& MeshDataCache = FMeshPaintMeshDataCache::Get();
+	for (const FObjectKey& Mesh : ReferencedMeshes)
+	{
+		MeshDataCache.ReleaseReference(Mesh);
+	}
+	ReferencedMeshes.Reset();
+	SET_DWORD_STAT(STAT_MeshPaint_SharedMeshes, MeshDataCache.GetNumReferencedMeshes());
+
+	Super::Deinitialize();
+}
+
+bool UMeshPaintContextSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	// Preview worlds host paint surfaces too, e.g. in asset editors
+	return WorldType != EWorldType::None && WorldType != EWorldType::Inactive;
+}
+
+UMeshPaintContextSubsystem* UMeshPaintContextSubsystem::Get(const UObject* WorldContextObject)
+{
+	const UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+	return World ? World->GetSubsystem<UMeshPaintContextSubsystem>() : nullptr;
+}
+
+void UMeshPaintContextSubsystem::RegisterSurface(UMeshPaintSurfaceComponent* Surface)
+{
+	Surfaces.AddUnique(Surface);
+}
+
+void UMeshPaintContextSubsystem::UnregisterSurface(UMeshPaintSurfaceComponent* Surface)
+{
+	Surfaces.RemoveSwap(Surface);
+}
+
+void UMeshPaintContextSubsystem::RegisterMirror(UMeshPaintMirrorComponent* Mirror)
+{
+	Mirrors.AddUnique(Mirror);
+}
+
+void UMeshPaintContextSubsystem::UnregisterMirror(UMeshPaintMirrorComponent* Mirror)
+{
+	Mirrors.RemoveSwap(Mirror);
+}
+
+FMeshPaintMeshDataCache& UMeshPaintContextSubsystem::UseMeshData(const UObject* WorldContextObject, const UObject* Mesh)
+{
+	check(IsInGameThread());
+
+	FMeshPaintMeshDataCache& MeshDataCache = FMeshPaintMeshDataCache::Get();
+	UMeshPaintContextSubsystem* Context = Get(WorldContextObject);
+	if (!Context || !Mesh) return MeshDataCache;
+
+	bool bAlreadyReferenced = false;
+	Context->ReferencedMeshes.Add(FObjectKey(Mesh), &bAlreadyReferenced);
+	if (!bAlreadyReferenced)
+	{
+		MeshDataCache.AddReference(FObjectKey(Mesh));
+		SET_DWORD_STAT(STAT_MeshPaint_SharedMeshes, MeshDataCache.GetNumReferencedMeshes());
+	}
+	return MeshDataCache;
+}
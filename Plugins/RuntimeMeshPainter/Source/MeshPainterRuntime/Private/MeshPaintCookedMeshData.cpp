@@ -0,0 +1,140 @@
+#include "MeshPaintCookedMeshData.h"
+#include "MeshPaintMeshDataCache.h"
+#include "MeshPaintTriangleBVH.h"
+#include "MeshPaintCoverageMap.h"
+#include "RuntimeMeshPainter.h"
+#include "Engine/StaticMesh.h"
+#include "UObject/ObjectSaveContext.h"
+
+namespace MeshPaintCookedMeshData
+{
+	template<typename DataType>
+	static void SerializeData(FArchive& Ar, TSharedPtr<DataType>& Data)
+	{
+		bool bValid = Data.IsValid();
+		Ar << bValid;
+		if (!bValid) return;
+
+		if (Ar.IsLoading())
+		{
+			Data = MakeShared<DataType>();
+		}
+		Ar << *Data;
+	}
+
+	template<typename DataType>
+	static TSharedPtr<DataType> ToShared(TUniquePtr<DataType>&& Data)
+	{
+		return TSharedPtr<DataType>(Data.Release());
+	}
+}
+
+void UMeshPaintCookedMeshData::Serialize(FArchive& Ar)
+{
+	Super::Serialize(Ar);
+
+	// Only cooked packages carry data, editor builds get it from the derived data cache
+	bool bCooked = Ar.IsCooking();
+	Ar << bCooked;
+	if (!bCooked) return;
+
+	int32 NumLODs = CookedLODs.Num();
+	Ar << NumLODs;
+	if (Ar.IsLoading())
+	{
+		CookedLODs.SetNum(NumLODs);
+	}
+	for (FCookedLOD& CookedLOD : CookedLODs)
+	{
+		Ar << CookedLOD.LODIndex;
+		Ar << CookedLOD.UVChannel;
+		MeshPaintCookedMeshData::SerializeData(Ar, CookedLOD.TriangleBVH);
+
+		int32 NumCoverageMaps = CookedLOD.CoverageMaps.Num();
+		Ar << NumCoverageMaps;
+		if (Ar.IsLoading())
+		{
+			CookedLOD.CoverageMaps.SetNum(NumCoverageMaps);
+		}
+		for (TPair<FIntPoint, TSharedPtr<FMeshPaintCoverageMap>>& CoverageMap : CookedLOD.CoverageMaps)
+		{
+			Ar << CoverageMap.Key;
+			MeshPaintCookedMeshData::SerializeData(Ar, CoverageMap.Value);
+		}
+	}
+
+	int32 NumLODStats = CookedLODStats.Num();
+	Ar << NumLODStats;
+	if (Ar.IsLoading())
+	{
+		CookedLODStats.SetNum(NumLODStats);
+	}
+	for (TPair<int32, TSharedPtr<FMeshPaintLODStats>>& LODStats : CookedLODStats)
+	{
+		Ar << LODStats.Key;
+		MeshPaintCookedMeshData::SerializeData(Ar, LODStats.Value);
+	}
+}
+
+#if WITH_EDITOR
+void UMeshPaintCookedMeshData::PreSave(FObjectPreSaveContext SaveContext)
+{
+	Super::PreSave(SaveContext);
+
+	if (SaveContext.IsCooking())
+	{
+		BuildCookedData();
+	}
+}
+
+void UMeshPaintCookedMeshData::BuildCookedData()
+{
+	CookedLODs.Reset();
+	CookedLODStats.Reset();
+
+	UStaticMesh* StaticMesh = Cast<UStaticMesh>(GetOuter());
+	if (!StaticMesh)
+	{
+		UE_LOG(LogMeshPainter, Warning, TEXT("%s is not owned by a static mesh, no paint data is cooked"), *GetPathName());
+		return;
+	}
+
+	for (const FMeshPaintCookedMeshDataSettings& Setting : Settings)
+	{
+		FCookedLOD& CookedLOD = CookedLODs.AddDefaulted_GetRef();
+		CookedLOD.LODIndex = Setting.LOD;
+		CookedLOD.UVChannel = Setting.UVChannel;
+		CookedLOD.TriangleBVH = MeshPaintCookedMeshData::ToShared(FMeshPaintMeshDataCache::BuildTriangleBVH(StaticMesh, Setting.LOD, Setting.UVChannel));
+		for (const FIntPoint& Resolution : Setting.CoverageResolutions)
+		{
+			CookedLOD.CoverageMaps.Emplace(Resolution, MeshPaintCookedMeshData::ToShared(FMeshPaintMeshDataCache::BuildCoverageMap(StaticMesh, Setting.LOD, Setting.UVChannel, Resolution)));
+		}
+
+		if (!CookedLODStats.ContainsByPredicate([&Setting](const TPair<int32, TSharedPtr<FMeshPaintLODStats>>& LODStats) { return LODStats.Key == Setting.UVChannel; }))
+		{
+			CookedLODStats.Emplace(Setting.UVChannel, MeshPaintCookedMeshData::ToShared(FMeshPaintMeshDataCache::BuildLODStats(StaticMesh, Setting.UVChannel)));
+		}
+	}
+}
+#endif
+
+TSharedPtr<const FMeshPaintTriangleBVH> UMeshPaintCookedMeshData::FindTriangleBVH(int32 LODIndex, int32 UVChannel) const
+{
+	const FCookedLOD* CookedLOD = CookedLODs.FindByPredicate([LODIndex, UVChannel](const FCookedLOD& LOD) { return LOD.LODIndex == LODIndex && LOD.UVChannel == UVChannel; });
+	return CookedLOD ? CookedLOD->TriangleBVH : nullptr;
+}
+
+TSharedPtr<const FMeshPaintLODStats> UMeshPaintCookedMeshData::FindLODStats(int32 UVChannel) const
+{
+	const TPair<int32, TSharedPtr<FMeshPaintLODStats>>* LODStats = CookedLODStats.FindByPredicate([UVChannel](const TPair<int32, TSharedPtr<FMeshPaintLODStats>>& Stats) { return Stats.Key == UVChannel; });
+	return LODStats ? LODStats->Value : nullptr;
+}
+
+TSharedPtr<const FMeshPaintCoverageMap> UMeshPaintCookedMeshData::FindCoverageMap(int32 LODIndex, int32 UVChannel, FIntPoint Resolution) const
+{
+	const FCookedLOD* CookedLOD = CookedLODs.FindByPredicate([LODIndex, UVChannel](const FCookedLOD& LOD) { return LOD.LODIndex == LODIndex && LOD.UVChannel == UVChannel; });
+	if (!CookedLOD) return nullptr;
+
+	const TPair<FIntPoint, TSharedPtr<FMeshPaintCoverageMap>>* CoverageMap = CookedLOD->CoverageMaps.FindByPredicate([Resolution](const TPair<FIntPoint, TSharedPtr<FMeshPaintCoverageMap>>& Map) { return Map.Key == Resolution; });
+	return CoverageMap ? CoverageMap->Value : nullptr;
+}
@@ -0,0 +1,202 @@
+#include "MeshPaintCoverageMap.h"
+#include "MeshPaintUVRasterizer.h"
+#include "MeshPainterStats.h"
+#include "Async/ParallelFor.h"
+#include "Engine/Texture2D.h"
+#include "TextureResource.h"
+
+namespace MeshPaintCoverageMap
+{
+	static constexpr int32 TileSize = 64;
+
+	static int32 FindRoot(TArray<int32>& Parents, int32 Index)
+	{
+		while (Parents[Index] != Index)
+		{
+			Parents[Index] = Parents[Parents[Index]];
+			Index = Parents[Index];
+		}
+		return Index;
+	}
+
+	static void Union(TArray<int32>& Parents, int32 A, int32 B)
+	{
+		A = FindRoot(Parents, A);
+		B = FindRoot(Parents, B);
+		if (A != B)
+		{
+			Parents[FMath::Max(A, B)] = FMath::Min(A, B);
+		}
+	}
+}
+
+void FMeshPaintCoverageMap::Build(TConstArrayView<FVector2f> UVs, TConstArrayView<uint32> Indices, FIntPoint InSize, bool bMultithreaded)
+{
+	MESH_PAINT_TRACE_SCOPE(BuildCoverageMap);
+
+	Size = InSize.ComponentMax(FIntPoint::ZeroValue);
+	NumTriangles = Indices.Num() / 3;
+	NumCoveredTexels = 0;
+	TriangleIds.SetNumZeroed(Size.X * Size.Y);
+	TriangleIslands.Reset();
+	IslandBounds.Reset();
+	IslandTexelCounts.Reset();
+
+	// Render data splits vertices along normal and tangent seams, weld them by UV so only real UV seams separate islands
+	TArray<int32> Parents;
+	Parents.SetNumUninitialized(UVs.Num());
+	TMap<FVector2f, int32> FirstVertexOfUV;
+	FirstVertexOfUV.Reserve(UVs.Num());
+	for (int32 VertexIndex = 0; VertexIndex < UVs.Num(); ++VertexIndex)
+	{
+		Parents[VertexIndex] = FirstVertexOfUV.FindOrAdd(UVs[VertexIndex], VertexIndex);
+	}
+	for (int32 TriangleIndex = 0; TriangleIndex < NumTriangles; ++TriangleIndex)
+	{
+		MeshPaintCoverageMap::Union(Parents, Indices[TriangleIndex * 3 + 0], Indices[TriangleIndex * 3 + 1]);
+		MeshPaintCoverageMap::Union(Parents, Indices[TriangleIndex * 3 + 0], Indices[TriangleIndex * 3 + 2]);
+	}
+
+	TMap<int32, int32> IslandOfRoot;
+	TriangleIslands.SetNumUninitialized(NumTriangles);
+	for (int32 TriangleIndex = 0; TriangleIndex < NumTriangles; ++TriangleIndex)
+	{
+		const int32 Root = MeshPaintCoverageMap::FindRoot(Parents, Indices[TriangleIndex * 3]);
+		TriangleIslands[TriangleIndex] = IslandOfRoot.FindOrAdd(Root, IslandOfRoot.Num());
+	}
+	IslandBounds.Init(FIntRect(Size, FIntPoint::ZeroValue), IslandOfRoot.Num());
+	IslandTexelCounts.SetNumZeroed(IslandOfRoot.Num());
+
+	if (Size.X == 0 || Size.Y == 0) return;
+
+	// Bin triangles into tiles keeping index buffer order, overlapping triangles resolve like the GPU pass does
+	const FIntPoint NumTiles((Size.X + MeshPaintCoverageMap::TileSize - 1) / MeshPaintCoverageMap::TileSize, (Size.Y + MeshPaintCoverageMap::TileSize - 1) / MeshPaintCoverageMap::TileSize);
+	TArray<TArray<int32>> TileTriangles;
+	TileTriangles.SetNum(NumTiles.X * NumTiles.Y);
+	for (int32 TriangleIndex = 0; TriangleIndex < NumTriangles; ++TriangleIndex)
+	{
+		const FVector2f P0 = UVs[Indices[TriangleIndex * 3 + 0]] * FVector2f(Size);
+		const FVector2f P1 = UVs[Indices[TriangleIndex * 3 + 1]] * FVector2f(Size);
+		const FVector2f P2 = UVs[Indices[TriangleIndex * 3 + 2]] * FVector2f(Size);
+		const FVector2f Min = FVector2f::Min(P0, FVector2f::Min(P1, P2));
+		const FVector2f Max = FVector2f::Max(P0, FVector2f::Max(P1, P2));
+		if (Max.X < 0.0f || Max.Y < 0.0f || Min.X > Size.X || Min.Y > Size.Y) continue;
+
+		const int32 MinTileX = FMath::Clamp(FMath::FloorToInt32(Min.X) / MeshPaintCoverageMap::TileSize, 0, NumTiles.X - 1);
+		const int32 MinTileY = FMath::Clamp(FMath::FloorToInt32(Min.Y) / MeshPaintCoverageMap::TileSize, 0, NumTiles.Y - 1);
+		const int32 MaxTileX = FMath::Clamp(FMath::CeilToInt32(Max.X) / MeshPaintCoverageMap::TileSize, 0, NumTiles.X - 1);
+		const int32 MaxTileY = FMath::Clamp(FMath::CeilToInt32(Max.Y) / MeshPaintCoverageMap::TileSize, 0, NumTiles.Y - 1);
+		for (int32 TileY = MinTileY; TileY <= MaxTileY; ++TileY)
+		{
+			for (int32 TileX = MinTileX; TileX <= MaxTileX; ++TileX)
+			{
+				TileTriangles[TileY * NumTiles.X + TileX].Add(TriangleIndex);
+			}
+		}
+	}
+
+	ParallelFor(TEXT("MeshPaintCoverageMap"), TileTriangles.Num(), 1, [&](int32 TileIndex)
+	{
+		const FIntPoint TileMin((TileIndex % NumTiles.X) * MeshPaintCoverageMap::TileSize, (TileIndex / NumTiles.X) * MeshPaintCoverageMap::TileSize);
+		const FIntRect TileRect(TileMin, (TileMin + FIntPoint(MeshPaintCoverageMap::TileSize)).ComponentMin(Size));
+
+		for (const int32 TriangleIndex : TileTriangles[TileIndex])
+		{
+			MeshPaintUVRaster::RasterizeTriangle(
+				UVs[Indices[TriangleIndex * 3 + 0]] * FVector2f(Size),
+				UVs[Indices[TriangleIndex * 3 + 1]] * FVector2f(Size),
+				UVs[Indices[TriangleIndex * 3 + 2]] * FVector2f(Size),
+				TileRect,
+				[&](int32 X, int32 Y, int32 LaneMask, const VectorRegister4Float&, const VectorRegister4Float&, const VectorRegister4Float&)
+				{
+					for (int32 Lane = 0; Lane < MeshPaintUVRaster::LaneCount; ++Lane)
+					{
+						if (LaneMask & (1 << Lane))
+						{
+							TriangleIds[Y * Size.X + X + Lane] = (uint32)TriangleIndex + 1;
+						}
+					}
+				});
+		}
+	}, bMultithreaded ? EParallelForFlags::None : EParallelForFlags::ForceSingleThread);
+
+	for (int32 Y = 0; Y < Size.Y; ++Y)
+	{
+		for (int32 X = 0; X < Size.X; ++X)
+		{
+			const int32 IslandIndex = GetIsland(X, Y);
+			if (IslandIndex == INDEX_NONE) continue;
+
+			FIntRect& Bounds = IslandBounds[IslandIndex];
+			Bounds.Min = Bounds.Min.ComponentMin(FIntPoint(X, Y));
+			Bounds.Max = Bounds.Max.ComponentMax(FIntPoint(X + 1, Y + 1));
+			IslandTexelCounts[IslandIndex]++;
+			NumCoveredTexels++;
+		}
+	}
+
+	// Islands without a covered texel keep an empty rectangle
+	for (FIntRect& Bounds : IslandBounds)
+	{
+		if (Bounds.Min.X >= Bounds.Max.X)
+		{
+			Bounds = FIntRect();
+		}
+	}
+}
+
+FIntPoint FMeshPaintCoverageMap::UVToTexel(const FVector2f& UV) const
+{
+	const FIntPoint Texel(FMath::FloorToInt32(UV.X * Size.X), FMath::FloorToInt32(UV.Y * Size.Y));
+	return FIntPoint(
+		Texel.X >= 0 && Texel.X < Size.X ? Texel.X : INDEX_NONE,
+		Texel.Y >= 0 && Texel.Y < Size.Y ? Texel.Y : INDEX_NONE);
+}
+
+UTexture2D* FMeshPaintCoverageMap::CreateTexture(UObject* Outer, FName Name) const
+{
+	check(IsInGameThread());
+	if (!IsValid()) return nullptr;
+
+	UTexture2D* Texture = UTexture2D::CreateTransient(Size.X, Size.Y, PF_G32R32F, Name);
+	if (!Texture) return nullptr;
+
+	if (Outer)
+	{
+		Texture->Rename(nullptr, Outer, REN_DontCreateRedirectors | REN_NonTransactional);
+	}
+	Texture->Filter = TF_Nearest;
+	Texture->SRGB = false;
+	Texture->NeverStream = true;
+	Texture->AddressX = TA_Clamp;
+	Texture->AddressY = TA_Clamp;
+
+	FTexture2DMipMap& Mip = Texture->GetPlatformData()->Mips[0];
+	FVector2f* Texels = static_cast<FVector2f*>(Mip.BulkData.Lock(LOCK_READ_WRITE));
+	for (int32 TexelIndex = 0; TexelIndex < TriangleIds.Num(); ++TexelIndex)
+	{
+		const int32 TriangleIndex = (int32)TriangleIds[TexelIndex] - 1;
+		Texels[TexelIndex] = FVector2f((float)TriangleIds[TexelIndex], TriangleIndex != INDEX_NONE ? (float)(TriangleIslands[TriangleIndex] + 1) : 0.0f);
+	}
+	Mip.BulkData.Unlock();
+
+	Texture->UpdateResource();
+	return Texture;
+}
+
+SIZE_T FMeshPaintCoverageMap::GetAllocatedSize() const
+{
+	return TriangleIds.GetAllocatedSize() + TriangleIslands.GetAllocatedSize() + IslandBounds.GetAllocatedSize() + IslandTexelCounts.GetAllocatedSize();
+}
+
+FArchive& operator<<(FArchive& Ar, FMeshPaintCoverageMap& Map)
+{
+	Ar << Map.Size;
+	Ar << Map.NumTriangles;
+	Ar << Map.NumCoveredTexels;
+	Ar << Map.TriangleIds;
+	Ar << Map.TriangleIslands;
+	Ar << Map.IslandBounds;
+	Ar << Map.IslandTexelCounts;
+	return Ar;
+}
@@ -0,0 +1,237 @@
+#include "MeshPaintDecaySubsystem.h"
+#include "MeshPaintResidencySubsystem.h"
+#include "MeshPainterRender.h"
+#include "MeshPainterStats.h"
+#include "RuntimeMeshPainter.h"
+#include "Engine/TextureRenderTarget2D.h"
+#include "Engine/World.h"
+#include "TextureResource.h"
+#include "RenderGraphBuilder.h"
+
+static int32 GMeshPaintDecayTileSize = 32;
+static FAutoConsoleVariableRef CVarMeshPaintDecayTileSize(
+	TEXT("r.MeshPaint.Decay.TileSize"),
+	GMeshPaintDecayTileSize,
+	TEXT("Size in texels of the tiles decay is tracked and applied in, rounded to a multiple of 8. Applies to targets registered afterwards"));
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Decaying paint tiles"), STAT_MeshPaint_DecayTiles, STATGROUP_MeshPaint);
+
+namespace MeshPaintDecay
+{
+	/** Smallest change a format stores near one, smaller fades are accumulated over frames */
+	static float GetQuantum(EPixelFormat Format)
+	{
+		switch (Format)
+		{
+		case PF_B8G8R8A8:
+		case PF_R8G8B8A8:
+		case PF_R8G8:
+		case PF_G8:
+		case PF_R8:
+			return 1.0f / 255.0f;
+		case PF_A2B10G10R10:
+			return 1.0f / 1023.0f;
+		case PF_G16:
+		case PF_G16R16:
+		case PF_R16G16B16A16_UNORM:
+			return 1.0f / 65535.0f;
+		case PF_FloatRGBA:
+		case PF_G16R16F:
+		case PF_R16F:
+			return 1.0f / 1024.0f;
+		default:
+			return 0.0f;
+		}
+	}
+}
+
+void UMeshPaintDecaySubsystem::Deinitialize()
+{
+	Targets.Reset();
+	SET_DWORD_STAT(STAT_MeshPaint_DecayTiles, 0);
+
+	Super::Deinitialize();
+}
+
+TStatId UMeshPaintDecaySubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UMeshPaintDecaySubsystem, STATGROUP_Tickables);
+}
+
+UMeshPaintDecaySubsystem::FDecayTarget* UMeshPaintDecaySubsystem::FindTarget(const UTextureRenderTarget2D* Target)
+{
+	return Targets.FindByPredicate([Target](const FDecayTarget& DecayTarget) { return DecayTarget.Target.Get() == Target; });
+}
+
+void UMeshPaintDecaySubsystem::ResetTiles(FDecayTarget& DecayTarget) const
+{
+	const UTextureRenderTarget2D* Target = DecayTarget.Target.Get();
+	DecayTarget.TargetSize = FIntPoint(Target->SizeX, Target->SizeY);
+	DecayTarget.NumTiles = FIntPoint(FMath::DivideAndRoundUp(Target->SizeX, DecayTarget.TileSize), FMath::DivideAndRoundUp(Target->SizeY, DecayTarget.TileSize));
+	DecayTarget.MaxExpireTime = GetExpireTime(DecayTarget);
+	DecayTarget.TileExpireTimes.Init(DecayTarget.MaxExpireTime, DecayTarget.NumTiles.X * DecayTarget.NumTiles.Y);
+}
+
+double UMeshPaintDecaySubsystem::GetExpireTime(const FDecayTarget& DecayTarget) const
+{
+	return GetWorld()->GetTimeSeconds() + (DecayTarget.MaxValue + DecayTarget.Quantum) / DecayTarget.FadePerSecond;
+}
+
+bool UMeshPaintDecaySubsystem::RegisterDecayTarget(UTextureRenderTarget2D* Target, float FadePerSecond, FLinearColor ChannelMask, float MaxValue)
+{
+	check(IsInGameThread());
+	if (!IsValid(Target) || FadePerSecond <= 0.0f || Target->SizeX <= 0 || Target->SizeY <= 0) return false;
+
+	const ETextureCreateFlags Flags = Target->bCanCreateUAV ? TexCreate_UAV : TexCreate_None;
+	if (!MeshPaintRender::SupportsDecay(Target->GetFormat(), Flags))
+	{
+		UE_LOG(LogMeshPainter, Warning, TEXT("Paint decay needs %s to be UAV capable with a format supporting typed UAV loads"), *Target->GetPathName());
+		return false;
+	}
+
+	FDecayTarget* DecayTarget = FindTarget(Target);
+	if (!DecayTarget)
+	{
+		DecayTarget = &Targets.AddDefaulted_GetRef();
+		DecayTarget->Target = Target;
+	}
+
+	DecayTarget->FadePerSecond = FadePerSecond;
+	DecayTarget->MaxValue = FMath::Max(MaxValue, 0.0f);
+	DecayTarget->ChannelMask = FVector4f(ChannelMask);
+	DecayTarget->TileSize = FMath::Clamp(FMath::DivideAndRoundUp(GMeshPaintDecayTileSize, 8) * 8, 8, 256);
+	DecayTarget->Quantum = MeshPaintDecay::GetQuantum(Target->GetFormat());
+	DecayTarget->PendingAmount = 0.0f;
+	ResetTiles(*DecayTarget);
+	return true;
+}
+
+void UMeshPaintDecaySubsystem::UnregisterDecayTarget(UTextureRenderTarget2D* Target)
+{
+	check(IsInGameThread());
+	Targets.RemoveAllSwap([Target](const FDecayTarget& DecayTarget) { return DecayTarget.Target.Get() == Target; });
+}
+
+void UMeshPaintDecaySubsystem::MarkPainted(UTextureRenderTarget2D* Target, const FBox2D& UVRect)
+{
+	FDecayTarget* DecayTarget = FindTarget(Target);
+	if (!DecayTarget || !UVRect.bIsValid) return;
+
+	if (DecayTarget->TargetSize != FIntPoint(Target->SizeX, Target->SizeY))
+	{
+		ResetTiles(*DecayTarget);
+		return;
+	}
+
+	const FVector2D TileScale = FVector2D(Target->SizeX, Target->SizeY) / DecayTarget->TileSize;
+	const FIntPoint MinTile(
+		FMath::Clamp(FMath::FloorToInt32(UVRect.Min.X * TileScale.X), 0, DecayTarget->NumTiles.X - 1),
+		FMath::Clamp(FMath::FloorToInt32(UVRect.Min.Y * TileScale.Y), 0, DecayTarget->NumTiles.Y - 1));
+	const FIntPoint MaxTile(
+		FMath::Clamp(FMath::CeilToInt32(UVRect.Max.X * TileScale.X), 1, DecayTarget->NumTiles.X),
+		FMath::Clamp(FMath::CeilToInt32(UVRect.Max.Y * TileScale.Y), 1, DecayTarget->NumTiles.Y));
+
+	const double ExpireTime = GetExpireTime(*DecayTarget);
+	DecayTarget->MaxExpireTime = FMath::Max(DecayTarget->MaxExpireTime, ExpireTime);
+	for (int32 TileY = MinTile.Y; TileY < MaxTile.Y; ++TileY)
+	{
+		for (int32 TileX = MinTile.X; TileX < MaxTile.X; ++TileX)
+		{
+			DecayTarget->TileExpireTimes[TileY * DecayTarget->NumTiles.X + TileX] = ExpireTime;
+		}
+	}
+}
+
+void UMeshPaintDecaySubsystem::MarkTargetsPainted(UWorld* World, TConstArrayView<UTextureRenderTarget2D*> InTargets, const FBox2D& UVRect)
+{
+	UMeshPaintDecaySubsystem* Subsystem = World ? World->GetSubsystem<UMeshPaintDecaySubsystem>() : nullptr;
+	if (!Subsystem || Subsystem->Targets.IsEmpty()) return;
+
+	for (UTextureRenderTarget2D* Target : InTargets)
+	{
+		if (Target)
+		{
+			Subsystem->MarkPainted(Target, UVRect);
+		}
+	}
+}
+
+void UMeshPaintDecaySubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+	MESH_PAINT_TRACE_SCOPE(DecayTick);
+
+	const double Now = GetWorld()->GetTimeSeconds();
+	Targets.RemoveAllSwap([](const FDecayTarget& DecayTarget) { return !DecayTarget.Target.IsValid(); });
+
+	NumActiveTiles = 0;
+	TArray<TPair<FTextureRenderTargetResource*, FMeshPaintDecayParameters>> Passes;
+	for (FDecayTarget& DecayTarget : Targets)
+	{
+		// A resized target holds new content, painted or not
+		if (DecayTarget.TargetSize != FIntPoint(DecayTarget.Target->SizeX, DecayTarget.Target->SizeY))
+		{
+			ResetTiles(DecayTarget);
+		}
+
+		// A tile fades during the tick in which it expires as well, a target without such tile has nothing left to fade
+		if (DecayTarget.MaxExpireTime <= Now - DeltaTime)
+		{
+			DecayTarget.PendingAmount = 0.0f;
+			continue;
+		}
+
+		// Targets being evicted keep the remaining life of their tiles, a fade applied after their readback would be lost
+		FTextureRenderTargetResource* Resource = DecayTarget.Target->GameThread_GetRenderTargetResource();
+		if (!Resource || !UMeshPaintResidencySubsystem::IsTargetResident(GetWorld(), DecayTarget.Target.Get()))
+		{
+			for (double& ExpireTime : DecayTarget.TileExpireTimes)
+			{
+				ExpireTime += ExpireTime > Now - DeltaTime ? DeltaTime : 0.0;
+			}
+			DecayTarget.MaxExpireTime += DeltaTime;
+			continue;
+		}
+
+		FMeshPaintDecayParameters Params;
+		for (int32 TileIndex = 0; TileIndex < DecayTarget.TileExpireTimes.Num(); ++TileIndex)
+		{
+			if (DecayTarget.TileExpireTimes[TileIndex] > Now - DeltaTime)
+			{
+				Params.Tiles.Emplace(TileIndex % DecayTarget.NumTiles.X, TileIndex / DecayTarget.NumTiles.X);
+			}
+		}
+
+		if (Params.Tiles.IsEmpty())
+		{
+			DecayTarget.PendingAmount = 0.0f;
+			continue;
+		}
+
+		NumActiveTiles += Params.Tiles.Num();
+		DecayTarget.PendingAmount += DecayTarget.FadePerSecond * DeltaTime;
+		if (DecayTarget.PendingAmount < DecayTarget.Quantum) continue;
+
+		Params.TileSize = DecayTarget.TileSize;
+		Params.Amount = DecayTarget.ChannelMask * DecayTarget.PendingAmount;
+		DecayTarget.PendingAmount = 0.0f;
+
+		Passes.Emplace(Resource, MoveTemp(Params));
+	}
+
+	// One graph for all targets, so their passes share a single fork and join of the async compute queue
+	if (!Passes.IsEmpty())
+	{
+		ENQUEUE_RENDER_COMMAND(MeshPaintDecayCommand)([Passes = MoveTemp(Passes)](FRHICommandListImmediate& RHICmdList)
+		{
+			FRDGBuilder GraphBuilder(RHICmdList);
+			for (const TPair<FTextureRenderTargetResource*, FMeshPaintDecayParameters>& Pass : Passes)
+			{
+				MeshPaintRender::AddDecayPass(GraphBuilder, Pass.Key, Pass.Value);
+			}
+			GraphBuilder.Execute();
+		});
+	}
+
+	SET_DWORD_STAT(STAT_MeshPaint_DecayTiles, NumActiveTiles);
+}
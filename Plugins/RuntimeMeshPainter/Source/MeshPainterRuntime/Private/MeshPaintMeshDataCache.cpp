@@ -0,0 +1,588 @@
+#include "MeshPaintMeshDataCache.h"
+#include "MeshPaintTriangleBVH.h"
+#include "MeshPaintCoverageMap.h"
+#include "RuntimeMeshPainter.h"
+#include "Engine/StaticMesh.h"
+#include "StaticMeshResources.h"
+#include "Engine/SkinnedAsset.h"
+#include "Rendering/SkeletalMeshRenderData.h"
+#include "Engine/Texture2D.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "MeshPaintCookedMeshData.h"
+#if WITH_EDITOR
+#include "StaticMeshAttributes.h"
+#include "DerivedDataCacheInterface.h"
+#endif
+
+static int32 GMeshPaintMeshDataAsyncBuild = 1;
+static FAutoConsoleVariableRef CVarMeshPaintMeshDataAsyncBuild(
+	TEXT("r.MeshPaint.MeshData.AsyncBuild"),
+	GMeshPaintMeshDataAsyncBuild,
+	TEXT("Build paint triangle hierarchies, LOD statistics and coverage maps on worker threads, lookups return nothing until they are ready. 0 builds them in the lookup"));
+
+static float GMeshPaintMeshDataRetryDelay = 10.0f;
+static FAutoConsoleVariableRef CVarMeshPaintMeshDataRetryDelay(
+	TEXT("r.MeshPaint.MeshData.RetryDelay"),
+	GMeshPaintMeshDataRetryDelay,
+	TEXT("Seconds before a lookup starts a failed mesh data build again, e.g. once CPU access has been enabled on the mesh. Negative keeps failures until the mesh is invalidated"));
+
+namespace MeshPaintCoverageMap
+{
+	/** Bump when the coverage map layout or rasterization changes */
+	static const TCHAR* DerivedDataVersion = TEXT("9C1A3E4D7B2F4C0E8A6D5B3F1E2C7A90");
+
+	static constexpr int32 MaxResolution = 8192;
+}
+
+namespace MeshPaintLODStats
+{
+	static float ComputeMedianTriangleSize(TConstArrayView<FVector2f> UVs, TConstArrayView<uint32> Indices)
+	{
+		TArray<float> Sizes;
+		Sizes.Reserve(Indices.Num() / 3);
+		for (int32 Index = 0; Index + 2 < Indices.Num(); Index += 3)
+		{
+			const FVector2f& UV0 = UVs[Indices[Index + 0]];
+			const FVector2f& UV1 = UVs[Indices[Index + 1]];
+			const FVector2f& UV2 = UVs[Indices[Index + 2]];
+			const float TwiceArea = FMath::Abs(FVector2f::CrossProduct(UV1 - UV0, UV2 - UV0));
+			if (TwiceArea > 0.0f)
+			{
+				Sizes.Add(FMath::Sqrt(TwiceArea));
+			}
+		}
+		if (Sizes.IsEmpty()) return 0.0f;
+
+		Sizes.Sort();
+		return Sizes[Sizes.Num() / 2];
+	}
+
+	/** Assumes the UV layout covers half of the unit square with triangles of equal size */
+	static float EstimateTriangleSize(int32 NumTriangles)
+	{
+		return NumTriangles > 0 ? FMath::Sqrt(1.0f / NumTriangles) : 0.0f;
+	}
+}
+
+namespace MeshPaintMeshData
+{
+	/** Bump when the layout or build of the data changes */
+	static const TCHAR* TriangleBVHVersion = TEXT("4E7B2C91A0D34F8E9B16C5D27A83E0F4");
+	static const TCHAR* LODStatsVersion = TEXT("B3D85A6E1F2C4079A8E4D61C92F7035B");
+
+	/** Earliest time a failed build may start again */
+	static double GetRetryTime()
+	{
+		return GMeshPaintMeshDataRetryDelay >= 0.0f ? FPlatformTime::Seconds() + GMeshPaintMeshDataRetryDelay : TNumericLimits<double>::Max();
+	}
+
+	/** Geometry of a mesh LOD copied on the game thread, builds on workers never touch the mesh. Builds which do not need positions leave them empty */
+	struct FLODGeometry
+	{
+		int32 NumTriangles = 0;
+		TArray<FVector3f> Positions;
+		TArray<FVector2f> UVs;
+		TArray<uint32> Indices;
+	};
+
+	/** Key of mesh data in the derived data cache, empty outside of the editor or when the render data has no key */
+	static FString MakeDerivedDataKey(const UStaticMesh* StaticMesh, const TCHAR* Type, const TCHAR* Version, const FString& Settings)
+	{
+#if WITH_EDITOR
+		const FString& MeshKey = StaticMesh->GetRenderData()->DerivedDataKey;
+		if (!MeshKey.IsEmpty())
+		{
+			return FDerivedDataCacheInterface::BuildCacheKey(Type, Version, *(MeshKey + Settings));
+		}
+#endif
+		return FString();
+	}
+
+	static FString MakeTriangleBVHKey(const UStaticMesh* StaticMesh, int32 LODIndex, int32 UVChannel)
+	{
+		return MakeDerivedDataKey(StaticMesh, TEXT("MESHPAINTBVH"), TriangleBVHVersion, FString::Printf(TEXT("_%d_%d"), LODIndex, UVChannel));
+	}
+
+	static FString MakeLODStatsKey(const UStaticMesh* StaticMesh, int32 UVChannel)
+	{
+		return MakeDerivedDataKey(StaticMesh, TEXT("MESHPAINTLODSTATS"), LODStatsVersion, FString::Printf(TEXT("_%d"), UVChannel));
+	}
+
+	static FString MakeCoverageMapKey(const UStaticMesh* StaticMesh, int32 LODIndex, int32 UVChannel, FIntPoint Resolution)
+	{
+		return MakeDerivedDataKey(StaticMesh, TEXT("MESHPAINTCOVERAGE"), MeshPaintCoverageMap::DerivedDataVersion,
+			FString::Printf(TEXT("_%d_%d_%dx%d"), LODIndex, UVChannel, Resolution.X, Resolution.Y));
+	}
+
+	/** Data stored in the derived data cache, null on a miss and outside of the editor. Any thread */
+	template<typename DataType>
+	static TUniquePtr<DataType> LoadDerivedData(const FString& DerivedDataKey, const FString& DebugContext)
+	{
+#if WITH_EDITOR
+		TArray<uint8> DerivedData;
+		if (!DerivedDataKey.IsEmpty() && GetDerivedDataCacheRef().GetSynchronous(*DerivedDataKey, DerivedData, DebugContext))
+		{
+			TUniquePtr<DataType> Data = MakeUnique<DataType>();
+			FMemoryReader Reader(DerivedData);
+			Reader << *Data;
+			if (Data->IsValid()) return Data;
+		}
+#endif
+		return nullptr;
+	}
+
+	/** Builds data and stores it in the derived data cache. Null when the result is not valid. Any thread */
+	template<typename DataType, typename BuildFuncType>
+	static TUniquePtr<DataType> BuildAndStore(const FString& DerivedDataKey, const FString& DebugContext, BuildFuncType&& Build)
+	{
+		TUniquePtr<DataType> Data = MakeUnique<DataType>();
+		Build(*Data);
+		if (!Data->IsValid()) return nullptr;
+
+#if WITH_EDITOR
+		if (!DerivedDataKey.IsEmpty())
+		{
+			TArray<uint8> DerivedData;
+			FMemoryWriter Writer(DerivedData);
+			Writer << *Data;
+			GetDerivedDataCacheRef().Put(*DerivedDataKey, DerivedData, DebugContext);
+		}
+#endif
+		return Data;
+	}
+
+	/** Geometry of a mesh LOD, positions are skipped when OutPositions is null. Game thread */
+	static bool CopyLODGeometry(UStaticMesh* StaticMesh, int32 LODIndex, int32 UVChannel, TArray<FVector3f>* OutPositions, TArray<FVector2f>& OutUVs, TArray<uint32>& OutIndices)
+	{
+		if (OutPositions) OutPositions->Reset();
+		OutUVs.Reset();
+		OutIndices.Reset();
+
+		if (!IsValid(StaticMesh) || !StaticMesh->GetRenderData() || !StaticMesh->GetRenderData()->LODResources.IsValidIndex(LODIndex)) return false;
+
+		const FStaticMeshLODResources& LODResources = StaticMesh->GetRenderData()->LODResources[LODIndex];
+		const FPositionVertexBuffer& PositionBuffer = LODResources.VertexBuffers.PositionVertexBuffer;
+		const FStaticMeshVertexBuffer& VertexBuffer = LODResources.VertexBuffers.StaticMeshVertexBuffer;
+		const FIndexArrayView IndexView = LODResources.IndexBuffer.GetArrayView();
+
+		if (PositionBuffer.GetNumVertices() > 0 && IndexView.Num() >= 3 && (!OutPositions || PositionBuffer.GetVertexData() != nullptr) && VertexBuffer.GetTexCoordData() != nullptr)
+		{
+			const uint32 NumVertices = PositionBuffer.GetNumVertices();
+			const uint32 UVIndex = FMath::Clamp<uint32>(UVChannel, 0, VertexBuffer.GetNumTexCoords() - 1);
+			OutUVs.SetNumUninitialized(NumVertices);
+			for (uint32 VertexIndex = 0; VertexIndex < NumVertices; ++VertexIndex)
+			{
+				OutUVs[VertexIndex] = VertexBuffer.GetVertexUV(VertexIndex, UVIndex);
+			}
+			if (OutPositions)
+			{
+				OutPositions->SetNumUninitialized(NumVertices);
+				for (uint32 VertexIndex = 0; VertexIndex < NumVertices; ++VertexIndex)
+				{
+					(*OutPositions)[VertexIndex] = PositionBuffer.VertexPosition(VertexIndex);
+				}
+			}
+
+			OutIndices.SetNumUninitialized(IndexView.Num() - IndexView.Num() % 3);
+			for (int32 Index = 0; Index < OutIndices.Num(); ++Index)
+			{
+				OutIndices[Index] = IndexView[Index];
+			}
+			return true;
+		}
+
+#if WITH_EDITOR
+		// Render data may have dropped its CPU copies, source data is still around in the editor
+		if (const FMeshDescription* MeshDescription = StaticMesh->GetMeshDescription(LODIndex))
+		{
+			FStaticMeshConstAttributes Attributes(*MeshDescription);
+			TVertexAttributesConstRef<FVector3f> VertexPositions = Attributes.GetVertexPositions();
+			TVertexInstanceAttributesConstRef<FVector2f> VertexInstanceUVs = Attributes.GetVertexInstanceUVs();
+			const int32 UVIndex = FMath::Clamp(UVChannel, 0, FMath::Max(0, VertexInstanceUVs.GetNumChannels() - 1));
+
+			if (OutPositions) OutPositions->Reserve(MeshDescription->VertexInstances().Num());
+			OutUVs.Reserve(MeshDescription->VertexInstances().Num());
+			TMap<FVertexInstanceID, uint32> VertexRemap;
+			for (const FTriangleID TriangleID : MeshDescription->Triangles().GetElementIDs())
+			{
+				for (const FVertexInstanceID VertexInstanceID : MeshDescription->GetTriangleVertexInstances(TriangleID))
+				{
+					uint32& Index = VertexRemap.FindOrAdd(VertexInstanceID, MAX_uint32);
+					if (Index == MAX_uint32)
+					{
+						Index = OutUVs.Num();
+						if (OutPositions) OutPositions->Add(VertexPositions[MeshDescription->GetVertexInstanceVertex(VertexInstanceID)]);
+						OutUVs.Add(VertexInstanceUVs.GetNumChannels() > 0 ? VertexInstanceUVs.Get(VertexInstanceID, UVIndex) : FVector2f::ZeroVector);
+					}
+					OutIndices.Add(Index);
+				}
+			}
+			return !OutIndices.IsEmpty();
+		}
+#endif
+
+		return false;
+	}
+
+	/** Builds below copy the geometry they need on the calling thread, the returned function builds and stores the data on any thread */
+	static TUniqueFunction<TUniquePtr<FMeshPaintTriangleBVH>()> PrepareTriangleBVHBuild(UStaticMesh* StaticMesh, int32 LODIndex, int32 UVChannel)
+	{
+		FLODGeometry Geometry;
+		CopyLODGeometry(StaticMesh, LODIndex, UVChannel, &Geometry.Positions, Geometry.UVs, Geometry.Indices);
+
+		return [Geometry = MoveTemp(Geometry), DerivedDataKey = MakeTriangleBVHKey(StaticMesh, LODIndex, UVChannel), MeshName = StaticMesh->GetPathName(), LODIndex]() mutable
+		{
+			TUniquePtr<FMeshPaintTriangleBVH> BVH = BuildAndStore<FMeshPaintTriangleBVH>(DerivedDataKey, MeshName, [&Geometry](FMeshPaintTriangleBVH& Data)
+			{
+				if (!Geometry.Indices.IsEmpty())
+				{
+					Data.Build(MoveTemp(Geometry.Positions), MoveTemp(Geometry.UVs), Geometry.Indices);
+				}
+			});
+			if (!BVH.IsValid())
+			{
+				UE_LOG(LogMeshPainter, Warning, TEXT("Unable to build paint triangle hierarchy for %s LOD %d: render data is not CPU accessible (enable Allow CPU Access on the mesh)"), *MeshName, LODIndex);
+			}
+			return BVH;
+		};
+	}
+
+	static TUniqueFunction<TUniquePtr<FMeshPaintLODStats>()> PrepareLODStatsBuild(UStaticMesh* StaticMesh, int32 UVChannel)
+	{
+		const FStaticMeshRenderData* RenderData = StaticMesh->GetRenderData();
+		TArray<FLODGeometry> LODs;
+		LODs.SetNum(RenderData->LODResources.Num());
+		for (int32 LODIndex = 0; LODIndex < LODs.Num(); ++LODIndex)
+		{
+			FLODGeometry& Geometry = LODs[LODIndex];
+			Geometry.NumTriangles = RenderData->LODResources[LODIndex].GetNumTriangles();
+			CopyLODGeometry(StaticMesh, LODIndex, UVChannel, nullptr, Geometry.UVs, Geometry.Indices);
+		}
+
+		return [LODs = MoveTemp(LODs), DerivedDataKey = MakeLODStatsKey(StaticMesh, UVChannel), MeshName = StaticMesh->GetPathName()]()
+		{
+			return BuildAndStore<FMeshPaintLODStats>(DerivedDataKey, MeshName, [&LODs](FMeshPaintLODStats& Stats)
+			{
+				for (const FLODGeometry& Geometry : LODs)
+				{
+					FMeshPaintLODStats::FLOD& LOD = Stats.LODs.AddDefaulted_GetRef();
+					LOD.NumTriangles = Geometry.NumTriangles;
+					LOD.MedianUVTriangleSize = !Geometry.Indices.IsEmpty()
+						? MeshPaintLODStats::ComputeMedianTriangleSize(Geometry.UVs, Geometry.Indices)
+						: MeshPaintLODStats::EstimateTriangleSize(LOD.NumTriangles);
+				}
+			});
+		};
+	}
+
+	static TUniqueFunction<TUniquePtr<FMeshPaintCoverageMap>()> PrepareCoverageMapBuild(UStaticMesh* StaticMesh, int32 LODIndex, int32 UVChannel, FIntPoint Resolution)
+	{
+		FLODGeometry Geometry;
+		CopyLODGeometry(StaticMesh, LODIndex, UVChannel, nullptr, Geometry.UVs, Geometry.Indices);
+
+		return [Geometry = MoveTemp(Geometry), DerivedDataKey = MakeCoverageMapKey(StaticMesh, LODIndex, UVChannel, Resolution), MeshName = StaticMesh->GetPathName(), LODIndex, Resolution]()
+		{
+			TUniquePtr<FMeshPaintCoverageMap> CoverageMap = BuildAndStore<FMeshPaintCoverageMap>(DerivedDataKey, MeshName, [&Geometry, Resolution](FMeshPaintCoverageMap& Data)
+			{
+				if (!Geometry.Indices.IsEmpty())
+				{
+					Data.Build(Geometry.UVs, Geometry.Indices, Resolution);
+				}
+			});
+			if (!CoverageMap.IsValid())
+			{
+				UE_LOG(LogMeshPainter, Warning, TEXT("Unable to build paint coverage for %s LOD %d: render data is not CPU accessible (enable Allow CPU Access on the mesh)"), *MeshName, LODIndex);
+			}
+			return CoverageMap;
+		};
+	}
+}
+
+int32 FMeshPaintLODStats::SelectLOD(const FVector2D& CellTexels, float MinTriangleTexels) const
+{
+	const float TexelsPerUV = FMath::Sqrt((float)(CellTexels.X * CellTexels.Y));
+	for (int32 LODIndex = 0; LODIndex < LODs.Num(); ++LODIndex)
+	{
+		if (LODs[LODIndex].MedianUVTriangleSize * TexelsPerUV >= MinTriangleTexels) return LODIndex;
+	}
+	return FMath::Max(LODs.Num() - 1, 0);
+}
+
+FMeshPaintMeshDataCache& FMeshPaintMeshDataCache::Get()
+{
+	static FMeshPaintMeshDataCache Instance;
+	return Instance;
+}
+
+bool FMeshPaintMeshDataCache::GetLODGeometry(UStaticMesh* StaticMesh, int32 LODIndex, int32 UVChannel, TArray<FVector3f>& OutPositions, TArray<FVector2f>& OutUVs, TArray<uint32>& OutIndices)
+{
+	return MeshPaintMeshData::CopyLODGeometry(StaticMesh, LODIndex, UVChannel, &OutPositions, OutUVs, OutIndices);
+}
+
+template<typename DataType>
+TSharedPtr<const DataType> FMeshPaintMeshDataCache::Resolve(TCachedData<DataType>& Entry)
+{
+	if (Entry.PendingBuild.IsValid() && Entry.PendingBuild.IsCompleted())
+	{
+		TUniquePtr<DataType> Result = MoveTemp(Entry.PendingBuild.GetResult());
+		Entry.PendingBuild = UE::Tasks::TTask<TUniquePtr<DataType>>();
+		FinishBuild(Entry, MoveTemp(Result));
+	}
+	return Entry.Data;
+}
+
+template<typename DataType>
+void FMeshPaintMeshDataCache::FinishBuild(TCachedData<DataType>& Entry, TUniquePtr<DataType>&& Result)
+{
+	Entry.Data = TSharedPtr<const DataType>(Result.Release());
+	if (Entry.bDerivedDataLookup && !Entry.Data.IsValid())
+	{
+		// A miss is not a failure, the build may start on the next lookup
+		Entry.bDerivedDataMissed = true;
+		Entry.RetryTime = 0.0;
+	}
+	else
+	{
+		// Failures are kept until their retry time, so a misconfigured mesh does not rebuild on every query
+		Entry.RetryTime = Entry.Data.IsValid() ? 0.0 : MeshPaintMeshData::GetRetryTime();
+	}
+	Entry.bDerivedDataLookup = false;
+}
+
+template<typename DataType>
+bool FMeshPaintMeshDataCache::CanRetry(const TCachedData<DataType>& Entry)
+{
+	return !Entry.Data.IsValid() && !Entry.PendingBuild.IsValid() && FPlatformTime::Seconds() >= Entry.RetryTime;
+}
+
+template<typename DataType>
+void FMeshPaintMeshDataCache::StartBuild(TCachedData<DataType>& Entry, const FString& DerivedDataKey, const FString& DebugContext, TFunctionRef<TUniqueFunction<TUniquePtr<DataType>()>()> PrepareBuild)
+{
+	if (!Entry.bDerivedDataMissed && !DerivedDataKey.IsEmpty())
+	{
+		Entry.bDerivedDataLookup = true;
+		if (GMeshPaintMeshDataAsyncBuild)
+		{
+			Entry.PendingBuild = UE::Tasks::Launch(UE_SOURCE_LOCATION, [DerivedDataKey, DebugContext]() { return MeshPaintMeshData::LoadDerivedData<DataType>(DerivedDataKey, DebugContext); });
+			return;
+		}
+
+		FinishBuild(Entry, MeshPaintMeshData::LoadDerivedData<DataType>(DerivedDataKey, DebugContext));
+		if (Entry.Data.IsValid()) return;
+	}
+
+	if (GMeshPaintMeshDataAsyncBuild)
+	{
+		Entry.PendingBuild = UE::Tasks::Launch(UE_SOURCE_LOCATION, PrepareBuild());
+	}
+	else
+	{
+		FinishBuild(Entry, PrepareBuild()());
+	}
+}
+
+TUniquePtr<FMeshPaintTriangleBVH> FMeshPaintMeshDataCache::BuildTriangleBVH(UStaticMesh* StaticMesh, int32 LODIndex, int32 UVChannel)
+{
+	if (!IsValid(StaticMesh) || !StaticMesh->GetRenderData() || !StaticMesh->GetRenderData()->LODResources.IsValidIndex(LODIndex)) return nullptr;
+	if (TUniquePtr<FMeshPaintTriangleBVH> BVH = MeshPaintMeshData::LoadDerivedData<FMeshPaintTriangleBVH>(MeshPaintMeshData::MakeTriangleBVHKey(StaticMesh, LODIndex, UVChannel), StaticMesh->GetPathName())) return BVH;
+	return MeshPaintMeshData::PrepareTriangleBVHBuild(StaticMesh, LODIndex, UVChannel)();
+}
+
+TUniquePtr<FMeshPaintLODStats> FMeshPaintMeshDataCache::BuildLODStats(UStaticMesh* StaticMesh, int32 UVChannel)
+{
+	if (!IsValid(StaticMesh) || !StaticMesh->GetRenderData() || StaticMesh->GetRenderData()->LODResources.IsEmpty()) return nullptr;
+	if (TUniquePtr<FMeshPaintLODStats> Stats = MeshPaintMeshData::LoadDerivedData<FMeshPaintLODStats>(MeshPaintMeshData::MakeLODStatsKey(StaticMesh, UVChannel), StaticMesh->GetPathName())) return Stats;
+	return MeshPaintMeshData::PrepareLODStatsBuild(StaticMesh, UVChannel)();
+}
+
+TUniquePtr<FMeshPaintCoverageMap> FMeshPaintMeshDataCache::BuildCoverageMap(UStaticMesh* StaticMesh, int32 LODIndex, int32 UVChannel, FIntPoint Resolution)
+{
+	if (!IsValid(StaticMesh) || !StaticMesh->GetRenderData() || !StaticMesh->GetRenderData()->LODResources.IsValidIndex(LODIndex)) return nullptr;
+	if (Resolution.X <= 0 || Resolution.Y <= 0 || Resolution.GetMax() > MeshPaintCoverageMap::MaxResolution) return nullptr;
+	if (TUniquePtr<FMeshPaintCoverageMap> CoverageMap = MeshPaintMeshData::LoadDerivedData<FMeshPaintCoverageMap>(MeshPaintMeshData::MakeCoverageMapKey(StaticMesh, LODIndex, UVChannel, Resolution), StaticMesh->GetPathName())) return CoverageMap;
+	return MeshPaintMeshData::PrepareCoverageMapBuild(StaticMesh, LODIndex, UVChannel, Resolution)();
+}
+
+TSharedPtr<const FMeshPaintTriangleBVH> FMeshPaintMeshDataCache::FindOrBuildTriangleBVH(UStaticMesh* StaticMesh, int32 LODIndex, int32 UVChannel)
+{
+	if (!IsValid(StaticMesh) || !StaticMesh->GetRenderData()) return nullptr;
+
+	const FStaticMeshRenderData* RenderData = StaticMesh->GetRenderData();
+	if (RenderData->LODResources.IsEmpty()) return nullptr;
+
+	LODIndex = FMath::Clamp(LODIndex, 0, RenderData->LODResources.Num() - 1);
+	const FBVHKey Key(FObjectKey(StaticMesh), LODIndex, UVChannel);
+
+	FScopeLock ScopeLock(&Lock);
+	TCachedData<FMeshPaintTriangleBVH>* Existing = TriangleBVHs.Find(Key);
+	if (Existing && (Resolve(*Existing).IsValid() || !CanRetry(*Existing)))
+	{
+		return Existing->Data;
+	}
+
+	TCachedData<FMeshPaintTriangleBVH>& Entry = TriangleBVHs.FindOrAdd(Key);
+	const UMeshPaintCookedMeshData* CookedData = StaticMesh->GetAssetUserData<UMeshPaintCookedMeshData>();
+	Entry.Data = CookedData ? CookedData->FindTriangleBVH(LODIndex, UVChannel) : nullptr;
+	if (!Entry.Data.IsValid())
+	{
+		StartBuild<FMeshPaintTriangleBVH>(Entry, MeshPaintMeshData::MakeTriangleBVHKey(StaticMesh, LODIndex, UVChannel), StaticMesh->GetPathName(),
+			[StaticMesh, LODIndex, UVChannel]() { return MeshPaintMeshData::PrepareTriangleBVHBuild(StaticMesh, LODIndex, UVChannel); });
+	}
+	return Resolve(Entry);
+}
+
+TSharedPtr<const FMeshPaintLODStats> FMeshPaintMeshDataCache::FindOrBuildLODStats(UStaticMesh* StaticMesh, int32 UVChannel)
+{
+	if (!IsValid(StaticMesh) || !StaticMesh->GetRenderData() || StaticMesh->GetRenderData()->LODResources.IsEmpty()) return nullptr;
+
+	const FLODStatsKey Key(FObjectKey(StaticMesh), UVChannel);
+
+	FScopeLock ScopeLock(&Lock);
+	TCachedData<FMeshPaintLODStats>* Existing = LODStats.Find(Key);
+	if (Existing && (Resolve(*Existing).IsValid() || !CanRetry(*Existing)))
+	{
+		return Existing->Data;
+	}
+
+	TCachedData<FMeshPaintLODStats>& Entry = LODStats.FindOrAdd(Key);
+	const UMeshPaintCookedMeshData* CookedData = StaticMesh->GetAssetUserData<UMeshPaintCookedMeshData>();
+	Entry.Data = CookedData ? CookedData->FindLODStats(UVChannel) : nullptr;
+	if (!Entry.Data.IsValid())
+	{
+		StartBuild<FMeshPaintLODStats>(Entry, MeshPaintMeshData::MakeLODStatsKey(StaticMesh, UVChannel), StaticMesh->GetPathName(),
+			[StaticMesh, UVChannel]() { return MeshPaintMeshData::PrepareLODStatsBuild(StaticMesh, UVChannel); });
+	}
+	return Resolve(Entry);
+}
+
+TSharedPtr<const FMeshPaintLODStats> FMeshPaintMeshDataCache::FindOrBuildLODStats(USkinnedAsset* SkinnedAsset)
+{
+	const FSkeletalMeshRenderData* RenderData = IsValid(SkinnedAsset) ? SkinnedAsset->GetResourceForRendering() : nullptr;
+	if (!RenderData || RenderData->LODRenderData.IsEmpty()) return nullptr;
+
+	const FLODStatsKey Key(FObjectKey(SkinnedAsset), 0);
+
+	FScopeLock ScopeLock(&Lock);
+	if (TCachedData<FMeshPaintLODStats>* Existing = LODStats.Find(Key))
+	{
+		return Resolve(*Existing);
+	}
+
+	// Estimates only read triangle counts, nothing worth a worker
+	TSharedPtr<FMeshPaintLODStats> Stats = MakeShared<FMeshPaintLODStats>();
+	for (const FSkeletalMeshLODRenderData& LODData : RenderData->LODRenderData)
+	{
+		FMeshPaintLODStats::FLOD& LOD = Stats->LODs.AddDefaulted_GetRef();
+		LOD.NumTriangles = LODData.GetTotalFaces();
+		LOD.MedianUVTriangleSize = MeshPaintLODStats::EstimateTriangleSize(LOD.NumTriangles);
+	}
+
+	LODStats.Add(Key).Data = Stats;
+	return Stats;
+}
+
+TSharedPtr<const FMeshPaintCoverageMap> FMeshPaintMeshDataCache::FindOrBuildCoverageMap(UStaticMesh* StaticMesh, int32 LODIndex, int32 UVChannel, FIntPoint Resolution)
+{
+	if (!IsValid(StaticMesh) || !StaticMesh->GetRenderData() || StaticMesh->GetRenderData()->LODResources.IsEmpty()) return nullptr;
+	if (Resolution.X <= 0 || Resolution.Y <= 0 || Resolution.GetMax() > MeshPaintCoverageMap::MaxResolution) return nullptr;
+
+	const FStaticMeshRenderData* RenderData = StaticMesh->GetRenderData();
+	LODIndex = FMath::Clamp(LODIndex, 0, RenderData->LODResources.Num() - 1);
+	const FCoverageKey Key(FObjectKey(StaticMesh), LODIndex, UVChannel, Resolution);
+
+	FScopeLock ScopeLock(&Lock);
+	TCachedData<FMeshPaintCoverageMap>* Existing = CoverageMaps.Find(Key);
+	if (Existing && (Resolve(*Existing).IsValid() || !CanRetry(*Existing)))
+	{
+		return Existing->Data;
+	}
+
+	TCachedData<FMeshPaintCoverageMap>& Entry = CoverageMaps.FindOrAdd(Key);
+	const UMeshPaintCookedMeshData* CookedData = StaticMesh->GetAssetUserData<UMeshPaintCookedMeshData>();
+	Entry.Data = CookedData ? CookedData->FindCoverageMap(LODIndex, UVChannel, Resolution) : nullptr;
+	if (!Entry.Data.IsValid())
+	{
+		StartBuild<FMeshPaintCoverageMap>(Entry, MeshPaintMeshData::MakeCoverageMapKey(StaticMesh, LODIndex, UVChannel, Resolution), StaticMesh->GetPathName(),
+			[StaticMesh, LODIndex, UVChannel, Resolution]() { return MeshPaintMeshData::PrepareCoverageMapBuild(StaticMesh, LODIndex, UVChannel, Resolution); });
+	}
+	return Resolve(Entry);
+}
+
+UTexture2D* FMeshPaintMeshDataCache::FindOrCreateCoverageTexture(UStaticMesh* StaticMesh, int32 LODIndex, int32 UVChannel, FIntPoint Resolution)
+{
+	check(IsInGameThread());
+
+	TSharedPtr<const FMeshPaintCoverageMap> CoverageMap = FindOrBuildCoverageMap(StaticMesh, LODIndex, UVChannel, Resolution);
+	if (!CoverageMap.IsValid()) return nullptr;
+
+	LODIndex = FMath::Clamp(LODIndex, 0, StaticMesh->GetRenderData()->LODResources.Num() - 1);
+	const FCoverageKey Key(FObjectKey(StaticMesh), LODIndex, UVChannel, Resolution);
+
+	FScopeLock ScopeLock(&Lock);
+	TStrongObjectPtr<UTexture2D>& Texture = CoverageTextures.FindOrAdd(Key);
+	if (!Texture.IsValid())
+	{
+		Texture.Reset(CoverageMap->CreateTexture(GetTransientPackage()));
+	}
+	return Texture.Get();
+}
+
+void FMeshPaintMeshDataCache::AddReference(FObjectKey Mesh)
+{
+	check(IsInGameThread());
+	++References.FindOrAdd(Mesh);
+}
+
+void FMeshPaintMeshDataCache::ReleaseReference(FObjectKey Mesh)
+{
+	check(IsInGameThread());
+
+	int32* NumReferences = References.Find(Mesh);
+	if (!NumReferences || --*NumReferences > 0) return;
+
+	References.Remove(Mesh);
+	Invalidate(Mesh);
+}
+
+void FMeshPaintMeshDataCache::Invalidate(FObjectKey MeshKey)
+{
+	FScopeLock ScopeLock(&Lock);
+	for (auto It = TriangleBVHs.CreateIterator(); It; ++It)
+	{
+		if (It.Key().Get<0>() == MeshKey)
+		{
+			It.RemoveCurrent();
+		}
+	}
+	for (auto It = LODStats.CreateIterator(); It; ++It)
+	{
+		if (It.Key().Get<0>() == MeshKey)
+		{
+			It.RemoveCurrent();
+		}
+	}
+	for (auto It = CoverageMaps.CreateIterator(); It; ++It)
+	{
+		if (It.Key().Get<0>() == MeshKey)
+		{
+			It.RemoveCurrent();
+		}
+	}
+	for (auto It = CoverageTextures.CreateIterator(); It; ++It)
+	{
+		if (It.Key().Get<0>() == MeshKey)
+		{
+			It.RemoveCurrent();
+		}
+	}
+}
+
+void FMeshPaintMeshDataCache::Reset()
+{
+	FScopeLock ScopeLock(&Lock);
+	TriangleBVHs.Reset();
+	LODStats.Reset();
+	CoverageMaps.Reset();
+	CoverageTextures.Reset();
+}
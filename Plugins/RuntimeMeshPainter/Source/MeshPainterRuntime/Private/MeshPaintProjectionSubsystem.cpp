@@ -0,0 +1,124 @@
+#include "MeshPaintProjectionSubsystem.h"
+#include "MeshPainterRender.h"
+#include "MeshPainterStats.h"
+#include "Components/PrimitiveComponent.h"
+#include "Engine/World.h"
+
+static int32 GMeshPaintProjectionDepthResolution = 256;
+static FAutoConsoleVariableRef CVarMeshPaintProjectionDepthResolution(
+	TEXT("r.MeshPaint.Projection.DepthResolution"),
+	GMeshPaintProjectionDepthResolution,
+	TEXT("Size of the square occluder depth map rendered from paint projectors"));
+
+static int32 GMeshPaintProjectionMaxCachedDepths = 8;
+static FAutoConsoleVariableRef CVarMeshPaintProjectionMaxCachedDepths(
+	TEXT("r.MeshPaint.Projection.MaxCachedDepths"),
+	GMeshPaintProjectionMaxCachedDepths,
+	TEXT("Projector depth maps kept per world, the least recently used one is dropped first"));
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Projection depth renders"), STAT_MeshPaint_ProjectionDepthRenders, STATGROUP_MeshPaint);
+
+namespace MeshPaintProjection
+{
+	static bool IsSameProjector(const FRenderMaterialOnMeshViewConfiguration& A, const FRenderMaterialOnMeshViewConfiguration& B)
+	{
+		return A.ViewOrigin.Equals(B.ViewOrigin, UE_KINDA_SMALL_NUMBER)
+			&& A.ViewRotationMatrix.Equals(B.ViewRotationMatrix, UE_KINDA_SMALL_NUMBER)
+			&& A.ProjectionMatrix.Equals(B.ProjectionMatrix, UE_KINDA_SMALL_NUMBER);
+	}
+}
+
+void UMeshPaintProjectionSubsystem::Deinitialize()
+{
+	CachedDepths.Reset();
+
+	Super::Deinitialize();
+}
+
+void UMeshPaintProjectionSubsystem::InvalidateDepths()
+{
+	CachedDepths.Reset();
+}
+
+TSharedPtr<FMeshPaintProjectionDepth, ESPMode::ThreadSafe> UMeshPaintProjectionSubsystem::FindOrRenderDepth(const FRenderMaterialOnMeshViewConfiguration& Projector, TConstArrayView<UPrimitiveComponent*> Occluders, int32 Resolution)
+{
+	check(IsInGameThread());
+	MESH_PAINT_TRACE_SCOPE(FindOrRenderProjectionDepth);
+
+	UWorld* World = GetWorld();
+	if (!World || !World->Scene) return nullptr;
+
+	Resolution = FMath::Clamp(Resolution > 0 ? Resolution : GMeshPaintProjectionDepthResolution, 16, 4096);
+
+	// Occluders without render state do not occlude and do not invalidate either
+	TArray<FOccluderState> OccluderStates;
+	OccluderStates.Reserve(Occluders.Num());
+	for (UPrimitiveComponent* Occluder : Occluders)
+	{
+		if (!IsValid(Occluder) || !Occluder->SceneProxy) continue;
+		OccluderStates.Add({ Occluder->SceneProxy, Occluder->GetComponentTransform() });
+	}
+
+	FCachedDepth* Cached = CachedDepths.FindByPredicate([&](const FCachedDepth& Entry)
+	{
+		return Entry.Resolution == Resolution && MeshPaintProjection::IsSameProjector(Entry.Projector, Projector);
+	});
+
+	if (Cached && Cached->Occluders.Num() == OccluderStates.Num())
+	{
+		bool bSceneMoved = false;
+		for (int32 Index = 0; Index < OccluderStates.Num() && !bSceneMoved; ++Index)
+		{
+			bSceneMoved = Cached->Occluders[Index].Proxy != OccluderStates[Index].Proxy
+				|| !Cached->Occluders[Index].Transform.Equals(OccluderStates[Index].Transform, UE_KINDA_SMALL_NUMBER);
+		}
+		if (!bSceneMoved)
+		{
+			Cached->LastUsedFrame = GFrameCounter;
+			return Cached->Depth;
+		}
+	}
+
+	if (!Cached)
+	{
+		if (CachedDepths.Num() >= FMath::Max(GMeshPaintProjectionMaxCachedDepths, 1))
+		{
+			int32 OldestIndex = 0;
+			for (int32 Index = 1; Index < CachedDepths.Num(); ++Index)
+			{
+				if (CachedDepths[Index].LastUsedFrame < CachedDepths[OldestIndex].LastUsedFrame) OldestIndex = Index;
+			}
+			CachedDepths.RemoveAtSwap(OldestIndex);
+		}
+		Cached = &CachedDepths.AddDefaulted_GetRef();
+		Cached->Projector = Projector;
+		Cached->Resolution = Resolution;
+	}
+
+	FMeshPaintProjectionDepthParameters Params;
+	Params.Scene = World->Scene;
+	Params.Resolution = FIntPoint(Resolution, Resolution);
+	Params.ViewProjection.SetViewRectangle(FIntRect(0, 0, Resolution, Resolution));
+	Params.ViewProjection.ViewOrigin = Projector.ViewOrigin;
+	Params.ViewProjection.ViewRotationMatrix = Projector.ViewRotationMatrix;
+	Params.ViewProjection.ProjectionMatrix = Projector.ProjectionMatrix;
+	for (const FOccluderState& Occluder : OccluderStates)
+	{
+		FMeshPaintProxyRenderParameters& Param = Params.Occluders.AddDefaulted_GetRef();
+		Param.PrimitiveProxy = Occluder.Proxy;
+	}
+
+	// Paint passes holding the previous map keep it alive until they ran
+	TSharedPtr<FMeshPaintProjectionDepth, ESPMode::ThreadSafe> Depth = MakeShared<FMeshPaintProjectionDepth, ESPMode::ThreadSafe>();
+	ENQUEUE_RENDER_COMMAND(MeshPaintProjectionDepthCommand)([Depth, Params = MoveTemp(Params)](FRHICommandListImmediate& RHICmdList)
+	{
+		MeshPaintRender::AddProjectionDepthPass(RHICmdList, Params, *Depth);
+	});
+
+	Cached->Occluders = MoveTemp(OccluderStates);
+	Cached->Depth = Depth;
+	Cached->LastUsedFrame = GFrameCounter;
+	NumDepthRenders++;
+	INC_DWORD_STAT(STAT_MeshPaint_ProjectionDepthRenders);
+	return Depth;
+}
@@ -0,0 +1,273 @@
+#include "MeshPaintReferenceRasterizer.h"
+#include "MeshPaintMeshDataCache.h"
+#include "MeshPaintUVRasterizer.h"
+#include "RuntimeMeshPainter.h"
+#include "Async/ParallelFor.h"
+#include "Engine/StaticMesh.h"
+#include "HAL/IConsoleManager.h"
+#include "ImageUtils.h"
+#include "Misc/Paths.h"
+
+bool FMeshPaintReferenceRasterizer::FPrimitive::InitFromStaticMesh(UStaticMesh* StaticMesh, int32 LODIndex, int32 UVChannel)
+{
+	TArray<FVector3f> Positions;
+	return FMeshPaintMeshDataCache::GetLODGeometry(StaticMesh, LODIndex, UVChannel, Positions, UVs, Indices);
+}
+
+FVector4f FMeshPaintReferenceRasterizer::ComputeUVTileMapping(const FBox2D& UVRegion)
+{
+	const FVector2D UVScale = UVRegion.GetSize();
+	const FVector2D UVBias = UVRegion.Min;
+	return FVector4f(FVector4(UVScale * FVector2D(2.0f, -2.0f), UVBias * 2.0f + FVector2D(-1.0f, 1.0f)));
+}
+
+bool FMeshPaintReferenceRasterizer::PassesAtlasCellClip(const FVector2f& UV)
+{
+	const FVector2f ClipArea(FMath::Clamp(UV.X, 0.0f, 1.0f), FMath::Clamp(UV.Y, 0.0f, 1.0f));
+	const float ClipValue = ClipArea.X * (1.0f - ClipArea.X) + ClipArea.Y * (1.0f - ClipArea.Y);
+	return !(ClipValue < 0.0f);
+}
+
+FLinearColor FMeshPaintReferenceRasterizer::Blend(const FLinearColor& Source, const FLinearColor& Destination)
+{
+	// TStaticBlendState<CW_RGBA, BO_Add, BF_SourceAlpha, BF_InverseSourceAlpha, BO_Add, BF_One, BF_InverseSourceAlpha>
+	const float InvSourceAlpha = 1.0f - Source.A;
+	return FLinearColor(
+		Source.R * Source.A + Destination.R * InvSourceAlpha,
+		Source.G * Source.A + Destination.G * InvSourceAlpha,
+		Source.B * Source.A + Destination.B * InvSourceAlpha,
+		Source.A + Destination.A * InvSourceAlpha);
+}
+
+FMeshPaintReferenceRasterizer::FStats FMeshPaintReferenceRasterizer::Rasterize(TConstArrayView<FPrimitive> Primitives, const FShadingFunction& Shading, const FSettings& Settings, FImage& InOutImage)
+{
+	FStats Stats;
+	const double StartTime = FPlatformTime::Seconds();
+
+	if (InOutImage.Format != ERawImageFormat::RGBA32F || InOutImage.GammaSpace != EGammaSpace::Linear)
+	{
+		InOutImage.ChangeFormat(ERawImageFormat::RGBA32F, EGammaSpace::Linear);
+	}
+
+	const FIntPoint Size(InOutImage.SizeX, InOutImage.SizeY);
+	TArrayView64<FLinearColor> Texels = InOutImage.AsRGBA32F();
+	if (Settings.bClearTarget)
+	{
+		for (FLinearColor& Texel : Texels)
+		{
+			Texel = Settings.ClearColor;
+		}
+	}
+
+	if (Size.X <= 0 || Size.Y <= 0 || !Shading)
+	{
+		return Stats;
+	}
+
+	// Transform every triangle to texel space exactly like the vertex shader and clip space to viewport mapping do
+	struct FTriangle
+	{
+		FVector2f Texel[3];
+		FVector2f UV[3];
+	};
+	TArray<FTriangle> Triangles;
+	for (const FPrimitive& Primitive : Primitives)
+	{
+		const FVector4f Mapping = ComputeUVTileMapping(Primitive.UVRegion);
+		for (int32 Index = 0; Index + 2 < Primitive.Indices.Num(); Index += 3)
+		{
+			FTriangle& Triangle = Triangles.AddDefaulted_GetRef();
+			for (int32 Corner = 0; Corner < 3; ++Corner)
+			{
+				const FVector2f& UV = Primitive.UVs[Primitive.Indices[Index + Corner]];
+				const FVector2f ClipSpace(UV.X * Mapping.X + Mapping.Z, UV.Y * Mapping.Y + Mapping.W);
+				Triangle.Texel[Corner] = FVector2f((ClipSpace.X * 0.5f + 0.5f) * Size.X, (0.5f - ClipSpace.Y * 0.5f) * Size.Y);
+				Triangle.UV[Corner] = UV;
+			}
+		}
+	}
+	Stats.NumTriangles = Triangles.Num();
+
+	// Bin triangles into tiles keeping submission order, blending is order dependent
+	const int32 TileSize = FMath::Max(Settings.TileSize, MeshPaintUVRaster::LaneCount);
+	const FIntPoint NumTiles((Size.X + TileSize - 1) / TileSize, (Size.Y + TileSize - 1) / TileSize);
+	TArray<TArray<int32>> TileTriangles;
+	TileTriangles.SetNum(NumTiles.X * NumTiles.Y);
+	for (int32 TriangleIndex = 0; TriangleIndex < Triangles.Num(); ++TriangleIndex)
+	{
+		const FTriangle& Triangle = Triangles[TriangleIndex];
+		const FVector2f Min = FVector2f::Min(Triangle.Texel[0], FVector2f::Min(Triangle.Texel[1], Triangle.Texel[2]));
+		const FVector2f Max = FVector2f::Max(Triangle.Texel[0], FVector2f::Max(Triangle.Texel[1], Triangle.Texel[2]));
+		const int32 MinTileX = FMath::Clamp(FMath::FloorToInt32(Min.X) / TileSize, 0, NumTiles.X - 1);
+		const int32 MinTileY = FMath::Clamp(FMath::FloorToInt32(Min.Y) / TileSize, 0, NumTiles.Y - 1);
+		const int32 MaxTileX = FMath::Clamp(FMath::CeilToInt32(Max.X) / TileSize, 0, NumTiles.X - 1);
+		const int32 MaxTileY = FMath::Clamp(FMath::CeilToInt32(Max.Y) / TileSize, 0, NumTiles.Y - 1);
+		if (Max.X < 0.0f || Max.Y < 0.0f || Min.X > Size.X || Min.Y > Size.Y) continue;
+
+		for (int32 TileY = MinTileY; TileY <= MaxTileY; ++TileY)
+		{
+			for (int32 TileX = MinTileX; TileX <= MaxTileX; ++TileX)
+			{
+				TileTriangles[TileY * NumTiles.X + TileX].Add(TriangleIndex);
+			}
+		}
+	}
+
+	TArray<int64> TileTexelCounts;
+	TileTexelCounts.SetNumZeroed(TileTriangles.Num());
+
+	ParallelFor(TEXT("MeshPaintReferenceRaster"), TileTriangles.Num(), 1, [&](int32 TileIndex)
+	{
+		const FIntPoint TileMin((TileIndex % NumTiles.X) * TileSize, (TileIndex / NumTiles.X) * TileSize);
+		const FIntRect TileRect(TileMin, (TileMin + FIntPoint(TileSize)).ComponentMin(Size));
+
+		for (const int32 TriangleIndex : TileTriangles[TileIndex])
+		{
+			const FTriangle& Triangle = Triangles[TriangleIndex];
+			TileTexelCounts[TileIndex] += MeshPaintUVRaster::RasterizeTriangle(Triangle.Texel[0], Triangle.Texel[1], Triangle.Texel[2], TileRect,
+				[&](int32 X, int32 Y, int32 LaneMask, const VectorRegister4Float& B0, const VectorRegister4Float& B1, const VectorRegister4Float& B2)
+				{
+					alignas(16) float U[MeshPaintUVRaster::LaneCount];
+					alignas(16) float V[MeshPaintUVRaster::LaneCount];
+					VectorStoreAligned(MeshPaintUVRaster::Interpolate(B0, B1, B2, Triangle.UV[0].X, Triangle.UV[1].X, Triangle.UV[2].X), U);
+					VectorStoreAligned(MeshPaintUVRaster::Interpolate(B0, B1, B2, Triangle.UV[0].Y, Triangle.UV[1].Y, Triangle.UV[2].Y), V);
+
+					for (int32 Lane = 0; Lane < MeshPaintUVRaster::LaneCount; ++Lane)
+					{
+						if (!(LaneMask & (1 << Lane))) continue;
+
+						const FVector2f UV(U[Lane], V[Lane]);
+						if (!PassesAtlasCellClip(UV)) continue;
+
+						FLinearColor& Texel = Texels[(int64)Y * Size.X + X + Lane];
+						Texel = Blend(Shading(UV), Texel);
+					}
+				});
+		}
+	}, Settings.bMultithreaded ? EParallelForFlags::None : EParallelForFlags::ForceSingleThread);
+
+	for (const int64 Count : TileTexelCounts)
+	{
+		Stats.NumTexelsShaded += Count;
+	}
+	Stats.NumTiles = TileTriangles.Num();
+	Stats.Seconds = FPlatformTime::Seconds() - StartTime;
+	return Stats;
+}
+
+FMeshPaintReferenceRasterizer::FComparison FMeshPaintReferenceRasterizer::Compare(const FImage& Image, const FImage& Golden, float Tolerance, FImage* OutDifference)
+{
+	FComparison Result;
+	Result.bSizeMatches = Image.SizeX == Golden.SizeX && Image.SizeY == Golden.SizeY;
+	if (!Result.bSizeMatches) return Result;
+
+	FImage ImageLinear;
+	FImage GoldenLinear;
+	Image.CopyTo(ImageLinear, ERawImageFormat::RGBA32F, EGammaSpace::Linear);
+	Golden.CopyTo(GoldenLinear, ERawImageFormat::RGBA32F, EGammaSpace::Linear);
+
+	if (OutDifference)
+	{
+		OutDifference->Init(Image.SizeX, Image.SizeY, ERawImageFormat::RGBA32F, EGammaSpace::Linear);
+	}
+
+	const TArrayView64<FLinearColor> ImageTexels = ImageLinear.AsRGBA32F();
+	const TArrayView64<FLinearColor> GoldenTexels = GoldenLinear.AsRGBA32F();
+	for (int64 TexelIndex = 0; TexelIndex < ImageTexels.Num(); ++TexelIndex)
+	{
+		const FLinearColor& A = ImageTexels[TexelIndex];
+		const FLinearColor& B = GoldenTexels[TexelIndex];
+		const FLinearColor Difference(FMath::Abs(A.R - B.R), FMath::Abs(A.G - B.G), FMath::Abs(A.B - B.B), FMath::Abs(A.A - B.A));
+		const float Error = FMath::Max(FMath::Max(Difference.R, Difference.G), FMath::Max(Difference.B, Difference.A));
+
+		Result.MaxError = FMath::Max(Result.MaxError, Error);
+		Result.NumMismatchedTexels += Error > Tolerance ? 1 : 0;
+		if (OutDifference)
+		{
+			OutDifference->AsRGBA32F()[TexelIndex] = FLinearColor(Difference.R, Difference.G, Difference.B, 1.0f);
+		}
+	}
+	return Result;
+}
+
+/**
+ * MeshPaint.ReferenceRaster Mesh=/Game/Path/Mesh Size=512 [LOD=0] [UV=0] [Golden=File.exr] [CreateGolden] [Out=File.exr] [Tolerance=0.004] [Threads=1]
+ * Paints a half transparent UV gradient over the UV layout of a mesh and compares the result with a golden image.
+ * A missing golden fails unless CreateGolden is given. Runs with -nullrhi, the MeshPaint.ReferenceRaster automation
+ * tests cover the rasterizer itself.
+ */
+static FAutoConsoleCommandWithArgsAndOutputDevice GMeshPaintReferenceRasterCommand(
+	TEXT("MeshPaint.ReferenceRaster"),
+	TEXT("Rasterizes a mesh UV layout on the CPU and compares it with a golden image"),
+	FConsoleCommandWithArgsAndOutputDeviceDelegate::CreateLambda([](const TArray<FString>& Args, FOutputDevice& Ar)
+	{
+		const FString CommandLine = FString::Join(Args, TEXT(" "));
+		FString MeshPath, GoldenPath, OutPath;
+		int32 Size = 512, LOD = 0, UVChannel = 0, Threads = 1;
+		float Tolerance = 1.0f / 255.0f;
+		FParse::Value(*CommandLine, TEXT("Mesh="), MeshPath);
+		FParse::Value(*CommandLine, TEXT("Golden="), GoldenPath);
+		FParse::Value(*CommandLine, TEXT("Out="), OutPath);
+		FParse::Value(*CommandLine, TEXT("Size="), Size);
+		FParse::Value(*CommandLine, TEXT("LOD="), LOD);
+		FParse::Value(*CommandLine, TEXT("UV="), UVChannel);
+		FParse::Value(*CommandLine, TEXT("Threads="), Threads);
+		FParse::Value(*CommandLine, TEXT("Tolerance="), Tolerance);
+
+		FMeshPaintReferenceRasterizer::FPrimitive Primitive;
+		UStaticMesh* StaticMesh = LoadObject<UStaticMesh>(nullptr, *MeshPath);
+		if (!StaticMesh || !Primitive.InitFromStaticMesh(StaticMesh, LOD, UVChannel))
+		{
+			Ar.Logf(ELogVerbosity::Error, TEXT("MeshPaint.ReferenceRaster: FAILED, unable to read geometry of '%s'"), *MeshPath);
+			return;
+		}
+
+		FMeshPaintReferenceRasterizer::FSettings Settings;
+		Settings.bClearTarget = true;
+		Settings.ClearColor = FLinearColor::Transparent;
+		Settings.bMultithreaded = Threads != 1;
+
+		FImage Image(FMath::Max(Size, 1), FMath::Max(Size, 1), ERawImageFormat::RGBA32F, EGammaSpace::Linear);
+		const FMeshPaintReferenceRasterizer::FStats Stats = FMeshPaintReferenceRasterizer::Rasterize(MakeArrayView(&Primitive, 1),
+			[](const FVector2f& UV) { return FLinearColor(UV.X, UV.Y, 1.0f, 0.5f); }, Settings, Image);
+
+		Ar.Logf(TEXT("MeshPaint.ReferenceRaster: %lld triangles, %lld texels in %.3f ms (%.1f Mtexel/s, %d tiles)"),
+			Stats.NumTriangles, Stats.NumTexelsShaded, Stats.Seconds * 1000.0, Stats.Seconds > 0.0 ? Stats.NumTexelsShaded / Stats.Seconds * 1e-6 : 0.0, Stats.NumTiles);
+
+		if (!OutPath.IsEmpty())
+		{
+			FImageUtils::SaveImageByExtension(*OutPath, Image);
+		}
+
+		if (GoldenPath.IsEmpty())
+		{
+			return;
+		}
+
+		FImage Golden;
+		if (!FPaths::FileExists(GoldenPath))
+		{
+			if (!Args.Contains(TEXT("CreateGolden")))
+			{
+				Ar.Logf(ELogVerbosity::Error, TEXT("MeshPaint.ReferenceRaster: FAILED, golden '%s' does not exist, pass CreateGolden to create it"), *GoldenPath);
+				return;
+			}
+			const bool bSaved = FImageUtils::SaveImageByExtension(*GoldenPath, Image);
+			Ar.Logf(bSaved ? ELogVerbosity::Display : ELogVerbosity::Error, TEXT("MeshPaint.ReferenceRaster: golden '%s' %s"), *GoldenPath, bSaved ? TEXT("created") : TEXT("FAILED to create"));
+			return;
+		}
+		if (!FImageUtils::LoadImage(*GoldenPath, Golden))
+		{
+			Ar.Logf(ELogVerbosity::Error, TEXT("MeshPaint.ReferenceRaster: FAILED, unable to load golden '%s'"), *GoldenPath);
+			return;
+		}
+
+		FImage Difference;
+		const FMeshPaintReferenceRasterizer::FComparison Comparison = FMeshPaintReferenceRasterizer::Compare(Image, Golden, Tolerance, &Difference);
+		if (!Comparison.Passed())
+		{
+			FImageUtils::SaveImageByExtension(*FPaths::Combine(FPaths::GetPath(GoldenPath), FPaths::GetBaseFilename(GoldenPath) + TEXT("_Diff.exr")), Difference);
+		}
+		Ar.Logf(Comparison.Passed() ? ELogVerbosity::Display : ELogVerbosity::Error, TEXT("MeshPaint.ReferenceRaster: %s, %lld texels above tolerance %f, max error %f%s"),
+			Comparison.Passed() ? TEXT("PASSED") : TEXT("FAILED"), Comparison.NumMismatchedTexels, Tolerance, Comparison.MaxError, Comparison.bSizeMatches ? TEXT("") : TEXT(", size mismatch"));
+	}));
@@ -0,0 +1,395 @@
+#include "MeshPaintResidencySubsystem.h"
+#include "MeshPainterStats.h"
+#include "Engine/TextureRenderTarget2D.h"
+#include "Engine/World.h"
+#include "Components/PrimitiveComponent.h"
+#include "Misc/Compression.h"
+#include "RHIGPUReadback.h"
+#include "TextureResource.h"
+
+static int32 GMeshPaintResidencyBudgetMB = 512;
+static FAutoConsoleVariableRef CVarMeshPaintResidencyBudgetMB(
+	TEXT("r.MeshPaint.Residency.BudgetMB"),
+	GMeshPaintResidencyBudgetMB,
+	TEXT("GPU memory managed paint targets of a world may use before the least recently visible ones are evicted to CPU memory, 0 disables eviction"));
+
+static float GMeshPaintResidencyMinHiddenSeconds = 5.0f;
+static FAutoConsoleVariableRef CVarMeshPaintResidencyMinHiddenSeconds(
+	TEXT("r.MeshPaint.Residency.MinHiddenSeconds"),
+	GMeshPaintResidencyMinHiddenSeconds,
+	TEXT("Time a paint target has to stay off screen before it can be evicted"));
+
+static int32 GMeshPaintResidencyUseOodle = 1;
+static FAutoConsoleVariableRef CVarMeshPaintResidencyUseOodle(
+	TEXT("r.MeshPaint.Residency.UseOodle"),
+	GMeshPaintResidencyUseOodle,
+	TEXT("Compress evicted paint targets with Oodle, LZ4 otherwise"));
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Resident paint targets"), STAT_MeshPaint_ResidentTargets, STATGROUP_MeshPaint);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Evicted paint targets"), STAT_MeshPaint_EvictedTargets, STATGROUP_MeshPaint);
+DECLARE_MEMORY_STAT(TEXT("Resident paint target memory"), STAT_MeshPaint_ResidentMemory, STATGROUP_MeshPaint);
+DECLARE_MEMORY_STAT(TEXT("Evicted paint target memory"), STAT_MeshPaint_EvictedMemory, STATGROUP_MeshPaint);
+DECLARE_MEMORY_STAT(TEXT("Compressed paint target memory"), STAT_MeshPaint_CompressedMemory, STATGROUP_MeshPaint);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Paint target promotion latency (ms)"), STAT_MeshPaint_PromotionLatency, STATGROUP_MeshPaint);
+
+void UMeshPaintResidencySubsystem::Deinitialize()
+{
+	// Targets may outlive the world, hand them back with their contents
+	for (FEntry& Entry : Entries)
+	{
+		if (Entry.Target.IsValid())
+		{
+			EnsureResident(Entry.Target.Get());
+		}
+	}
+	Entries.Reset();
+	UpdateStats();
+
+	Super::Deinitialize();
+}
+
+TStatId UMeshPaintResidencySubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UMeshPaintResidencySubsystem, STATGROUP_Tickables);
+}
+
+UMeshPaintResidencySubsystem::FEntry* UMeshPaintResidencySubsystem::FindEntry(const UTextureRenderTarget2D* Target)
+{
+	return Entries.FindByPredicate([Target](const FEntry& Entry) { return Entry.Target.Get() == Target; });
+}
+
+void UMeshPaintResidencySubsystem::RegisterTarget(UTextureRenderTarget2D* Target, UPrimitiveComponent* VisibilitySource)
+{
+	check(IsInGameThread());
+	if (!IsValid(Target)) return;
+
+	FEntry* Entry = FindEntry(Target);
+	if (!Entry)
+	{
+		Entry = &Entries.AddDefaulted_GetRef();
+		Entry->Target = Target;
+		Entry->LastVisibleTime = GetWorld()->GetTimeSeconds();
+	}
+	if (VisibilitySource)
+	{
+		Entry->VisibilitySources.AddUnique(VisibilitySource);
+	}
+}
+
+void UMeshPaintResidencySubsystem::UnregisterTarget(UTextureRenderTarget2D* Target, UPrimitiveComponent* VisibilitySource)
+{
+	check(IsInGameThread());
+
+	FEntry* Entry = FindEntry(Target);
+	if (!Entry) return;
+
+	Entry->VisibilitySources.Remove(VisibilitySource);
+	if (Entry->VisibilitySources.IsEmpty())
+	{
+		EnsureResident(Target);
+		Entries.RemoveAtSwap(UE_PTRDIFF_TO_INT32(Entry - Entries.GetData()));
+	}
+}
+
+bool UMeshPaintResidencySubsystem::EnsureResident(UTextureRenderTarget2D* Target)
+{
+	check(IsInGameThread());
+
+	FEntry* Entry = FindEntry(Target);
+	if (!Entry) return false;
+
+	// Paint counts as use, the target must not be evicted right after
+	Entry->LastVisibleTime = GetWorld() ? GetWorld()->GetTimeSeconds() : Entry->LastVisibleTime;
+
+	switch (Entry->State)
+	{
+	case EState::ReadingBack:
+	case EState::Compressing:
+		// The contents are still on the GPU, in flight work only holds references to its own payload
+		Entry->Readback.Reset();
+		Entry->Payload.Reset();
+		Entry->State = EState::Resident;
+		break;
+	case EState::Evicted:
+		StartPromotion(*Entry, true);
+		break;
+	case EState::Decompressing:
+		Entry->DecompressTask.Wait();
+		Upload(*Entry);
+		break;
+	default:
+		break;
+	}
+	return true;
+}
+
+void UMeshPaintResidencySubsystem::EnsureTargetsResident(UWorld* World, TConstArrayView<UTextureRenderTarget2D*> Targets)
+{
+	UMeshPaintResidencySubsystem* Subsystem = World ? World->GetSubsystem<UMeshPaintResidencySubsystem>() : nullptr;
+	if (!Subsystem || Subsystem->Entries.IsEmpty()) return;
+
+	for (UTextureRenderTarget2D* Target : Targets)
+	{
+		if (Target)
+		{
+			Subsystem->EnsureResident(Target);
+		}
+	}
+}
+
+bool UMeshPaintResidencySubsystem::IsTargetResident(UWorld* World, const UTextureRenderTarget2D* Target)
+{
+	UMeshPaintResidencySubsystem* Subsystem = World ? World->GetSubsystem<UMeshPaintResidencySubsystem>() : nullptr;
+	const FEntry* Entry = Subsystem ? Subsystem->FindEntry(Target) : nullptr;
+	return !Entry || Entry->State == EState::Resident;
+}
+
+void UMeshPaintResidencySubsystem::UpdateVisibility(FEntry& Entry, double Now) const
+{
+	for (const TWeakObjectPtr<UPrimitiveComponent>& Source : Entry.VisibilitySources)
+	{
+		if (const UPrimitiveComponent* Component = Source.Get())
+		{
+			Entry.LastVisibleTime = FMath::Max(Entry.LastVisibleTime, (double)Component->GetLastRenderTimeOnScreen());
+		}
+	}
+}
+
+void UMeshPaintResidencySubsystem::StartEviction(FEntry& Entry)
+{
+	UTextureRenderTarget2D* Target = Entry.Target.Get();
+	FTextureRenderTargetResource* Resource = Target ? Target->GameThread_GetRenderTargetResource() : nullptr;
+	if (!Resource) return;
+
+	Entry.Extent = FIntPoint(Target->SizeX, Target->SizeY);
+	Entry.Format = Target->GetFormat();
+	Entry.Readback = MakeShared<FRHIGPUTextureReadback>(TEXT("MeshPaintResidencyReadback"));
+	Entry.State = EState::ReadingBack;
+
+	ENQUEUE_RENDER_COMMAND(MeshPaintResidencyReadback)([Readback = Entry.Readback, Resource](FRHICommandListImmediate& RHICmdList)
+	{
+		Readback->EnqueueCopy(RHICmdList, Resource->GetRenderTargetTexture());
+	});
+}
+
+void UMeshPaintResidencySubsystem::StartPromotion(FEntry& Entry, bool bSynchronous)
+{
+	Entry.PromotionStartTime = FPlatformTime::Seconds();
+	Entry.Payload->bReady = false;
+
+	auto Decompress = [Payload = Entry.Payload]()
+	{
+		MESH_PAINT_TRACE_SCOPE(DecompressPaintTarget);
+
+		Payload->UncompressedData.SetNumUninitialized(Payload->UncompressedSize);
+		if (Payload->CompressionFormat.IsNone()
+			|| !FCompression::UncompressMemory(Payload->CompressionFormat, Payload->UncompressedData.GetData(), Payload->UncompressedSize, Payload->CompressedData.GetData(), Payload->CompressedData.Num()))
+		{
+			FMemory::Memcpy(Payload->UncompressedData.GetData(), Payload->CompressedData.GetData(), FMath::Min(Payload->UncompressedSize, Payload->CompressedData.Num()));
+		}
+		Payload->bReady = true;
+	};
+
+	if (bSynchronous)
+	{
+		Decompress();
+		Upload(Entry);
+	}
+	else
+	{
+		Entry.DecompressTask = UE::Tasks::Launch(UE_SOURCE_LOCATION, MoveTemp(Decompress));
+		Entry.State = EState::Decompressing;
+	}
+}
+
+void UMeshPaintResidencySubsystem::Upload(FEntry& Entry)
+{
+	UTextureRenderTarget2D* Target = Entry.Target.Get();
+	if (!Target) return;
+
+	MESH_PAINT_TRACE_SCOPE(UploadPaintTarget);
+
+	Target->UpdateResource();
+	FTextureRenderTargetResource* Resource = Target->GameThread_GetRenderTargetResource();
+	if (Resource)
+	{
+		// The pending clear of the new resource has to run before the upload, not over it
+		ENQUEUE_RENDER_COMMAND(MeshPaintResidencyUpload)([Resource, Payload = Entry.Payload, Extent = Entry.Extent, Format = Entry.Format](FRHICommandListImmediate& RHICmdList)
+		{
+			Resource->FlushDeferredResourceUpdate(RHICmdList);
+			const uint32 SourcePitch = Extent.X * GPixelFormats[Format].BlockBytes;
+			RHICmdList.UpdateTexture2D(Resource->GetRenderTargetTexture(), 0, FUpdateTextureRegion2D(0, 0, 0, 0, Extent.X, Extent.Y), SourcePitch, Payload->UncompressedData.GetData());
+		});
+
+		// Only the top mip is stored, the others are rebuilt from it after the upload like after painting
+		if (Target->bAutoGenerateMips)
+		{
+			Target->UpdateResourceImmediate(false);
+		}
+	}
+
+	Stats.LastPromotionSeconds = FPlatformTime::Seconds() - Entry.PromotionStartTime;
+	Stats.MaxPromotionSeconds = FMath::Max(Stats.MaxPromotionSeconds, Stats.LastPromotionSeconds);
+	SET_FLOAT_STAT(STAT_MeshPaint_PromotionLatency, Stats.LastPromotionSeconds * 1000.0);
+
+	Entry.Payload.Reset();
+	Entry.State = EState::Resident;
+}
+
+void UMeshPaintResidencySubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+	MESH_PAINT_TRACE_SCOPE(ResidencyTick);
+
+	const double Now = GetWorld()->GetTimeSeconds();
+	const FName CompressionFormat = GMeshPaintResidencyUseOodle ? NAME_Oodle : NAME_LZ4;
+
+	Entries.RemoveAllSwap([](const FEntry& Entry) { return !Entry.Target.IsValid(); });
+
+	uint64 ResidentBytes = 0;
+	for (FEntry& Entry : Entries)
+	{
+		UpdateVisibility(Entry, Now);
+		const bool bRecentlyVisible = Now - Entry.LastVisibleTime < GMeshPaintResidencyMinHiddenSeconds;
+
+		switch (Entry.State)
+		{
+		case EState::ReadingBack:
+			if (bRecentlyVisible)
+			{
+				EnsureResident(Entry.Target.Get());
+			}
+			else if (Entry.Readback->IsReady())
+			{
+				Entry.Payload = MakeShared<FPayload, ESPMode::ThreadSafe>();
+				Entry.State = EState::Compressing;
+
+				ENQUEUE_RENDER_COMMAND(MeshPaintResidencyCompress)([Readback = Entry.Readback, Payload = Entry.Payload, Extent = Entry.Extent, Format = Entry.Format, CompressionFormat](FRHICommandListImmediate&)
+				{
+					const int32 RowBytes = Extent.X * GPixelFormats[Format].BlockBytes;
+					int32 RowPitchInPixels = 0;
+					const uint8* Source = (const uint8*)Readback->Lock(RowPitchInPixels);
+					const int32 SourcePitch = RowPitchInPixels * GPixelFormats[Format].BlockBytes;
+
+					Payload->UncompressedSize = RowBytes * Extent.Y;
+					Payload->UncompressedData.SetNumUninitialized(Payload->UncompressedSize);
+					for (int32 Row = 0; Row < Extent.Y; ++Row)
+					{
+						FMemory::Memcpy(Payload->UncompressedData.GetData() + Row * RowBytes, Source + Row * SourcePitch, RowBytes);
+					}
+					Readback->Unlock();
+
+					UE::Tasks::Launch(UE_SOURCE_LOCATION, [Payload, CompressionFormat]()
+					{
+						MESH_PAINT_TRACE_SCOPE(CompressPaintTarget);
+
+						int32 CompressedSize = FCompression::CompressMemoryBound(CompressionFormat, Payload->UncompressedSize);
+						Payload->CompressedData.SetNumUninitialized(CompressedSize);
+						if (FCompression::CompressMemory(CompressionFormat, Payload->CompressedData.GetData(), CompressedSize, Payload->UncompressedData.GetData(), Payload->UncompressedSize))
+						{
+							Payload->CompressedData.SetNum(CompressedSize);
+							Payload->CompressionFormat = CompressionFormat;
+						}
+						else
+						{
+							Payload->CompressedData = MoveTemp(Payload->UncompressedData);
+							Payload->CompressionFormat = NAME_None;
+						}
+						Payload->UncompressedData.Empty();
+						Payload->bReady = true;
+					});
+				});
+				Entry.Readback.Reset();
+			}
+			break;
+
+		case EState::Compressing:
+			if (bRecentlyVisible)
+			{
+				EnsureResident(Entry.Target.Get());
+			}
+			else if (Entry.Payload->bReady)
+			{
+				Entry.Target->ReleaseResource();
+				Entry.State = EState::Evicted;
+			}
+			break;
+
+		case EState::Evicted:
+			if (bRecentlyVisible)
+			{
+				StartPromotion(Entry, false);
+			}
+			break;
+
+		case EState::Decompressing:
+			if (Entry.Payload->bReady)
+			{
+				Upload(Entry);
+			}
+			break;
+
+		default:
+			break;
+		}
+
+		Entry.SizeInBytes = (uint64)Entry.Target->SizeX * Entry.Target->SizeY * GPixelFormats[Entry.Target->GetFormat()].BlockBytes;
+		ResidentBytes += Entry.State != EState::Evicted ? Entry.SizeInBytes : 0;
+	}
+
+	// Least recently visible targets go first, targets already on their way out count as freed
+	const uint64 BudgetBytes = (uint64)FMath::Max(GMeshPaintResidencyBudgetMB, 0) * 1024 * 1024;
+	if (BudgetBytes > 0 && ResidentBytes > BudgetBytes)
+	{
+		TArray<FEntry*, TInlineAllocator<64>> Candidates;
+		for (FEntry& Entry : Entries)
+		{
+			if (Entry.State == EState::ReadingBack || Entry.State == EState::Compressing)
+			{
+				ResidentBytes -= Entry.SizeInBytes;
+			}
+			else if (Entry.State == EState::Resident && Now - Entry.LastVisibleTime >= GMeshPaintResidencyMinHiddenSeconds)
+			{
+				Candidates.Add(&Entry);
+			}
+		}
+		Candidates.Sort([](const FEntry& A, const FEntry& B) { return A.LastVisibleTime < B.LastVisibleTime; });
+
+		for (FEntry* Entry : Candidates)
+		{
+			if (ResidentBytes <= BudgetBytes) break;
+			StartEviction(*Entry);
+			ResidentBytes -= Entry->State == EState::ReadingBack ? Entry->SizeInBytes : 0;
+		}
+	}
+
+	UpdateStats();
+}
+
+void UMeshPaintResidencySubsystem::UpdateStats()
+{
+	FStats NewStats;
+	NewStats.LastPromotionSeconds = Stats.LastPromotionSeconds;
+	NewStats.MaxPromotionSeconds = Stats.MaxPromotionSeconds;
+	for (const FEntry& Entry : Entries)
+	{
+		if (Entry.State == EState::Evicted || Entry.State == EState::Decompressing)
+		{
+			NewStats.NumEvicted++;
+			NewStats.EvictedBytes += Entry.SizeInBytes;
+			NewStats.CompressedBytes += Entry.Payload.IsValid() ? Entry.Payload->CompressedData.Num() : 0;
+		}
+		else
+		{
+			NewStats.NumResident++;
+			NewStats.ResidentBytes += Entry.SizeInBytes;
+		}
+	}
+	Stats = NewStats;
+
+	SET_DWORD_STAT(STAT_MeshPaint_ResidentTargets, Stats.NumResident);
+	SET_DWORD_STAT(STAT_MeshPaint_EvictedTargets, Stats.NumEvicted);
+	SET_MEMORY_STAT(STAT_MeshPaint_ResidentMemory, Stats.ResidentBytes);
+	SET_MEMORY_STAT(STAT_MeshPaint_EvictedMemory, Stats.EvictedBytes);
+	SET_MEMORY_STAT(STAT_MeshPaint_CompressedMemory, Stats.CompressedBytes);
+}
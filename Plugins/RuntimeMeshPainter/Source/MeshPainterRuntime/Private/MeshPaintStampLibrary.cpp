@@ -0,0 +1,62 @@
+#include "MeshPaintStampLibrary.h"
+#include "RuntimeMeshPainter.h"
+#include "Engine/Texture2D.h"
+#include "Engine/Texture2DArray.h"
+
+UMeshPaintStampLibrary::UMeshPaintStampLibrary()
+	: MaskArray(nullptr)
+{
+}
+
+#if WITH_EDITOR
+void UMeshPaintStampLibrary::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	if (PropertyChangedEvent.GetMemberPropertyName() == GET_MEMBER_NAME_CHECKED(UMeshPaintStampLibrary, Masks))
+	{
+		RebuildMaskArray();
+	}
+}
+
+bool UMeshPaintStampLibrary::RebuildMaskArray()
+{
+	TArray<UTexture2D*> ValidMasks = Masks;
+	ValidMasks.Remove(nullptr);
+	if (ValidMasks.IsEmpty())
+	{
+		MaskArray = nullptr;
+		MarkPackageDirty();
+		return true;
+	}
+
+	if (!MaskArray)
+	{
+		MaskArray = NewObject<UTexture2DArray>(this, TEXT("MaskArray"));
+	}
+
+	// Masks are sampled with the texel footprint, far stamps need every mip and should not wait for streaming
+	MaskArray->SourceTextures = ValidMasks;
+	MaskArray->SRGB = false;
+	MaskArray->CompressionSettings = ValidMasks[0]->CompressionSettings;
+	MaskArray->MipGenSettings = TMGS_FromTextureGroup;
+	MaskArray->AddressX = TA_Clamp;
+	MaskArray->AddressY = TA_Clamp;
+	MaskArray->NeverStream = true;
+
+	if (!MaskArray->CheckArrayTexturesCompatibility())
+	{
+		UE_LOG(LogMeshPainter, Warning, TEXT("Masks of %s differ in size or format and cannot be packed"), *GetPathName());
+		return false;
+	}
+
+	MaskArray->UpdateSourceFromSourceTextures(false);
+	MarkPackageDirty();
+	return true;
+}
+#endif
+
+int32 UMeshPaintStampLibrary::GetNumShapes() const
+{
+	return MaskArray ? MaskArray->GetArraySize() : 0;
+}
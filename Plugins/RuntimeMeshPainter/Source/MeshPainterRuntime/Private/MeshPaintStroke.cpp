@@ -0,0 +1,110 @@
+#include "MeshPaintStroke.h"
+#include "MeshPainterStats.h"
+
+namespace MeshPaintStroke
+{
+	/** Segments a smooth stroke span is flattened into */
+	static constexpr int32 SmoothSubdivisions = 8;
+
+	struct FStrokeVertex
+	{
+		FVector Location;
+		float Pressure;
+	};
+
+	static float GetPressure(const FMeshPaintStroke& Stroke, int32 PointIndex)
+	{
+		return Stroke.Pressures.IsValidIndex(PointIndex) ? FMath::Clamp(Stroke.Pressures[PointIndex], 0.0f, 1.0f) : 1.0f;
+	}
+
+	/** Turns the stroke into a polyline, smooth strokes are sampled along a uniform Catmull-Rom spline */
+	static void BuildPolyline(const FMeshPaintStroke& Stroke, TArray<FStrokeVertex>& OutVertices)
+	{
+		const int32 NumPoints = Stroke.Points.Num();
+		if (!Stroke.bSmooth || NumPoints < 3)
+		{
+			OutVertices.Reserve(NumPoints);
+			for (int32 PointIndex = 0; PointIndex < NumPoints; ++PointIndex)
+			{
+				OutVertices.Add({ Stroke.Points[PointIndex], GetPressure(Stroke, PointIndex) });
+			}
+			return;
+		}
+
+		OutVertices.Reserve((NumPoints - 1) * SmoothSubdivisions + 1);
+		for (int32 PointIndex = 0; PointIndex < NumPoints - 1; ++PointIndex)
+		{
+			const FVector& P0 = Stroke.Points[FMath::Max(PointIndex - 1, 0)];
+			const FVector& P1 = Stroke.Points[PointIndex];
+			const FVector& P2 = Stroke.Points[PointIndex + 1];
+			const FVector& P3 = Stroke.Points[FMath::Min(PointIndex + 2, NumPoints - 1)];
+			const float Pressure1 = GetPressure(Stroke, PointIndex);
+			const float Pressure2 = GetPressure(Stroke, PointIndex + 1);
+
+			for (int32 Step = 0; Step < SmoothSubdivisions; ++Step)
+			{
+				const float T = (float)Step / SmoothSubdivisions;
+				const float T2 = T * T;
+				const float T3 = T2 * T;
+				const FVector Location = 0.5f * ((2.0f * P1) + (P2 - P0) * T + (2.0f * P0 - 5.0f * P1 + 4.0f * P2 - P3) * T2 + (3.0f * P1 - P0 - 3.0f * P2 + P3) * T3);
+				OutVertices.Add({ Location, FMath::Lerp(Pressure1, Pressure2, T) });
+			}
+		}
+		OutVertices.Add({ Stroke.Points.Last(), GetPressure(Stroke, NumPoints - 1) });
+	}
+
+	void ExpandStroke(const FMeshPaintStroke& Stroke, TArray<FMeshPaintBrushStamp>& OutStamps)
+	{
+		MESH_PAINT_TRACE_SCOPE(ExpandStroke);
+
+		if (Stroke.Points.IsEmpty() || Stroke.Brush.Radius <= 0.0f || Stroke.Brush.Strength <= 0.0f) return;
+
+		TArray<FStrokeVertex> Vertices;
+		BuildPolyline(Stroke, Vertices);
+
+		double Length = 0.0;
+		for (int32 VertexIndex = 1; VertexIndex < Vertices.Num(); ++VertexIndex)
+		{
+			Length += FVector::Distance(Vertices[VertexIndex - 1].Location, Vertices[VertexIndex].Location);
+		}
+
+		const double Step = FMath::Max3((double)Stroke.Spacing * Stroke.Brush.Radius, Length / (MaxStampsPerStroke - 1), UE_KINDA_SMALL_NUMBER);
+
+		auto AddStamp = [&](const FVector& Location, float Pressure)
+		{
+			FMeshPaintBrushStamp& Stamp = OutStamps.Add_GetRef(Stroke.Brush);
+			Stamp.Location = Location;
+			Stamp.Strength *= Pressure;
+		};
+
+		AddStamp(Vertices[0].Location, Vertices[0].Pressure);
+
+		// Distance left to walk before the next stamp carries over segment boundaries
+		double DistanceToNextStamp = Step;
+		for (int32 VertexIndex = 1; VertexIndex < Vertices.Num(); ++VertexIndex)
+		{
+			const FStrokeVertex& Start = Vertices[VertexIndex - 1];
+			const FStrokeVertex& End = Vertices[VertexIndex];
+			const double SegmentLength = FVector::Distance(Start.Location, End.Location);
+
+			double Position = DistanceToNextStamp;
+			while (Position <= SegmentLength)
+			{
+				const float Alpha = (float)(Position / SegmentLength);
+				AddStamp(FMath::Lerp(Start.Location, End.Location, (double)Alpha), FMath::Lerp(Start.Pressure, End.Pressure, Alpha));
+				Position += Step;
+			}
+			DistanceToNextStamp = Position - SegmentLength;
+		}
+	}
+
+	UE::Tasks::TTask<TArray<FMeshPaintBrushStamp>> LaunchExpandStroke(FMeshPaintStroke Stroke)
+	{
+		return UE::Tasks::Launch(UE_SOURCE_LOCATION, [Stroke = MoveTemp(Stroke)]()
+		{
+			TArray<FMeshPaintBrushStamp> Stamps;
+			ExpandStroke(Stroke, Stamps);
+			return Stamps;
+		});
+	}
+}
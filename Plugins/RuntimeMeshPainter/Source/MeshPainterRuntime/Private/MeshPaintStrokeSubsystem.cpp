@@ -0,0 +1,113 @@
+#include "MeshPaintStrokeSubsystem.h"
+#include "MeshPaintStroke.h"
+#include "MeshPainterStats.h"
+#include "Components/PrimitiveComponent.h"
+
+void UMeshPaintStrokeSubsystem::Deinitialize()
+{
+	// Expansions only reference their own copy of the stroke, waiting keeps task lifetime simple
+	for (FMeshPaintStrokeBatch& Batch : PendingBatches)
+	{
+		UE::Tasks::Wait(Batch.Expansions);
+	}
+	PendingBatches.Reset();
+
+	Super::Deinitialize();
+}
+
+void UMeshPaintStrokeSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+	Flush();
+}
+
+TStatId UMeshPaintStrokeSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UMeshPaintStrokeSubsystem, STATGROUP_Tickables);
+}
+
+void UMeshPaintStrokeSubsystem::QueueStroke(
+	const TArray<FRenderMaterialOnMeshPrimitive>& Components,
+	UMaterialInterface* Material,
+	UTextureRenderTarget2D* BaseColor,
+	UTextureRenderTarget2D* Emissive,
+	UTextureRenderTarget2D* NormalMap,
+	const FMeshPaintStroke& Stroke,
+	EMeshPaintBlendMode BlendMode,
+	float BlendThreshold,
+	bool bUpdatePaintMirrors)
+{
+	check(IsInGameThread());
+	if (Components.IsEmpty() || Stroke.Points.IsEmpty()) return;
+
+	FMeshPaintStrokeBatch* Batch = PendingBatches.FindByPredicate([&](const FMeshPaintStrokeBatch& Existing)
+	{
+		return Existing.Material == Material && Existing.BaseColor == BaseColor && Existing.Emissive == Emissive && Existing.NormalMap == NormalMap
+			&& Existing.BlendMode == BlendMode && Existing.BlendThreshold == BlendThreshold && Existing.bUpdatePaintMirrors == bUpdatePaintMirrors;
+	});
+	if (!Batch)
+	{
+		Batch = &PendingBatches.AddDefaulted_GetRef();
+		Batch->Material = Material;
+		Batch->BaseColor = BaseColor;
+		Batch->Emissive = Emissive;
+		Batch->NormalMap = NormalMap;
+		Batch->BlendMode = BlendMode;
+		Batch->BlendThreshold = BlendThreshold;
+		Batch->bUpdatePaintMirrors = bUpdatePaintMirrors;
+	}
+
+	// The same component may be painted in several atlas cells or slices, only exact duplicates are merged
+	for (const FRenderMaterialOnMeshPrimitive& Component : Components)
+	{
+		if (!Batch->Components.ContainsByPredicate([&](const FRenderMaterialOnMeshPrimitive& Existing)
+			{
+				return Existing.MeshComponent == Component.MeshComponent && Existing.DesiredLOD == Component.DesiredLOD && Existing.DesiredUV == Component.DesiredUV
+					&& Existing.UVRegion == Component.UVRegion && Existing.ArraySlice == Component.ArraySlice && Existing.bReferencePose == Component.bReferencePose;
+			}))
+		{
+			Batch->Components.Add(Component);
+		}
+	}
+	Batch->Expansions.Add(MeshPaintStroke::LaunchExpandStroke(Stroke));
+}
+
+void UMeshPaintStrokeSubsystem::Flush()
+{
+	check(IsInGameThread());
+	if (PendingBatches.IsEmpty()) return;
+
+	MESH_PAINT_TRACE_SCOPE(FlushStrokes);
+
+	// Painting may queue new strokes through callbacks, those go into the next flush
+	TArray<FMeshPaintStrokeBatch> Batches = MoveTemp(PendingBatches);
+	UWorld* World = GetWorld();
+
+	for (FMeshPaintStrokeBatch& Batch : Batches)
+	{
+		TArray<FMeshPaintBrushStamp> Stamps;
+		for (UE::Tasks::TTask<TArray<FMeshPaintBrushStamp>>& Expansion : Batch.Expansions)
+		{
+			Stamps.Append(MoveTemp(Expansion.GetResult()));
+		}
+		if (Stamps.IsEmpty()) continue;
+
+		FBox StampBounds(ForceInit);
+		for (const FMeshPaintBrushStamp& Stamp : Stamps)
+		{
+			StampBounds += FBox::BuildAABB(Stamp.Location, FVector(Stamp.Radius));
+		}
+
+		// Components away from the whole stroke would only rasterize texels the brush clips
+		Batch.Components.RemoveAll([&](const FRenderMaterialOnMeshPrimitive& Component)
+		{
+			return !IsValid(Component.MeshComponent) || !Component.MeshComponent->Bounds.GetBox().Intersect(StampBounds);
+		});
+
+		// Mirrors of the painted components are updated by the paint call itself
+		if (!Batch.Components.IsEmpty())
+		{
+			UMeshPainterFunctionLibrary::RenderBrushStampsOnMesh(World, MakeArrayView(Batch.Components), Batch.Material, Batch.BaseColor, Batch.Emissive, Batch.NormalMap, Stamps, Batch.BlendMode, Batch.BlendThreshold, nullptr, Batch.bUpdatePaintMirrors);
+		}
+	}
+}
@@ -0,0 +1,331 @@
+#include "MeshPaintTriangleBVH.h"
+#include "StaticMeshResources.h"
+#include "Algo/Sort.h"
+
+namespace MeshPaintTriangleBVH
+{
+	static constexpr int32 MaxLeafTriangles = 4;
+
+	/** Outward normal of a render triangle, engine meshes wind their front faces clockwise */
+	static FVector3f GetWindingNormal(const FVector3f& P0, const FVector3f& P1, const FVector3f& P2)
+	{
+		return (P2 - P0) ^ (P1 - P0);
+	}
+
+	/** Closest point on a triangle expressed in barycentrics (Ericson, Real-Time Collision Detection 5.1.5) */
+	static FVector3f ClosestPointBarycentrics(const FVector3f& P, const FVector3f& A, const FVector3f& B, const FVector3f& C)
+	{
+		const FVector3f AB = B - A;
+		const FVector3f AC = C - A;
+		const FVector3f AP = P - A;
+		const float D1 = AB | AP;
+		const float D2 = AC | AP;
+		if (D1 <= 0.0f && D2 <= 0.0f) return FVector3f(1.0f, 0.0f, 0.0f);
+
+		const FVector3f BP = P - B;
+		const float D3 = AB | BP;
+		const float D4 = AC | BP;
+		if (D3 >= 0.0f && D4 <= D3) return FVector3f(0.0f, 1.0f, 0.0f);
+
+		const float VC = D1 * D4 - D3 * D2;
+		if (VC <= 0.0f && D1 >= 0.0f && D3 <= 0.0f)
+		{
+			const float V = D1 / (D1 - D3);
+			return FVector3f(1.0f - V, V, 0.0f);
+		}
+
+		const FVector3f CP = P - C;
+		const float D5 = AB | CP;
+		const float D6 = AC | CP;
+		if (D6 >= 0.0f && D5 <= D6) return FVector3f(0.0f, 0.0f, 1.0f);
+
+		const float VB = D5 * D2 - D1 * D6;
+		if (VB <= 0.0f && D2 >= 0.0f && D6 <= 0.0f)
+		{
+			const float W = D2 / (D2 - D6);
+			return FVector3f(1.0f - W, 0.0f, W);
+		}
+
+		const float VA = D3 * D6 - D5 * D4;
+		if (VA <= 0.0f && (D4 - D3) >= 0.0f && (D5 - D6) >= 0.0f)
+		{
+			const float W = (D4 - D3) / ((D4 - D3) + (D5 - D6));
+			return FVector3f(0.0f, 1.0f - W, W);
+		}
+
+		const float Denominator = VA + VB + VC;
+		if (!(FMath::Abs(Denominator) > UE_SMALL_NUMBER))
+		{
+			// Degenerate triangle, fall back to the first vertex
+			return FVector3f(1.0f, 0.0f, 0.0f);
+		}
+		const float V = VB / Denominator;
+		const float W = VC / Denominator;
+		return FVector3f(1.0f - V - W, V, W);
+	}
+}
+
+bool FMeshPaintTriangleBVH::Build(const FStaticMeshLODResources& LODResources, int32 UVChannel)
+{
+	const FPositionVertexBuffer& PositionBuffer = LODResources.VertexBuffers.PositionVertexBuffer;
+	const FStaticMeshVertexBuffer& VertexBuffer = LODResources.VertexBuffers.StaticMeshVertexBuffer;
+	const FIndexArrayView IndexView = LODResources.IndexBuffer.GetArrayView();
+
+	const int32 NumVertices = PositionBuffer.GetNumVertices();
+	if (NumVertices == 0 || IndexView.Num() < 3 || PositionBuffer.GetVertexData() == nullptr || VertexBuffer.GetTexCoordData() == nullptr)
+	{
+		return false;
+	}
+
+	const uint32 UVIndex = FMath::Clamp<uint32>(UVChannel, 0, VertexBuffer.GetNumTexCoords() - 1);
+
+	TArray<FVector3f> SourcePositions;
+	TArray<FVector2f> SourceUVs;
+	SourcePositions.SetNumUninitialized(NumVertices);
+	SourceUVs.SetNumUninitialized(NumVertices);
+	for (int32 VertexIndex = 0; VertexIndex < NumVertices; ++VertexIndex)
+	{
+		SourcePositions[VertexIndex] = PositionBuffer.VertexPosition(VertexIndex);
+		SourceUVs[VertexIndex] = VertexBuffer.GetVertexUV(VertexIndex, UVIndex);
+	}
+
+	TArray<uint32> SourceIndices;
+	SourceIndices.SetNumUninitialized(IndexView.Num() - IndexView.Num() % 3);
+	for (int32 Index = 0; Index < SourceIndices.Num(); ++Index)
+	{
+		SourceIndices[Index] = IndexView[Index];
+	}
+
+	Build(MoveTemp(SourcePositions), MoveTemp(SourceUVs), SourceIndices);
+	return IsValid();
+}
+
+void FMeshPaintTriangleBVH::Build(TArray<FVector3f>&& InPositions, TArray<FVector2f>&& InUVs, const TArray<uint32>& InIndices)
+{
+	Positions = MoveTemp(InPositions);
+	UVs = MoveTemp(InUVs);
+	Nodes.Reset();
+	Indices.Reset();
+	TriangleIds.Reset();
+	TriangleSlots.Reset();
+
+	const int32 NumTriangles = InIndices.Num() / 3;
+	if (NumTriangles == 0 || Positions.IsEmpty())
+	{
+		return;
+	}
+
+	TArray<FVector3f> Centroids;
+	Centroids.SetNumUninitialized(NumTriangles);
+	TriangleIds.SetNumUninitialized(NumTriangles);
+	for (int32 TriangleIndex = 0; TriangleIndex < NumTriangles; ++TriangleIndex)
+	{
+		const uint32 Base = TriangleIndex * 3;
+		Centroids[TriangleIndex] = (Positions[InIndices[Base]] + Positions[InIndices[Base + 1]] + Positions[InIndices[Base + 2]]) / 3.0f;
+		TriangleIds[TriangleIndex] = TriangleIndex;
+	}
+
+	auto GetSourceTriangleBounds = [&](uint32 TriangleIndex)
+	{
+		const uint32 Base = TriangleIndex * 3;
+		FBox3f Box(Positions[InIndices[Base]], Positions[InIndices[Base]]);
+		Box += Positions[InIndices[Base + 1]];
+		Box += Positions[InIndices[Base + 2]];
+		return Box;
+	};
+
+	struct FBuildTask
+	{
+		int32 NodeIndex;
+		int32 Begin;
+		int32 End;
+	};
+
+	Nodes.Reserve(FMath::Max(1, 2 * NumTriangles / MeshPaintTriangleBVH::MaxLeafTriangles));
+	Nodes.AddDefaulted();
+
+	TArray<FBuildTask, TInlineAllocator<64>> Tasks;
+	Tasks.Add({ 0, 0, NumTriangles });
+	while (!Tasks.IsEmpty())
+	{
+		const FBuildTask Task = Tasks.Pop(false);
+		const int32 Count = Task.End - Task.Begin;
+
+		FBox3f Bounds(ForceInit);
+		FBox3f CentroidBounds(ForceInit);
+		for (int32 Slot = Task.Begin; Slot < Task.End; ++Slot)
+		{
+			Bounds += GetSourceTriangleBounds(TriangleIds[Slot]);
+			CentroidBounds += Centroids[TriangleIds[Slot]];
+		}
+
+		Nodes[Task.NodeIndex].Min = Bounds.Min;
+		Nodes[Task.NodeIndex].Max = Bounds.Max;
+
+		const FVector3f CentroidExtent = CentroidBounds.GetSize();
+		const int32 Axis = CentroidExtent.X >= CentroidExtent.Y ? (CentroidExtent.X >= CentroidExtent.Z ? 0 : 2) : (CentroidExtent.Y >= CentroidExtent.Z ? 1 : 2);
+		if (Count <= MeshPaintTriangleBVH::MaxLeafTriangles || CentroidExtent[Axis] <= 0.0f)
+		{
+			Nodes[Task.NodeIndex].FirstIndex = Task.Begin;
+			Nodes[Task.NodeIndex].TriangleCount = Count;
+			continue;
+		}
+
+		// Median split along the longest centroid axis keeps the tree balanced
+		Algo::Sort(MakeArrayView(TriangleIds.GetData() + Task.Begin, Count), [&Centroids, Axis](uint32 A, uint32 B)
+		{
+			return Centroids[A][Axis] < Centroids[B][Axis];
+		});
+
+		const int32 ChildIndex = Nodes.Num();
+		Nodes.AddDefaulted(2);
+		Nodes[Task.NodeIndex].FirstIndex = ChildIndex;
+		Nodes[Task.NodeIndex].TriangleCount = 0;
+
+		const int32 Middle = Task.Begin + Count / 2;
+		Tasks.Add({ ChildIndex, Task.Begin, Middle });
+		Tasks.Add({ ChildIndex + 1, Middle, Task.End });
+	}
+	Nodes.Shrink();
+
+	Indices.SetNumUninitialized(NumTriangles * 3);
+	TriangleSlots.SetNumUninitialized(NumTriangles);
+	for (int32 Slot = 0; Slot < NumTriangles; ++Slot)
+	{
+		const uint32 TriangleIndex = TriangleIds[Slot];
+		Indices[Slot * 3 + 0] = InIndices[TriangleIndex * 3 + 0];
+		Indices[Slot * 3 + 1] = InIndices[TriangleIndex * 3 + 1];
+		Indices[Slot * 3 + 2] = InIndices[TriangleIndex * 3 + 2];
+		TriangleSlots[TriangleIndex] = Slot;
+	}
+}
+
+FBox3f FMeshPaintTriangleBVH::GetTriangleBounds(uint32 Slot) const
+{
+	const uint32 Base = Slot * 3;
+	FBox3f Box(Positions[Indices[Base]], Positions[Indices[Base]]);
+	Box += Positions[Indices[Base + 1]];
+	Box += Positions[Indices[Base + 2]];
+	return Box;
+}
+
+bool FMeshPaintTriangleBVH::FindClosestTriangle(const FVector3f& Point, float MaxDistance, FHit& OutHit, const FVector3f* FacingNormal) const
+{
+	OutHit = FHit();
+	if (!IsValid()) return false;
+
+	float BestDistanceSquared = FMath::Square(MaxDistance);
+
+	TArray<uint32, TInlineAllocator<64>> Stack;
+	Stack.Add(0);
+	while (!Stack.IsEmpty())
+	{
+		const FNode& Node = Nodes[Stack.Pop(false)];
+		if (Node.DistanceSquared(Point) > BestDistanceSquared) continue;
+
+		if (Node.IsLeaf())
+		{
+			for (uint32 Slot = Node.FirstIndex; Slot < Node.FirstIndex + Node.TriangleCount; ++Slot)
+			{
+				const FVector3f& P0 = Positions[Indices[Slot * 3 + 0]];
+				const FVector3f& P1 = Positions[Indices[Slot * 3 + 1]];
+				const FVector3f& P2 = Positions[Indices[Slot * 3 + 2]];
+				if (FacingNormal && MeshPaintTriangleBVH::GetWindingNormal(P0, P1, P2).Dot(*FacingNormal) < 0.0f) continue;
+
+				const FVector3f Barycentrics = MeshPaintTriangleBVH::ClosestPointBarycentrics(Point, P0, P1, P2);
+				const FVector3f ClosestPoint = P0 * Barycentrics.X + P1 * Barycentrics.Y + P2 * Barycentrics.Z;
+				const float DistanceSquared = FVector3f::DistSquared(ClosestPoint, Point);
+				if (DistanceSquared <= BestDistanceSquared)
+				{
+					BestDistanceSquared = DistanceSquared;
+					OutHit.TriangleIndex = TriangleIds[Slot];
+					OutHit.Barycentrics = Barycentrics;
+					OutHit.DistanceSquared = DistanceSquared;
+				}
+			}
+		}
+		else
+		{
+			// Visit the nearer child first, it is popped last
+			const uint32 Near = Node.FirstIndex;
+			const uint32 Far = Node.FirstIndex + 1;
+			if (Nodes[Near].DistanceSquared(Point) <= Nodes[Far].DistanceSquared(Point))
+			{
+				Stack.Add(Far);
+				Stack.Add(Near);
+			}
+			else
+			{
+				Stack.Add(Near);
+				Stack.Add(Far);
+			}
+		}
+	}
+
+	return OutHit.IsValid();
+}
+
+bool FMeshPaintTriangleBVH::GetClosestPointOnTriangle(int32 TriangleIndex, const FVector3f& Point, float MaxDistance, FHit& OutHit) const
+{
+	OutHit = FHit();
+	if (!TriangleSlots.IsValidIndex(TriangleIndex)) return false;
+
+	FVector3f P0, P1, P2;
+	GetTrianglePositions(TriangleIndex, P0, P1, P2);
+	const FVector3f Barycentrics = MeshPaintTriangleBVH::ClosestPointBarycentrics(Point, P0, P1, P2);
+	const float DistanceSquared = FVector3f::DistSquared(P0 * Barycentrics.X + P1 * Barycentrics.Y + P2 * Barycentrics.Z, Point);
+	if (DistanceSquared > FMath::Square(MaxDistance)) return false;
+
+	OutHit.TriangleIndex = TriangleIndex;
+	OutHit.Barycentrics = Barycentrics;
+	OutHit.DistanceSquared = DistanceSquared;
+	return true;
+}
+
+FVector3f FMeshPaintTriangleBVH::GetTriangleNormal(int32 TriangleIndex) const
+{
+	FVector3f P0, P1, P2;
+	GetTrianglePositions(TriangleIndex, P0, P1, P2);
+	return MeshPaintTriangleBVH::GetWindingNormal(P0, P1, P2);
+}
+
+void FMeshPaintTriangleBVH::GetTrianglePositions(int32 TriangleIndex, FVector3f& OutP0, FVector3f& OutP1, FVector3f& OutP2) const
+{
+	const uint32 Base = TriangleSlots[TriangleIndex] * 3;
+	OutP0 = Positions[Indices[Base + 0]];
+	OutP1 = Positions[Indices[Base + 1]];
+	OutP2 = Positions[Indices[Base + 2]];
+}
+
+void FMeshPaintTriangleBVH::GetTriangleUVs(int32 TriangleIndex, FVector2f& OutUV0, FVector2f& OutUV1, FVector2f& OutUV2) const
+{
+	const uint32 Base = TriangleSlots[TriangleIndex] * 3;
+	OutUV0 = UVs[Indices[Base + 0]];
+	OutUV1 = UVs[Indices[Base + 1]];
+	OutUV2 = UVs[Indices[Base + 2]];
+}
+
+FVector2f FMeshPaintTriangleBVH::GetHitUV(const FHit& Hit) const
+{
+	if (!Hit.IsValid()) return FVector2f::ZeroVector;
+
+	FVector2f UV0, UV1, UV2;
+	GetTriangleUVs(Hit.TriangleIndex, UV0, UV1, UV2);
+	return UV0 * Hit.Barycentrics.X + UV1 * Hit.Barycentrics.Y + UV2 * Hit.Barycentrics.Z;
+}
+
+SIZE_T FMeshPaintTriangleBVH::GetAllocatedSize() const
+{
+	return Nodes.GetAllocatedSize() + Positions.GetAllocatedSize() + UVs.GetAllocatedSize() + Indices.GetAllocatedSize() + TriangleIds.GetAllocatedSize() + TriangleSlots.GetAllocatedSize();
+}
+
+FArchive& operator<<(FArchive& Ar, FMeshPaintTriangleBVH& BVH)
+{
+	BVH.Nodes.BulkSerialize(Ar);
+	Ar << BVH.Positions;
+	Ar << BVH.UVs;
+	Ar << BVH.Indices;
+	Ar << BVH.TriangleIds;
+	Ar << BVH.TriangleSlots;
+	return Ar;
+}
@@ -4,6 +4,329 @@
 #include "PrimitiveSceneInfo.h"
 #include "StaticMeshBatch.h"
 #include "MeshPainterRender.h"
+#include "MeshPainterReferencePose.h"
+#include "MeshPainterStats.h"
+#include "MeshPaintChannelLayout.h"
+#include "MaterialExpressionMeshPaintSurfaceCoordinates.h"
+#include "RuntimeMeshPainter.h"
+#include "Components/MeshPaintMirrorComponent.h"
+#include "Components/MeshPaintSurfaceComponent.h"
+#include "Kismet/KismetRenderingLibrary.h"
+#include "Components/SkinnedMeshComponent.h"
+#include "Engine/SkinnedAsset.h"
+#include "Rendering/SkeletalMeshRenderData.h"
+#include "Components/StaticMeshComponent.h"
+#include "MeshPaintMeshDataCache.h"
+#include "MeshPaintCoverageMap.h"
+#include "MeshPaintTriangleBVH.h"
+#include "Engine/Texture2D.h"
+#include "MeshPaintStroke.h"
+#include "MeshPaintResidencySubsystem.h"
+#include "MeshPaintDecaySubsystem.h"
+#include "MeshPaintProjectionSubsystem.h"
+#include "MeshPaintContextSubsystem.h"
+#include "MeshPaintStampLibrary.h"
+#include "Engine/Texture2DArray.h"
+
+static float GMeshPaintAutoLODMinTriangleTexels = 1.0f;
+static FAutoConsoleVariableRef CVarMeshPaintAutoLODMinTriangleTexels(
+	TEXT("r.MeshPaint.AutoLOD.MinTriangleTexels"),
+	GMeshPaintAutoLODMinTriangleTexels,
+	TEXT("Median UV triangle size in target texels the automatic paint LOD has to keep"));
+
+static int32 GMeshPaintLegacyResourceUpdate = 0;
+static FAutoConsoleVariableRef CVarMeshPaintLegacyResourceUpdate(
+	TEXT("r.MeshPaint.LegacyResourceUpdate"),
+	GMeshPaintLegacyResourceUpdate,
+	TEXT("Call UpdateResourceImmediate on every target of every paint call, instead of only for targets which generate mips"));
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Render target resource updates"), STAT_MeshPaint_ResourceUpdates, STATGROUP_MeshPaint);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Render target resource updates skipped"), STAT_MeshPaint_ResourceUpdatesSkipped, STATGROUP_MeshPaint);
+
+namespace MeshPainterFunctionLibrary
+{
+	static bool NeedsResourceUpdate(const UTextureRenderTarget2D* TargetObject) { return TargetObject->bAutoGenerateMips; }
+	static bool NeedsResourceUpdate(const UTextureRenderTarget2DArray* TargetObject) { return false; }
+
+	/** Painting writes the top mip only, UpdateResourceImmediate is left for targets regenerating their mips from it */
+	template<typename RenderTargetType>
+	static void UpdateTargetResources(TConstArrayView<RenderTargetType*> TargetObjects)
+	{
+		MESH_PAINT_SCOPED_STAGE(UpdateResource);
+		for (RenderTargetType* TargetObject : TargetObjects)
+		{
+			if (!TargetObject) continue;
+
+			if (GMeshPaintLegacyResourceUpdate || NeedsResourceUpdate(TargetObject))
+			{
+				TargetObject->UpdateResourceImmediate(false);
+				INC_DWORD_STAT(STAT_MeshPaint_ResourceUpdates);
+			}
+			else
+			{
+				INC_DWORD_STAT(STAT_MeshPaint_ResourceUpdatesSkipped);
+			}
+		}
+	}
+
+	/** Resolves DesiredLOD, automatic selection compares per LOD UV triangle sizes with the texels of the atlas cell */
+	static int32 ResolvePaintLOD(const FRenderMaterialOnMeshPrimitive& Prim, FIntPoint TargetSize)
+	{
+		if (Prim.DesiredLOD >= 0) return Prim.DesiredLOD;
+
+		TSharedPtr<const FMeshPaintLODStats> Stats;
+		if (UStaticMeshComponent* StaticMeshComponent = Cast<UStaticMeshComponent>(Prim.MeshComponent))
+		{
+			Stats = UMeshPaintContextSubsystem::UseMeshData(StaticMeshComponent, StaticMeshComponent->GetStaticMesh()).FindOrBuildLODStats(StaticMeshComponent->GetStaticMesh(), Prim.DesiredUV);
+		}
+		else if (USkinnedMeshComponent* SkinnedComponent = Cast<USkinnedMeshComponent>(Prim.MeshComponent))
+		{
+			Stats = UMeshPaintContextSubsystem::UseMeshData(SkinnedComponent, SkinnedComponent->GetSkinnedAsset()).FindOrBuildLODStats(SkinnedComponent->GetSkinnedAsset());
+		}
+		if (!Stats.IsValid()) return 0;
+
+		const FVector2D CellTexels = Prim.UVRegion.GetSize().GetAbs() * FVector2D(TargetSize);
+		return Stats->SelectLOD(CellTexels, GMeshPaintAutoLODMinTriangleTexels);
+	}
+
+	/**
+	 * Render triangle of a static mesh LOD under a hit, from the triangle hierarchy shared by every component of the mesh. The face index of
+	 * complex traces against the collision LOD is used when it lies within MaxDistance, otherwise the closest triangle facing the impact normal
+	 */
+	static TSharedPtr<const FMeshPaintTriangleBVH> FindTriangleAtHit(UStaticMeshComponent* StaticMeshComponent, int32 LODIndex, int32 UVChannel, const FHitResult& Hit, float MaxDistance, FMeshPaintTriangleBVH::FHit& OutHit)
+	{
+		UStaticMesh* StaticMesh = StaticMeshComponent->GetStaticMesh();
+		TSharedPtr<const FMeshPaintTriangleBVH> BVH = UMeshPaintContextSubsystem::UseMeshData(StaticMeshComponent, StaticMesh).FindOrBuildTriangleBVH(StaticMesh, LODIndex, UVChannel);
+		if (!BVH.IsValid()) return nullptr;
+
+		const FTransform& ComponentToWorld = StaticMeshComponent->GetComponentTransform();
+		const FVector3f LocalPoint = FVector3f(ComponentToWorld.InverseTransformPosition(Hit.ImpactPoint));
+		const float LocalMaxDistance = MaxDistance / FMath::Max((float)ComponentToWorld.GetMinimumAxisScale(), UE_SMALL_NUMBER);
+
+		// Normals go through the inverse transpose, a negative scale flips them together with the winding
+		const FVector3f LocalNormal = FVector3f(ComponentToWorld.InverseTransformVectorNoScale(Hit.ImpactNormal) * ComponentToWorld.GetScale3D());
+		const bool bHasNormal = !LocalNormal.IsNearlyZero();
+
+		// Collision triangles only match the render ones for complex traces of the collision LOD, the distance and facing checks catch the rest
+		if (Hit.FaceIndex != INDEX_NONE && Hit.GetComponent() == StaticMeshComponent && LODIndex == StaticMesh->GetLODForCollision()
+			&& BVH->GetClosestPointOnTriangle(Hit.FaceIndex, LocalPoint, LocalMaxDistance, OutHit)
+			&& (!bHasNormal || BVH->GetTriangleNormal(Hit.FaceIndex).Dot(LocalNormal) >= 0.0f))
+		{
+			return BVH;
+		}
+		return BVH->FindClosestTriangle(LocalPoint, LocalMaxDistance, OutHit, bHasNormal ? &LocalNormal : nullptr) ? BVH : nullptr;
+	}
+
+	/**
+	 * Part of the atlas cell the brush stamps can reach, from the UVs of the triangles of the LOD inside the stamp bounds. Returns false when no stamp
+	 * reaches the component. OutUVBounds is left invalid, for the whole cell, when the mesh has no triangle hierarchy yet
+	 */
+	static bool GetBrushUVBounds(UPrimitiveComponent* MeshComponent, int32 LODIndex, int32 UVChannel, const FBox2D& UVRegion, TConstArrayView<FMeshPaintBrushStamp> BrushStamps, FBox2D& OutUVBounds)
+	{
+		OutUVBounds = FBox2D(ForceInit);
+
+		const FBox ComponentBounds = MeshComponent->Bounds.GetBox();
+		TArray<const FMeshPaintBrushStamp*, TInlineAllocator<16>> Reaching;
+		for (const FMeshPaintBrushStamp& Stamp : BrushStamps)
+		{
+			if (Stamp.Radius > 0.0f && FMath::SphereAABBIntersection(FSphere(Stamp.Location, Stamp.Radius), ComponentBounds))
+			{
+				Reaching.Add(&Stamp);
+			}
+		}
+		if (Reaching.IsEmpty()) return false;
+
+		// Skinned meshes move away from their asset triangles, they keep the whole cell
+		UStaticMeshComponent* StaticMeshComponent = Cast<UStaticMeshComponent>(MeshComponent);
+		if (!StaticMeshComponent) return true;
+
+		TSharedPtr<const FMeshPaintTriangleBVH> BVH = UMeshPaintContextSubsystem::UseMeshData(StaticMeshComponent, StaticMeshComponent->GetStaticMesh()).FindOrBuildTriangleBVH(StaticMeshComponent->GetStaticMesh(), LODIndex, UVChannel);
+		if (!BVH.IsValid()) return true;
+
+		const FTransform& ComponentToWorld = StaticMeshComponent->GetComponentTransform();
+		FBox2D MeshUVBounds(ForceInit);
+		for (const FMeshPaintBrushStamp* Stamp : Reaching)
+		{
+			const FBox LocalBox = FBox::BuildAABB(Stamp->Location, FVector(Stamp->Radius)).InverseTransformBy(ComponentToWorld);
+			BVH->ForEachTriangleInBox(FBox3f(LocalBox), [&BVH, &MeshUVBounds](int32 TriangleIndex)
+			{
+				FVector2f UV0, UV1, UV2;
+				BVH->GetTriangleUVs(TriangleIndex, UV0, UV1, UV2);
+				MeshUVBounds += FVector2D(UV0);
+				MeshUVBounds += FVector2D(UV1);
+				MeshUVBounds += FVector2D(UV2);
+			});
+		}
+		if (!MeshUVBounds.bIsValid) return false;
+
+		// Paint outside the unit square is clipped by the pass
+		const FVector2D Min = MeshUVBounds.Min.ComponentMax(FVector2D::Zero());
+		const FVector2D Max = MeshUVBounds.Max.ComponentMin(FVector2D::One());
+		OutUVBounds += UVRegion.Min + Min * UVRegion.GetSize();
+		OutUVBounds += UVRegion.Min + Max * UVRegion.GetSize();
+		return true;
+	}
+
+	/** Scene proxies and per primitive settings of the paint pass, components no brush stamp reaches are left out of brush passes */
+	static void GatherPrimitivesToRender(TConstArrayView<FRenderMaterialOnMeshPrimitive> Components, FIntPoint TargetSize, FMeshPaintRenderParameters& Params, TConstArrayView<FMeshPaintBrushStamp> BrushStamps = {})
+	{
+		for (const FRenderMaterialOnMeshPrimitive& Prim : Components)
+		{
+			if (!IsValid(Prim.MeshComponent) || !Prim.MeshComponent->SceneProxy) continue;
+			FMeshPaintProxyRenderParameters Param;
+			Param.PrimitiveProxy = Prim.MeshComponent->SceneProxy;
+			Param.TargetLOD = ResolvePaintLOD(Prim, TargetSize);
+			Param.UVRegion = Prim.UVRegion;
+			Param.ArraySlice = Prim.ArraySlice;
+			if (!BrushStamps.IsEmpty() && !GetBrushUVBounds(Prim.MeshComponent, Param.TargetLOD, Prim.DesiredUV, Prim.UVRegion, BrushStamps, Param.PaintUVBounds)) continue;
+			if (USkinnedMeshComponent* SkinnedComponent = Cast<USkinnedMeshComponent>(Prim.MeshComponent))
+			{
+				// Streamed out LODs have no buffers to draw, the render thread checks again when the pass is built
+				USkinnedAsset* SkinnedAsset = SkinnedComponent->GetSkinnedAsset();
+				const FSkeletalMeshRenderData* RenderData = SkinnedAsset ? SkinnedAsset->GetResourceForRendering() : nullptr;
+				if (!RenderData || RenderData->LODRenderData.IsEmpty()) continue;
+				Param.TargetLOD = FMath::Clamp(Param.TargetLOD, SkinnedAsset->GetStreamableResourceState().ResidentFirstLODIdx(), RenderData->LODRenderData.Num() - 1);
+
+				Param.bSkinnedMesh = true;
+				if (Prim.bReferencePose)
+				{
+					Param.bReferencePose = true;
+					FMeshPaintReferencePoseMesh::GatherSectionMaterials(SkinnedComponent, Param.TargetLOD, Param.ReferencePoseMaterials);
+				}
+			}
+			Params.PrimitivesToRender.Add(Param);
+		}
+	}
+
+	/** Paint mirrors of the painted components, direct paint calls replay their paint on them like PaintSurfacesInVolume does */
+	static void GatherPaintMirrors(UWorld* World, TConstArrayView<FRenderMaterialOnMeshPrimitive> Components, TArray<UMeshPaintMirrorComponent*, TInlineAllocator<16>>& OutMirrors)
+	{
+		UMeshPaintContextSubsystem* Context = World ? World->GetSubsystem<UMeshPaintContextSubsystem>() : nullptr;
+		if (!Context) return;
+
+		for (UMeshPaintMirrorComponent* Mirror : Context->GetMirrors())
+		{
+			UStaticMeshComponent* PaintedComponent = Mirror->GetPaintedComponent();
+			if (PaintedComponent && Components.ContainsByPredicate([PaintedComponent](const FRenderMaterialOnMeshPrimitive& Prim) { return Prim.MeshComponent == PaintedComponent; }))
+			{
+				OutMirrors.Add(Mirror);
+			}
+		}
+	}
+
+	/** Material passes cover the whole layout and are taken as opaque, brush passes are replayed stamp by stamp */
+	static void UpdatePaintMirrors(UWorld* World, TConstArrayView<FRenderMaterialOnMeshPrimitive> Components, bool bClear, TConstArrayView<FMeshPaintBrushStamp> BrushStamps)
+	{
+		TArray<UMeshPaintMirrorComponent*, TInlineAllocator<16>> Mirrors;
+		GatherPaintMirrors(World, Components, Mirrors);
+		for (UMeshPaintMirrorComponent* Mirror : Mirrors)
+		{
+			if (bClear)
+			{
+				Mirror->ClearPaint();
+			}
+			if (BrushStamps.IsEmpty())
+			{
+				Mirror->ApplyFill(1.0f, 0);
+			}
+			for (const FMeshPaintBrushStamp& Stamp : BrushStamps)
+			{
+				Mirror->ApplyBrushStamp(Stamp);
+			}
+		}
+	}
+
+	/** Paints into prepared targets and updates the UObjects owning them */
+	template<typename RenderTargetType>
+	static bool RenderMaterialOnMeshTargets(
+		UWorld* World,
+		TArrayView<FRenderMaterialOnMeshPrimitive> Components,
+		UMaterialInterface* Material,
+		const FMeshPaintRenderTargets& Targets,
+		TConstArrayView<RenderTargetType*> TargetObjects,
+		const FRenderMaterialOnMeshViewConfiguration& ViewPointConfiguration,
+		bool bClearRenderTargets,
+		EMeshPaintBlendMode BlendMode,
+		float BlendThreshold,
+		TConstArrayView<FMeshPaintBrushStamp> BrushStamps = {},
+		UMeshPaintStampLibrary* StampLibrary = nullptr,
+		TSharedPtr<FMeshPaintProjectionDepth, ESPMode::ThreadSafe> ProjectionDepth = nullptr,
+		float ProjectionDepthBias = 0.0f,
+		bool bUpdatePaintMirrors = true)
+	{
+		if (!Targets.IsValidForRendering()) return false;
+
+		const FIntPoint TargetSize = Targets.GetPrimaryRenderTarget()->GetSizeXY();
+
+		FSceneViewProjectionData ViewInitOptions;
+		ViewInitOptions.SetViewRectangle(FIntRect(0, 0, TargetSize.X, TargetSize.Y));
+		ViewInitOptions.ViewOrigin = ViewPointConfiguration.ViewOrigin;
+		ViewInitOptions.ViewRotationMatrix = ViewPointConfiguration.ViewRotationMatrix;
+		ViewInitOptions.ProjectionMatrix = ViewPointConfiguration.ProjectionMatrix;
+
+		FMeshPaintRenderParameters Params;
+		Params.bClearTargets = bClearRenderTargets;
+		Params.BlendMode = BlendMode;
+		Params.BlendThreshold = BlendThreshold;
+		Params.Scene = World->Scene;
+		Params.MaterialOverride = Material ? Material->GetRenderProxy() : nullptr;
+		Params.ViewProjection = ViewInitOptions;
+		Params.ProjectionDepth = ProjectionDepth;
+		Params.ProjectionDepthBias = ProjectionDepthBias;
+
+		Params.BrushStamps.Reserve(BrushStamps.Num());
+		for (const FMeshPaintBrushStamp& Stamp : BrushStamps)
+		{
+			FMeshPaintRenderBrushStamp& RenderStamp = Params.BrushStamps.AddDefaulted_GetRef();
+			RenderStamp.Location = Stamp.Location;
+			RenderStamp.Radius = Stamp.Radius;
+			RenderStamp.Hardness = Stamp.Hardness;
+			RenderStamp.Strength = Stamp.Strength;
+			RenderStamp.ShapeIndex = Stamp.ShapeIndex;
+			RenderStamp.Orientation = Stamp.Orientation.Quaternion();
+		}
+		Params.BrushShapes = StampLibrary && StampLibrary->GetMaskArray() ? StampLibrary->GetMaskArray()->GetResource() : nullptr;
+
+		GatherPrimitivesToRender(Components, TargetSize, Params, BrushStamps);
+
+		if (Params.PrimitivesToRender.IsEmpty())
+			return false;
+
+		{
+			MESH_PAINT_SCOPED_STAGE(Enqueue);
+			ENQUEUE_RENDER_COMMAND(RenderMaterialOnMeshUVLayoutCommand)(
+			[=](FRHICommandListImmediate& RHICmdList)
+			{
+				// Cheap when no clear is pending, the render thread is the only place that knows
+				{
+					MESH_PAINT_SCOPED_STAGE(FlushDeferredResourceUpdate);
+					Targets.FlushDeferredResourceUpdate(RHICmdList);
+				}
+				MeshPaintRender::AddMeshPaintPass(RHICmdList, Targets, Params);
+			});
+		}
+
+		// Paint stays inside the atlas cells of the primitives, brush paint inside the part of the cells under the stamps. Array targets are not decayed
+		if constexpr (std::is_same_v<RenderTargetType, UTextureRenderTarget2D>)
+		{
+			FBox2D PaintedUVRect(ForceInit);
+			for (const FMeshPaintProxyRenderParameters& Param : Params.PrimitivesToRender)
+			{
+				PaintedUVRect += Param.PaintUVBounds.bIsValid ? Param.PaintUVBounds : Param.UVRegion;
+			}
+			UMeshPaintDecaySubsystem::MarkTargetsPainted(World, TargetObjects, PaintedUVRect);
+		}
+
+		// Mirrors cannot test projector occlusion, projected paint is left out of them
+		if (bUpdatePaintMirrors && !ProjectionDepth.IsValid())
+		{
+			UpdatePaintMirrors(World, Components, bClearRenderTargets, BrushStamps);
+		}
+
+		UpdateTargetResources(TargetObjects);
+		return true;
+	}
+}
 
 bool UMeshPainterFunctionLibrary::RenderMaterialOnMeshUVLayout(
 	UObject* WorldContextObject,
@@ -12,12 +335,12 @@ bool UMeshPainterFunctionLibrary::RenderMaterialOnMeshUVLayout(
 	UTextureRenderTarget2D* BaseColor, 
 	UTextureRenderTarget2D* Emissive,
 	UTextureRenderTarget2D* NormalMap,
-	int32 LOD, bool bClearRenderTargets)
+	int32 LOD, bool bClearRenderTargets, EMeshPaintBlendMode BlendMode, float BlendThreshold)
 {
 	FRenderMaterialOnMeshPrimitive PrimitiveInfo;
 	PrimitiveInfo.DesiredLOD = LOD;
 	PrimitiveInfo.MeshComponent = MeshComponent;
-	return RenderMaterialOnMeshUVAtlasMulti(WorldContextObject, MakeArrayView(&PrimitiveInfo, 1), Material, BaseColor, Emissive, NormalMap, FRenderMaterialOnMeshViewConfiguration(), bClearRenderTargets);
+	return RenderMaterialOnMeshUVAtlasMulti(WorldContextObject, MakeArrayView(&PrimitiveInfo, 1), Material, BaseColor, Emissive, NormalMap, FRenderMaterialOnMeshViewConfiguration(), bClearRenderTargets, BlendMode, BlendThreshold);
 }
 
 bool UMeshPainterFunctionLibrary::RenderMaterialOnMeshUVAtlas(
@@ -27,13 +350,13 @@ bool UMeshPainterFunctionLibrary::RenderMaterialOnMeshUVAtlas(
 	UTextureRenderTarget2D* BaseColor, 
 	UTextureRenderTarget2D* Emissive,
 	UTextureRenderTarget2D* NormalMap,
-	int32 LOD, const FBox2D& UVRegion, bool bClearRenderTargets)
+	int32 LOD, const FBox2D& UVRegion, bool bClearRenderTargets, EMeshPaintBlendMode BlendMode, float BlendThreshold)
 {
 	FRenderMaterialOnMeshPrimitive PrimitiveInfo;
 	PrimitiveInfo.DesiredLOD = LOD;
 	PrimitiveInfo.MeshComponent = MeshComponent;
 	PrimitiveInfo.UVRegion = UVRegion;
-	return RenderMaterialOnMeshUVAtlasMulti(WorldContextObject, MakeArrayView(&PrimitiveInfo, 1), Material, BaseColor, Emissive, NormalMap, FRenderMaterialOnMeshViewConfiguration(), bClearRenderTargets);
+	return RenderMaterialOnMeshUVAtlasMulti(WorldContextObject, MakeArrayView(&PrimitiveInfo, 1), Material, BaseColor, Emissive, NormalMap, FRenderMaterialOnMeshViewConfiguration(), bClearRenderTargets, BlendMode, BlendThreshold);
 }
 
 bool UMeshPainterFunctionLibrary::RenderMaterialOnMeshUVAtlasMulti(
@@ -44,10 +367,12 @@ bool UMeshPainterFunctionLibrary::RenderMaterialOnMeshUVAtlasMulti(
 	UTextureRenderTarget2D* Emissive,
 	UTextureRenderTarget2D* NormalMap,
 	const FBox2D& UVRegion,
-	bool bClearRenderTargets
+	bool bClearRenderTargets,
+	EMeshPaintBlendMode BlendMode,
+	float BlendThreshold
 )
 {
-	return RenderMaterialOnMeshUVAtlasMulti(WorldContextObject, MakeArrayView(Components), Material, BaseColor, Emissive, NormalMap, FRenderMaterialOnMeshViewConfiguration(), bClearRenderTargets);
+	return RenderMaterialOnMeshUVAtlasMulti(WorldContextObject, MakeArrayView(Components), Material, BaseColor, Emissive, NormalMap, FRenderMaterialOnMeshViewConfiguration(), bClearRenderTargets, BlendMode, BlendThreshold);
 }
 
 bool UMeshPainterFunctionLibrary::RenderMaterialOnMeshUVAtlasMulti(
@@ -58,11 +383,14 @@ bool UMeshPainterFunctionLibrary::RenderMaterialOnMeshUVAtlasMulti(
 	UTextureRenderTarget2D* Emissive,
 	UTextureRenderTarget2D* NormalMap,
 	const FRenderMaterialOnMeshViewConfiguration& ViewPointConfiguration,
-	bool bClearRenderTargets
+	bool bClearRenderTargets,
+	EMeshPaintBlendMode BlendMode,
+	float BlendThreshold
 )
 {
 	// Must execute on the main thread
 	check(IsInGameThread());
+	MESH_PAINT_TRACE_SCOPE(RenderMaterialOnMeshUVAtlasMulti);
 
 	UWorld* World = GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::LogAndReturnNull);
 	if (Components.IsEmpty() || !IsValid(World))
@@ -70,51 +398,685 @@ bool UMeshPainterFunctionLibrary::RenderMaterialOnMeshUVAtlasMulti(
 
 	if (Material)
 	{
+		MESH_PAINT_SCOPED_STAGE(EnsureIsComplete);
 		Material->EnsureIsComplete();
 	}
 
+	UTextureRenderTarget2D* TargetObjects[] = { BaseColor, Emissive, NormalMap };
+	UMeshPaintResidencySubsystem::EnsureTargetsResident(World, TargetObjects);
+
 	FMeshPaintRenderTargets Targets;
-	Targets.SetRenderTarget(BaseColor, FMeshPaintRenderTargets::RT_BaseColor);
-	Targets.SetRenderTarget(Emissive, FMeshPaintRenderTargets::RT_Emissive);
-	Targets.SetRenderTarget(NormalMap, FMeshPaintRenderTargets::RT_NormalMap);
-	if (!Targets.IsValidForRendering()) return false;
-
-	const FIntPoint TargetSize = Targets.GetPrimaryRenderTarget()->GetSizeXY();
-
-	FSceneViewProjectionData ViewInitOptions;
-	ViewInitOptions.SetViewRectangle(FIntRect(0, 0, TargetSize.X, TargetSize.Y));
-	ViewInitOptions.ViewOrigin = ViewPointConfiguration.ViewOrigin;
-	ViewInitOptions.ViewRotationMatrix = ViewPointConfiguration.ViewRotationMatrix;
-	ViewInitOptions.ProjectionMatrix = ViewPointConfiguration.ProjectionMatrix;
-
-	FMeshPaintRenderParameters Params;
-	Params.bClearTargets = bClearRenderTargets;
-	Params.Scene = World->Scene;
-	Params.MaterialOverride = Material ? Material->GetRenderProxy() : nullptr;
-	Params.ViewProjection = ViewInitOptions;
-	
+	{
+		MESH_PAINT_SCOPED_STAGE(SetRenderTarget);
+		Targets.SetRenderTarget(BaseColor, FMeshPaintRenderTargets::RT_BaseColor);
+		Targets.SetRenderTarget(Emissive, FMeshPaintRenderTargets::RT_Emissive);
+		Targets.SetRenderTarget(NormalMap, FMeshPaintRenderTargets::RT_NormalMap);
+	}
+
+	return MeshPainterFunctionLibrary::RenderMaterialOnMeshTargets<UTextureRenderTarget2D>(World, Components, Material, Targets, TargetObjects, ViewPointConfiguration, bClearRenderTargets, BlendMode, BlendThreshold);
+}
+
+bool UMeshPainterFunctionLibrary::RenderMaterialOnMeshProjected(
+	UObject* WorldContextObject,
+	TArray<FRenderMaterialOnMeshPrimitive> Components,
+	UMaterialInterface* Material,
+	UTextureRenderTarget2D* BaseColor,
+	UTextureRenderTarget2D* Emissive,
+	UTextureRenderTarget2D* NormalMap,
+	const FRenderMaterialOnMeshViewConfiguration& Projector,
+	const TArray<UPrimitiveComponent*>& Occluders,
+	int32 DepthResolution,
+	float DepthBias,
+	EMeshPaintBlendMode BlendMode,
+	float BlendThreshold
+)
+{
+	check(IsInGameThread());
+	MESH_PAINT_TRACE_SCOPE(RenderMaterialOnMeshProjected);
+
+	UWorld* World = GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::LogAndReturnNull);
+	UMeshPaintProjectionSubsystem* ProjectionSubsystem = World ? World->GetSubsystem<UMeshPaintProjectionSubsystem>() : nullptr;
+	if (Components.IsEmpty() || !ProjectionSubsystem)
+		return false;
+
+	// Painted primitives hide their own far side
+	TArray<UPrimitiveComponent*, TInlineAllocator<16>> AllOccluders;
 	for (const FRenderMaterialOnMeshPrimitive& Prim : Components)
 	{
-		if (!IsValid(Prim.MeshComponent) || !Prim.MeshComponent->SceneProxy) continue;
-		FMeshPaintProxyRenderParameters Param;
-		Param.PrimitiveProxy = Prim.MeshComponent->SceneProxy;
-		Param.TargetLOD = Prim.DesiredLOD;
-		Param.UVRegion = Prim.UVRegion;
-		Params.PrimitivesToRender.Add(Param);
+		AllOccluders.AddUnique(Prim.MeshComponent);
+	}
+	for (UPrimitiveComponent* Occluder : Occluders)
+	{
+		AllOccluders.AddUnique(Occluder);
+	}
+
+	TSharedPtr<FMeshPaintProjectionDepth, ESPMode::ThreadSafe> ProjectionDepth = ProjectionSubsystem->FindOrRenderDepth(Projector, AllOccluders, DepthResolution);
+	if (!ProjectionDepth.IsValid())
+		return false;
+
+	if (Material)
+	{
+		MESH_PAINT_SCOPED_STAGE(EnsureIsComplete);
+		Material->EnsureIsComplete();
+	}
+
+	UTextureRenderTarget2D* TargetObjects[] = { BaseColor, Emissive, NormalMap };
+	UMeshPaintResidencySubsystem::EnsureTargetsResident(World, TargetObjects);
+
+	FMeshPaintRenderTargets Targets;
+	{
+		MESH_PAINT_SCOPED_STAGE(SetRenderTarget);
+		Targets.SetRenderTarget(BaseColor, FMeshPaintRenderTargets::RT_BaseColor);
+		Targets.SetRenderTarget(Emissive, FMeshPaintRenderTargets::RT_Emissive);
+		Targets.SetRenderTarget(NormalMap, FMeshPaintRenderTargets::RT_NormalMap);
+	}
+
+	return MeshPainterFunctionLibrary::RenderMaterialOnMeshTargets<UTextureRenderTarget2D>(World, Components, Material, Targets, TargetObjects, Projector, false, BlendMode, BlendThreshold, {}, nullptr, ProjectionDepth, DepthBias);
+}
+
+bool UMeshPainterFunctionLibrary::RenderMaterialOnMeshArraySlices(
+	UObject* WorldContextObject,
+	TArray<FRenderMaterialOnMeshPrimitive> Components,
+	UMaterialInterface* Material,
+	UTextureRenderTarget2DArray* BaseColor,
+	UTextureRenderTarget2DArray* Emissive,
+	UTextureRenderTarget2DArray* NormalMap,
+	bool bClearRenderTargets,
+	EMeshPaintBlendMode BlendMode,
+	float BlendThreshold
+)
+{
+	check(IsInGameThread());
+	MESH_PAINT_TRACE_SCOPE(RenderMaterialOnMeshArraySlices);
+
+	UWorld* World = GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::LogAndReturnNull);
+	if (Components.IsEmpty() || !IsValid(World))
+		return false;
+
+	if (Material)
+	{
+		MESH_PAINT_SCOPED_STAGE(EnsureIsComplete);
+		Material->EnsureIsComplete();
+	}
+
+	FMeshPaintRenderTargets Targets;
+	{
+		MESH_PAINT_SCOPED_STAGE(SetRenderTarget);
+		Targets.SetRenderTarget(BaseColor, FMeshPaintRenderTargets::RT_BaseColor);
+		Targets.SetRenderTarget(Emissive, FMeshPaintRenderTargets::RT_Emissive);
+		Targets.SetRenderTarget(NormalMap, FMeshPaintRenderTargets::RT_NormalMap);
+	}
+
+	UTextureRenderTarget2DArray* TargetObjects[] = { BaseColor, Emissive, NormalMap };
+	return MeshPainterFunctionLibrary::RenderMaterialOnMeshTargets<UTextureRenderTarget2DArray>(World, Components, Material, Targets, TargetObjects, FRenderMaterialOnMeshViewConfiguration(), bClearRenderTargets, BlendMode, BlendThreshold);
+}
+
+void UMeshPainterFunctionLibrary::SetPaintArraySlice(UPrimitiveComponent* Component, int32 ArraySlice, int32 SliceDataIndex)
+{
+	if (!IsValid(Component) || SliceDataIndex < 0)
+		return;
+
+	Component->SetCustomPrimitiveDataFloat(SliceDataIndex, (float)ArraySlice);
+}
+
+void UMeshPainterFunctionLibrary::SetPaintSurfaceDescriptor(UPrimitiveComponent* Component, const FBox2D& UVRegion, int32 ArraySlice, int32 DescriptorDataIndex)
+{
+	if (!IsValid(Component) || DescriptorDataIndex < 0)
+		return;
+
+	// Layout of UMaterialExpressionMeshPaintSurfaceCoordinates
+	static_assert(UMaterialExpressionMeshPaintSurfaceCoordinates::DescriptorSize == 5, "Paint surface descriptor layout changed");
+	Component->SetCustomPrimitiveDataVector4(DescriptorDataIndex, FVector4(UVRegion.Min.X, UVRegion.Min.Y, UVRegion.Max.X - UVRegion.Min.X, UVRegion.Max.Y - UVRegion.Min.Y));
+	Component->SetCustomPrimitiveDataFloat(DescriptorDataIndex + 4, (float)ArraySlice);
+}
+
+bool UMeshPainterFunctionLibrary::RenderMaterialOnMeshChannels(
+	UObject* WorldContextObject,
+	TArray<FRenderMaterialOnMeshPrimitive> Components,
+	UMaterialInterface* Material,
+	FName ChannelLayout,
+	const TArray<UTextureRenderTarget2D*>& ChannelTargets,
+	bool bClearRenderTargets,
+	EMeshPaintBlendMode BlendMode,
+	float BlendThreshold
+)
+{
+	check(IsInGameThread());
+	MESH_PAINT_TRACE_SCOPE(RenderMaterialOnMeshChannels);
+
+	UWorld* World = GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::LogAndReturnNull);
+	if (Components.IsEmpty() || !IsValid(World))
+		return false;
+
+	const FMeshPaintChannelLayout* Layout = GetDefault<UMeshPaintChannelSettings>()->FindLayout(ChannelLayout);
+	if (!Layout)
+	{
+		UE_LOG(LogMeshPainter, Warning, TEXT("Mesh paint channel layout %s is not defined in the project settings"), *ChannelLayout.ToString());
+		return false;
+	}
+	if (Layout->Channels.Num() > MESH_PAINT_MAX_CHANNELS || ChannelTargets.Num() != Layout->Channels.Num())
+	{
+		UE_LOG(LogMeshPainter, Warning, TEXT("Mesh paint channel layout %s has %d channels, %d targets were given"), *ChannelLayout.ToString(), Layout->Channels.Num(), ChannelTargets.Num());
+		return false;
+	}
+
+	if (Material)
+	{
+		MESH_PAINT_SCOPED_STAGE(EnsureIsComplete);
+		Material->EnsureIsComplete();
+	}
+
+	UMeshPaintResidencySubsystem::EnsureTargetsResident(World, ChannelTargets);
+
+	FMeshPaintRenderTargets Targets;
+	{
+		MESH_PAINT_SCOPED_STAGE(SetRenderTarget);
+		for (int32 ChannelIndex = 0; ChannelIndex < ChannelTargets.Num(); ++ChannelIndex)
+		{
+			const FMeshPaintChannelDesc& Channel = Layout->Channels[ChannelIndex];
+			UTextureRenderTarget2D* ChannelTarget = ChannelTargets[ChannelIndex];
+			if (!Targets.AddChannelRenderTarget(ChannelTarget, Channel.Source))
+			{
+				UE_LOG(LogMeshPainter, Warning, TEXT("Mesh paint channel %s of layout %s has no valid render target"), *Channel.Name.ToString(), *ChannelLayout.ToString());
+				return false;
+			}
+			if (ChannelTarget->RenderTargetFormat != MeshPaintChannels::GetRenderTargetFormat(Channel.Format))
+			{
+				UE_LOG(LogMeshPainter, Verbose, TEXT("Render target of mesh paint channel %s does not match the layout format"), *Channel.Name.ToString());
+			}
+		}
+	}
+
+	return MeshPainterFunctionLibrary::RenderMaterialOnMeshTargets<UTextureRenderTarget2D>(World, Components, Material, Targets, ChannelTargets, FRenderMaterialOnMeshViewConfiguration(), bClearRenderTargets, BlendMode, BlendThreshold);
+}
+
+bool UMeshPainterFunctionLibrary::CreateChannelRenderTargets(UObject* WorldContextObject, FName ChannelLayout, int32 Width, int32 Height, TArray<UTextureRenderTarget2D*>& OutChannelTargets)
+{
+	OutChannelTargets.Reset();
+
+	const FMeshPaintChannelLayout* Layout = GetDefault<UMeshPaintChannelSettings>()->FindLayout(ChannelLayout);
+	if (!Layout || Width <= 0 || Height <= 0)
+		return false;
+
+	for (const FMeshPaintChannelDesc& Channel : Layout->Channels)
+	{
+		UTextureRenderTarget2D* ChannelTarget = UKismetRenderingLibrary::CreateRenderTarget2D(WorldContextObject, Width, Height, MeshPaintChannels::GetRenderTargetFormat(Channel.Format), FLinearColor::Transparent, false, true);
+		if (!ChannelTarget)
+		{
+			OutChannelTargets.Reset();
+			return false;
+		}
+		OutChannelTargets.Add(ChannelTarget);
+	}
+	return true;
+}
+
+bool UMeshPainterFunctionLibrary::FillUVIslandAtLocation(
+	UObject* WorldContextObject,
+	const FRenderMaterialOnMeshPrimitive& Primitive,
+	FVector Location,
+	UTextureRenderTarget2D* RenderTarget,
+	FLinearColor Color,
+	float MaxDistance,
+	EMeshPaintBlendMode BlendMode,
+	float BlendThreshold
+)
+{
+	check(IsInGameThread());
+	MESH_PAINT_TRACE_SCOPE(FillUVIslandAtLocation);
+
+	UWorld* World = GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::LogAndReturnNull);
+	UStaticMeshComponent* StaticMeshComponent = Cast<UStaticMeshComponent>(Primitive.MeshComponent);
+	if (!IsValid(World) || !IsValid(StaticMeshComponent) || !StaticMeshComponent->GetStaticMesh() || !IsValid(RenderTarget))
+		return false;
+
+	UTextureRenderTarget2D* TargetObjects[] = { RenderTarget };
+	UMeshPaintResidencySubsystem::EnsureTargetsResident(World, TargetObjects);
+
+	FTextureRenderTargetResource* Resource = RenderTarget->GameThread_GetRenderTargetResource();
+	if (!Resource)
+		return false;
+
+	// Coverage is built at the texel size of the atlas cell so the pass reads it one to one
+	UStaticMesh* StaticMesh = StaticMeshComponent->GetStaticMesh();
+	const FIntPoint TargetSize(RenderTarget->SizeX, RenderTarget->SizeY);
+	const FVector2D CellSize = Primitive.UVRegion.GetSize().GetAbs() * FVector2D(TargetSize);
+	const FIntPoint CoverageSize(FMath::RoundToInt32(CellSize.X), FMath::RoundToInt32(CellSize.Y));
+	const int32 LODIndex = MeshPainterFunctionLibrary::ResolvePaintLOD(Primitive, TargetSize);
+
+	FMeshPaintMeshDataCache& MeshDataCache = UMeshPaintContextSubsystem::UseMeshData(World, StaticMesh);
+	TSharedPtr<const FMeshPaintTriangleBVH> BVH = MeshDataCache.FindOrBuildTriangleBVH(StaticMesh, LODIndex, Primitive.DesiredUV);
+	TSharedPtr<const FMeshPaintCoverageMap> CoverageMap = MeshDataCache.FindOrBuildCoverageMap(StaticMesh, LODIndex, Primitive.DesiredUV, CoverageSize);
+	if (!BVH.IsValid() || !CoverageMap.IsValid())
+		return false;
+
+	const FTransform& ComponentToWorld = StaticMeshComponent->GetComponentTransform();
+	const FVector3f LocalPoint = FVector3f(ComponentToWorld.InverseTransformPosition(Location));
+	const float LocalMaxDistance = MaxDistance / FMath::Max((float)ComponentToWorld.GetMinimumAxisScale(), UE_SMALL_NUMBER);
+
+	FMeshPaintTriangleBVH::FHit Hit;
+	if (!BVH->FindClosestTriangle(LocalPoint, LocalMaxDistance, Hit))
+		return false;
+
+	const int32 IslandIndex = CoverageMap->GetTriangleIsland(Hit.TriangleIndex);
+	if (IslandIndex == INDEX_NONE || CoverageMap->GetIslandTexelCount(IslandIndex) == 0)
+		return false;
+
+	UTexture2D* CoverageTexture = MeshDataCache.FindOrCreateCoverageTexture(StaticMesh, LODIndex, Primitive.DesiredUV, CoverageSize);
+	if (!CoverageTexture || !CoverageTexture->GetResource())
+		return false;
+
+	// Island bounds are in coverage texels, pad a texel for the rounding of the cell size
+	const FIntRect& IslandBounds = CoverageMap->GetIslandBounds(IslandIndex);
+	const FVector2D CellMin = Primitive.UVRegion.Min * FVector2D(TargetSize);
+	const FVector2D CoverageToTarget = CellSize / FVector2D(CoverageSize);
+
+	FMeshPaintIslandFillParameters Params;
+	Params.CoverageTexture = CoverageTexture->GetResource();
+	Params.IslandIndex = IslandIndex;
+	Params.UVRegion = Primitive.UVRegion;
+	Params.DirtyRect = FIntRect(
+		FMath::FloorToInt32(CellMin.X + IslandBounds.Min.X * CoverageToTarget.X) - 1,
+		FMath::FloorToInt32(CellMin.Y + IslandBounds.Min.Y * CoverageToTarget.Y) - 1,
+		FMath::CeilToInt32(CellMin.X + IslandBounds.Max.X * CoverageToTarget.X) + 1,
+		FMath::CeilToInt32(CellMin.Y + IslandBounds.Max.Y * CoverageToTarget.Y) + 1);
+	Params.Color = Color;
+	Params.BlendMode = BlendMode;
+	Params.BlendThreshold = BlendThreshold;
+
+	{
+		MESH_PAINT_SCOPED_STAGE(Enqueue);
+		ENQUEUE_RENDER_COMMAND(FillUVIslandCommand)(
+		[Resource, Params](FRHICommandListImmediate& RHICmdList)
+		{
+			{
+				MESH_PAINT_SCOPED_STAGE(FlushDeferredResourceUpdate);
+				Resource->FlushDeferredResourceUpdate(RHICmdList);
+			}
+			MeshPaintRender::AddIslandFillPass(RHICmdList, Resource, Params);
+		});
+	}
+
+	UMeshPaintDecaySubsystem::MarkTargetsPainted(World, TargetObjects, FBox2D(FVector2D(Params.DirtyRect.Min) / FVector2D(TargetSize), FVector2D(Params.DirtyRect.Max) / FVector2D(TargetSize)));
+
+	// Island triangles are only known for the painted LOD, mirrors of other LODs cannot follow
+	TArray<UMeshPaintMirrorComponent*, TInlineAllocator<16>> Mirrors;
+	MeshPainterFunctionLibrary::GatherPaintMirrors(World, MakeArrayView(&Primitive, 1), Mirrors);
+	for (UMeshPaintMirrorComponent* Mirror : Mirrors)
+	{
+		if (Mirror->GetLOD() == LODIndex && Mirror->GetUVChannel() == Primitive.DesiredUV)
+		{
+			Mirror->ApplyFill(Color.A, 0, [&CoverageMap, IslandIndex](int32 TriangleIndex) { return CoverageMap->GetTriangleIsland(TriangleIndex) == IslandIndex; });
+		}
+	}
+
+	MeshPainterFunctionLibrary::UpdateTargetResources<UTextureRenderTarget2D>(TargetObjects);
+	return true;
+}
+
+bool UMeshPainterFunctionLibrary::MakeBrushRenderParameters(
+	UWorld* World,
+	TConstArrayView<FRenderMaterialOnMeshPrimitive> Components,
+	UMaterialInterface* Material,
+	FIntPoint TargetSize,
+	EMeshPaintBlendMode BlendMode,
+	float BlendThreshold,
+	FMeshPaintRenderParameters& OutParams,
+	TConstArrayView<FMeshPaintBrushStamp> BoundingStamps
+)
+{
+	check(IsInGameThread());
+	if (!IsValid(World) || TargetSize.X <= 0 || TargetSize.Y <= 0)
+		return false;
+
+	const FRenderMaterialOnMeshViewConfiguration ViewPointConfiguration;
+	OutParams.ViewProjection.SetViewRectangle(FIntRect(0, 0, TargetSize.X, TargetSize.Y));
+	OutParams.ViewProjection.ViewOrigin = ViewPointConfiguration.ViewOrigin;
+	OutParams.ViewProjection.ViewRotationMatrix = ViewPointConfiguration.ViewRotationMatrix;
+	OutParams.ViewProjection.ProjectionMatrix = ViewPointConfiguration.ProjectionMatrix;
+	OutParams.Scene = World->Scene;
+	OutParams.MaterialOverride = Material ? Material->GetRenderProxy() : nullptr;
+	OutParams.BlendMode = BlendMode;
+	OutParams.BlendThreshold = BlendThreshold;
+
+	MeshPainterFunctionLibrary::GatherPrimitivesToRender(Components, TargetSize, OutParams, BoundingStamps);
+	return !OutParams.PrimitivesToRender.IsEmpty();
+}
+
+bool UMeshPainterFunctionLibrary::FindPaintUVFromHit(const FHitResult& Hit, int32 UVChannel, FVector2D& UV, int32 LODIndex, float MaxDistance)
+{
+	check(IsInGameThread());
+
+	UStaticMeshComponent* StaticMeshComponent = Cast<UStaticMeshComponent>(Hit.GetComponent());
+	if (!Hit.bBlockingHit || !IsValid(StaticMeshComponent) || !StaticMeshComponent->GetStaticMesh())
+		return false;
+
+	FMeshPaintTriangleBVH::FHit TriangleHit;
+	TSharedPtr<const FMeshPaintTriangleBVH> BVH = MeshPainterFunctionLibrary::FindTriangleAtHit(StaticMeshComponent, LODIndex, UVChannel, Hit, MaxDistance, TriangleHit);
+	if (!BVH.IsValid())
+		return false;
+
+	UV = FVector2D(BVH->GetHitUV(TriangleHit));
+	return true;
+}
+
+bool UMeshPainterFunctionLibrary::PaintAtHit(
+	UObject* WorldContextObject,
+	const FHitResult& Hit,
+	const FRenderMaterialOnMeshPrimitive& Primitive,
+	UTextureRenderTarget2D* RenderTarget,
+	FLinearColor Color,
+	float Radius,
+	float Hardness,
+	float Strength,
+	bool bClampToIsland,
+	EMeshPaintBlendMode BlendMode,
+	float BlendThreshold
+)
+{
+	check(IsInGameThread());
+	MESH_PAINT_TRACE_SCOPE(PaintAtHit);
+
+	FRenderMaterialOnMeshPrimitive HitPrimitive = Primitive;
+	if (!HitPrimitive.MeshComponent)
+	{
+		HitPrimitive.MeshComponent = Hit.GetComponent();
+	}
+
+	UWorld* World = GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::LogAndReturnNull);
+	UStaticMeshComponent* StaticMeshComponent = Cast<UStaticMeshComponent>(HitPrimitive.MeshComponent);
+	if (!IsValid(World) || !Hit.bBlockingHit || !IsValid(StaticMeshComponent) || !StaticMeshComponent->GetStaticMesh() || !IsValid(RenderTarget) || Radius <= 0.0f)
+		return false;
+
+	UTextureRenderTarget2D* TargetObjects[] = { RenderTarget };
+	UMeshPaintResidencySubsystem::EnsureTargetsResident(World, TargetObjects);
+
+	FTextureRenderTargetResource* Resource = RenderTarget->GameThread_GetRenderTargetResource();
+	if (!Resource)
+		return false;
+
+	// Simple collision can sit away from the render mesh, anything within the brush radius is still under the brush
+	UStaticMesh* StaticMesh = StaticMeshComponent->GetStaticMesh();
+	const FIntPoint TargetSize(RenderTarget->SizeX, RenderTarget->SizeY);
+	const int32 LODIndex = MeshPainterFunctionLibrary::ResolvePaintLOD(HitPrimitive, TargetSize);
+
+	FMeshPaintTriangleBVH::FHit TriangleHit;
+	TSharedPtr<const FMeshPaintTriangleBVH> BVH = MeshPainterFunctionLibrary::FindTriangleAtHit(StaticMeshComponent, LODIndex, HitPrimitive.DesiredUV, Hit, Radius, TriangleHit);
+	if (!BVH.IsValid())
+		return false;
+
+	// World radius to UV radius with the texel density of the hit triangle
+	FVector3f P0, P1, P2;
+	FVector2f UV0, UV1, UV2;
+	BVH->GetTrianglePositions(TriangleHit.TriangleIndex, P0, P1, P2);
+	BVH->GetTriangleUVs(TriangleHit.TriangleIndex, UV0, UV1, UV2);
+	const FTransform& ComponentToWorld = StaticMeshComponent->GetComponentTransform();
+	const FVector W0 = ComponentToWorld.TransformPosition(FVector(P0));
+	const double WorldArea = FVector::CrossProduct(ComponentToWorld.TransformPosition(FVector(P1)) - W0, ComponentToWorld.TransformPosition(FVector(P2)) - W0).Size();
+	const double UVArea = FMath::Abs(FVector2f::CrossProduct(UV1 - UV0, UV2 - UV0));
+	if (WorldArea <= UE_DOUBLE_SMALL_NUMBER || UVArea <= UE_DOUBLE_SMALL_NUMBER)
+		return false;
+
+	const FVector2D CellMin = HitPrimitive.UVRegion.Min * FVector2D(TargetSize);
+	const FVector2D CellSize = HitPrimitive.UVRegion.GetSize() * FVector2D(TargetSize);
+	const FVector2D HitUV = FVector2D(BVH->GetHitUV(TriangleHit));
+	const double RadiusUV = Radius * FMath::Sqrt(UVArea / WorldArea);
+
+	FMeshPaintUVStampParameters Params;
+	Params.Center = FVector2f(CellMin + HitUV * CellSize);
+	Params.Radius = FVector2f(CellSize.GetAbs() * RadiusUV);
+	Params.Hardness = Hardness;
+	Params.Strength = Strength;
+	Params.Color = Color;
+	Params.BlendMode = BlendMode;
+	Params.BlendThreshold = BlendThreshold;
+	Params.UVRegion = HitPrimitive.UVRegion;
+
+	if (bClampToIsland)
+	{
+		const FIntPoint CoverageSize(FMath::RoundToInt32(FMath::Abs(CellSize.X)), FMath::RoundToInt32(FMath::Abs(CellSize.Y)));
+		FMeshPaintMeshDataCache& MeshDataCache = UMeshPaintContextSubsystem::UseMeshData(World, StaticMesh);
+		TSharedPtr<const FMeshPaintCoverageMap> CoverageMap = MeshDataCache.FindOrBuildCoverageMap(StaticMesh, LODIndex, HitPrimitive.DesiredUV, CoverageSize);
+		UTexture2D* CoverageTexture = CoverageMap.IsValid() ? MeshDataCache.FindOrCreateCoverageTexture(StaticMesh, LODIndex, HitPrimitive.DesiredUV, CoverageSize) : nullptr;
+		if (!CoverageTexture || !CoverageTexture->GetResource())
+			return false;
+
+		Params.CoverageTexture = CoverageTexture->GetResource();
+		Params.IslandIndex = CoverageMap->GetTriangleIsland(TriangleHit.TriangleIndex);
+	}
+
+	{
+		MESH_PAINT_SCOPED_STAGE(Enqueue);
+		ENQUEUE_RENDER_COMMAND(PaintAtHitCommand)(
+		[Resource, Params](FRHICommandListImmediate& RHICmdList)
+		{
+			{
+				MESH_PAINT_SCOPED_STAGE(FlushDeferredResourceUpdate);
+				Resource->FlushDeferredResourceUpdate(RHICmdList);
+			}
+			MeshPaintRender::AddUVStampPass(RHICmdList, Resource, Params);
+		});
+	}
+
+	const FVector2D StampMin = FVector2D(Params.Center - Params.Radius) / FVector2D(TargetSize);
+	const FVector2D StampMax = FVector2D(Params.Center + Params.Radius) / FVector2D(TargetSize);
+	UMeshPaintDecaySubsystem::MarkTargetsPainted(World, TargetObjects, FBox2D(StampMin, StampMax));
+
+	FMeshPaintBrushStamp MirrorStamp;
+	MirrorStamp.Location = Hit.ImpactPoint;
+	MirrorStamp.Radius = Radius;
+	MirrorStamp.Hardness = Hardness;
+	MirrorStamp.Strength = Strength;
+	MeshPainterFunctionLibrary::UpdatePaintMirrors(World, MakeArrayView(&HitPrimitive, 1), false, MakeArrayView(&MirrorStamp, 1));
+
+	MeshPainterFunctionLibrary::UpdateTargetResources<UTextureRenderTarget2D>(TargetObjects);
+	return true;
+}
+
+void UMeshPainterFunctionLibrary::ApplyBrushStampToPaintMirrors(UObject* WorldContextObject, const FMeshPaintBrushStamp& Stamp)
+{
+	check(IsInGameThread());
+
+	UWorld* World = GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::LogAndReturnNull);
+	if (!IsValid(World))
+		return;
+
+	UMeshPaintMirrorComponent::BroadcastBrushStamp(World, Stamp);
+}
+
+bool UMeshPainterFunctionLibrary::RenderBrushStampsOnMesh(
+	UObject* WorldContextObject,
+	TArray<FRenderMaterialOnMeshPrimitive> Components,
+	UMaterialInterface* Material,
+	UTextureRenderTarget2D* BaseColor,
+	UTextureRenderTarget2D* Emissive,
+	UTextureRenderTarget2D* NormalMap,
+	const TArray<FMeshPaintBrushStamp>& Stamps,
+	EMeshPaintBlendMode BlendMode,
+	float BlendThreshold,
+	UMeshPaintStampLibrary* StampLibrary
+)
+{
+	return RenderBrushStampsOnMesh(WorldContextObject, MakeArrayView(Components), Material, BaseColor, Emissive, NormalMap, MakeArrayView(Stamps), BlendMode, BlendThreshold, StampLibrary);
+}
+
+bool UMeshPainterFunctionLibrary::RenderBrushStampsOnMesh(
+	UObject* WorldContextObject,
+	TArrayView<FRenderMaterialOnMeshPrimitive> Components,
+	UMaterialInterface* Material,
+	UTextureRenderTarget2D* BaseColor,
+	UTextureRenderTarget2D* Emissive,
+	UTextureRenderTarget2D* NormalMap,
+	TConstArrayView<FMeshPaintBrushStamp> Stamps,
+	EMeshPaintBlendMode BlendMode,
+	float BlendThreshold,
+	UMeshPaintStampLibrary* StampLibrary,
+	bool bUpdatePaintMirrors
+)
+{
+	check(IsInGameThread());
+	MESH_PAINT_TRACE_SCOPE(RenderBrushStampsOnMesh);
+
+	UWorld* World = GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::LogAndReturnNull);
+	if (Components.IsEmpty() || Stamps.IsEmpty() || !IsValid(World))
+		return false;
+
+	if (Material)
+	{
+		MESH_PAINT_SCOPED_STAGE(EnsureIsComplete);
+		Material->EnsureIsComplete();
+	}
+
+	UTextureRenderTarget2D* TargetObjects[] = { BaseColor, Emissive, NormalMap };
+	UMeshPaintResidencySubsystem::EnsureTargetsResident(World, TargetObjects);
+
+	FMeshPaintRenderTargets Targets;
+	{
+		MESH_PAINT_SCOPED_STAGE(SetRenderTarget);
+		Targets.SetRenderTarget(BaseColor, FMeshPaintRenderTargets::RT_BaseColor);
+		Targets.SetRenderTarget(Emissive, FMeshPaintRenderTargets::RT_Emissive);
+		Targets.SetRenderTarget(NormalMap, FMeshPaintRenderTargets::RT_NormalMap);
+	}
+
+	return MeshPainterFunctionLibrary::RenderMaterialOnMeshTargets<UTextureRenderTarget2D>(World, Components, Material, Targets, TargetObjects, FRenderMaterialOnMeshViewConfiguration(), false, BlendMode, BlendThreshold, Stamps, StampLibrary, nullptr, 0.0f, bUpdatePaintMirrors);
+}
+
+bool UMeshPainterFunctionLibrary::RenderStrokeOnMesh(
+	UObject* WorldContextObject,
+	TArray<FRenderMaterialOnMeshPrimitive> Components,
+	UMaterialInterface* Material,
+	UTextureRenderTarget2D* BaseColor,
+	UTextureRenderTarget2D* Emissive,
+	UTextureRenderTarget2D* NormalMap,
+	const FMeshPaintStroke& Stroke,
+	EMeshPaintBlendMode BlendMode,
+	float BlendThreshold
+)
+{
+	// Expanded on the game thread, stamps are then culled per primitive like any other brush pass
+	TArray<FMeshPaintBrushStamp> Stamps;
+	MeshPaintStroke::ExpandStroke(Stroke, Stamps);
+	return RenderBrushStampsOnMesh(WorldContextObject, MakeArrayView(Components), Material, BaseColor, Emissive, NormalMap, Stamps, BlendMode, BlendThreshold);
+}
+
+int32 UMeshPainterFunctionLibrary::PaintSurfacesInVolume(
+	UObject* WorldContextObject,
+	UMaterialInterface* Material,
+	const TArray<FMeshPaintBrushStamp>& Stamps,
+	EMeshPaintBlendMode BlendMode,
+	float BlendThreshold,
+	bool bUpdatePaintMirrors,
+	UMeshPaintStampLibrary* StampLibrary
+)
+{
+	check(IsInGameThread());
+	MESH_PAINT_TRACE_SCOPE(PaintSurfacesInVolume);
+
+	UWorld* World = GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::LogAndReturnNull);
+	if (Stamps.IsEmpty() || !IsValid(World))
+		return 0;
+
+	TArray<UMeshPaintSurfaceComponent*> Surfaces;
+	UMeshPaintSurfaceComponent::FindSurfacesInStamps(World, Stamps, Surfaces);
+
+	// Surfaces sharing targets go in one pass, each keeps its own atlas cell or slice
+	int32 NumPainted = 0;
+	TBitArray<> Submitted(false, Surfaces.Num());
+	TArray<UMeshPaintSurfaceComponent*> Group;
+	for (int32 SurfaceIndex = 0; SurfaceIndex < Surfaces.Num(); ++SurfaceIndex)
+	{
+		if (Submitted[SurfaceIndex]) continue;
+
+		Group.Reset();
+		for (int32 OtherIndex = SurfaceIndex; OtherIndex < Surfaces.Num(); ++OtherIndex)
+		{
+			if (Submitted[OtherIndex] || !Surfaces[SurfaceIndex]->SharesTargetsWith(*Surfaces[OtherIndex])) continue;
+			Submitted[OtherIndex] = true;
+			Group.Add(Surfaces[OtherIndex]);
+		}
+
+		// Mirrors are broadcast below, they may belong to components without a surface
+		NumPainted += RenderBrushStampsOnSurfaces(World, Group, Material, Stamps, BlendMode, BlendThreshold, false, StampLibrary) ? Group.Num() : 0;
 	}
 
-	if (Params.PrimitivesToRender.IsEmpty())
+	if (bUpdatePaintMirrors)
+	{
+		for (const FMeshPaintBrushStamp& Stamp : Stamps)
+		{
+			UMeshPaintMirrorComponent::BroadcastBrushStamp(World, Stamp);
+		}
+	}
+
+	return NumPainted;
+}
+
+bool UMeshPainterFunctionLibrary::RenderBrushStampsOnSurfaces(
+	UWorld* World,
+	TConstArrayView<UMeshPaintSurfaceComponent*> Surfaces,
+	UMaterialInterface* Material,
+	TConstArrayView<FMeshPaintBrushStamp> Stamps,
+	EMeshPaintBlendMode BlendMode,
+	float BlendThreshold,
+	bool bUpdatePaintMirrors,
+	UMeshPaintStampLibrary* StampLibrary
+)
+{
+	check(IsInGameThread());
+	MESH_PAINT_TRACE_SCOPE(RenderBrushStampsOnSurfaces);
+
+	if (Surfaces.IsEmpty() || Stamps.IsEmpty() || !IsValid(World))
 		return false;
 
-	ENQUEUE_RENDER_COMMAND(RenderMaterialOnMeshUVLayoutCommand)(
-	[=](FRHICommandListImmediate& RHICmdList)
+	if (Material)
 	{
-		Targets.FlushDeferredResourceUpdate(RHICmdList);
-		MeshPaintRender::AddMeshPaintPass(RHICmdList, Targets, Params);
-	});
+		MESH_PAINT_SCOPED_STAGE(EnsureIsComplete);
+		Material->EnsureIsComplete();
+	}
+
+	TArray<FRenderMaterialOnMeshPrimitive> Primitives;
+	Primitives.Reserve(Surfaces.Num());
+	for (const UMeshPaintSurfaceComponent* Surface : Surfaces)
+	{
+		Primitives.Add(Surface->MakePaintPrimitive());
+	}
+
+	const UMeshPaintSurfaceComponent& First = *Surfaces[0];
+	UTextureRenderTarget2D* ManagedTargets[] = { Cast<UTextureRenderTarget2D>(First.GetBaseColor()), Cast<UTextureRenderTarget2D>(First.GetEmissive()), Cast<UTextureRenderTarget2D>(First.GetNormalMap()) };
+	UMeshPaintResidencySubsystem::EnsureTargetsResident(World, ManagedTargets);
+
+	FMeshPaintRenderTargets Targets;
+	{
+		MESH_PAINT_SCOPED_STAGE(SetRenderTarget);
+		Targets.SetRenderTarget(First.GetBaseColor(), FMeshPaintRenderTargets::RT_BaseColor);
+		Targets.SetRenderTarget(First.GetEmissive(), FMeshPaintRenderTargets::RT_Emissive);
+		Targets.SetRenderTarget(First.GetNormalMap(), FMeshPaintRenderTargets::RT_NormalMap);
+	}
+
+	if (Cast<UTextureRenderTarget2DArray>(First.GetBaseColor()) || Cast<UTextureRenderTarget2DArray>(First.GetEmissive()) || Cast<UTextureRenderTarget2DArray>(First.GetNormalMap()))
+	{
+		UTextureRenderTarget2DArray* TargetObjects[] = { Cast<UTextureRenderTarget2DArray>(First.GetBaseColor()), Cast<UTextureRenderTarget2DArray>(First.GetEmissive()), Cast<UTextureRenderTarget2DArray>(First.GetNormalMap()) };
+		return MeshPainterFunctionLibrary::RenderMaterialOnMeshTargets<UTextureRenderTarget2DArray>(World, Primitives, Material, Targets, TargetObjects, FRenderMaterialOnMeshViewConfiguration(), false, BlendMode, BlendThreshold, Stamps, StampLibrary, nullptr, 0.0f, bUpdatePaintMirrors);
+	}
+	UTextureRenderTarget2D* TargetObjects[] = { ManagedTargets[0], ManagedTargets[1], ManagedTargets[2] };
+	return MeshPainterFunctionLibrary::RenderMaterialOnMeshTargets<UTextureRenderTarget2D>(World, Primitives, Material, Targets, TargetObjects, FRenderMaterialOnMeshViewConfiguration(), false, BlendMode, BlendThreshold, Stamps, StampLibrary, nullptr, 0.0f, bUpdatePaintMirrors);
+}
+
+UTexture2D* UMeshPainterFunctionLibrary::GetPaintCoverageTexture(UObject* WorldContextObject, UStaticMesh* StaticMesh, int32 LOD, int32 UVChannel, int32 Width, int32 Height)
+{
+	check(IsInGameThread());
+	return UMeshPaintContextSubsystem::UseMeshData(WorldContextObject, StaticMesh).FindOrCreateCoverageTexture(StaticMesh, LOD, UVChannel, FIntPoint(Width, Height));
+}
+
+bool UMeshPainterFunctionLibrary::GetPaintCoverageStats(UObject* WorldContextObject, UStaticMesh* StaticMesh, int32 LOD, int32 UVChannel, int32 Width, int32 Height, float& OutCoverage, int32& OutNumIslands)
+{
+	OutCoverage = 0.0f;
+	OutNumIslands = 0;
+
+	TSharedPtr<const FMeshPaintCoverageMap> CoverageMap = UMeshPaintContextSubsystem::UseMeshData(WorldContextObject, StaticMesh).FindOrBuildCoverageMap(StaticMesh, LOD, UVChannel, FIntPoint(Width, Height));
+	if (!CoverageMap.IsValid())
+		return false;
 
-	if (BaseColor) BaseColor->UpdateResourceImmediate(false);
-	if (Emissive) Emissive->UpdateResourceImmediate(false);
-	if (NormalMap) NormalMap->UpdateResourceImmediate(false);
+	OutCoverage = CoverageMap->GetCoverage();
+	OutNumIslands = CoverageMap->GetNumIslands();
 	return true;
 }
@@ -1,20 +1,42 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "RuntimeMeshPainter.h"
+#include "MeshPaintMeshDataCache.h"
+#include "Engine/SkinnedAsset.h"
+#include "Engine/StaticMesh.h"
+#include "UObject/UObjectGlobals.h"
 
 #define LOCTEXT_NAMESPACE "FRuntimeMeshPainterModule"
 
+DEFINE_LOG_CATEGORY(LogMeshPainter);
+
 void FRuntimeMeshPainterModule::StartupModule()
 {
 	// This code will execute after your module is loaded into memory; the exact timing is specified in the .uplugin file per-module
-	
+
+#if WITH_EDITOR
+	// Rebuilt and reimported meshes change their geometry in place, paint data built from the previous geometry is dropped
+	ObjectPropertyChangedHandle = FCoreUObjectDelegates::OnObjectPropertyChanged.AddLambda([](UObject* Object, FPropertyChangedEvent&)
+	{
+		if (Object && (Object->IsA<UStaticMesh>() || Object->IsA<USkinnedAsset>()))
+		{
+			FMeshPaintMeshDataCache::Get().Invalidate(Object);
+		}
+	});
+#endif
 }
 
 void FRuntimeMeshPainterModule::ShutdownModule()
 {
 	// This function may be called during shutdown to clean up your module.  For modules that support dynamic reloading,
 	// we call this function before unloading the module.
-	
+
+#if WITH_EDITOR
+	FCoreUObjectDelegates::OnObjectPropertyChanged.Remove(ObjectPropertyChangedHandle);
+#endif
+
+	// Coverage textures are held by strong pointers, they have to go before UObjects are torn down
+	FMeshPaintMeshDataCache::Get().Reset();
 }
 
 #undef LOCTEXT_NAMESPACE
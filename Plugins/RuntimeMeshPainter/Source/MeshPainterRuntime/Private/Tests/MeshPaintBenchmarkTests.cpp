@@ -0,0 +1,87 @@
+#include "Dom/JsonObject.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "Tests/AutomationCommon.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace MeshPaintBenchmarkTests
+{
+	/** Seconds to wait for the benchmark to write its results */
+	static const double Timeout = 60.0;
+
+	static UWorld* FindWorld()
+	{
+		for (const FWorldContext& Context : GEngine->GetWorldContexts())
+		{
+			if ((Context.WorldType == EWorldType::Game || Context.WorldType == EWorldType::PIE || Context.WorldType == EWorldType::Editor) && Context.World())
+			{
+				return Context.World();
+			}
+		}
+		return nullptr;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMeshPaintBenchmarkTargetSetTest, "MeshPaint.Benchmark.InvalidTargetSet",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter)
+
+bool FMeshPaintBenchmarkTargetSetTest::RunTest(const FString& Parameters)
+{
+	UWorld* World = MeshPaintBenchmarkTests::FindWorld();
+	if (!TestNotNull(TEXT("World to run the benchmark in"), World)) return false;
+
+	// BCE is not a set of whole target names, it must not enable BC and E
+	AddExpectedError(TEXT("invalid target set 'BCE'"), EAutomationExpectedErrorFlags::Contains, 1);
+	GEngine->Exec(World, TEXT("MeshPaint.Benchmark Targets=BC,BCE Frames=1 Warmup=0"));
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMeshPaintBenchmarkSmokeTest, "MeshPaint.Benchmark.Smoke",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter)
+
+bool FMeshPaintBenchmarkSmokeTest::RunTest(const FString& Parameters)
+{
+	UWorld* World = MeshPaintBenchmarkTests::FindWorld();
+	if (!TestNotNull(TEXT("World to run the benchmark in"), World)) return false;
+
+	const FString OutputBase = FPaths::Combine(FPaths::AutomationTransientDir(), TEXT("MeshPaint"), TEXT("BenchmarkSmoke"));
+	IFileManager::Get().Delete(*(OutputBase + TEXT(".json")), false, true, true);
+	IFileManager::Get().Delete(*(OutputBase + TEXT(".csv")), false, true, true);
+	GEngine->Exec(World, *FString::Printf(TEXT("MeshPaint.Benchmark Primitives=2 Size=64 Targets=bc+E,N Calls=1 Frames=2 Warmup=1 Tag=Smoke Out=\"%s\""), *OutputBase));
+
+	const double StartTime = FPlatformTime::Seconds();
+	ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([this, OutputBase, StartTime]()
+	{
+		FString Json;
+		if (!FFileHelper::LoadFileToString(Json, *(OutputBase + TEXT(".json"))))
+		{
+			if (FPlatformTime::Seconds() - StartTime < MeshPaintBenchmarkTests::Timeout) return false;
+			AddError(TEXT("Benchmark did not write its results in time"));
+			return true;
+		}
+
+		TSharedPtr<FJsonObject> Root;
+		if (!TestTrue(TEXT("Results are valid json"), FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(Json), Root) && Root.IsValid())) return true;
+
+		const TArray<TSharedPtr<FJsonValue>>& Cases = Root->GetArrayField(TEXT("Cases"));
+		if (TestEqual(TEXT("One case per target set"), Cases.Num(), 2))
+		{
+			TestEqual(TEXT("First target set"), Cases[0]->AsObject()->GetStringField(TEXT("Targets")), FString(TEXT("BC+E")));
+			TestEqual(TEXT("Second target set"), Cases[1]->AsObject()->GetStringField(TEXT("Targets")), FString(TEXT("N")));
+			TestTrue(TEXT("Stage timings are recorded"), Cases[0]->AsObject()->HasField(TEXT("StageMsPerFrame")));
+		}
+		TestEqual(TEXT("Tag"), Root->GetStringField(TEXT("Tag")), FString(TEXT("Smoke")));
+		return true;
+	}));
+	return true;
+}
+
+#endif
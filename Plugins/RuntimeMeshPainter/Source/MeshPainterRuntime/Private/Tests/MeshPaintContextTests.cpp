@@ -0,0 +1,74 @@
+#include "MeshPaintContextSubsystem.h"
+#include "MeshPaintMeshDataCache.h"
+#include "MeshPainterFunctionLibrary.h"
+#include "Engine/Engine.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/Texture2D.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace MeshPaintContextTests
+{
+	/** Builds mesh data in the lookup for the duration of a test */
+	class FScopedSyncMeshDataBuild
+	{
+	public:
+		FScopedSyncMeshDataBuild()
+			: Variable(IConsoleManager::Get().FindConsoleVariable(TEXT("r.MeshPaint.MeshData.AsyncBuild")))
+			, PreviousValue(Variable ? Variable->GetInt() : 0)
+		{
+			if (Variable) Variable->Set(0, ECVF_SetByCode);
+		}
+		~FScopedSyncMeshDataBuild()
+		{
+			if (Variable) Variable->Set(PreviousValue, ECVF_SetByCode);
+		}
+
+	private:
+		IConsoleVariable* Variable;
+		int32 PreviousValue;
+	};
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMeshPaintContextCoverageReferenceTest, "MeshPaint.Context.CoverageReferencesMesh",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FMeshPaintContextCoverageReferenceTest::RunTest(const FString& Parameters)
+{
+	UStaticMesh* Plane = LoadObject<UStaticMesh>(nullptr, TEXT("/Engine/BasicShapes/Plane.Plane"));
+	if (!TestNotNull(TEXT("Engine plane mesh"), Plane)) return false;
+
+	MeshPaintContextTests::FScopedSyncMeshDataBuild SyncBuild;
+	FMeshPaintMeshDataCache::Get().Invalidate(Plane);
+
+	UWorld* World = UWorld::CreateWorld(EWorldType::Game, false);
+	GEngine->CreateNewWorldContext(EWorldType::Game).SetCurrentWorld(World);
+
+	UMeshPaintContextSubsystem* Context = UMeshPaintContextSubsystem::Get(World);
+	TestNotNull(TEXT("World paint context"), Context);
+
+	float Coverage = 0.0f;
+	int32 NumIslands = 0;
+	TestTrue(TEXT("Coverage stats"), UMeshPainterFunctionLibrary::GetPaintCoverageStats(World, Plane, 0, 0, 64, 64, Coverage, NumIslands));
+	TestTrue(TEXT("Plane covers its layout"), Coverage > 0.0f);
+
+	TWeakObjectPtr<UTexture2D> Texture = UMeshPainterFunctionLibrary::GetPaintCoverageTexture(World, Plane, 0, 0, 64, 64);
+	TestTrue(TEXT("Coverage texture"), Texture.IsValid());
+	if (Context)
+	{
+		TestEqual(TEXT("Meshes referenced by the world"), Context->GetNumReferencedMeshes(), 1);
+	}
+
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+
+	// The cache lets go of the texture with the last world referencing the mesh
+	CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+	TestFalse(TEXT("Coverage texture released with the world"), Texture.IsValid());
+	return true;
+}
+
+#endif
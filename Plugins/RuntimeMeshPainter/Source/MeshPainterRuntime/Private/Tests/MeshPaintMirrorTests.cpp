@@ -0,0 +1,174 @@
+#include "Components/MeshPaintMirrorComponent.h"
+#include "Components/StaticMeshComponent.h"
+#include "MeshPaintMeshDataCache.h"
+#include "MeshPaintTriangleBVH.h"
+#include "MeshPaintUVRasterizer.h"
+#include "Engine/StaticMesh.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace MeshPaintMirrorTests
+{
+	/** Two triangles covering [0, Size]^2 in XY at Z = 0, UVs map the square to the unit square */
+	static void MakeQuad(float Size, TArray<FVector3f>& OutPositions, TArray<FVector2f>& OutUVs, TArray<uint32>& OutIndices)
+	{
+		OutPositions = { FVector3f(0.0f, 0.0f, 0.0f), FVector3f(Size, 0.0f, 0.0f), FVector3f(Size, Size, 0.0f), FVector3f(0.0f, Size, 0.0f) };
+		OutUVs = { FVector2f(0.0f, 0.0f), FVector2f(1.0f, 0.0f), FVector2f(1.0f, 1.0f), FVector2f(0.0f, 1.0f) };
+		OutIndices = { 0, 1, 2, 0, 2, 3 };
+	}
+
+	/** Builds mesh data in the lookup for the duration of a test */
+	class FScopedSyncMeshDataBuild
+	{
+	public:
+		FScopedSyncMeshDataBuild()
+			: Variable(IConsoleManager::Get().FindConsoleVariable(TEXT("r.MeshPaint.MeshData.AsyncBuild")))
+			, PreviousValue(Variable ? Variable->GetInt() : 0)
+		{
+			if (Variable) Variable->Set(0, ECVF_SetByCode);
+		}
+		~FScopedSyncMeshDataBuild()
+		{
+			if (Variable) Variable->Set(PreviousValue, ECVF_SetByCode);
+		}
+
+	private:
+		IConsoleVariable* Variable;
+		int32 PreviousValue;
+	};
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMeshPaintUVRasterCoverageTest, "MeshPaint.Mirror.UVRasterCoverage",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FMeshPaintUVRasterCoverageTest::RunTest(const FString& Parameters)
+{
+	// Triangles sharing an edge must cover every texel of their union exactly once, whatever the grid alignment
+	const FIntPoint GridSize(13, 9);
+	const FIntRect ClipRect(FIntPoint::ZeroValue, GridSize);
+	TArray<int32> Hits;
+	Hits.SetNumZeroed(GridSize.X * GridSize.Y);
+
+	const FVector2f Corners[4] = { FVector2f(0.0f, 0.0f), FVector2f(GridSize.X, 0.0f), FVector2f(GridSize.X, GridSize.Y), FVector2f(0.0f, GridSize.Y) };
+	const FVector2f Center(3.75f, 4.5f);
+	for (int32 Edge = 0; Edge < 4; ++Edge)
+	{
+		MeshPaintUVRaster::RasterizeTriangle(Corners[Edge], Corners[(Edge + 1) % 4], Center, ClipRect,
+			[&](int32 X, int32 Y, int32 LaneMask, const VectorRegister4Float&, const VectorRegister4Float&, const VectorRegister4Float&)
+			{
+				for (int32 Lane = 0; Lane < MeshPaintUVRaster::LaneCount; ++Lane)
+				{
+					if (LaneMask & (1 << Lane)) ++Hits[Y * GridSize.X + X + Lane];
+				}
+			});
+	}
+
+	int32 NumWrong = 0;
+	for (const int32 NumHits : Hits)
+	{
+		NumWrong += NumHits != 1 ? 1 : 0;
+	}
+	TestEqual(TEXT("Texels not covered exactly once"), NumWrong, 0);
+
+	// Clockwise and counter clockwise windings cover the same texels
+	const int32 Clockwise = MeshPaintUVRaster::RasterizeTriangle(FVector2f(0.3f, 0.7f), FVector2f(8.2f, 1.1f), FVector2f(3.9f, 7.6f), ClipRect, [](auto&&...) {});
+	const int32 CounterClockwise = MeshPaintUVRaster::RasterizeTriangle(FVector2f(0.3f, 0.7f), FVector2f(3.9f, 7.6f), FVector2f(8.2f, 1.1f), ClipRect, [](auto&&...) {});
+	TestEqual(TEXT("Texels covered by both windings"), Clockwise, CounterClockwise);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMeshPaintTriangleBVHQueryTest, "MeshPaint.Mirror.TriangleBVHQuery",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FMeshPaintTriangleBVHQueryTest::RunTest(const FString& Parameters)
+{
+	TArray<FVector3f> Positions;
+	TArray<FVector2f> UVs;
+	TArray<uint32> Indices;
+	MeshPaintMirrorTests::MakeQuad(100.0f, Positions, UVs, Indices);
+
+	FMeshPaintTriangleBVH BVH;
+	BVH.Build(MoveTemp(Positions), MoveTemp(UVs), Indices);
+	if (!TestTrue(TEXT("Hierarchy is valid"), BVH.IsValid())) return false;
+	TestEqual(TEXT("Triangle count"), BVH.GetNumTriangles(), 2);
+
+	FMeshPaintTriangleBVH::FHit Hit;
+	if (TestTrue(TEXT("Point above the quad is found"), BVH.FindClosestTriangle(FVector3f(25.0f, 75.0f, 5.0f), 10.0f, Hit)))
+	{
+		TestEqual(TEXT("Hit triangle"), Hit.TriangleIndex, 1);
+		TestTrue(TEXT("Hit UV"), BVH.GetHitUV(Hit).Equals(FVector2f(0.25f, 0.75f), 1.e-4f));
+		TestEqual(TEXT("Hit distance"), Hit.DistanceSquared, 25.0f, 1.e-3f);
+	}
+	TestFalse(TEXT("Point beyond MaxDistance is rejected"), BVH.FindClosestTriangle(FVector3f(50.0f, 50.0f, 20.0f), 10.0f, Hit));
+
+	// The quad winds clockwise seen from -Z, so it faces -Z
+	const FVector3f FrontNormal(0.0f, 0.0f, -1.0f);
+	const FVector3f BackNormal(0.0f, 0.0f, 1.0f);
+	TestTrue(TEXT("Triangle facing the normal is found"), BVH.FindClosestTriangle(FVector3f(25.0f, 75.0f, -5.0f), 10.0f, Hit, &FrontNormal));
+	TestFalse(TEXT("Triangle facing against the normal is skipped"), BVH.FindClosestTriangle(FVector3f(25.0f, 75.0f, 5.0f), 10.0f, Hit, &BackNormal));
+	if (TestTrue(TEXT("Closest point on a given triangle"), BVH.GetClosestPointOnTriangle(0, FVector3f(75.0f, 25.0f, 5.0f), 10.0f, Hit)))
+	{
+		TestEqual(TEXT("Given triangle distance"), Hit.DistanceSquared, 25.0f, 1.e-3f);
+	}
+
+	int32 NumInBox = 0;
+	BVH.ForEachTriangleInBox(FBox3f(FVector3f(90.0f, 1.0f, -1.0f), FVector3f(95.0f, 5.0f, 1.0f)), [&NumInBox](int32) { ++NumInBox; });
+	TestTrue(TEXT("Box query finds the triangle under it"), NumInBox >= 1);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMeshPaintMirrorStampQueryTest, "MeshPaint.Mirror.StampAndQuery",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FMeshPaintMirrorStampQueryTest::RunTest(const FString& Parameters)
+{
+	// Engine plane, 100 units centered on the origin with UVs over the unit square
+	UStaticMesh* Plane = LoadObject<UStaticMesh>(nullptr, TEXT("/Engine/BasicShapes/Plane.Plane"));
+	if (!TestNotNull(TEXT("Engine plane mesh"), Plane)) return false;
+
+	MeshPaintMirrorTests::FScopedSyncMeshDataBuild SyncBuild;
+	FMeshPaintMeshDataCache::Get().Invalidate(Plane);
+
+	UStaticMeshComponent* MeshComponent = NewObject<UStaticMeshComponent>(GetTransientPackage());
+	MeshComponent->SetStaticMesh(Plane);
+	UMeshPaintMirrorComponent* Mirror = NewObject<UMeshPaintMirrorComponent>(GetTransientPackage());
+	Mirror->SetPaintedComponent(MeshComponent);
+
+	FMeshPaintBrushStamp Stamp;
+	Stamp.Location = FVector(-25.0, -25.0, 0.0);
+	Stamp.Radius = 15.0f;
+	Stamp.Hardness = 1.0f;
+	Stamp.Strength = 1.0f;
+	Stamp.OwnerId = 3;
+	TestTrue(TEXT("Stamp changes the mirror"), Mirror->ApplyBrushStamp(Stamp));
+
+	float Coverage = 0.0f;
+	uint8 OwnerId = 0;
+	if (TestTrue(TEXT("Query under the stamp"), Mirror->QueryPaintAtLocation(FVector(-25.0, -25.0, 1.0), 5.0f, Coverage, OwnerId)))
+	{
+		TestEqual(TEXT("Coverage under the stamp"), Coverage, 1.0f);
+		TestEqual(TEXT("Owner under the stamp"), (int32)OwnerId, 3);
+	}
+	if (TestTrue(TEXT("Query away from the stamp"), Mirror->QueryPaintAtLocation(FVector(30.0, 30.0, 0.0), 5.0f, Coverage, OwnerId)))
+	{
+		TestEqual(TEXT("Coverage away from the stamp"), Coverage, 0.0f);
+	}
+	TestFalse(TEXT("Query off the surface"), Mirror->QueryPaintAtLocation(FVector(0.0, 0.0, 50.0), 5.0f, Coverage, OwnerId));
+
+	// A disk of radius 15 on a 100 unit square
+	const float ExpectedCoverage = UE_PI * 15.0f * 15.0f / (100.0f * 100.0f);
+	TestEqual(TEXT("Owner coverage"), Mirror->GetOwnerCoverage(3), ExpectedCoverage, 0.02f);
+
+	TestTrue(TEXT("Fill changes the mirror"), Mirror->ApplyFill(1.0f, 5));
+	TestEqual(TEXT("Fill takes over every texel"), Mirror->GetOwnerCoverage(5), 1.0f, 1.e-3f);
+
+	Mirror->ClearPaint();
+	TestEqual(TEXT("Cleared mirror has no owner coverage"), Mirror->GetOwnerCoverage(5), 0.0f);
+
+	FMeshPaintMeshDataCache::Get().Invalidate(Plane);
+	return true;
+}
+
+#endif
@@ -0,0 +1,152 @@
+#include "MeshPaintReferenceRasterizer.h"
+#include "ImageUtils.h"
+#include "Interfaces/IPluginManager.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/CommandLine.h"
+#include "Misc/Paths.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace MeshPaintReferenceRasterTests
+{
+	/** Per channel tolerance against the checked in goldens */
+	static const float GoldenTolerance = 1.e-3f;
+
+	/** Goldens live in Tests/ReferenceRaster of the plugin */
+	static FString GetGoldenPath(const TCHAR* CaseName)
+	{
+		const TSharedPtr<IPlugin> Plugin = IPluginManager::Get().FindPlugin(TEXT("RuntimeMeshPainter"));
+		return Plugin.IsValid() ? FPaths::Combine(Plugin->GetBaseDir(), TEXT("Tests"), TEXT("ReferenceRaster"), FString(CaseName) + TEXT(".exr")) : FString();
+	}
+
+	/**
+	 * Compares Image with the golden of CaseName. A missing golden is an error, unless the test runs with
+	 * -MeshPaintCreateGoldens in which case the image is written as the new golden for review.
+	 */
+	static bool TestAgainstGolden(FAutomationTestBase& Test, const TCHAR* CaseName, const FImage& Image)
+	{
+		const FString GoldenPath = GetGoldenPath(CaseName);
+		if (GoldenPath.IsEmpty())
+		{
+			Test.AddError(TEXT("RuntimeMeshPainter plugin not found, unable to locate goldens"));
+			return false;
+		}
+
+		if (!FPaths::FileExists(GoldenPath))
+		{
+			if (!FParse::Param(FCommandLine::Get(), TEXT("MeshPaintCreateGoldens")))
+			{
+				Test.AddError(FString::Printf(TEXT("Golden '%s' is missing, run with -MeshPaintCreateGoldens to create it"), *GoldenPath));
+				return false;
+			}
+			if (!FImageUtils::SaveImageByExtension(*GoldenPath, Image))
+			{
+				Test.AddError(FString::Printf(TEXT("Unable to create golden '%s'"), *GoldenPath));
+				return false;
+			}
+			Test.AddWarning(FString::Printf(TEXT("Created golden '%s'"), *GoldenPath));
+			return true;
+		}
+
+		FImage Golden;
+		if (!FImageUtils::LoadImage(*GoldenPath, Golden))
+		{
+			Test.AddError(FString::Printf(TEXT("Unable to load golden '%s'"), *GoldenPath));
+			return false;
+		}
+
+		FImage Difference;
+		const FMeshPaintReferenceRasterizer::FComparison Comparison = FMeshPaintReferenceRasterizer::Compare(Image, Golden, GoldenTolerance, &Difference);
+		if (!Comparison.Passed())
+		{
+			const FString OutputDir = FPaths::Combine(FPaths::AutomationDir(), TEXT("MeshPaint"), TEXT("ReferenceRaster"));
+			FImageUtils::SaveImageByExtension(*FPaths::Combine(OutputDir, FString(CaseName) + TEXT(".exr")), Image);
+			if (Comparison.bSizeMatches)
+			{
+				FImageUtils::SaveImageByExtension(*FPaths::Combine(OutputDir, FString(CaseName) + TEXT("_Diff.exr")), Difference);
+			}
+			Test.AddError(FString::Printf(TEXT("%s differs from its golden: %lld texels above %f, max error %f%s, output in '%s'"),
+				CaseName, Comparison.NumMismatchedTexels, GoldenTolerance, Comparison.MaxError, Comparison.bSizeMatches ? TEXT("") : TEXT(", size mismatch"), *OutputDir));
+			return false;
+		}
+		return true;
+	}
+
+	/** A quad with an overlapping triangle submitted after it, the overlap checks blend order */
+	static FMeshPaintReferenceRasterizer::FPrimitive MakeLayoutPrimitive()
+	{
+		FMeshPaintReferenceRasterizer::FPrimitive Primitive;
+		Primitive.UVs = {
+			FVector2f(0.1f, 0.15f), FVector2f(0.85f, 0.1f), FVector2f(0.9f, 0.8f), FVector2f(0.12f, 0.9f),
+			FVector2f(0.3f, 0.3f), FVector2f(0.7f, 0.35f), FVector2f(0.5f, 0.95f) };
+		Primitive.Indices = { 0, 1, 2, 0, 2, 3, 4, 5, 6 };
+		return Primitive;
+	}
+
+	static FLinearColor ShadeLayout(const FVector2f& UV)
+	{
+		return FLinearColor(UV.X, UV.Y, 1.0f, 0.5f);
+	}
+
+	static FImage RasterizeLayout(bool bMultithreaded)
+	{
+		const FMeshPaintReferenceRasterizer::FPrimitive Primitive = MakeLayoutPrimitive();
+		FMeshPaintReferenceRasterizer::FSettings Settings;
+		Settings.bClearTarget = true;
+		Settings.ClearColor = FLinearColor::Transparent;
+		Settings.TileSize = 16;
+		Settings.bMultithreaded = bMultithreaded;
+
+		FImage Image(64, 64, ERawImageFormat::RGBA32F, EGammaSpace::Linear);
+		FMeshPaintReferenceRasterizer::Rasterize(MakeArrayView(&Primitive, 1), &ShadeLayout, Settings, Image);
+		return Image;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMeshPaintReferenceRasterLayoutTest, "MeshPaint.ReferenceRaster.Layout",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FMeshPaintReferenceRasterLayoutTest::RunTest(const FString& Parameters)
+{
+	return MeshPaintReferenceRasterTests::TestAgainstGolden(*this, TEXT("Layout"), MeshPaintReferenceRasterTests::RasterizeLayout(false));
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMeshPaintReferenceRasterAtlasCellsTest, "MeshPaint.ReferenceRaster.AtlasCells",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FMeshPaintReferenceRasterAtlasCellsTest::RunTest(const FString& Parameters)
+{
+	// Two primitives packed side by side, each mapped into its own atlas cell over a green cleared target
+	FMeshPaintReferenceRasterizer::FPrimitive Primitives[2];
+	Primitives[0].UVs = { FVector2f(0.05f, 0.1f), FVector2f(0.95f, 0.2f), FVector2f(0.4f, 0.9f) };
+	Primitives[0].Indices = { 0, 1, 2 };
+	Primitives[0].UVRegion = FBox2D(FVector2D(0.0, 0.0), FVector2D(0.5, 1.0));
+	Primitives[1].UVs = { FVector2f(0.05f, 0.1f), FVector2f(0.95f, 0.2f), FVector2f(0.4f, 0.9f), FVector2f(0.2f, 0.05f), FVector2f(0.9f, 0.6f), FVector2f(0.1f, 0.7f) };
+	Primitives[1].Indices = { 0, 1, 2, 3, 4, 5 };
+	Primitives[1].UVRegion = FBox2D(FVector2D(0.5, 0.0), FVector2D(1.0, 1.0));
+
+	FMeshPaintReferenceRasterizer::FSettings Settings;
+	Settings.bClearTarget = true;
+	Settings.bMultithreaded = false;
+
+	FImage Image(64, 32, ERawImageFormat::RGBA32F, EGammaSpace::Linear);
+	FMeshPaintReferenceRasterizer::Rasterize(Primitives,
+		[](const FVector2f& UV) { return FLinearColor(FMath::Clamp(UV.X, 0.0f, 1.0f), FMath::Clamp(UV.Y, 0.0f, 1.0f), FMath::Clamp(1.0f - UV.X, 0.0f, 1.0f), 0.75f); },
+		Settings, Image);
+	return MeshPaintReferenceRasterTests::TestAgainstGolden(*this, TEXT("AtlasCells"), Image);
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMeshPaintReferenceRasterThreadingTest, "MeshPaint.ReferenceRaster.Multithreaded",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FMeshPaintReferenceRasterThreadingTest::RunTest(const FString& Parameters)
+{
+	// Tiles processed on workers must give the exact single threaded result
+	const FImage SingleThreaded = MeshPaintReferenceRasterTests::RasterizeLayout(false);
+	const FImage Multithreaded = MeshPaintReferenceRasterTests::RasterizeLayout(true);
+	const FMeshPaintReferenceRasterizer::FComparison Comparison = FMeshPaintReferenceRasterizer::Compare(Multithreaded, SingleThreaded, 0.0f);
+	TestTrue(TEXT("Multithreaded raster matches single threaded raster"), Comparison.Passed());
+	return true;
+}
+
+#endif
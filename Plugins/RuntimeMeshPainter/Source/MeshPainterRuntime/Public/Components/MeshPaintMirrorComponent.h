@@ -0,0 +1,103 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "MeshPaintBrushTypes.h"
+#include "MeshPaintMirrorComponent.generated.h"
+
+class UStaticMeshComponent;
+class FMeshPaintTriangleBVH;
+
+/**
+ * Low resolution CPU copy of the paint applied to a static mesh component.
+ * Works without a GPU (dedicated servers, -nullrhi) and answers gameplay queries like "is this location painted and by whom".
+ * Paint calls of UMeshPainterFunctionLibrary on the mirrored component are replayed on it, except projected paint.
+ */
+UCLASS(ClassGroup=(Rendering), meta=(BlueprintSpawnableComponent))
+class RUNTIMEMESHPAINTER_API UMeshPaintMirrorComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UMeshPaintMirrorComponent();
+
+	//~ Begin UActorComponent Interface
+	virtual void OnRegister() override;
+	virtual void OnUnregister() override;
+	//~ End UActorComponent Interface
+
+	/** Rasterizes a brush stamp into the mirror, returns true when at least one texel changed */
+	UFUNCTION(BlueprintCallable, Category = "Mesh Paint")
+	bool ApplyBrushStamp(const FMeshPaintBrushStamp& Stamp);
+
+	/** Paints the whole UV layout at a uniform opacity, the way an opaque material pass covers it. Returns true when at least one texel changed */
+	UFUNCTION(BlueprintCallable, Category = "Mesh Paint")
+	bool ApplyFill(float Opacity, uint8 OwnerId);
+
+	/** Same as above, restricted to the triangles of the mirrored LOD TriangleFilter accepts */
+	bool ApplyFill(float Opacity, uint8 OwnerId, TFunctionRef<bool(int32 TriangleIndex)> TriangleFilter);
+
+	/** Looks up paint at the surface point closest to WorldLocation. Fails when no surface is within MaxDistance */
+	UFUNCTION(BlueprintCallable, Category = "Mesh Paint")
+	bool QueryPaintAtLocation(const FVector& WorldLocation, float MaxDistance, float& OutCoverage, uint8& OutOwnerId) const;
+
+	/** Removes all paint from the mirror */
+	UFUNCTION(BlueprintCallable, Category = "Mesh Paint")
+	void ClearPaint();
+
+	/** Overrides which component is mirrored, defaults to the first static mesh component of the owner */
+	UFUNCTION(BlueprintCallable, Category = "Mesh Paint")
+	void SetPaintedComponent(UStaticMeshComponent* InComponent);
+
+	UFUNCTION(BlueprintCallable, Category = "Mesh Paint")
+	UStaticMeshComponent* GetPaintedComponent() const;
+
+	/** Fraction of mirror texels painted by a given owner */
+	UFUNCTION(BlueprintCallable, Category = "Mesh Paint")
+	float GetOwnerCoverage(uint8 OwnerId) const;
+
+	/** Sends a stamp to every mirror of the world which bounds it touches */
+	static void BroadcastBrushStamp(UWorld* World, const FMeshPaintBrushStamp& Stamp);
+
+	int32 GetResolution() const { return Resolution; }
+	int32 GetLOD() const { return LOD; }
+	int32 GetUVChannel() const { return UVChannel; }
+	TConstArrayView<uint8> GetCoverage() const { return Coverage; }
+	TConstArrayView<uint8> GetOwners() const { return Owners; }
+
+protected:
+	/** Size of the square mirror grid in texels */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Mesh Paint", meta = (ClampMin = "4", ClampMax = "1024"))
+	int32 Resolution;
+
+	/** Mesh LOD used for rasterization and queries */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Mesh Paint")
+	int32 LOD;
+
+	/** Texture coordinate channel used for painting */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Mesh Paint")
+	int32 UVChannel;
+
+	/** Stamp opacity required to take over ownership of a texel */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Mesh Paint", meta = (ClampMin = "0.0", ClampMax = "1.0"))
+	float OwnershipThreshold;
+
+private:
+	const FMeshPaintTriangleBVH* ResolveTriangleBVH() const;
+	void EnsureGrid();
+
+	/** Blends an opaque texel of the given opacity over a grid texel, returns true when it changed */
+	bool BlendTexel(int32 TexelIndex, float Alpha, uint8 OwnerId);
+
+	UPROPERTY(Transient)
+	UStaticMeshComponent* PaintedComponent;
+
+	/** Opacity of paint per texel */
+	TArray<uint8> Coverage;
+
+	/** Owner of the paint per texel */
+	TArray<uint8> Owners;
+
+	mutable TSharedPtr<const FMeshPaintTriangleBVH> TriangleBVH;
+	mutable TWeakObjectPtr<const UObject> TriangleBVHMesh;
+};
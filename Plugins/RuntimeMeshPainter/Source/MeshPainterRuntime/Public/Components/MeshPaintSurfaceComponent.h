@@ -0,0 +1,111 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "MeshPainterFunctionLibrary.h"
+#include "MeshPaintSurfaceComponent.generated.h"
+
+class UPrimitiveComponent;
+class UTextureRenderTarget;
+
+/**
+ * Registers a primitive as paintable together with the targets it is painted into and its place in them (atlas cell or array slice).
+ * Volumetric brushes find surfaces through this registry and paint every surface sharing targets in a single pass.
+ */
+UCLASS(ClassGroup=(Rendering), meta=(BlueprintSpawnableComponent))
+class RUNTIMEMESHPAINTER_API UMeshPaintSurfaceComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UMeshPaintSurfaceComponent();
+
+	//~ Begin UActorComponent Interface
+	virtual void OnRegister() override;
+	virtual void OnUnregister() override;
+	//~ End UActorComponent Interface
+
+	/** Overrides which component is painted, defaults to the first mesh component of the owner */
+	UFUNCTION(BlueprintCallable, Category = "Mesh Paint")
+	void SetPaintedComponent(UPrimitiveComponent* InComponent);
+
+	UFUNCTION(BlueprintCallable, Category = "Mesh Paint")
+	UPrimitiveComponent* GetPaintedComponent() const;
+
+	/** Changes the targets and the place of the surface in them */
+	UFUNCTION(BlueprintCallable, Category = "Mesh Paint")
+	void SetPaintTargets(UTextureRenderTarget* InBaseColor, UTextureRenderTarget* InEmissive, UTextureRenderTarget* InNormalMap, const FBox2D& InUVRegion, int32 InArraySlice);
+
+	/** Unique id of the surface for the lifetime of the process, assigned on first registration and kept when the component registers again. 0 before */
+	UFUNCTION(BlueprintCallable, Category = "Mesh Paint")
+	int32 GetSurfaceId() const { return SurfaceId; }
+
+	/** Primitive description used by the paint passes */
+	FRenderMaterialOnMeshPrimitive MakePaintPrimitive() const;
+
+	/** True when both surfaces are painted into the same targets and can share a pass */
+	bool SharesTargetsWith(const UMeshPaintSurfaceComponent& Other) const;
+
+	UTextureRenderTarget* GetBaseColor() const { return BaseColor; }
+	UTextureRenderTarget* GetEmissive() const { return Emissive; }
+	UTextureRenderTarget* GetNormalMap() const { return NormalMap; }
+
+	/** Surfaces of a world which painted component bounds touch the sphere */
+	static void FindSurfacesInSphere(UWorld* World, const FVector& Center, float Radius, TArray<UMeshPaintSurfaceComponent*>& OutSurfaces);
+
+	/** Surfaces of a world which painted component bounds touch one of the stamps, each surface is listed once */
+	static void FindSurfacesInStamps(UWorld* World, TConstArrayView<FMeshPaintBrushStamp> Stamps, TArray<UMeshPaintSurfaceComponent*>& OutSurfaces);
+
+protected:
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Mesh Paint")
+	UTextureRenderTarget* BaseColor;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Mesh Paint")
+	UTextureRenderTarget* Emissive;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Mesh Paint")
+	UTextureRenderTarget* NormalMap;
+
+	/** Atlas cell of the surface in 2D targets */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Mesh Paint")
+	FBox2D UVRegion;
+
+	/** Slice of the surface in array targets */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Mesh Paint")
+	int32 ArraySlice;
+
+	/** Mesh LOD painted, INDEX_NONE selects it from texel density */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Mesh Paint")
+	int32 LOD;
+
+	/** Texture coordinate channel used for painting */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Mesh Paint")
+	int32 UVChannel;
+
+	/** Paints skeletal meshes in reference pose */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Mesh Paint")
+	bool bReferencePose;
+
+	/**
+	 * Custom primitive data index the surface descriptor of the painted component is kept at, for materials reading
+	 * their paint through the Mesh Paint Surface Coordinates node. INDEX_NONE leaves custom primitive data alone.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Mesh Paint")
+	int32 DescriptorDataIndex;
+
+private:
+	/** Writes the surface descriptor when DescriptorDataIndex is set */
+	void UpdateSurfaceDescriptor();
+
+	/** Starts loading or building the shared data of a static painted mesh in game worlds, so it is ready by the first paint */
+	void PrefetchMeshData();
+
+	/** Hands the 2D targets to the residency subsystem with the painted component as visibility source */
+	void RegisterResidency();
+	void UnregisterResidency();
+
+	UPROPERTY(Transient)
+	UPrimitiveComponent* PaintedComponent;
+
+	int32 SurfaceId;
+};
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MeshPaintBrushTypes.generated.h"
+
+/** Single spherical brush application in world space */
+USTRUCT(BlueprintType)
+struct FMeshPaintBrushStamp
+{
+	GENERATED_BODY()
+
+	FMeshPaintBrushStamp() : Location(FVector::ZeroVector), Radius(10.0f), Hardness(0.5f), Strength(1.0f), OwnerId(0), ShapeIndex(INDEX_NONE), Orientation(ForceInitToZero) {}
+
+	/** Brush center */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	FVector Location;
+
+	/** Brush radius in world units */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float Radius;
+
+	/** Fraction of the radius painted at full strength, the rest fades out linearly */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0.0", ClampMax = "1.0"))
+	float Hardness;
+
+	/** Opacity of the stamp at its center */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0.0", ClampMax = "1.0"))
+	float Strength;
+
+	/** Gameplay owner of the paint (team, player slot etc.) */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	uint8 OwnerId;
+
+	/** Shape of the stamp library painted with, masks the sphere. INDEX_NONE keeps the stamp round */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 ShapeIndex;
+
+	/** Frame of the shape, it is projected along the X axis like a decal */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	FRotator Orientation;
+};
+
+/** World space stroke expanded into evenly spaced brush stamps */
+USTRUCT(BlueprintType)
+struct FMeshPaintStroke
+{
+	GENERATED_BODY()
+
+	FMeshPaintStroke() : Spacing(0.25f), bSmooth(false) {}
+
+	/** Stroke points in painting order */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	TArray<FVector> Points;
+
+	/** Pressure per point scaling stamp strength, missing entries count as full pressure */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	TArray<float> Pressures;
+
+	/** Shape of every stamp, its location is ignored */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	FMeshPaintBrushStamp Brush;
+
+	/** Distance between stamps as a fraction of the brush radius */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0.01"))
+	float Spacing;
+
+	/** Follows a Catmull-Rom spline through the points instead of straight segments */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	bool bSmooth;
+};
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "MeshPaintContextSubsystem.generated.h"
+
+class UMeshPaintSurfaceComponent;
+class UMeshPaintMirrorComponent;
+class FMeshPaintMeshDataCache;
+
+/**
+ * Paint state of a world: its surface and mirror registries and its references to the shared per asset data of FMeshPaintMeshDataCache.
+ * Worlds never see each other's state, so PIE clients are isolated while the immutable mesh data is built once for all of them.
+ * Everything goes when the world is torn down, mesh data with the last world referencing it.
+ */
+UCLASS()
+class RUNTIMEMESHPAINTER_API UMeshPaintContextSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	//~ Begin UWorldSubsystem Interface
+	virtual void Deinitialize() override;
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+	//~ End UWorldSubsystem Interface
+
+	/** Context of the world of an object, null when the world has none or is being torn down */
+	static UMeshPaintContextSubsystem* Get(const UObject* WorldContextObject);
+
+	void RegisterSurface(UMeshPaintSurfaceComponent* Surface);
+	void UnregisterSurface(UMeshPaintSurfaceComponent* Surface);
+	TConstArrayView<UMeshPaintSurfaceComponent*> GetSurfaces() const { return Surfaces; }
+
+	void RegisterMirror(UMeshPaintMirrorComponent* Mirror);
+	void UnregisterMirror(UMeshPaintMirrorComponent* Mirror);
+	TConstArrayView<UMeshPaintMirrorComponent*> GetMirrors() const { return Mirrors; }
+
+	/**
+	 * Shared data cache, after referencing Mesh from the world of WorldContextObject until the world is torn down.
+	 * Data used outside of any world is not referenced and stays until invalidated
+	 */
+	static FMeshPaintMeshDataCache& UseMeshData(const UObject* WorldContextObject, const UObject* Mesh);
+
+	/** Meshes whose shared data this world references */
+	int32 GetNumReferencedMeshes() const { return ReferencedMeshes.Num(); }
+
+private:
+	/** Components unregister themselves before they are destroyed */
+	TArray<UMeshPaintSurfaceComponent*> Surfaces;
+	TArray<UMeshPaintMirrorComponent*> Mirrors;
+
+	TSet<FObjectKey> ReferencedMeshes;
+};
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/AssetUserData.h"
+#include "MeshPaintCookedMeshData.generated.h"
+
+class FMeshPaintTriangleBVH;
+class FMeshPaintCoverageMap;
+struct FMeshPaintLODStats;
+
+/** Paint settings of a mesh LOD its data is cooked for */
+USTRUCT(BlueprintType)
+struct RUNTIMEMESHPAINTER_API FMeshPaintCookedMeshDataSettings
+{
+	GENERATED_BODY()
+
+	FMeshPaintCookedMeshDataSettings() : LOD(0), UVChannel(0) {}
+
+	UPROPERTY(EditAnywhere, Category = "Mesh Paint", meta = (ClampMin = "0"))
+	int32 LOD;
+
+	UPROPERTY(EditAnywhere, Category = "Mesh Paint", meta = (ClampMin = "0"))
+	int32 UVChannel;
+
+	/** Texel sizes of the atlas cells the LOD is painted into, a coverage map is cooked for each */
+	UPROPERTY(EditAnywhere, Category = "Mesh Paint")
+	TArray<FIntPoint> CoverageResolutions;
+};
+
+/**
+ * Paint acceleration data of a static mesh built when the mesh is cooked, added to the asset user data of the mesh.
+ * Triangle hierarchies, LOD statistics and coverage maps of the listed settings go through the derived data cache at cook time
+ * and are deserialized with the mesh package, so cooked games do not build them when painting starts.
+ * FMeshPaintMeshDataCache builds data of other settings on a worker.
+ */
+UCLASS(meta = (DisplayName = "Mesh Paint Cooked Data"))
+class RUNTIMEMESHPAINTER_API UMeshPaintCookedMeshData : public UAssetUserData
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(EditAnywhere, Category = "Mesh Paint")
+	TArray<FMeshPaintCookedMeshDataSettings> Settings;
+
+	//~ Begin UObject Interface
+	virtual void Serialize(FArchive& Ar) override;
+#if WITH_EDITOR
+	virtual void PreSave(FObjectPreSaveContext SaveContext) override;
+#endif
+	//~ End UObject Interface
+
+	/** Cooked data, null when none was cooked for the settings or outside of cooked packages */
+	TSharedPtr<const FMeshPaintTriangleBVH> FindTriangleBVH(int32 LODIndex, int32 UVChannel) const;
+	TSharedPtr<const FMeshPaintLODStats> FindLODStats(int32 UVChannel) const;
+	TSharedPtr<const FMeshPaintCoverageMap> FindCoverageMap(int32 LODIndex, int32 UVChannel, FIntPoint Resolution) const;
+
+private:
+	struct FCookedLOD
+	{
+		int32 LODIndex = 0;
+		int32 UVChannel = 0;
+		TSharedPtr<FMeshPaintTriangleBVH> TriangleBVH;
+		TArray<TPair<FIntPoint, TSharedPtr<FMeshPaintCoverageMap>>> CoverageMaps;
+	};
+
+#if WITH_EDITOR
+	/** Builds the data of Settings from the outer mesh */
+	void BuildCookedData();
+#endif
+
+	TArray<FCookedLOD> CookedLODs;
+	TArray<TPair<int32, TSharedPtr<FMeshPaintLODStats>>> CookedLODStats;
+};
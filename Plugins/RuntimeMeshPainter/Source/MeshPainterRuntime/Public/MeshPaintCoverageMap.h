@@ -0,0 +1,77 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UTexture2D;
+
+/**
+ * Which texels of a paint target a mesh LOD covers in UV space, at a given resolution.
+ * Every texel center inside a triangle stores the triangle and its UV island, texels outside the layout are invalid.
+ * Triangles are rasterized in index buffer order with the fill convention of the paint pass, so the map matches GPU coverage.
+ */
+class RUNTIMEMESHPAINTER_API FMeshPaintCoverageMap
+{
+public:
+	FMeshPaintCoverageMap() : Size(FIntPoint::ZeroValue), NumTriangles(0), NumCoveredTexels(0) {}
+
+	/** Builds the map from a UV layout, triangles sharing a UV vertex belong to the same island */
+	void Build(TConstArrayView<FVector2f> UVs, TConstArrayView<uint32> Indices, FIntPoint InSize, bool bMultithreaded = true);
+
+	bool IsValid() const { return Size.X > 0 && Size.Y > 0 && TriangleIds.Num() == Size.X * Size.Y; }
+
+	FIntPoint GetSize() const { return Size; }
+	int32 GetNumTriangles() const { return NumTriangles; }
+	int32 GetNumIslands() const { return IslandBounds.Num(); }
+
+	/** Valid mask, true when a triangle covers the texel center */
+	bool IsTexelCovered(int32 X, int32 Y) const { return GetTriangle(X, Y) != INDEX_NONE; }
+
+	/** Triangle covering a texel in index buffer order, INDEX_NONE for invalid texels */
+	int32 GetTriangle(int32 X, int32 Y) const { return (int32)TriangleIds[Y * Size.X + X] - 1; }
+
+	/** Island of a texel, INDEX_NONE for invalid texels */
+	int32 GetIsland(int32 X, int32 Y) const
+	{
+		const int32 TriangleIndex = GetTriangle(X, Y);
+		return TriangleIndex != INDEX_NONE ? TriangleIslands[TriangleIndex] : INDEX_NONE;
+	}
+
+	/** Island of a triangle, also for triangles too small to cover a texel */
+	int32 GetTriangleIsland(int32 TriangleIndex) const { return TriangleIslands.IsValidIndex(TriangleIndex) ? TriangleIslands[TriangleIndex] : INDEX_NONE; }
+
+	/** Texel at a UV, INDEX_NONE components outside of the unit square */
+	FIntPoint UVToTexel(const FVector2f& UV) const;
+
+	/** Texel rectangle touched by an island, a tight dirty rect for island sized paint */
+	const FIntRect& GetIslandBounds(int32 IslandIndex) const { return IslandBounds[IslandIndex]; }
+
+	int32 GetIslandTexelCount(int32 IslandIndex) const { return IslandTexelCounts[IslandIndex]; }
+	int64 GetNumCoveredTexels() const { return NumCoveredTexels; }
+
+	/** Fraction of the target covered by the layout */
+	float GetCoverage() const { return IsValid() ? (float)((double)NumCoveredTexels / ((double)Size.X * Size.Y)) : 0.0f; }
+
+	/**
+	 * Transient PF_G32R32F texture for materials and paint shaders, sampled with point filtering.
+	 * R holds triangle index + 1 and G island index + 1, zero marks invalid texels. Game thread
+	 */
+	UTexture2D* CreateTexture(UObject* Outer, FName Name = NAME_None) const;
+
+	SIZE_T GetAllocatedSize() const;
+
+	friend FArchive& operator<<(FArchive& Ar, FMeshPaintCoverageMap& Map);
+
+private:
+	FIntPoint Size;
+	int32 NumTriangles;
+	int64 NumCoveredTexels;
+
+	/** Triangle index + 1 per texel, zero for texels no triangle covers */
+	TArray<uint32> TriangleIds;
+
+	/** Island of every triangle */
+	TArray<int32> TriangleIslands;
+
+	TArray<FIntRect> IslandBounds;
+	TArray<int32> IslandTexelCounts;
+};
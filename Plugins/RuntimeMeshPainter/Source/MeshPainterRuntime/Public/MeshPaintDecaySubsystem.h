@@ -0,0 +1,81 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "MeshPaintDecaySubsystem.generated.h"
+
+class UTextureRenderTarget2D;
+
+/**
+ * Fades paint of registered targets linearly to zero over time, for wetness, blood or heat.
+ * Targets are split into tiles (r.MeshPaint.Decay.TileSize). Paint entry points mark the tiles they touch, a compute pass
+ * fades those tiles only and a tile leaves the active set once it has had time to reach zero. Targets whose tiles have all
+ * expired are skipped without visiting their tiles, so idle targets cost nothing. Resized targets start over with every tile active.
+ */
+UCLASS()
+class RUNTIMEMESHPAINTER_API UMeshPaintDecaySubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	//~ Begin UTickableWorldSubsystem Interface
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	//~ End UTickableWorldSubsystem Interface
+
+	/**
+	 * Starts fading a target by FadePerSecond per second, MaxValue being the largest value paint can leave in it.
+	 * ChannelMask selects the channels which fade. The whole target is active at first since it may already hold paint.
+	 * Returns false when the target is not UAV capable or its format does not support typed UAV loads.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Mesh Paint")
+	bool RegisterDecayTarget(UTextureRenderTarget2D* Target, float FadePerSecond, FLinearColor ChannelMask = FLinearColor(1.0f, 1.0f, 1.0f, 1.0f), float MaxValue = 1.0f);
+
+	UFUNCTION(BlueprintCallable, Category = "Mesh Paint")
+	void UnregisterDecayTarget(UTextureRenderTarget2D* Target);
+
+	/** Marks the tiles under a UV rectangle as painted, they stay active until their value can have faded out */
+	void MarkPainted(UTextureRenderTarget2D* Target, const FBox2D& UVRect);
+
+	/** Same as above for the registered ones among Targets, paint entry points go through this after painting */
+	static void MarkTargetsPainted(UWorld* World, TConstArrayView<UTextureRenderTarget2D*> Targets, const FBox2D& UVRect);
+
+	/** Number of tiles faded by the last tick over every target */
+	int32 GetNumActiveTiles() const { return NumActiveTiles; }
+
+private:
+	struct FDecayTarget
+	{
+		TWeakObjectPtr<UTextureRenderTarget2D> Target;
+		float FadePerSecond = 0.0f;
+		float MaxValue = 1.0f;
+		FVector4f ChannelMask = FVector4f::One();
+		int32 TileSize = 32;
+		FIntPoint NumTiles = FIntPoint::ZeroValue;
+
+		/** Target size the tiles were laid out for */
+		FIntPoint TargetSize = FIntPoint::ZeroValue;
+
+		/** World time at which each tile has faded out */
+		TArray<double> TileExpireTimes;
+
+		/** Latest of TileExpireTimes */
+		double MaxExpireTime = 0.0;
+
+		/** Fade not applied yet, 8 and 16 bit formats skip frames until it reaches one quantization step */
+		float PendingAmount = 0.0f;
+		float Quantum = 0.0f;
+	};
+
+	FDecayTarget* FindTarget(const UTextureRenderTarget2D* Target);
+
+	/** Lays tiles out over the current size of the target, all of them active for the time MaxValue takes to fade */
+	void ResetTiles(FDecayTarget& DecayTarget) const;
+
+	/** Time at which paint marked now has faded out */
+	double GetExpireTime(const FDecayTarget& DecayTarget) const;
+
+	TArray<FDecayTarget> Targets;
+	int32 NumActiveTiles = 0;
+};
@@ -0,0 +1,146 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/ObjectKey.h"
+#include "UObject/StrongObjectPtr.h"
+#include "Tasks/Task.h"
+
+class UStaticMesh;
+class USkinnedAsset;
+class FMeshPaintTriangleBVH;
+class FMeshPaintCoverageMap;
+class UTexture2D;
+
+/** UV space triangle statistics of every LOD of a mesh, used to pick paint LODs from texel density */
+struct RUNTIMEMESHPAINTER_API FMeshPaintLODStats
+{
+	struct FLOD
+	{
+		int32 NumTriangles = 0;
+
+		/** Median of sqrt(2 * UV area) over triangles, the leg of a right triangle of the same UV area */
+		float MedianUVTriangleSize = 0.0f;
+
+		friend FArchive& operator<<(FArchive& Ar, FLOD& LOD)
+		{
+			return Ar << LOD.NumTriangles << LOD.MedianUVTriangleSize;
+		}
+	};
+
+	TArray<FLOD> LODs;
+
+	bool IsValid() const { return !LODs.IsEmpty(); }
+
+	/** Finest LOD whose median triangle still spans MinTriangleTexels texels in an atlas cell of CellTexels, the last LOD when none does */
+	int32 SelectLOD(const FVector2D& CellTexels, float MinTriangleTexels) const;
+
+	friend FArchive& operator<<(FArchive& Ar, FMeshPaintLODStats& Stats)
+	{
+		return Ar << Stats.LODs;
+	}
+};
+
+/**
+ * Per asset paint acceleration data, shared by every component and every world using the same mesh.
+ * Worlds reference the meshes they paint through their UMeshPaintContextSubsystem, data of a mesh goes with its last reference.
+ * Data comes from the mesh UMeshPaintCookedMeshData when it was cooked for the lookup settings, otherwise it is built on a worker
+ * (r.MeshPaint.MeshData.AsyncBuild) from geometry copied on the game thread. Editor builds keep built data in the derived data cache,
+ * looked up on the worker before any geometry is copied.
+ * Lookups never wait: they return null until the data is ready. Failed builds are retried after r.MeshPaint.MeshData.RetryDelay.
+ */
+class RUNTIMEMESHPAINTER_API FMeshPaintMeshDataCache
+{
+public:
+	static FMeshPaintMeshDataCache& Get();
+
+	/** Extracts LOD geometry from CPU accessible render data, or from the source mesh description in editor builds */
+	static bool GetLODGeometry(UStaticMesh* StaticMesh, int32 LODIndex, int32 UVChannel, TArray<FVector3f>& OutPositions, TArray<FVector2f>& OutUVs, TArray<uint32>& OutIndices);
+
+	/** Builds the data below on the calling thread, through the derived data cache in editor builds. Returns null when the mesh has no CPU accessible geometry */
+	static TUniquePtr<FMeshPaintTriangleBVH> BuildTriangleBVH(UStaticMesh* StaticMesh, int32 LODIndex, int32 UVChannel);
+	static TUniquePtr<FMeshPaintLODStats> BuildLODStats(UStaticMesh* StaticMesh, int32 UVChannel);
+	static TUniquePtr<FMeshPaintCoverageMap> BuildCoverageMap(UStaticMesh* StaticMesh, int32 LODIndex, int32 UVChannel, FIntPoint Resolution);
+
+	/** Returns triangle hierarchy of a mesh LOD, starts building it on first use. Returns null while building or when the mesh has no CPU accessible render data */
+	TSharedPtr<const FMeshPaintTriangleBVH> FindOrBuildTriangleBVH(UStaticMesh* StaticMesh, int32 LODIndex, int32 UVChannel);
+
+	/** Returns UV triangle statistics of every LOD, starts computing them on first use. LODs without CPU accessible data are estimated from triangle counts */
+	TSharedPtr<const FMeshPaintLODStats> FindOrBuildLODStats(UStaticMesh* StaticMesh, int32 UVChannel);
+
+	/** Same as above for skeletal meshes, always estimated from triangle counts, never pending */
+	TSharedPtr<const FMeshPaintLODStats> FindOrBuildLODStats(USkinnedAsset* SkinnedAsset);
+
+	/** Returns the UV coverage of a mesh LOD at a target resolution, starts building it on first use. Returns null while building or when the mesh has no CPU accessible geometry */
+	TSharedPtr<const FMeshPaintCoverageMap> FindOrBuildCoverageMap(UStaticMesh* StaticMesh, int32 LODIndex, int32 UVChannel, FIntPoint Resolution);
+
+	/** Texture of the coverage map above, created once per mesh LOD and resolution, null while the map is pending. Game thread */
+	UTexture2D* FindOrCreateCoverageTexture(UStaticMesh* StaticMesh, int32 LODIndex, int32 UVChannel, FIntPoint Resolution);
+
+	/** Counts a user of the data of a mesh, a world painting it. Game thread */
+	void AddReference(FObjectKey Mesh);
+
+	/** Removes a user, the last one drops everything cached for the mesh. Paint requests in flight keep the data they hold. Game thread */
+	void ReleaseReference(FObjectKey Mesh);
+
+	/** Meshes with at least one user */
+	int32 GetNumReferencedMeshes() const { return References.Num(); }
+
+	/** Drops everything cached for a mesh, e.g. after it has been rebuilt */
+	void Invalidate(const UObject* Mesh) { Invalidate(FObjectKey(Mesh)); }
+
+	/** Same as above for a mesh which may have been destroyed */
+	void Invalidate(FObjectKey Mesh);
+
+	/** Drops all cached data */
+	void Reset();
+
+private:
+	using FBVHKey = TTuple<FObjectKey, int32, int32>;
+	using FLODStatsKey = TTuple<FObjectKey, int32>;
+	using FCoverageKey = TTuple<FObjectKey, int32, int32, FIntPoint>;
+
+	/** Data of a key, or the worker task building it */
+	template<typename DataType>
+	struct TCachedData
+	{
+		TSharedPtr<const DataType> Data;
+		UE::Tasks::TTask<TUniquePtr<DataType>> PendingBuild;
+
+		/** Time after which a failed build may start again, in FPlatformTime::Seconds */
+		double RetryTime = 0.0;
+
+		/** PendingBuild only looks the data up in the derived data cache */
+		bool bDerivedDataLookup = false;
+
+		/** The derived data cache missed, the next build copies geometry right away */
+		bool bDerivedDataMissed = false;
+	};
+
+	/** Data once its build is done, null while pending or after a failed build */
+	template<typename DataType>
+	static TSharedPtr<const DataType> Resolve(TCachedData<DataType>& Entry);
+
+	/** True when Entry holds a failed build which may start again */
+	template<typename DataType>
+	static bool CanRetry(const TCachedData<DataType>& Entry);
+
+	/**
+	 * Looks the data up in the derived data cache with DerivedDataKey alone, the build PrepareBuild returns only runs after a miss so geometry
+	 * is not copied for data already in the cache. Runs on a worker, or in place when async builds are disabled
+	 */
+	template<typename DataType>
+	static void StartBuild(TCachedData<DataType>& Entry, const FString& DerivedDataKey, const FString& DebugContext, TFunctionRef<TUniqueFunction<TUniquePtr<DataType>()>()> PrepareBuild);
+
+	/** Stores the result of a lookup or a build in Entry */
+	template<typename DataType>
+	static void FinishBuild(TCachedData<DataType>& Entry, TUniquePtr<DataType>&& Result);
+
+	FCriticalSection Lock;
+	TMap<FBVHKey, TCachedData<FMeshPaintTriangleBVH>> TriangleBVHs;
+	TMap<FLODStatsKey, TCachedData<FMeshPaintLODStats>> LODStats;
+	TMap<FCoverageKey, TCachedData<FMeshPaintCoverageMap>> CoverageMaps;
+	TMap<FCoverageKey, TStrongObjectPtr<UTexture2D>> CoverageTextures;
+
+	/** Users by mesh, game thread only */
+	TMap<FObjectKey, int32> References;
+};
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "MeshPainterFunctionLibrary.h"
+#include "MeshPaintProjectionSubsystem.generated.h"
+
+class UPrimitiveComponent;
+class FPrimitiveSceneProxy;
+struct FMeshPaintProjectionDepth;
+
+/**
+ * Occluder depth maps of paint projectors (spray cans, projected decals), see UMeshPainterFunctionLibrary::RenderMaterialOnMeshProjected.
+ * A map is rendered once at low resolution (r.MeshPaint.Projection.DepthResolution) and reused until the projector moves
+ * or one of its occluders moves, is added, removed or has its render state recreated.
+ */
+UCLASS()
+class RUNTIMEMESHPAINTER_API UMeshPaintProjectionSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	//~ Begin UWorldSubsystem Interface
+	virtual void Deinitialize() override;
+	//~ End UWorldSubsystem Interface
+
+	/** Depth of the occluders seen from the projector, the cached map when nothing moved. Resolution <= 0 uses the console variable */
+	TSharedPtr<FMeshPaintProjectionDepth, ESPMode::ThreadSafe> FindOrRenderDepth(const FRenderMaterialOnMeshViewConfiguration& Projector, TConstArrayView<UPrimitiveComponent*> Occluders, int32 Resolution);
+
+	/** Drops every cached map, for scene changes transforms do not show such as vertex animation */
+	UFUNCTION(BlueprintCallable, Category = "Mesh Paint")
+	void InvalidateDepths();
+
+	/** Number of maps rendered since the subsystem started, cache hits do not count */
+	int32 GetNumDepthRenders() const { return NumDepthRenders; }
+
+private:
+	struct FOccluderState
+	{
+		FPrimitiveSceneProxy* Proxy = nullptr;
+		FTransform Transform;
+	};
+
+	struct FCachedDepth
+	{
+		FRenderMaterialOnMeshViewConfiguration Projector;
+		int32 Resolution = 0;
+		TArray<FOccluderState> Occluders;
+		TSharedPtr<FMeshPaintProjectionDepth, ESPMode::ThreadSafe> Depth;
+		uint64 LastUsedFrame = 0;
+	};
+
+	TArray<FCachedDepth> CachedDepths;
+	int32 NumDepthRenders = 0;
+};
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ImageCore.h"
+
+class UStaticMesh;
+
+/**
+ * Software version of the UV space raster done by MeshPaintShaderVS/MeshPaintShaderPS.
+ * Reproduces UVTileMapping, the atlas cell clip of the pixel shader and the pass blend state, so GPU output of
+ * materials with known shading can be validated on machines without a GPU.
+ */
+class RUNTIMEMESHPAINTER_API FMeshPaintReferenceRasterizer
+{
+public:
+	/** One primitive of the paint request */
+	struct FPrimitive
+	{
+		FPrimitive() : UVRegion(FVector2D::Zero(), FVector2D::One()) {}
+
+		/** Fills UVs and indices from a mesh LOD */
+		bool InitFromStaticMesh(UStaticMesh* StaticMesh, int32 LODIndex, int32 UVChannel);
+
+		TArray<FVector2f> UVs;
+		TArray<uint32> Indices;
+
+		/** Atlas cell, same as FMeshPaintProxyRenderParameters::UVRegion */
+		FBox2D UVRegion;
+	};
+
+	/** Material stand-in, receives interpolated mesh UV and returns emissive color with opacity in alpha */
+	using FShadingFunction = TFunction<FLinearColor(const FVector2f& UV)>;
+
+	struct FSettings
+	{
+		FSettings() : TileSize(64), bClearTarget(false), ClearColor(FLinearColor::Green), bMultithreaded(true) {}
+
+		/** Size of the square tiles work is split into */
+		int32 TileSize;
+
+		/** Same as FMeshPaintRenderParameters::bClearTargets */
+		bool bClearTarget;
+
+		/** Clear value, defaults to the one of UTextureRenderTarget2D */
+		FLinearColor ClearColor;
+
+		/** Process tiles on task graph workers */
+		bool bMultithreaded;
+	};
+
+	struct FStats
+	{
+		FStats() : NumTriangles(0), NumTexelsShaded(0), NumTiles(0), Seconds(0.0) {}
+
+		int64 NumTriangles;
+		int64 NumTexelsShaded;
+		int32 NumTiles;
+		double Seconds;
+	};
+
+	/** Same mapping FMeshPaintPassProcessor passes to the vertex shader */
+	static FVector4f ComputeUVTileMapping(const FBox2D& UVRegion);
+
+	/** Same test as the pixel shader clip, applied to the interpolated UV */
+	static bool PassesAtlasCellClip(const FVector2f& UV);
+
+	/** Blends Source over Destination with the blend state of the paint pass */
+	static FLinearColor Blend(const FLinearColor& Source, const FLinearColor& Destination);
+
+	/** Rasterizes primitives into an RGBA32F linear image in submission order */
+	static FStats Rasterize(TConstArrayView<FPrimitive> Primitives, const FShadingFunction& Shading, const FSettings& Settings, FImage& InOutImage);
+
+	struct FComparison
+	{
+		FComparison() : NumMismatchedTexels(0), MaxError(0.0f), bSizeMatches(false) {}
+
+		int64 NumMismatchedTexels;
+		float MaxError;
+		bool bSizeMatches;
+
+		bool Passed() const { return bSizeMatches && NumMismatchedTexels == 0; }
+	};
+
+	/** Compares two images texel by texel, optionally producing an image of absolute differences */
+	static FComparison Compare(const FImage& Image, const FImage& Golden, float Tolerance, FImage* OutDifference = nullptr);
+};
@@ -0,0 +1,114 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tasks/Task.h"
+#include <atomic>
+#include "MeshPaintResidencySubsystem.generated.h"
+
+class UTextureRenderTarget2D;
+class UPrimitiveComponent;
+class FRHIGPUTextureReadback;
+
+/**
+ * Keeps paint targets of a world within a GPU memory budget (r.MeshPaint.Residency.BudgetMB).
+ * Targets not seen for a while are read back asynchronously, compressed into CPU memory and their GPU resource released,
+ * least recently visible first. They are uploaded again when a component using them renders or paint is applied to them.
+ * Only 2D render targets are managed.
+ */
+UCLASS()
+class RUNTIMEMESHPAINTER_API UMeshPaintResidencySubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	//~ Begin UTickableWorldSubsystem Interface
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	//~ End UTickableWorldSubsystem Interface
+
+	/** Tracks a target, its visibility is the most recent on screen time of its components */
+	UFUNCTION(BlueprintCallable, Category = "Mesh Paint")
+	void RegisterTarget(UTextureRenderTarget2D* Target, UPrimitiveComponent* VisibilitySource);
+
+	/** Removes a visibility source, the target stops being managed with the last one. Evicted targets are restored first */
+	UFUNCTION(BlueprintCallable, Category = "Mesh Paint")
+	void UnregisterTarget(UTextureRenderTarget2D* Target, UPrimitiveComponent* VisibilitySource);
+
+	/** Restores an evicted target synchronously and cancels eviction in flight, returns false for unmanaged targets */
+	UFUNCTION(BlueprintCallable, Category = "Mesh Paint")
+	bool EnsureResident(UTextureRenderTarget2D* Target);
+
+	/** Calls EnsureResident for the managed targets, paint entry points go through this before binding targets */
+	static void EnsureTargetsResident(UWorld* World, TConstArrayView<UTextureRenderTarget2D*> Targets);
+
+	/** False from the start of an eviction until the target is uploaded again, GPU work such as decay has to wait meanwhile. Unmanaged targets are resident */
+	static bool IsTargetResident(UWorld* World, const UTextureRenderTarget2D* Target);
+
+	struct FStats
+	{
+		FStats() : NumResident(0), NumEvicted(0), ResidentBytes(0), EvictedBytes(0), CompressedBytes(0), LastPromotionSeconds(0.0), MaxPromotionSeconds(0.0) {}
+
+		int32 NumResident;
+		int32 NumEvicted;
+		uint64 ResidentBytes;
+
+		/** GPU memory freed by eviction and the CPU memory holding it */
+		uint64 EvictedBytes;
+		uint64 CompressedBytes;
+
+		/** Time from a restore request until the upload is queued */
+		double LastPromotionSeconds;
+		double MaxPromotionSeconds;
+	};
+
+	FStats GetStats() const { return Stats; }
+
+private:
+	enum class EState : uint8
+	{
+		Resident,
+		ReadingBack,
+		Compressing,
+		Evicted,
+		Decompressing
+	};
+
+	/** Target contents moving between GPU and CPU, shared with render thread commands and worker tasks */
+	struct FPayload
+	{
+		TArray<uint8> CompressedData;
+		TArray<uint8> UncompressedData;
+		int32 UncompressedSize = 0;
+
+		/** NAME_None when compression did not pay off and CompressedData holds raw texels */
+		FName CompressionFormat;
+		std::atomic<bool> bReady { false };
+	};
+
+	struct FEntry
+	{
+		TWeakObjectPtr<UTextureRenderTarget2D> Target;
+		TArray<TWeakObjectPtr<UPrimitiveComponent>> VisibilitySources;
+		EState State = EState::Resident;
+		double LastVisibleTime = 0.0;
+		double PromotionStartTime = 0.0;
+		uint64 SizeInBytes = 0;
+		FIntPoint Extent = FIntPoint::ZeroValue;
+		EPixelFormat Format = PF_Unknown;
+		TSharedPtr<FRHIGPUTextureReadback> Readback;
+		TSharedPtr<FPayload, ESPMode::ThreadSafe> Payload;
+		UE::Tasks::FTask DecompressTask;
+	};
+
+	FEntry* FindEntry(const UTextureRenderTarget2D* Target);
+	void UpdateVisibility(FEntry& Entry, double Now) const;
+	void StartEviction(FEntry& Entry);
+	void StartPromotion(FEntry& Entry, bool bSynchronous);
+	void Upload(FEntry& Entry);
+	void UpdateStats();
+
+	TArray<FEntry> Entries;
+	FStats Stats;
+};
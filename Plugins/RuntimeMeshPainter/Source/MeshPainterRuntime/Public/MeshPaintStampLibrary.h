@@ -0,0 +1,46 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "MeshPaintStampLibrary.generated.h"
+
+class UTexture2D;
+class UTexture2DArray;
+
+/**
+ * Brush shapes packed into one texture array with precomputed mips, stamps pick their shape by index (FMeshPaintBrushStamp::ShapeIndex).
+ * Stamps of every shape of a library are painted in the same pass. The mask is read from the red channel.
+ */
+UCLASS(BlueprintType)
+class RUNTIMEMESHPAINTER_API UMeshPaintStampLibrary : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	UMeshPaintStampLibrary();
+
+	/** Shape masks in index order, all of the same size and format */
+	UPROPERTY(EditAnywhere, Category = "Mesh Paint")
+	TArray<UTexture2D*> Masks;
+
+	//~ Begin UObject Interface
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+	//~ End UObject Interface
+
+#if WITH_EDITOR
+	/** Packs Masks into the mask array, mips are built with it and cooked. Returns false when the masks cannot share an array */
+	UFUNCTION(CallInEditor, Category = "Mesh Paint")
+	bool RebuildMaskArray();
+#endif
+
+	UTexture2DArray* GetMaskArray() const { return MaskArray; }
+
+	UFUNCTION(BlueprintCallable, Category = "Mesh Paint")
+	int32 GetNumShapes() const;
+
+private:
+	UPROPERTY(VisibleAnywhere, Category = "Mesh Paint")
+	UTexture2DArray* MaskArray;
+};
@@ -0,0 +1,17 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Tasks/Task.h"
+#include "MeshPaintBrushTypes.h"
+
+namespace MeshPaintStroke
+{
+	/** Upper bound of stamps a single stroke expands to, spacing grows for longer strokes */
+	constexpr int32 MaxStampsPerStroke = 4096;
+
+	/** Places stamps along the stroke every Spacing * Radius, starting at the first point */
+	RUNTIMEMESHPAINTER_API void ExpandStroke(const FMeshPaintStroke& Stroke, TArray<FMeshPaintBrushStamp>& OutStamps);
+
+	/** Expands a stroke on a worker thread */
+	RUNTIMEMESHPAINTER_API UE::Tasks::TTask<TArray<FMeshPaintBrushStamp>> LaunchExpandStroke(FMeshPaintStroke Stroke);
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tasks/Task.h"
+#include "MeshPainterFunctionLibrary.h"
+#include "MeshPaintStrokeSubsystem.generated.h"
+
+/** Strokes of a frame painted with the same material into the same targets */
+USTRUCT()
+struct FMeshPaintStrokeBatch
+{
+	GENERATED_BODY()
+
+	FMeshPaintStrokeBatch() : Material(nullptr), BaseColor(nullptr), Emissive(nullptr), NormalMap(nullptr), BlendMode(EMeshPaintBlendMode::AlphaBlend), BlendThreshold(0.5f), bUpdatePaintMirrors(false) {}
+
+	UPROPERTY()
+	TArray<FRenderMaterialOnMeshPrimitive> Components;
+
+	UPROPERTY()
+	UMaterialInterface* Material;
+
+	UPROPERTY()
+	UTextureRenderTarget2D* BaseColor;
+
+	UPROPERTY()
+	UTextureRenderTarget2D* Emissive;
+
+	UPROPERTY()
+	UTextureRenderTarget2D* NormalMap;
+
+	EMeshPaintBlendMode BlendMode;
+	float BlendThreshold;
+	bool bUpdatePaintMirrors;
+
+	/** Stamps of queued strokes, expanded on worker threads */
+	TArray<UE::Tasks::TTask<TArray<FMeshPaintBrushStamp>>> Expansions;
+};
+
+/**
+ * Collects strokes queued during a frame and paints them after actors ticked, one pass per target set.
+ * Continuous painting from input or physics then costs a single pass per frame no matter how many segments were added.
+ */
+UCLASS()
+class RUNTIMEMESHPAINTER_API UMeshPaintStrokeSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	//~ Begin UTickableWorldSubsystem Interface
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	//~ End UTickableWorldSubsystem Interface
+
+	/** Queues a stroke, merged with other strokes of the frame painting the same material into the same targets with the same settings */
+	UFUNCTION(BlueprintCallable, Category = "Mesh Paint")
+	void QueueStroke(
+		const TArray<FRenderMaterialOnMeshPrimitive>& Components,
+		UMaterialInterface* Material,
+		UTextureRenderTarget2D* BaseColor,
+		UTextureRenderTarget2D* Emissive,
+		UTextureRenderTarget2D* NormalMap,
+		const FMeshPaintStroke& Stroke,
+		EMeshPaintBlendMode BlendMode = EMeshPaintBlendMode::AlphaBlend,
+		float BlendThreshold = 0.5f,
+		bool bUpdatePaintMirrors = true);
+
+	/** Paints every queued stroke now instead of at the end of the frame */
+	UFUNCTION(BlueprintCallable, Category = "Mesh Paint")
+	void Flush();
+
+private:
+	UPROPERTY(Transient)
+	TArray<FMeshPaintStrokeBatch> PendingBatches;
+};
@@ -0,0 +1,140 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+struct FStaticMeshLODResources;
+
+/** Compact bounding volume hierarchy over the triangles of a single mesh LOD, keeps positions and one UV channel */
+class RUNTIMEMESHPAINTER_API FMeshPaintTriangleBVH
+{
+public:
+	struct FHit
+	{
+		FHit() : TriangleIndex(INDEX_NONE), Barycentrics(FVector3f::ZeroVector), DistanceSquared(TNumericLimits<float>::Max()) {}
+
+		/** Index of the triangle in the source index buffer order */
+		int32 TriangleIndex;
+
+		/** Barycentrics of the closest point on the triangle */
+		FVector3f Barycentrics;
+
+		/** Squared distance from the query point to the triangle */
+		float DistanceSquared;
+
+		bool IsValid() const { return TriangleIndex != INDEX_NONE; }
+	};
+
+	/** Builds the hierarchy from CPU accessible render data. Fails when the mesh does not keep CPU copies of its buffers */
+	bool Build(const FStaticMeshLODResources& LODResources, int32 UVChannel);
+
+	/** Builds the hierarchy from raw arrays */
+	void Build(TArray<FVector3f>&& InPositions, TArray<FVector2f>&& InUVs, const TArray<uint32>& InIndices);
+
+	bool IsValid() const { return !Nodes.IsEmpty(); }
+
+	int32 GetNumTriangles() const { return TriangleIds.Num(); }
+
+	/**
+	 * Finds the triangle closest to a local space point within MaxDistance. With a local space FacingNormal, triangles which
+	 * winding faces against it are skipped, so the far side of thin geometry is never picked
+	 */
+	bool FindClosestTriangle(const FVector3f& Point, float MaxDistance, FHit& OutHit, const FVector3f* FacingNormal = nullptr) const;
+
+	/** Closest point of a given triangle to a local space point, fails beyond MaxDistance */
+	bool GetClosestPointOnTriangle(int32 TriangleIndex, const FVector3f& Point, float MaxDistance, FHit& OutHit) const;
+
+	/** Unnormalized geometric normal of a triangle from its winding */
+	FVector3f GetTriangleNormal(int32 TriangleIndex) const;
+
+	/** Calls Func(int32 TriangleIndex) for every triangle which bounds intersect a local space box */
+	template<typename FuncType>
+	void ForEachTriangleInBox(const FBox3f& Box, FuncType&& Func) const
+	{
+		if (!IsValid()) return;
+
+		TArray<uint32, TInlineAllocator<64>> Stack;
+		Stack.Add(0);
+		while (!Stack.IsEmpty())
+		{
+			const FNode& Node = Nodes[Stack.Pop(false)];
+			if (!Node.Intersects(Box)) continue;
+
+			if (Node.IsLeaf())
+			{
+				for (uint32 Slot = Node.FirstIndex; Slot < Node.FirstIndex + Node.TriangleCount; ++Slot)
+				{
+					if (GetTriangleBounds(Slot).Intersect(Box))
+					{
+						Func((int32)TriangleIds[Slot]);
+					}
+				}
+			}
+			else
+			{
+				Stack.Add(Node.FirstIndex);
+				Stack.Add(Node.FirstIndex + 1);
+			}
+		}
+	}
+
+	/** Returns local space positions of a triangle */
+	void GetTrianglePositions(int32 TriangleIndex, FVector3f& OutP0, FVector3f& OutP1, FVector3f& OutP2) const;
+
+	/** Returns UVs of a triangle */
+	void GetTriangleUVs(int32 TriangleIndex, FVector2f& OutUV0, FVector2f& OutUV1, FVector2f& OutUV2) const;
+
+	/** Interpolated UV of a hit */
+	FVector2f GetHitUV(const FHit& Hit) const;
+
+	/** Local space bounds of the whole mesh */
+	FBox3f GetBounds() const { return IsValid() ? FBox3f(Nodes[0].Min, Nodes[0].Max) : FBox3f(ForceInit); }
+
+	SIZE_T GetAllocatedSize() const;
+
+	friend FArchive& operator<<(FArchive& Ar, FMeshPaintTriangleBVH& BVH);
+
+private:
+	struct FNode
+	{
+		FVector3f Min;
+		/** First child node for inner nodes, first triangle slot for leaves */
+		uint32 FirstIndex;
+		FVector3f Max;
+		/** Zero for inner nodes */
+		uint32 TriangleCount;
+
+		bool IsLeaf() const { return TriangleCount != 0; }
+		bool Intersects(const FBox3f& Box) const
+		{
+			return Min.X <= Box.Max.X && Max.X >= Box.Min.X && Min.Y <= Box.Max.Y && Max.Y >= Box.Min.Y && Min.Z <= Box.Max.Z && Max.Z >= Box.Min.Z;
+		}
+		float DistanceSquared(const FVector3f& Point) const
+		{
+			const FVector3f Delta = FVector3f::Max(FVector3f::Max(Min - Point, Point - Max), FVector3f::ZeroVector);
+			return Delta.SizeSquared();
+		}
+
+		friend FArchive& operator<<(FArchive& Ar, FNode& Node)
+		{
+			return Ar << Node.Min << Node.FirstIndex << Node.Max << Node.TriangleCount;
+		}
+	};
+
+	FBox3f GetTriangleBounds(uint32 Slot) const;
+
+	/** Hierarchy, root is the first node, children are always stored next to each other */
+	TArray<FNode> Nodes;
+
+	/** Vertex data */
+	TArray<FVector3f> Positions;
+	TArray<FVector2f> UVs;
+
+	/** Triangle indices reordered so every leaf references a contiguous range of slots */
+	TArray<uint32> Indices;
+
+	/** Source triangle index of every slot */
+	TArray<uint32> TriangleIds;
+
+	/** Slot of every source triangle */
+	TArray<uint32> TriangleSlots;
+};
@@ -0,0 +1,136 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+namespace MeshPaintUVRaster
+{
+	/** Number of horizontally adjacent texels processed at once */
+	static constexpr int32 LaneCount = 4;
+
+	/** Lane offsets of the texel centers within a SIMD group */
+	inline VectorRegister4Float GetLaneOffsets()
+	{
+		return MakeVectorRegisterFloat(0.5f, 1.5f, 2.5f, 3.5f);
+	}
+
+	/** Edge owns texels lying exactly on it when it is a top or left edge of a positively oriented triangle (D3D fill convention) */
+	inline bool IsTopLeftEdge(const FVector2f& A, const FVector2f& B)
+	{
+		const float DX = B.X - A.X;
+		const float DY = B.Y - A.Y;
+		return DY < 0.0f || (DY == 0.0f && DX > 0.0f);
+	}
+
+	/**
+	 * Rasterizes a triangle given in texel coordinates (texel N covers [N, N+1)) and calls
+	 * Visitor(int32 X, int32 Y, int32 LaneMask, VectorRegister4Float B0, VectorRegister4Float B1, VectorRegister4Float B2)
+	 * for every group of LaneCount texels starting at X that has at least one covered texel center inside ClipRect.
+	 * Bit N of LaneMask marks texel X + N, B0..B2 are the barycentrics of the corresponding texel centers.
+	 * Returns the number of covered texels.
+	 */
+	template<typename VisitorType>
+	int32 RasterizeTriangle(FVector2f P0, FVector2f P1, FVector2f P2, const FIntRect& ClipRect, VisitorType&& Visitor)
+	{
+		float Area = (P1.X - P0.X) * (P2.Y - P0.Y) - (P1.Y - P0.Y) * (P2.X - P0.X);
+		if (!(FMath::Abs(Area) > UE_SMALL_NUMBER))
+		{
+			return 0;
+		}
+
+		// Paint passes run with CM_None, accept both windings
+		bool bSwapped = false;
+		if (Area < 0.0f)
+		{
+			Swap(P1, P2);
+			Area = -Area;
+			bSwapped = true;
+		}
+
+		const FIntRect Bounds(
+			FMath::Max(ClipRect.Min.X, FMath::FloorToInt32(FMath::Min3(P0.X, P1.X, P2.X))),
+			FMath::Max(ClipRect.Min.Y, FMath::FloorToInt32(FMath::Min3(P0.Y, P1.Y, P2.Y))),
+			FMath::Min(ClipRect.Max.X, FMath::CeilToInt32(FMath::Max3(P0.X, P1.X, P2.X))),
+			FMath::Min(ClipRect.Max.Y, FMath::CeilToInt32(FMath::Max3(P0.Y, P1.Y, P2.Y))));
+
+		if (Bounds.Min.X >= Bounds.Max.X || Bounds.Min.Y >= Bounds.Max.Y)
+		{
+			return 0;
+		}
+
+		// Edge function E(P) = (B - A) x (P - A), normalized so the three of them are barycentrics
+		const FVector2f EdgeStart[3] = { P1, P2, P0 };
+		const FVector2f EdgeEnd[3] = { P2, P0, P1 };
+		const float InvArea = 1.0f / Area;
+
+		VectorRegister4Float StepX[3];
+		VectorRegister4Float StepY[3];
+		VectorRegister4Float RowStart[3];
+		bool bTopLeft[3];
+		const VectorRegister4Float LaneX = VectorAdd(VectorSetFloat1((float)Bounds.Min.X), GetLaneOffsets());
+		const float FirstRowY = (float)Bounds.Min.Y + 0.5f;
+		for (int32 EdgeIndex = 0; EdgeIndex < 3; ++EdgeIndex)
+		{
+			const FVector2f& A = EdgeStart[EdgeIndex];
+			const FVector2f& B = EdgeEnd[EdgeIndex];
+			const float DX = -(B.Y - A.Y) * InvArea;
+			const float DY = (B.X - A.X) * InvArea;
+			const float C = -(DX * A.X + DY * A.Y);
+
+			StepX[EdgeIndex] = VectorSetFloat1(DX * LaneCount);
+			StepY[EdgeIndex] = VectorSetFloat1(DY);
+			RowStart[EdgeIndex] = VectorMultiplyAdd(LaneX, VectorSetFloat1(DX), VectorSetFloat1(DY * FirstRowY + C));
+			bTopLeft[EdgeIndex] = IsTopLeftEdge(A, B);
+		}
+
+		const VectorRegister4Float Zero = VectorZeroFloat();
+		int32 NumCovered = 0;
+		for (int32 Y = Bounds.Min.Y; Y < Bounds.Max.Y; ++Y)
+		{
+			VectorRegister4Float W0 = RowStart[0];
+			VectorRegister4Float W1 = RowStart[1];
+			VectorRegister4Float W2 = RowStart[2];
+
+			for (int32 X = Bounds.Min.X; X < Bounds.Max.X; X += LaneCount)
+			{
+				const VectorRegister4Float Inside0 = bTopLeft[0] ? VectorCompareGE(W0, Zero) : VectorCompareGT(W0, Zero);
+				const VectorRegister4Float Inside1 = bTopLeft[1] ? VectorCompareGE(W1, Zero) : VectorCompareGT(W1, Zero);
+				const VectorRegister4Float Inside2 = bTopLeft[2] ? VectorCompareGE(W2, Zero) : VectorCompareGT(W2, Zero);
+				int32 LaneMask = VectorMaskBits(VectorBitwiseAnd(Inside0, VectorBitwiseAnd(Inside1, Inside2)));
+
+				const int32 RemainingLanes = Bounds.Max.X - X;
+				if (RemainingLanes < LaneCount)
+				{
+					LaneMask &= (1 << RemainingLanes) - 1;
+				}
+
+				if (LaneMask != 0)
+				{
+					NumCovered += FMath::CountBits((uint64)LaneMask);
+					if (bSwapped)
+					{
+						Visitor(X, Y, LaneMask, W0, W2, W1);
+					}
+					else
+					{
+						Visitor(X, Y, LaneMask, W0, W1, W2);
+					}
+				}
+
+				W0 = VectorAdd(W0, StepX[0]);
+				W1 = VectorAdd(W1, StepX[1]);
+				W2 = VectorAdd(W2, StepX[2]);
+			}
+
+			RowStart[0] = VectorAdd(RowStart[0], StepY[0]);
+			RowStart[1] = VectorAdd(RowStart[1], StepY[1]);
+			RowStart[2] = VectorAdd(RowStart[2], StepY[2]);
+		}
+		return NumCovered;
+	}
+
+	/** Interpolates a per-vertex attribute for all lanes using barycentrics produced by RasterizeTriangle */
+	inline VectorRegister4Float Interpolate(const VectorRegister4Float& B0, const VectorRegister4Float& B1, const VectorRegister4Float& B2, float V0, float V1, float V2)
+	{
+		return VectorMultiplyAdd(B0, VectorSetFloat1(V0), VectorMultiplyAdd(B1, VectorSetFloat1(V1), VectorMultiply(B2, VectorSetFloat1(V2))));
+	}
+}
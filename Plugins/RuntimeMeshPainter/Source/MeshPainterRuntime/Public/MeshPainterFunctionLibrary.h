@@ -5,18 +5,29 @@
 #include "CoreMinimal.h"
 #include "Kismet/BlueprintFunctionLibrary.h"
 #include "Engine/TextureRenderTarget2D.h"
+#include "Engine/TextureRenderTarget2DArray.h"
+#include "Engine/HitResult.h"
+#include "MeshPaintBrushTypes.h"
+#include "MeshPaintBlendMode.h"
 #include "MeshPainterFunctionLibrary.generated.h"
 
+class UStaticMesh;
+struct FMeshPaintRenderParameters;
+class UTexture2D;
+class UMeshPaintStampLibrary;
+class UMeshPaintSurfaceComponent;
+
 USTRUCT(BlueprintType)
 struct FRenderMaterialOnMeshPrimitive
 {
 	GENERATED_BODY()
 
-	FRenderMaterialOnMeshPrimitive() : MeshComponent(nullptr), DesiredLOD(0), DesiredUV(0), UVRegion(FBox2D(FVector2D::Zero(), FVector2D::One())) {};
+	FRenderMaterialOnMeshPrimitive() : MeshComponent(nullptr), DesiredLOD(0), DesiredUV(0), UVRegion(FBox2D(FVector2D::Zero(), FVector2D::One())), ArraySlice(0), bReferencePose(false) {};
 	
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	UPrimitiveComponent* MeshComponent;
 
+	/** LOD painted, INDEX_NONE picks the finest LOD whose triangles are not sub-texel in the target (r.MeshPaint.AutoLOD.MinTriangleTexels) */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	int32 DesiredLOD;
 
@@ -25,6 +36,14 @@ struct FRenderMaterialOnMeshPrimitive
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	FBox2D UVRegion;
+
+	/** Slice painted into when the targets are render target arrays */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 ArraySlice;
+
+	/** Paints skeletal meshes in reference pose, skinning is skipped since the UV layout does not depend on the pose */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	bool bReferencePose;
 };
 
 USTRUCT(BlueprintType)
@@ -63,7 +82,9 @@ public:
 		UTextureRenderTarget2D* Emissive,
 		UTextureRenderTarget2D* NormalMap,
 		int32 LOD, 
-		bool bClearRenderTargets);
+		bool bClearRenderTargets,
+		EMeshPaintBlendMode BlendMode = EMeshPaintBlendMode::AlphaBlend,
+		float BlendThreshold = 0.5f);
 
 	UFUNCTION(BlueprintCallable, meta=(WorldContext="WorldContextObject"))
 	static bool RenderMaterialOnMeshUVAtlas(
@@ -75,7 +96,9 @@ public:
 		UTextureRenderTarget2D* NormalMap,
 		int32 LOD, 
 		const FBox2D& UVRegion,
-		bool bClearRenderTargets
+		bool bClearRenderTargets,
+		EMeshPaintBlendMode BlendMode = EMeshPaintBlendMode::AlphaBlend,
+		float BlendThreshold = 0.5f
 	);
 
 	UFUNCTION(BlueprintCallable, meta=(WorldContext="WorldContextObject"))
@@ -87,7 +110,9 @@ public:
 		UTextureRenderTarget2D* Emissive,
 		UTextureRenderTarget2D* NormalMap,
 		const FBox2D& UVRegion,
-		bool bClearRenderTargets
+		bool bClearRenderTargets,
+		EMeshPaintBlendMode BlendMode = EMeshPaintBlendMode::AlphaBlend,
+		float BlendThreshold = 0.5f
 	);
 
 	static bool RenderMaterialOnMeshUVAtlasMulti(
@@ -98,6 +123,223 @@ public:
 		UTextureRenderTarget2D* Emissive,
 		UTextureRenderTarget2D* NormalMap,
 		const FRenderMaterialOnMeshViewConfiguration& ViewPointConfiguration,
-		bool bClearRenderTargets
+		bool bClearRenderTargets,
+		EMeshPaintBlendMode BlendMode = EMeshPaintBlendMode::AlphaBlend,
+		float BlendThreshold = 0.5f
+	);
+
+	/**
+	 * Paints the material projected from a projector such as a spray can, only on texels the projector sees.
+	 * Occlusion is tested against a low resolution depth map of the painted primitives and Occluders rendered from the projector,
+	 * cached by UMeshPaintProjectionSubsystem until something moves. The material sees the projector as its view.
+	 * DepthResolution <= 0 uses r.MeshPaint.Projection.DepthResolution, DepthBias is in world units.
+	 */
+	UFUNCTION(BlueprintCallable, meta=(WorldContext="WorldContextObject", AutoCreateRefTerm="Occluders"))
+	static bool RenderMaterialOnMeshProjected(
+		UObject* WorldContextObject,
+		TArray<FRenderMaterialOnMeshPrimitive> Components,
+		UMaterialInterface* Material,
+		UTextureRenderTarget2D* BaseColor,
+		UTextureRenderTarget2D* Emissive,
+		UTextureRenderTarget2D* NormalMap,
+		const FRenderMaterialOnMeshViewConfiguration& Projector,
+		const TArray<UPrimitiveComponent*>& Occluders,
+		int32 DepthResolution = 0,
+		float DepthBias = 2.0f,
+		EMeshPaintBlendMode BlendMode = EMeshPaintBlendMode::AlphaBlend,
+		float BlendThreshold = 0.5f
+	);
+
+	/** Paints every primitive into its ArraySlice of render target arrays, in a single pass where the RHI allows it */
+	UFUNCTION(BlueprintCallable, meta=(WorldContext="WorldContextObject"))
+	static bool RenderMaterialOnMeshArraySlices(
+		UObject* WorldContextObject,
+		TArray<FRenderMaterialOnMeshPrimitive> Components,
+		UMaterialInterface* Material,
+		UTextureRenderTarget2DArray* BaseColor,
+		UTextureRenderTarget2DArray* Emissive,
+		UTextureRenderTarget2DArray* NormalMap,
+		bool bClearRenderTargets,
+		EMeshPaintBlendMode BlendMode = EMeshPaintBlendMode::AlphaBlend,
+		float BlendThreshold = 0.5f
+	);
+
+	/** Stores the paint slice of a component in custom primitive data, read by the Mesh Paint Array Coordinates material node */
+	UFUNCTION(BlueprintCallable)
+	static void SetPaintArraySlice(UPrimitiveComponent* Component, int32 ArraySlice, int32 SliceDataIndex = 0);
+
+	/**
+	 * Stores the atlas cell and slice of a component in custom primitive data, read by the Mesh Paint Surface Coordinates material node.
+	 * Takes UMaterialExpressionMeshPaintSurfaceCoordinates::DescriptorSize floats from DescriptorDataIndex.
+	 */
+	UFUNCTION(BlueprintCallable)
+	static void SetPaintSurfaceDescriptor(UPrimitiveComponent* Component, const FBox2D& UVRegion, int32 ArraySlice, int32 DescriptorDataIndex = 0);
+
+	/** Paints every channel of a layout from the Mesh Paint Channels project settings in one pass. Targets are given in channel order */
+	UFUNCTION(BlueprintCallable, meta=(WorldContext="WorldContextObject"))
+	static bool RenderMaterialOnMeshChannels(
+		UObject* WorldContextObject,
+		TArray<FRenderMaterialOnMeshPrimitive> Components,
+		UMaterialInterface* Material,
+		FName ChannelLayout,
+		const TArray<UTextureRenderTarget2D*>& ChannelTargets,
+		bool bClearRenderTargets,
+		EMeshPaintBlendMode BlendMode = EMeshPaintBlendMode::AlphaBlend,
+		float BlendThreshold = 0.5f
+	);
+
+	/** Creates a render target per channel of a layout with the channel format, UAV capable for programmable blend modes */
+	UFUNCTION(BlueprintCallable, meta=(WorldContext="WorldContextObject"))
+	static bool CreateChannelRenderTargets(UObject* WorldContextObject, FName ChannelLayout, int32 Width, int32 Height, TArray<UTextureRenderTarget2D*>& OutChannelTargets);
+
+	/** Paints the material through brush stamps, opacity is scaled by their accumulated coverage. All stamps go in one pass whatever their shape in StampLibrary */
+	UFUNCTION(BlueprintCallable, meta=(WorldContext="WorldContextObject"))
+	static bool RenderBrushStampsOnMesh(
+		UObject* WorldContextObject,
+		TArray<FRenderMaterialOnMeshPrimitive> Components,
+		UMaterialInterface* Material,
+		UTextureRenderTarget2D* BaseColor,
+		UTextureRenderTarget2D* Emissive,
+		UTextureRenderTarget2D* NormalMap,
+		const TArray<FMeshPaintBrushStamp>& Stamps,
+		EMeshPaintBlendMode BlendMode = EMeshPaintBlendMode::AlphaBlend,
+		float BlendThreshold = 0.5f,
+		UMeshPaintStampLibrary* StampLibrary = nullptr
+	);
+
+	/** bUpdatePaintMirrors replays the stamps on the mirrors of the painted components */
+	static bool RenderBrushStampsOnMesh(
+		UObject* WorldContextObject,
+		TArrayView<FRenderMaterialOnMeshPrimitive> Components,
+		UMaterialInterface* Material,
+		UTextureRenderTarget2D* BaseColor,
+		UTextureRenderTarget2D* Emissive,
+		UTextureRenderTarget2D* NormalMap,
+		TConstArrayView<FMeshPaintBrushStamp> Stamps,
+		EMeshPaintBlendMode BlendMode = EMeshPaintBlendMode::AlphaBlend,
+		float BlendThreshold = 0.5f,
+		UMeshPaintStampLibrary* StampLibrary = nullptr,
+		bool bUpdatePaintMirrors = true
+	);
+
+	/** Expands a stroke into stamps and paints them in one pass. UMeshPaintStrokeSubsystem merges strokes of a frame instead */
+	UFUNCTION(BlueprintCallable, meta=(WorldContext="WorldContextObject"))
+	static bool RenderStrokeOnMesh(
+		UObject* WorldContextObject,
+		TArray<FRenderMaterialOnMeshPrimitive> Components,
+		UMaterialInterface* Material,
+		UTextureRenderTarget2D* BaseColor,
+		UTextureRenderTarget2D* Emissive,
+		UTextureRenderTarget2D* NormalMap,
+		const FMeshPaintStroke& Stroke,
+		EMeshPaintBlendMode BlendMode = EMeshPaintBlendMode::AlphaBlend,
+		float BlendThreshold = 0.5f
+	);
+
+	/**
+	 * Paints every registered paint surface the stamps touch, whatever their UV layout. Surfaces sharing targets are painted in one pass.
+	 * Returns the number of surfaces painted.
+	 */
+	UFUNCTION(BlueprintCallable, meta=(WorldContext="WorldContextObject"))
+	static int32 PaintSurfacesInVolume(
+		UObject* WorldContextObject,
+		UMaterialInterface* Material,
+		const TArray<FMeshPaintBrushStamp>& Stamps,
+		EMeshPaintBlendMode BlendMode = EMeshPaintBlendMode::AlphaBlend,
+		float BlendThreshold = 0.5f,
+		bool bUpdatePaintMirrors = true,
+		UMeshPaintStampLibrary* StampLibrary = nullptr
+	);
+
+	/**
+	 * Paints stamps into surfaces sharing their targets (SharesTargetsWith) in one pass, 2D and array targets alike.
+	 * bUpdatePaintMirrors replays the stamps on the mirrors of the painted components.
+	 */
+	static bool RenderBrushStampsOnSurfaces(
+		UWorld* World,
+		TConstArrayView<UMeshPaintSurfaceComponent*> Surfaces,
+		UMaterialInterface* Material,
+		TConstArrayView<FMeshPaintBrushStamp> Stamps,
+		EMeshPaintBlendMode BlendMode = EMeshPaintBlendMode::AlphaBlend,
+		float BlendThreshold = 0.5f,
+		bool bUpdatePaintMirrors = true,
+		UMeshPaintStampLibrary* StampLibrary = nullptr
+	);
+
+	/**
+	 * Fills the whole UV island of a static mesh under a location with a color, nothing bleeds into neighbouring islands.
+	 * The island is found on the CPU from the triangle hierarchy and filled with a single screen pass over its texels.
+	 * The mesh needs CPU accessible render data.
+	 */
+	UFUNCTION(BlueprintCallable, meta=(WorldContext="WorldContextObject"))
+	static bool FillUVIslandAtLocation(
+		UObject* WorldContextObject,
+		const FRenderMaterialOnMeshPrimitive& Primitive,
+		FVector Location,
+		UTextureRenderTarget2D* RenderTarget,
+		FLinearColor Color,
+		float MaxDistance = 10.0f,
+		EMeshPaintBlendMode BlendMode = EMeshPaintBlendMode::AlphaBlend,
+		float BlendThreshold = 0.5f
+	);
+
+	/**
+	 * UV of the static mesh render data under a hit, without keeping collision UVs in memory (bSupportUVFromHitResults).
+	 * The impact point is matched against the triangle hierarchy of the mesh LOD, built once and shared by every component of the mesh.
+	 * The face index of complex traces picks the triangle when it matches, otherwise triangles facing against the impact normal are skipped.
+	 */
+	UFUNCTION(BlueprintCallable)
+	static bool FindPaintUVFromHit(const FHitResult& Hit, int32 UVChannel, FVector2D& UV, int32 LODIndex = 0, float MaxDistance = 10.0f);
+
+	/**
+	 * Paints a soft round stamp at a hit, placed in UV space at the UV found under the impact point.
+	 * Radius is in world units, converted with the texel density of the hit triangle. Only texels under the stamp are touched.
+	 * Primitive gives the UV channel, LOD and atlas cell, its component is taken from the hit when left empty.
+	 * bClampToIsland keeps the stamp on the UV island of the hit instead of spilling onto islands packed next to it.
+	 */
+	UFUNCTION(BlueprintCallable, meta=(WorldContext="WorldContextObject"))
+	static bool PaintAtHit(
+		UObject* WorldContextObject,
+		const FHitResult& Hit,
+		const FRenderMaterialOnMeshPrimitive& Primitive,
+		UTextureRenderTarget2D* RenderTarget,
+		FLinearColor Color,
+		float Radius = 10.0f,
+		float Hardness = 0.5f,
+		float Strength = 1.0f,
+		bool bClampToIsland = true,
+		EMeshPaintBlendMode BlendMode = EMeshPaintBlendMode::AlphaBlend,
+		float BlendThreshold = 0.5f
+	);
+
+	/** Applies a brush stamp to every paint mirror component it touches. Works without a GPU */
+	UFUNCTION(BlueprintCallable, meta=(WorldContext="WorldContextObject"))
+	static void ApplyBrushStampToPaintMirrors(UObject* WorldContextObject, const FMeshPaintBrushStamp& Stamp);
+
+	/**
+	 * UV coverage of a mesh LOD in a target of the given size: triangle index + 1 in R, UV island index + 1 in G, zero outside the layout.
+	 * Cached per mesh LOD and size until the world of WorldContextObject is torn down, sample it with point filtering. Null until the coverage is built on a worker.
+	 */
+	UFUNCTION(BlueprintCallable, meta=(WorldContext="WorldContextObject"))
+	static UTexture2D* GetPaintCoverageTexture(UObject* WorldContextObject, UStaticMesh* StaticMesh, int32 LOD, int32 UVChannel, int32 Width, int32 Height);
+
+	/** Fraction of a target of the given size a mesh LOD covers and its number of UV islands. Returns false when the mesh has no CPU accessible geometry or while the coverage is being built */
+	UFUNCTION(BlueprintCallable, meta=(WorldContext="WorldContextObject"))
+	static bool GetPaintCoverageStats(UObject* WorldContextObject, UStaticMesh* StaticMesh, int32 LOD, int32 UVChannel, int32 Width, int32 Height, float& OutCoverage, int32& OutNumIslands);
+
+	/**
+	 * Render thread description of a brush pass painting Components into targets of TargetSize, without stamps.
+	 * For systems adding paint passes themselves, like the Niagara data interface with stamps written on the GPU.
+	 * BoundingStamps enclose the stamps painted later, when given only the texels they reach are drawn (PaintUVBounds).
+	 */
+	static bool MakeBrushRenderParameters(
+		UWorld* World,
+		TConstArrayView<FRenderMaterialOnMeshPrimitive> Components,
+		UMaterialInterface* Material,
+		FIntPoint TargetSize,
+		EMeshPaintBlendMode BlendMode,
+		float BlendThreshold,
+		FMeshPaintRenderParameters& OutParams,
+		TConstArrayView<FMeshPaintBrushStamp> BoundingStamps = {}
 	);
 };
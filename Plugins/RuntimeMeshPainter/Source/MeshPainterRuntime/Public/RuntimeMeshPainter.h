@@ -3,6 +3,9 @@
 #pragma once
 
 #include "Modules/ModuleManager.h"
+#include "Logging/LogMacros.h"
+
+DECLARE_LOG_CATEGORY_EXTERN(LogMeshPainter, Log, All);
 
 class FRuntimeMeshPainterModule : public IModuleInterface
 {
@@ -11,4 +14,9 @@ public:
 	/** IModuleInterface implementation */
 	virtual void StartupModule() override;
 	virtual void ShutdownModule() override;
+
+private:
+#if WITH_EDITOR
+	FDelegateHandle ObjectPropertyChangedHandle;
+#endif
 };
@@ -26,6 +26,7 @@ public class RuntimeMeshPainter : ModuleRules
 			new string[]
 			{
 				"Core",
+				"MeshPainterShaderCore",
 				// ... add other public dependencies that you statically link with here ...
 			}
 			);
@@ -41,12 +42,19 @@ public class RuntimeMeshPainter : ModuleRules
 				"RenderCore",
 				"Renderer",
 				"RHI",
-                "MeshPainterShaderCore"
+				"ImageCore",
+				"Json",
+				"Projects"
 				// ... add private dependencies that you statically link with here ...	
 			}
 			);
 		
 		
+		if (Target.bBuildEditor)
+		{
+			PrivateDependencyModuleNames.AddRange(new string[] { "MeshDescription", "StaticMeshDescription", "DerivedDataCache" });
+		}
+
 		DynamicallyLoadedModuleNames.AddRange(
 			new string[]
 			{
@@ -10,7 +10,7 @@ public class MeshPainterShaderCore : ModuleRules
 		PCHUsage = ModuleRules.PCHUsageMode.UseExplicitOrSharedPCHs;
 
         PrivateIncludePaths.AddRange(new string[] { Path.Combine(GetModuleDirectory("Renderer"), "Private"), });
-        PublicDependencyModuleNames.AddRange(new string[] { "Core" });
+        PublicDependencyModuleNames.AddRange(new string[] { "Core", "DeveloperSettings" });
         PrivateDependencyModuleNames.AddRange(new string[] { "CoreUObject", "Engine", "Projects", "RenderCore", "Renderer", "RHI" });
 		DynamicallyLoadedModuleNames.AddRange(new string[] { });
     }
@@ -0,0 +1,43 @@
+#include "MaterialExpressionMeshPaintArrayCoordinates.h"
+#include "MaterialCompiler.h"
+
+#define LOCTEXT_NAMESPACE "FRuntimeMeshPainterModule"
+
+UMaterialExpressionMeshPaintArrayCoordinates::UMaterialExpressionMeshPaintArrayCoordinates(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+	, ConstCoordinate(0)
+	, SliceDataIndex(0)
+{
+	// Structure to hold one-time initialization
+	struct FConstructorStatics
+	{
+		FText NAME_Coordinates;
+		FConstructorStatics()
+			: NAME_Coordinates(LOCTEXT("Coordinates", "Coordinates"))
+		{
+		}
+	};
+	static FConstructorStatics ConstructorStatics;
+
+#if WITH_EDITORONLY_DATA
+	MenuCategories.Add(ConstructorStatics.NAME_Coordinates);
+#endif
+}
+
+#if WITH_EDITOR
+int32 UMaterialExpressionMeshPaintArrayCoordinates::Compile(class FMaterialCompiler* Compiler, int32 OutputIndex)
+{
+	const int32 UV = Coordinates.GetTracedInput().Expression ? Compiler->ValidCast(Coordinates.Compile(Compiler), MCT_Float2) : Compiler->TextureCoordinate(ConstCoordinate, false, false);
+
+	// Slices are stored as floats, round to protect against interpolation noise
+	const int32 Slice = Compiler->Floor(Compiler->Add(Compiler->CustomPrimitiveData(SliceDataIndex, MCT_Float), Compiler->Constant(0.5f)));
+	return Compiler->AppendVector(UV, Slice);
+}
+
+void UMaterialExpressionMeshPaintArrayCoordinates::GetCaption(TArray<FString>& OutCaptions) const
+{
+	OutCaptions.Add(FString(TEXT("Mesh Paint Array Coordinates")));
+}
+#endif
+
+#undef LOCTEXT_NAMESPACE
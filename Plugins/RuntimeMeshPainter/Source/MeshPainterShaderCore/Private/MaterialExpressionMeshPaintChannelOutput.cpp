@@ -0,0 +1,69 @@
+#include "MaterialExpressionMeshPaintChannelOutput.h"
+#include "MeshPaintChannelLayout.h"
+#include "MaterialCompiler.h"
+
+#define LOCTEXT_NAMESPACE "FRuntimeMeshPainterModule"
+
+UMaterialExpressionMeshPaintChannelOutput::UMaterialExpressionMeshPaintChannelOutput(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+	// Structure to hold one-time initialization
+	struct FConstructorStatics
+	{
+		FText NAME_MeshPaintChannels;
+		FConstructorStatics()
+			: NAME_MeshPaintChannels(LOCTEXT("Shading", "Shading"))
+		{
+		}
+	};
+	static FConstructorStatics ConstructorStatics;
+
+#if WITH_EDITORONLY_DATA
+	MenuCategories.Add(ConstructorStatics.NAME_MeshPaintChannels);
+#endif
+
+#if WITH_EDITOR
+	Outputs.Reset();
+#endif
+}
+
+FExpressionInput* UMaterialExpressionMeshPaintChannelOutput::GetChannelInput(int32 ChannelIndex)
+{
+	FExpressionInput* Inputs[MESH_PAINT_MAX_CHANNELS] = { &Channel0, &Channel1, &Channel2, &Channel3, &Channel4, &Channel5, &Channel6, &Channel7 };
+	return Inputs[ChannelIndex];
+}
+
+#if WITH_EDITOR
+int32 UMaterialExpressionMeshPaintChannelOutput::Compile(class FMaterialCompiler* Compiler, int32 OutputIndex)
+{
+	int32 CodeInput = INDEX_NONE;
+	if (OutputIndex >= 0 && OutputIndex < MESH_PAINT_MAX_CHANNELS)
+	{
+		FExpressionInput* Input = GetChannelInput(OutputIndex);
+		CodeInput = Input->IsConnected() ? Compiler->ValidCast(Input->Compile(Compiler), MCT_Float3) : Compiler->Constant3(0.0f, 0.0f, 0.0f);
+	}
+	return Compiler->CustomOutput(this, OutputIndex, CodeInput);
+}
+
+void UMaterialExpressionMeshPaintChannelOutput::GetCaption(TArray<FString>& OutCaptions) const
+{
+	OutCaptions.Add(FString(TEXT("Mesh Paint Channels")));
+}
+#endif
+
+int32 UMaterialExpressionMeshPaintChannelOutput::GetNumOutputs() const
+{
+	return MESH_PAINT_MAX_CHANNELS;
+}
+
+FString UMaterialExpressionMeshPaintChannelOutput::GetFunctionName() const
+{
+	return TEXT("GetMeshPaintChannelOutput");
+}
+
+FString UMaterialExpressionMeshPaintChannelOutput::GetDisplayName() const
+{
+	return TEXT("Mesh Paint Channels");
+}
+
+#undef LOCTEXT_NAMESPACE
@@ -0,0 +1,62 @@
+#include "MaterialExpressionMeshPaintSurfaceCoordinates.h"
+#include "MaterialCompiler.h"
+#include "Engine/EngineTypes.h"
+
+#define LOCTEXT_NAMESPACE "FRuntimeMeshPainterModule"
+
+UMaterialExpressionMeshPaintSurfaceCoordinates::UMaterialExpressionMeshPaintSurfaceCoordinates(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+	, ConstCoordinate(0)
+	, DescriptorDataIndex(0)
+{
+	// Structure to hold one-time initialization
+	struct FConstructorStatics
+	{
+		FText NAME_Coordinates;
+		FConstructorStatics()
+			: NAME_Coordinates(LOCTEXT("Coordinates", "Coordinates"))
+		{
+		}
+	};
+	static FConstructorStatics ConstructorStatics;
+
+#if WITH_EDITORONLY_DATA
+	MenuCategories.Add(ConstructorStatics.NAME_Coordinates);
+
+	bShowOutputNameOnPin = true;
+	Outputs.Reset();
+	Outputs.Add(FExpressionOutput(TEXT("UV")));
+	Outputs.Add(FExpressionOutput(TEXT("ArrayUVW")));
+	Outputs.Add(FExpressionOutput(TEXT("Slice")));
+#endif
+}
+
+#if WITH_EDITOR
+int32 UMaterialExpressionMeshPaintSurfaceCoordinates::Compile(class FMaterialCompiler* Compiler, int32 OutputIndex)
+{
+	if (DescriptorDataIndex < 0 || DescriptorDataIndex + DescriptorSize > FCustomPrimitiveData::NumCustomPrimitiveDataFloats)
+	{
+		return Compiler->Errorf(TEXT("The paint surface descriptor needs %d custom primitive data floats from DescriptorDataIndex"), DescriptorSize);
+	}
+
+	// Slices are stored as floats, round to protect against interpolation noise
+	const int32 Slice = Compiler->Floor(Compiler->Add(Compiler->CustomPrimitiveData(DescriptorDataIndex + 4, MCT_Float), Compiler->Constant(0.5f)));
+	if (OutputIndex == 2)
+	{
+		return Slice;
+	}
+
+	const int32 UV = Coordinates.GetTracedInput().Expression ? Compiler->ValidCast(Coordinates.Compile(Compiler), MCT_Float2) : Compiler->TextureCoordinate(ConstCoordinate, false, false);
+	const int32 CellMin = Compiler->CustomPrimitiveData(DescriptorDataIndex + 0, MCT_Float2);
+	const int32 CellSize = Compiler->CustomPrimitiveData(DescriptorDataIndex + 2, MCT_Float2);
+	const int32 AtlasUV = Compiler->Add(Compiler->Mul(UV, CellSize), CellMin);
+	return OutputIndex == 1 ? Compiler->AppendVector(AtlasUV, Slice) : AtlasUV;
+}
+
+void UMaterialExpressionMeshPaintSurfaceCoordinates::GetCaption(TArray<FString>& OutCaptions) const
+{
+	OutCaptions.Add(FString(TEXT("Mesh Paint Surface Coordinates")));
+}
+#endif
+
+#undef LOCTEXT_NAMESPACE
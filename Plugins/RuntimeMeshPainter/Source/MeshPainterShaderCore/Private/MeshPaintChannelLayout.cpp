@@ -0,0 +1,39 @@
+#include "MeshPaintChannelLayout.h"
+
+int32 FMeshPaintChannelLayout::FindChannel(FName ChannelName) const
+{
+	return Channels.IndexOfByPredicate([ChannelName](const FMeshPaintChannelDesc& Channel) { return Channel.Name == ChannelName; });
+}
+
+const FMeshPaintChannelLayout* UMeshPaintChannelSettings::FindLayout(FName LayoutName) const
+{
+	return ChannelLayouts.FindByPredicate([LayoutName](const FMeshPaintChannelLayout& Layout) { return Layout.Name == LayoutName; });
+}
+
+EPixelFormat MeshPaintChannels::GetPixelFormat(EMeshPaintChannelFormat Format)
+{
+	switch (Format)
+	{
+	case EMeshPaintChannelFormat::R8: return PF_R8;
+	case EMeshPaintChannelFormat::RG8: return PF_R8G8;
+	case EMeshPaintChannelFormat::RGBA8: return PF_B8G8R8A8;
+	case EMeshPaintChannelFormat::R16F: return PF_R16F;
+	case EMeshPaintChannelFormat::RG16F: return PF_G16R16F;
+	case EMeshPaintChannelFormat::RGBA16F: return PF_FloatRGBA;
+	}
+	return PF_B8G8R8A8;
+}
+
+ETextureRenderTargetFormat MeshPaintChannels::GetRenderTargetFormat(EMeshPaintChannelFormat Format)
+{
+	switch (Format)
+	{
+	case EMeshPaintChannelFormat::R8: return RTF_R8;
+	case EMeshPaintChannelFormat::RG8: return RTF_RG8;
+	case EMeshPaintChannelFormat::RGBA8: return RTF_RGBA8;
+	case EMeshPaintChannelFormat::R16F: return RTF_R16f;
+	case EMeshPaintChannelFormat::RG16F: return RTF_RG16f;
+	case EMeshPaintChannelFormat::RGBA16F: return RTF_RGBA16f;
+	}
+	return RTF_RGBA8;
+}
@@ -0,0 +1,125 @@
+#include "MeshPainterBlend.h"
+#include "MeshPainterRender.h"
+#include "MeshPainterRenderTargetPool.h"
+#include "GlobalShader.h"
+#include "ShaderParameterStruct.h"
+#include "DataDrivenShaderPlatformInfo.h"
+#include "RenderGraphBuilder.h"
+#include "RenderGraphUtils.h"
+#include "PixelFormat.h"
+
+class FMeshPaintBlendCS : public FGlobalShader
+{
+public:
+	DECLARE_GLOBAL_SHADER(FMeshPaintBlendCS);
+	SHADER_USE_PARAMETER_STRUCT(FMeshPaintBlendCS, FGlobalShader);
+
+	static constexpr int32 ThreadGroupSize = 8;
+
+	class FBlendModeDim : SHADER_PERMUTATION_INT("BLEND_MODE", 3);
+	class FDirectRMWDim : SHADER_PERMUTATION_BOOL("DIRECT_RMW");
+	using FPermutationDomain = TShaderPermutationDomain<FBlendModeDim, FDirectRMWDim>;
+
+	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+		SHADER_PARAMETER_RDG_TEXTURE(Texture2D<float4>, PaintTexture)
+		SHADER_PARAMETER(FIntPoint, PaintOffset)
+		SHADER_PARAMETER_RDG_TEXTURE(Texture2D<float4>, DestinationTexture)
+		SHADER_PARAMETER_RDG_TEXTURE_UAV(RWTexture2D<float4>, OutputTexture)
+		SHADER_PARAMETER(FIntPoint, DirtyRectMin)
+		SHADER_PARAMETER(FIntPoint, DirtyRectMax)
+		SHADER_PARAMETER(FIntPoint, OutputOffset)
+		SHADER_PARAMETER(float, BlendThreshold)
+	END_SHADER_PARAMETER_STRUCT()
+
+	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+	{
+		return IsFeatureLevelSupported(Parameters.Platform, ERHIFeatureLevel::SM5);
+	}
+
+	static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters, FShaderCompilerEnvironment& OutEnvironment)
+	{
+		FGlobalShader::ModifyCompilationEnvironment(Parameters, OutEnvironment);
+		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZE"), ThreadGroupSize);
+	}
+};
+
+IMPLEMENT_GLOBAL_SHADER(FMeshPaintBlendCS, "/Plugin/RuntimeMeshPainter/Private/MeshPaintBlend.usf", "MeshPaintBlendCS", SF_Compute);
+
+FRHIBlendState* MeshPaintRender::GetMeshPaintBlendState(EMeshPaintBlendMode BlendMode)
+{
+	switch (BlendMode)
+	{
+	case EMeshPaintBlendMode::Additive: return TStaticBlendState<CW_RGBA, BO_Add, BF_SourceAlpha, BF_One, BO_Add, BF_One, BF_One>::GetRHI();
+	case EMeshPaintBlendMode::Max: return TStaticBlendState<CW_RGBA, BO_Max, BF_One, BF_One, BO_Max, BF_One, BF_One>::GetRHI();
+	case EMeshPaintBlendMode::Min: return TStaticBlendState<CW_RGBA, BO_Min, BF_One, BF_One, BO_Min, BF_One, BF_One>::GetRHI();
+	default: break;
+	}
+
+	// Programmable modes use the same state, over a target cleared to zero it leaves premultiplied color and coverage
+	return TStaticBlendState<CW_RGBA, BO_Add, BF_SourceAlpha, BF_InverseSourceAlpha, BO_Add, BF_One, BF_InverseSourceAlpha>::GetRHI();
+}
+
+EPixelFormat MeshPaintRender::GetProgrammableBlendScratchFormat(EPixelFormat DestinationFormat)
+{
+	// Eight bit targets only need eight bits of premultiplied color, anything wider keeps half floats
+	switch (DestinationFormat)
+	{
+	case PF_G8:
+	case PF_R8:
+	case PF_R8G8:
+	case PF_B8G8R8A8:
+	case PF_R8G8B8A8:
+		return PF_R8G8B8A8;
+	default:
+		return PF_FloatRGBA;
+	}
+}
+
+void MeshPaintRender::AddProgrammableBlendPass(FRDGBuilder& GraphBuilder, FRDGTextureRef PaintTexture, FRDGTextureRef Destination, const FIntRect& DirtyRect, EMeshPaintBlendMode BlendMode, float BlendThreshold, FIntPoint PaintOffset)
+{
+	check(IsMeshPaintBlendModeProgrammable(BlendMode));
+	if (DirtyRect.Width() <= 0 || DirtyRect.Height() <= 0) return;
+
+	const bool bDirectRMW = EnumHasAnyFlags(Destination->Desc.Flags, TexCreate_UAV)
+		&& UE::PixelFormat::HasCapabilities(Destination->Desc.Format, EPixelFormatCapabilities::TypedUAVLoad);
+
+	FRDGTextureRef Output = bDirectRMW ? Destination : CreateTransientTexture(GraphBuilder, DirtyRect.Size(), Destination->Desc.Format, TEXT("MeshPaintBlendOutput"));
+
+	FMeshPaintBlendCS::FParameters* PassParameters = GraphBuilder.AllocParameters<FMeshPaintBlendCS::FParameters>();
+	PassParameters->PaintTexture = PaintTexture;
+	PassParameters->PaintOffset = PaintOffset;
+	PassParameters->DestinationTexture = bDirectRMW ? nullptr : Destination;
+	PassParameters->OutputTexture = GraphBuilder.CreateUAV(Output);
+	PassParameters->DirtyRectMin = DirtyRect.Min;
+	PassParameters->DirtyRectMax = DirtyRect.Max;
+	PassParameters->OutputOffset = bDirectRMW ? FIntPoint::ZeroValue : DirtyRect.Min;
+	PassParameters->BlendThreshold = BlendThreshold;
+
+	FMeshPaintBlendCS::FPermutationDomain Permutation;
+	Permutation.Set<FMeshPaintBlendCS::FBlendModeDim>((int32)BlendMode - (int32)EMeshPaintBlendMode::PaintUnpainted);
+	Permutation.Set<FMeshPaintBlendCS::FDirectRMWDim>(bDirectRMW);
+	TShaderMapRef<FMeshPaintBlendCS> ComputeShader(GetGlobalShaderMap(GMaxRHIFeatureLevel), Permutation);
+
+	// The scratch target is written by a raster pass, the graph forks the async queue after it and joins before the copy or the next use of Destination
+	FComputeShaderUtils::AddPass(
+		GraphBuilder,
+		RDG_EVENT_NAME("MeshPaintRender::Blend %s %dx%d", bDirectRMW ? TEXT("RMW") : TEXT("Copy"), DirtyRect.Width(), DirtyRect.Height()),
+		GetPaintComputePassFlags(),
+		ComputeShader,
+		PassParameters,
+		FComputeShaderUtils::GetGroupCount(DirtyRect.Size(), FMeshPaintBlendCS::ThreadGroupSize));
+
+	if (!bDirectRMW)
+	{
+		// Only the dirty rect is copied back, the target keeps its content elsewhere
+		FRHICopyTextureInfo CopyInfo;
+		CopyInfo.Size = FIntVector(DirtyRect.Width(), DirtyRect.Height(), 1);
+		CopyInfo.DestPosition = FIntVector(DirtyRect.Min.X, DirtyRect.Min.Y, 0);
+		AddCopyTexturePass(GraphBuilder, Output, Destination, CopyInfo);
+	}
+	else
+	{
+		// Written last on the async queue, the graph joins it before the target is sampled outside of the graph
+		GraphBuilder.SetTextureAccessFinal(Destination, ERHIAccess::SRVMask);
+	}
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RenderGraphFwd.h"
+#include "MeshPaintBlendMode.h"
+
+class FRHIBlendState;
+
+namespace MeshPaintRender
+{
+	/** Blend state of the mesh pass, programmable modes rasterize with premultiplied alpha into a cleared scratch target */
+	FRHIBlendState* GetMeshPaintBlendState(EMeshPaintBlendMode BlendMode);
+
+	/** Format of the scratch target painted before a programmable blend into Destination, keeps its precision and adds coverage alpha */
+	EPixelFormat GetProgrammableBlendScratchFormat(EPixelFormat DestinationFormat);
+
+	/**
+	 * Combines paint rasterized into PaintTexture with Destination inside DirtyRect using a programmable blend mode.
+	 * Targets supporting typed UAV loads are modified in place, others go through a dirty rect sized transient and a copy.
+	 * PaintTexture may cover the dirty rect only, PaintOffset is the Destination texel at its origin.
+	 */
+	void AddProgrammableBlendPass(FRDGBuilder& GraphBuilder, FRDGTextureRef PaintTexture, FRDGTextureRef Destination, const FIntRect& DirtyRect, EMeshPaintBlendMode BlendMode, float BlendThreshold, FIntPoint PaintOffset = FIntPoint::ZeroValue);
+}
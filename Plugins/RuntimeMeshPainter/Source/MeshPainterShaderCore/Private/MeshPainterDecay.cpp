@@ -0,0 +1,111 @@
+#include "MeshPainterRender.h"
+#include "MeshPainterStats.h"
+#include "GlobalShader.h"
+#include "ShaderParameterStruct.h"
+#include "DataDrivenShaderPlatformInfo.h"
+#include "RenderGraphBuilder.h"
+#include "RenderGraphUtils.h"
+#include "TextureResource.h"
+#include "PixelFormat.h"
+
+class FMeshPaintDecayCS : public FGlobalShader
+{
+public:
+	DECLARE_GLOBAL_SHADER(FMeshPaintDecayCS);
+	SHADER_USE_PARAMETER_STRUCT(FMeshPaintDecayCS, FGlobalShader);
+
+	static constexpr int32 ThreadGroupSize = 8;
+
+	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+		SHADER_PARAMETER_RDG_BUFFER_SRV(StructuredBuffer<uint>, Tiles)
+		SHADER_PARAMETER(uint32, TileOffset)
+		SHADER_PARAMETER(uint32, TileSize)
+		SHADER_PARAMETER(uint32, SubtilesPerRow)
+		SHADER_PARAMETER(FIntPoint, TargetSize)
+		SHADER_PARAMETER(FVector4f, DecayAmount)
+		SHADER_PARAMETER_RDG_TEXTURE_UAV(RWTexture2D<float4>, OutputTexture)
+	END_SHADER_PARAMETER_STRUCT()
+
+	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+	{
+		return IsFeatureLevelSupported(Parameters.Platform, ERHIFeatureLevel::SM5);
+	}
+
+	static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters, FShaderCompilerEnvironment& OutEnvironment)
+	{
+		FGlobalShader::ModifyCompilationEnvironment(Parameters, OutEnvironment);
+		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZE"), ThreadGroupSize);
+	}
+};
+
+IMPLEMENT_GLOBAL_SHADER(FMeshPaintDecayCS, "/Plugin/RuntimeMeshPainter/Private/MeshPaintDecay.usf", "MeshPaintDecayCS", SF_Compute);
+
+bool MeshPaintRender::SupportsDecay(EPixelFormat Format, ETextureCreateFlags Flags)
+{
+	return EnumHasAnyFlags(Flags, TexCreate_UAV) && UE::PixelFormat::HasCapabilities(Format, EPixelFormatCapabilities::TypedUAVLoad);
+}
+
+bool MeshPaintRender::AddDecayPass(FRHICommandListImmediate& RHICmdList, FTextureRenderTargetResource* RenderTarget, const FMeshPaintDecayParameters& Parameters)
+{
+	FRDGBuilder GraphBuilder(RHICmdList);
+	bool bResult = AddDecayPass(GraphBuilder, RenderTarget, Parameters);
+	GraphBuilder.Execute();
+	return bResult;
+}
+
+bool MeshPaintRender::AddDecayPass(FRDGBuilder& GraphBuilder, FTextureRenderTargetResource* RenderTarget, const FMeshPaintDecayParameters& Parameters)
+{
+	check(IsInRenderingThread());
+	MESH_PAINT_TRACE_SCOPE(AddDecayPass);
+
+	if (!RenderTarget || !RenderTarget->GetRenderTargetTexture() || Parameters.Tiles.IsEmpty()) return false;
+	check(Parameters.TileSize > 0 && Parameters.TileSize % FMeshPaintDecayCS::ThreadGroupSize == 0);
+
+	FRDGTextureRef OutputTexture = GraphBuilder.RegisterExternalTexture(CreateRenderTarget(RenderTarget->GetRenderTargetTexture(), TEXT("MeshPaintDecayOutput")));
+	if (!SupportsDecay(OutputTexture->Desc.Format, OutputTexture->Desc.Flags)) return false;
+
+	TArray<uint32> PackedTiles;
+	PackedTiles.Reserve(Parameters.Tiles.Num());
+	for (const FIntPoint& Tile : Parameters.Tiles)
+	{
+		PackedTiles.Add((uint32)Tile.X | ((uint32)Tile.Y << 16));
+	}
+	FRDGBufferRef TileBuffer = CreateStructuredBuffer(GraphBuilder, TEXT("MeshPaintDecayTiles"), PackedTiles);
+
+	const int32 SubtilesPerRow = Parameters.TileSize / FMeshPaintDecayCS::ThreadGroupSize;
+
+	FRDGBufferSRVRef TileSRV = GraphBuilder.CreateSRV(TileBuffer);
+	FRDGTextureUAVRef OutputUAV = GraphBuilder.CreateUAV(OutputTexture);
+	TShaderMapRef<FMeshPaintDecayCS> ComputeShader(GetGlobalShaderMap(GMaxRHIFeatureLevel));
+	const ERDGPassFlags PassFlags = GetPaintComputePassFlags();
+
+	// One group row per tile, split so the group count stays within dispatch limits
+	for (int32 TileOffset = 0; TileOffset < PackedTiles.Num(); TileOffset += GRHIMaxDispatchThreadGroupsPerDimension.X)
+	{
+		const int32 NumTiles = FMath::Min(PackedTiles.Num() - TileOffset, GRHIMaxDispatchThreadGroupsPerDimension.X);
+
+		FMeshPaintDecayCS::FParameters* PassParameters = GraphBuilder.AllocParameters<FMeshPaintDecayCS::FParameters>();
+		PassParameters->Tiles = TileSRV;
+		PassParameters->TileOffset = TileOffset;
+		PassParameters->TileSize = Parameters.TileSize;
+		PassParameters->SubtilesPerRow = SubtilesPerRow;
+		PassParameters->TargetSize = OutputTexture->Desc.Extent;
+		PassParameters->DecayAmount = Parameters.Amount;
+		PassParameters->OutputTexture = OutputUAV;
+
+		FComputeShaderUtils::AddPass(
+			GraphBuilder,
+			RDG_EVENT_NAME("MeshPaintRender::Decay %d tiles", NumTiles),
+			PassFlags,
+			ComputeShader,
+			PassParameters,
+			FIntVector(NumTiles, SubtilesPerRow * SubtilesPerRow, 1));
+	}
+
+	// Materials and Niagara sample the target outside of the graph, which joins the async queue before handing it back readable
+	GraphBuilder.SetTextureAccessFinal(OutputTexture, ERHIAccess::SRVMask);
+
+	const int64 NumTexels = (int64)PackedTiles.Num() * Parameters.TileSize * Parameters.TileSize;
+	MeshPaintStats::AddPassCounters(0, 1, NumTexels, NumTexels * GPixelFormats[OutputTexture->Desc.Format].BlockBytes);
+	return true;
+}
@@ -0,0 +1,98 @@
+#include "MeshPainterRender.h"
+#include "MeshPainterBlend.h"
+#include "MeshPainterRenderTargetPool.h"
+#include "MeshPainterStats.h"
+#include "GlobalShader.h"
+#include "ShaderParameterStruct.h"
+#include "DataDrivenShaderPlatformInfo.h"
+#include "PixelShaderUtils.h"
+#include "RenderGraphBuilder.h"
+#include "RenderGraphUtils.h"
+#include "TextureResource.h"
+
+class FMeshPaintIslandFillPS : public FGlobalShader
+{
+public:
+	DECLARE_GLOBAL_SHADER(FMeshPaintIslandFillPS);
+	SHADER_USE_PARAMETER_STRUCT(FMeshPaintIslandFillPS, FGlobalShader);
+
+	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+		SHADER_PARAMETER_TEXTURE(Texture2D<float2>, CoverageTexture)
+		SHADER_PARAMETER(FIntPoint, CoverageSize)
+		SHADER_PARAMETER(FVector4f, CellRect)
+		SHADER_PARAMETER(FVector2f, TargetOffset)
+		SHADER_PARAMETER(float, IslandId)
+		SHADER_PARAMETER(FVector4f, FillColor)
+		RENDER_TARGET_BINDING_SLOTS()
+	END_SHADER_PARAMETER_STRUCT()
+
+	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+	{
+		return IsFeatureLevelSupported(Parameters.Platform, ERHIFeatureLevel::SM5);
+	}
+};
+
+IMPLEMENT_GLOBAL_SHADER(FMeshPaintIslandFillPS, "/Plugin/RuntimeMeshPainter/Private/MeshPaintIslandFill.usf", "MeshPaintIslandFillPS", SF_Pixel);
+
+bool MeshPaintRender::AddIslandFillPass(FRHICommandListImmediate& RHICmdList, FTextureRenderTargetResource* RenderTarget, const FMeshPaintIslandFillParameters& Parameters)
+{
+	FRDGBuilder GraphBuilder(RHICmdList);
+	bool bResult = AddIslandFillPass(GraphBuilder, RenderTarget, Parameters);
+	GraphBuilder.Execute();
+	return bResult;
+}
+
+bool MeshPaintRender::AddIslandFillPass(FRDGBuilder& GraphBuilder, FTextureRenderTargetResource* RenderTarget, const FMeshPaintIslandFillParameters& Parameters)
+{
+	check(IsInRenderingThread());
+	MESH_PAINT_TRACE_SCOPE(AddIslandFillPass);
+
+	if (!RenderTarget || !RenderTarget->GetRenderTargetTexture() || !Parameters.CoverageTexture || !Parameters.CoverageTexture->TextureRHI || Parameters.IslandIndex == INDEX_NONE) return false;
+
+	FRHITexture* CoverageTexture = Parameters.CoverageTexture->TextureRHI;
+	FRDGTextureRef OutputTexture = GraphBuilder.RegisterExternalTexture(CreateRenderTarget(RenderTarget->GetRenderTargetTexture(), TEXT("MeshPaintIslandFillOutput")));
+	const FIntPoint TargetSize = OutputTexture->Desc.Extent;
+
+	FIntRect DirtyRect = Parameters.DirtyRect;
+	DirtyRect.Clip(FIntRect(FIntPoint::ZeroValue, TargetSize));
+	if (DirtyRect.IsEmpty()) return false;
+
+	// Programmable modes fill a cleared scratch target with premultiplied alpha and combine it afterwards, like the mesh pass.
+	// The scratch target only covers the dirty rect
+	const bool bProgrammableBlend = IsMeshPaintBlendModeProgrammable(Parameters.BlendMode);
+	FRDGTextureRef FillTexture = bProgrammableBlend
+		? FMeshPaintRenderTargetPool::Get().RegisterFreeElement(GraphBuilder, DirtyRect.Size(), MeshPaintRender::GetProgrammableBlendScratchFormat(OutputTexture->Desc.Format), TexCreate_RenderTargetable | TexCreate_ShaderResource, TEXT("MeshPaintIslandFillScratch"))
+		: OutputTexture;
+	const FIntPoint FillOffset = bProgrammableBlend ? DirtyRect.Min : FIntPoint::ZeroValue;
+
+	const FVector2f CellMin = FVector2f(Parameters.UVRegion.Min) * FVector2f(TargetSize);
+	const FVector2f CellSize = FVector2f(Parameters.UVRegion.GetSize()) * FVector2f(TargetSize);
+
+	FMeshPaintIslandFillPS::FParameters* PassParameters = GraphBuilder.AllocParameters<FMeshPaintIslandFillPS::FParameters>();
+	PassParameters->CoverageTexture = CoverageTexture;
+	PassParameters->CoverageSize = FIntPoint(CoverageTexture->GetSizeXYZ().X, CoverageTexture->GetSizeXYZ().Y);
+	PassParameters->CellRect = FVector4f(CellMin.X, CellMin.Y, CellSize.X, CellSize.Y);
+	PassParameters->TargetOffset = FVector2f(FillOffset);
+	PassParameters->IslandId = (float)(Parameters.IslandIndex + 1);
+	PassParameters->FillColor = FVector4f(Parameters.Color);
+	PassParameters->RenderTargets[0] = FRenderTargetBinding(FillTexture, bProgrammableBlend ? ERenderTargetLoadAction::EClear : ERenderTargetLoadAction::ELoad);
+
+	TShaderMapRef<FMeshPaintIslandFillPS> PixelShader(GetGlobalShaderMap(GMaxRHIFeatureLevel));
+	FPixelShaderUtils::AddFullscreenPass(
+		GraphBuilder,
+		GetGlobalShaderMap(GMaxRHIFeatureLevel),
+		RDG_EVENT_NAME("MeshPaintRender::IslandFill %dx%d", DirtyRect.Width(), DirtyRect.Height()),
+		PixelShader,
+		PassParameters,
+		DirtyRect - FillOffset,
+		MeshPaintRender::GetMeshPaintBlendState(Parameters.BlendMode));
+
+	if (bProgrammableBlend)
+	{
+		MeshPaintRender::AddProgrammableBlendPass(GraphBuilder, FillTexture, OutputTexture, DirtyRect, Parameters.BlendMode, Parameters.BlendThreshold, FillOffset);
+	}
+
+	const int64 NumTexels = (int64)DirtyRect.Width() * DirtyRect.Height();
+	MeshPaintStats::AddPassCounters(1, 1, NumTexels, NumTexels * GPixelFormats[OutputTexture->Desc.Format].BlockBytes);
+	return true;
+}
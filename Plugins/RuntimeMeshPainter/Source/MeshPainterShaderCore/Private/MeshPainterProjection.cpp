@@ -0,0 +1,211 @@
+#include "MeshPainterRender.h"
+#include "MeshPainterShader.h"
+#include "MeshPainterStats.h"
+#include "MeshPassProcessor.h"
+#include "MeshBatch.h"
+#include "PrimitiveSceneInfo.h"
+#include "Materials/Material.h"
+#include "Materials/MaterialRenderProxy.h"
+#include "RenderGraphBuilder.h"
+#include "RenderGraphUtils.h"
+#include "EngineModule.h"
+#include "SceneRendererInterface.h"
+#include "InstanceCulling/InstanceCullingContext.h"
+#include "MeshPassProcessor.inl"
+
+DECLARE_GPU_STAT_NAMED(MeshPaintProjectionDepth, TEXT("Mesh Paint Projection Depth"));
+
+class FMeshPaintProjectionDepthVS : public FMeshMaterialShader
+{
+public:
+	DECLARE_SHADER_TYPE(FMeshPaintProjectionDepthVS, MeshMaterial);
+
+	FMeshPaintProjectionDepthVS() { }
+	FMeshPaintProjectionDepthVS(const ShaderMetaType::CompiledShaderInitializerType& Initializer) : FMeshMaterialShader(Initializer) { }
+
+	/** Occluders are always drawn with the default material */
+	static bool ShouldCompilePermutation(const FMeshMaterialShaderPermutationParameters& Parameters)
+	{
+		return IsFeatureLevelSupported(Parameters.Platform, ERHIFeatureLevel::SM5)
+			&& Parameters.MaterialParameters.bIsDefaultMaterial
+			&& CheckMeshPaintVertexFactoryType(Parameters.VertexFactoryType);
+	}
+};
+
+IMPLEMENT_MATERIAL_SHADER_TYPE(, FMeshPaintProjectionDepthVS, TEXT("/Plugin/RuntimeMeshPainter/Private/MeshPaintProjectionDepth.usf"), TEXT("MeshPaintProjectionDepthVS"), SF_Vertex);
+
+class FMeshPaintProjectionDepthPassProcessor : public FMeshPassProcessor
+{
+public:
+	FMeshPaintProjectionDepthPassProcessor(const FSceneView* InView, FMeshPassDrawListContext* InDrawListContext)
+		: FMeshPassProcessor(EMeshPass::Num, nullptr, GMaxRHIFeatureLevel, InView, InDrawListContext)
+	{
+		DrawRenderState.SetDepthStencilState(TStaticDepthStencilState<true, CF_DepthNearOrEqual>::GetRHI());
+		DrawRenderState.SetBlendState(TStaticBlendState<CW_NONE>::GetRHI());
+	}
+
+	virtual void AddMeshBatch(const FMeshBatch& RESTRICT MeshBatch, uint64 BatchElementMask, const FPrimitiveSceneProxy* RESTRICT PrimitiveSceneProxy, int32 StaticMeshId = -1) override final
+	{
+		// Occluder materials do not change depth much at this resolution, the default material lets every batch share one shader
+		const FMaterialRenderProxy& MaterialRenderProxy = *UMaterial::GetDefaultMaterial(MD_Surface)->GetRenderProxy();
+		const FMaterial& Material = MaterialRenderProxy.GetIncompleteMaterialWithFallback(FeatureLevel);
+
+		FMaterialShaderTypes ShaderTypes;
+		ShaderTypes.AddShaderType<FMeshPaintProjectionDepthVS>();
+
+		FMaterialShaders Shaders;
+		if (!Material.TryGetShaders(ShaderTypes, MeshBatch.VertexFactory->GetType(), Shaders))
+		{
+			return;
+		}
+
+		TMeshProcessorShaders<FMeshPaintProjectionDepthVS, FMeshMaterialShader> PassShaders;
+		Shaders.TryGetVertexShader(PassShaders.VertexShader);
+
+		FMeshMaterialShaderElementData ShaderElementData;
+		ShaderElementData.InitializeMeshMaterialData(ViewIfDynamicMeshCommand, PrimitiveSceneProxy, MeshBatch, StaticMeshId, false);
+
+		const FMeshDrawingPolicyOverrideSettings OverrideSettings = ComputeMeshOverrideSettings(MeshBatch);
+
+		BuildMeshDrawCommands(
+			MeshBatch,
+			BatchElementMask,
+			PrimitiveSceneProxy,
+			MaterialRenderProxy,
+			Material,
+			DrawRenderState,
+			PassShaders,
+			ComputeMeshFillMode(Material, OverrideSettings),
+			CM_None,
+			FMeshDrawCommandSortKey::Default,
+			EMeshPassFeatures::Default,
+			ShaderElementData);
+
+		NumDraws += MeshBatch.Elements.Num();
+	}
+
+	/** Mesh draw commands built so far */
+	int32 GetNumDraws() const { return NumDraws; }
+
+private:
+	FMeshPassProcessorRenderState DrawRenderState;
+	int32 NumDraws = 0;
+};
+
+/** View families only need a render target for its size */
+class FMeshPaintProjectionDepthTarget : public FRenderTarget
+{
+public:
+	explicit FMeshPaintProjectionDepthTarget(FIntPoint InSize) : Size(InSize) { }
+	virtual FIntPoint GetSizeXY() const override { return Size; }
+
+private:
+	FIntPoint Size;
+};
+
+bool MeshPaintRender::AddProjectionDepthPass(FRHICommandListImmediate& RHICmdList, const FMeshPaintProjectionDepthParameters& Parameters, FMeshPaintProjectionDepth& OutDepth)
+{
+	FRDGBuilder GraphBuilder(RHICmdList);
+	bool bResult = AddProjectionDepthPass(GraphBuilder, Parameters, OutDepth);
+	GraphBuilder.Execute();
+	return bResult;
+}
+
+bool MeshPaintRender::AddProjectionDepthPass(FRDGBuilder& GraphBuilder, const FMeshPaintProjectionDepthParameters& InParameters, FMeshPaintProjectionDepth& OutDepth)
+{
+	check(IsInRenderingThread());
+	MESH_PAINT_TRACE_SCOPE(AddProjectionDepthPass);
+
+	if (!InParameters.Scene)
+	{
+		return false;
+	}
+
+	RDG_EVENT_SCOPE(GraphBuilder, "MeshPaintProjectionDepth");
+	RDG_GPU_STAT_SCOPE(GraphBuilder, MeshPaintProjectionDepth);
+
+	// Extracted when the graph executes, OutDepth has to outlive the builder
+	const FIntPoint Resolution = InParameters.Resolution.ComponentMax(FIntPoint(1, 1));
+	FRDGTextureRef DepthTexture = GraphBuilder.CreateTexture(
+		FRDGTextureDesc::Create2D(Resolution, PF_DepthStencil, FClearValueBinding::DepthFar, TexCreate_DepthStencilTargetable | TexCreate_ShaderResource),
+		TEXT("MeshPaintProjectionDepth"));
+	GraphBuilder.QueueTextureExtraction(DepthTexture, &OutDepth.Texture);
+
+	MeshPaintStats::AddPassCounters(InParameters.Occluders.Num(), 0, (int64)Resolution.X * Resolution.Y, (int64)Resolution.X * Resolution.Y * GPixelFormats[PF_DepthStencil].BlockBytes);
+
+	// Nothing occludes, every texel in the frustum passes
+	if (InParameters.Occluders.IsEmpty())
+	{
+		AddClearDepthStencilPass(GraphBuilder, DepthTexture, true, (float)ERHIZBuffer::FarPlane, false, 0);
+		return true;
+	}
+
+	// Passes run when the graph executes, everything they reference is owned by the graph
+	FEngineShowFlags EngineShowFlags(ESFIM_Game);
+	EngineShowFlags.PostProcessing = 0;
+
+	FMeshPaintProjectionDepthTarget* ViewTarget = GraphBuilder.AllocObject<FMeshPaintProjectionDepthTarget>(Resolution);
+	FSceneViewFamilyContext* ViewFamily = GraphBuilder.AllocObject<FSceneViewFamilyContext>(FSceneViewFamily::ConstructionValues(
+		ViewTarget,
+		InParameters.Scene,
+		EngineShowFlags)
+		.SetTime(FGameTime::GetTimeSinceAppStart()));
+
+	FScenePrimitiveRenderingContextScopeHelper ScenePrimitiveRenderingContextScopeHelper(GetRendererModule().BeginScenePrimitiveRendering(GraphBuilder, ViewFamily));
+
+	FSceneView* View = nullptr;
+	{
+		MESH_PAINT_SCOPED_STAGE(CreateView);
+
+		FSceneViewInitOptions ViewInitOptions;
+		*static_cast<FSceneViewProjectionData*>(&ViewInitOptions) = InParameters.ViewProjection;
+		ViewInitOptions.ViewFamily = ViewFamily;
+		ViewInitOptions.SetViewRectangle(FIntRect(FIntPoint::ZeroValue, Resolution));
+		ViewInitOptions.bIsSceneCapture = true;
+
+		GetRendererModule().CreateAndInitSingleView(GraphBuilder.RHICmdList, ViewFamily, &ViewInitOptions);
+		View = (FSceneView*)ViewFamily->Views[0];
+	}
+
+	MESH_PAINT_SCOPED_STAGE(MeshPassSetup);
+
+	FMeshPaintShaderParameters* PassParameters = GraphBuilder.AllocParameters<FMeshPaintShaderParameters>();
+	PassParameters->View = View->ViewUniformBuffer;
+	PassParameters->Scene = GetSceneUniformBufferRef(GraphBuilder, *View);
+	PassParameters->InstanceCulling = FInstanceCullingContext::CreateDummyInstanceCullingUniformBuffer(GraphBuilder);
+	PassParameters->RenderTargets.DepthStencil = FDepthStencilBinding(DepthTexture, ERenderTargetLoadAction::EClear, FExclusiveDepthStencil::DepthWrite_StencilNop);
+
+	const TArray<FMeshPaintProxyRenderParameters>* Occluders = GraphBuilder.AllocObject<TArray<FMeshPaintProxyRenderParameters>>(InParameters.Occluders);
+
+	GraphBuilder.AddPass(RDG_EVENT_NAME("MeshPaintRender::ProjectionDepthPass %dx%d", Resolution.X, Resolution.Y),
+		PassParameters,
+		ERDGPassFlags::Raster | ERDGPassFlags::NeverCull,
+		[View, Occluders](FRHICommandList& RHICmdList)
+		{
+			const FIntRect ViewRect = View->UnscaledViewRect;
+			RHICmdList.SetViewport(ViewRect.Min.X, ViewRect.Min.Y, 0.0f, ViewRect.Max.X, ViewRect.Max.Y, 1.0f);
+
+			MESH_PAINT_SCOPED_STAGE(DrawCommands);
+
+			DrawDynamicMeshPass(*View, RHICmdList, [View, Occluders](FDynamicPassMeshDrawListContext* DynamicMeshPassContext)
+			{
+				FMeshPaintProjectionDepthPassProcessor MeshPassProcessor(View, DynamicMeshPassContext);
+				for (const FMeshPaintProxyRenderParameters& Occluder : *Occluders)
+				{
+					FPrimitiveSceneInfo* PrimitiveSceneInfo = Occluder.PrimitiveProxy->GetPrimitiveSceneInfo();
+					if (PrimitiveSceneInfo->StaticMeshes.IsEmpty()) continue;
+
+					const uint8 MaxLOD = PrimitiveSceneInfo->StaticMeshes.Num() - 1;
+					const uint8 MinLOD = Occluder.PrimitiveProxy->GetCurrentFirstLODIdx_RenderThread();
+					if (const FMeshBatch* MeshBatch = PrimitiveSceneInfo->GetMeshBatch(FMath::Clamp(Occluder.TargetLOD, MinLOD, MaxLOD)))
+					{
+						MeshPassProcessor.AddMeshBatch(*MeshBatch, ~0ull, Occluder.PrimitiveProxy);
+					}
+				}
+
+				MeshPaintStats::AddPassCounters(0, MeshPassProcessor.GetNumDraws(), 0, 0);
+			});
+		});
+
+	return true;
+}
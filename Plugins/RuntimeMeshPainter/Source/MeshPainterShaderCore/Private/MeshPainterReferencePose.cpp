@@ -0,0 +1,135 @@
+#include "MeshPainterReferencePose.h"
+#include "Components/SkinnedMeshComponent.h"
+#include "Engine/SkinnedAsset.h"
+#include "Engine/SkeletalMesh.h"
+#include "Rendering/SkeletalMeshRenderData.h"
+#include "Materials/Material.h"
+#include "MeshBatch.h"
+#include "PrimitiveSceneProxy.h"
+
+namespace MeshPaintReferencePose
+{
+	/** Reference poses by render data and LOD, render thread only. Keys are never dereferenced, lookups get the render data from a live proxy */
+	static TMap<TPair<const FSkeletalMeshRenderData*, int32>, TUniquePtr<FMeshPaintReferencePoseMesh>> CachedMeshes;
+}
+
+FMeshPaintReferencePoseMesh::FMeshPaintReferencePoseMesh(int32 InLODIndex)
+	: LODIndex(InLODIndex)
+	, IndexBuffer(nullptr)
+	, VertexFactory(GMaxRHIFeatureLevel, "FMeshPaintReferencePoseMesh")
+{
+}
+
+FMeshPaintReferencePoseMesh::~FMeshPaintReferencePoseMesh()
+{
+	VertexFactory.ReleaseResource();
+}
+
+const FMeshPaintReferencePoseMesh* FMeshPaintReferencePoseMesh::FindOrCreate(FRHICommandListBase& RHICmdList, const FSkeletalMeshRenderData& RenderData, int32 LODIndex)
+{
+	check(IsInRenderingThread());
+
+	if (!RenderData.LODRenderData.IsValidIndex(LODIndex)) return nullptr;
+	const FSkeletalMeshLODRenderData& LODData = RenderData.LODRenderData[LODIndex];
+	FRHIBuffer* PositionBuffer = LODData.StaticVertexBuffers.PositionVertexBuffer.VertexBufferRHI;
+	if (!PositionBuffer || !LODData.MultiSizeIndexContainer.IsIndexBufferValid()) return nullptr;
+
+	// Render data releasing or streaming out its buffers leaves the cache holding the last reference, those entries are stale
+	for (auto It = MeshPaintReferencePose::CachedMeshes.CreateIterator(); It; ++It)
+	{
+		if (It.Value()->PositionBuffer->GetRefCount() == 1) It.RemoveCurrent();
+	}
+
+	TUniquePtr<FMeshPaintReferencePoseMesh>& Mesh = MeshPaintReferencePose::CachedMeshes.FindOrAdd(MakeTuple(&RenderData, LODIndex));
+	if (Mesh.IsValid() && Mesh->PositionBuffer == PositionBuffer)
+	{
+		return Mesh.Get();
+	}
+
+	Mesh.Reset(new FMeshPaintReferencePoseMesh(LODIndex));
+	Mesh->PositionBuffer = PositionBuffer;
+	Mesh->IndexBuffer = LODData.MultiSizeIndexContainer.GetIndexBuffer();
+	for (int32 SectionIndex = 0; SectionIndex < LODData.RenderSections.Num(); ++SectionIndex)
+	{
+		const FSkelMeshRenderSection& RenderSection = LODData.RenderSections[SectionIndex];
+		if (RenderSection.bDisabled || RenderSection.NumTriangles == 0) continue;
+
+		FSection& Section = Mesh->Sections.AddDefaulted_GetRef();
+		Section.FirstIndex = RenderSection.BaseIndex;
+		Section.NumTriangles = RenderSection.NumTriangles;
+		Section.MinVertexIndex = RenderSection.BaseVertexIndex;
+		Section.MaxVertexIndex = RenderSection.BaseVertexIndex + RenderSection.GetNumVertices() - 1;
+		Section.RenderSectionIndex = SectionIndex;
+	}
+
+	FLocalVertexFactory::FDataType Data;
+	LODData.StaticVertexBuffers.PositionVertexBuffer.BindPositionVertexBuffer(&Mesh->VertexFactory, Data);
+	LODData.StaticVertexBuffers.StaticMeshVertexBuffer.BindTangentVertexBuffer(&Mesh->VertexFactory, Data);
+	LODData.StaticVertexBuffers.StaticMeshVertexBuffer.BindPackedTexCoordVertexBuffer(&Mesh->VertexFactory, Data);
+	LODData.StaticVertexBuffers.ColorVertexBuffer.BindColorVertexBuffer(&Mesh->VertexFactory, Data);
+	Mesh->VertexFactory.SetData(RHICmdList, Data);
+	Mesh->VertexFactory.InitResource(RHICmdList);
+
+	return Mesh.Get();
+}
+
+void FMeshPaintReferencePoseMesh::ReleaseAll()
+{
+	check(IsInRenderingThread());
+	MeshPaintReferencePose::CachedMeshes.Empty();
+}
+
+void FMeshPaintReferencePoseMesh::GatherSectionMaterials(USkinnedMeshComponent* Component, int32 LODIndex, TArray<const FMaterialRenderProxy*, TInlineAllocator<4>>& OutMaterials)
+{
+	check(IsInGameThread());
+	OutMaterials.Reset();
+
+	USkinnedAsset* SkinnedAsset = IsValid(Component) ? Component->GetSkinnedAsset() : nullptr;
+	const FSkeletalMeshRenderData* RenderData = SkinnedAsset ? SkinnedAsset->GetResourceForRendering() : nullptr;
+	if (!RenderData || !RenderData->LODRenderData.IsValidIndex(LODIndex)) return;
+
+	const FSkeletalMeshLODRenderData& LODData = RenderData->LODRenderData[LODIndex];
+	const FSkeletalMeshLODInfo* LODInfo = SkinnedAsset->GetLODInfo(LODIndex);
+	for (int32 SectionIndex = 0; SectionIndex < LODData.RenderSections.Num(); ++SectionIndex)
+	{
+		int32 MaterialIndex = LODData.RenderSections[SectionIndex].MaterialIndex;
+		if (LODInfo && LODInfo->LODMaterialMap.IsValidIndex(SectionIndex) && LODInfo->LODMaterialMap[SectionIndex] != INDEX_NONE)
+		{
+			MaterialIndex = LODInfo->LODMaterialMap[SectionIndex];
+		}
+		UMaterialInterface* Material = Component->GetMaterial(MaterialIndex);
+		OutMaterials.Add((Material ? Material : UMaterial::GetDefaultMaterial(MD_Surface))->GetRenderProxy());
+	}
+}
+
+void FMeshPaintReferencePoseMesh::ForEachMeshBatch(const FPrimitiveSceneProxy* PrimitiveProxy, TConstArrayView<const FMaterialRenderProxy*> SectionMaterials, TFunctionRef<void(const FMeshBatch&)> Callback) const
+{
+	if (!VertexFactory.IsInitialized() || !IndexBuffer) return;
+
+	for (int32 SectionIndex = 0; SectionIndex < Sections.Num(); ++SectionIndex)
+	{
+		const FSection& Section = Sections[SectionIndex];
+		if (!SectionMaterials.IsValidIndex(Section.RenderSectionIndex)) continue;
+
+		FMeshBatch MeshBatch;
+		MeshBatch.VertexFactory = &VertexFactory;
+		MeshBatch.MaterialRenderProxy = SectionMaterials[Section.RenderSectionIndex];
+		MeshBatch.Type = PT_TriangleList;
+		MeshBatch.DepthPriorityGroup = SDPG_World;
+		MeshBatch.LODIndex = (int8)LODIndex;
+		MeshBatch.SegmentIndex = (uint8)SectionIndex;
+		MeshBatch.MeshIdInPrimitive = (uint16)SectionIndex;
+		MeshBatch.bUseForMaterial = true;
+		MeshBatch.CastShadow = false;
+
+		FMeshBatchElement& Element = MeshBatch.Elements[0];
+		Element.IndexBuffer = IndexBuffer;
+		Element.FirstIndex = Section.FirstIndex;
+		Element.NumPrimitives = Section.NumTriangles;
+		Element.MinVertexIndex = Section.MinVertexIndex;
+		Element.MaxVertexIndex = Section.MaxVertexIndex;
+		Element.PrimitiveUniformBuffer = PrimitiveProxy->GetUniformBuffer();
+
+		Callback(MeshBatch);
+	}
+}
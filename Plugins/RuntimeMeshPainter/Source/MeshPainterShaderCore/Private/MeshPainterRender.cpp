@@ -1,16 +1,39 @@
 #include "MeshPainterRender.h"
 #include "MeshPainterShader.h"
+#include "MeshPainterStats.h"
+#include "MeshPainterBlend.h"
+#include "MeshPainterRenderTargetPool.h"
+#include "MeshPainterReferencePose.h"
 #include "MeshPassProcessor.h"
 #include "MeshBatch.h"
 #include "PrimitiveSceneInfo.h"
 #include "Materials/MaterialRenderProxy.h"
 #include "RenderGraphBuilder.h"
+#include "RenderGraphUtils.h"
 #include "EngineModule.h"
 #include "SceneRendererInterface.h"
 #include "InstanceCulling/InstanceCullingContext.h"
 #include "RenderCaptureInterface.h"
+#include "SkeletalRenderPublic.h"
+#include "SkeletalMeshSceneProxy.h"
+#include "TextureResource.h"
 #include "MeshPassProcessor.inl"
 
+DECLARE_GPU_STAT_NAMED(MeshPaintPass, TEXT("Mesh Paint"));
+DEFINE_LOG_CATEGORY_STATIC(LogMeshPaintRender, Log, All);
+
+static int32 GMeshPaintUseSkinCache = 1;
+static FAutoConsoleVariableRef CVarMeshPaintUseSkinCache(
+	TEXT("r.MeshPaint.UseSkinCache"),
+	GMeshPaintUseSkinCache,
+	TEXT("Paint skeletal meshes with the positions of the GPU skin cache when it holds them instead of skinning them again"));
+
+static int32 GMeshPaintAsyncCompute = 1;
+static FAutoConsoleVariableRef CVarMeshPaintAsyncCompute(
+	TEXT("r.MeshPaint.AsyncCompute"),
+	GMeshPaintAsyncCompute,
+	TEXT("Run decay and programmable blend passes on the async compute queue on platforms where it is efficient"));
+
 #if (!UE_BUILD_SHIPPING && !UE_BUILD_TEST)
 static int32 RenderCaptureDraws = 0;
 static FAutoConsoleVariableRef CVarRenderCaptureDraws(
@@ -22,19 +45,35 @@ static FAutoConsoleVariableRef CVarRenderCaptureDraws(
 class FMeshPaintPassProcessor : public FMeshPassProcessor
 {
 public:
-	FMeshPaintPassProcessor(const FSceneView* InView, FMeshPassDrawListContext* InDrawListContext, const TArray<FMeshPaintProxyRenderParameters>& PrimitiveInfos, const FMaterialRenderProxy* InMaterial, EMeshPaintShaderOutputBits InOutputs)
-		: FMeshPassProcessor(EMeshPass::Num, nullptr, GMaxRHIFeatureLevel, InView, InDrawListContext), MaterialOverride(InMaterial), ActiveOutputs(InOutputs)
+	FMeshPaintPassProcessor(const FSceneView* InView, FMeshPassDrawListContext* InDrawListContext, const TArray<FMeshPaintProxyRenderParameters>& PrimitiveInfos, TConstArrayView<FUintVector2> InStampRanges, const FMaterialRenderProxy* InMaterial, EMeshPaintShaderOutputBits InOutputs, EMeshPaintBlendMode InBlendMode, TConstArrayView<EMeshPaintChannelSource> InChannelSources, bool bInLayered, FRHIUniformBuffer* InBrushParameters, FRHIUniformBuffer* InProjectionParameters, FRHIUniformBuffer* InStampCounterParameters)
+		: FMeshPassProcessor(EMeshPass::Num, nullptr, GMaxRHIFeatureLevel, InView, InDrawListContext), MaterialOverride(InMaterial), ActiveOutputs(InOutputs), NumChannels(InChannelSources.Num()), bLayered(bInLayered), BrushParameters(InBrushParameters), ProjectionParameters(InProjectionParameters), StampCounterParameters(InStampCounterParameters)
 	{
+		for (int32 ChannelIndex = 0; ChannelIndex < MESH_PAINT_MAX_CHANNELS; ++ChannelIndex)
+		{
+			ChannelSources[ChannelIndex / 4][ChannelIndex % 4] = ChannelIndex < NumChannels ? (int32)InChannelSources[ChannelIndex] : 0;
+		}
+
 		DrawRenderState.SetDepthStencilState(TStaticDepthStencilState<false, CF_Always>::GetRHI());
-		DrawRenderState.SetBlendState(TStaticBlendState<CW_RGBA, BO_Add, BF_SourceAlpha, BF_InverseSourceAlpha, BO_Add, BF_One, BF_InverseSourceAlpha>::GetRHI());
+		DrawRenderState.SetBlendState(MeshPaintRender::GetMeshPaintBlendState(InBlendMode));
 
-		for (const FMeshPaintProxyRenderParameters& Params : PrimitiveInfos)
+		const FVector PreViewTranslation = InView->ViewMatrices.GetPreViewTranslation();
+		for (int32 PrimitiveIndex = 0; PrimitiveIndex < PrimitiveInfos.Num(); ++PrimitiveIndex)
 		{
-			PrimitiveDetails.Add(Params.PrimitiveProxy, FPrimitiveDetails(Params.UVRegion));
+			const FMeshPaintProxyRenderParameters& Params = PrimitiveInfos[PrimitiveIndex];
+			const FUintVector2 StampRange = InStampRanges.IsValidIndex(PrimitiveIndex) ? InStampRanges[PrimitiveIndex] : FUintVector2::ZeroValue;
+			const FBoxSphereBounds& Bounds = Params.PrimitiveProxy->GetBounds();
+			const FVector4f CullSphere(FVector3f(Bounds.Origin + PreViewTranslation), (float)Bounds.SphereRadius);
+			PrimitiveDetails.Add(Params.PrimitiveProxy, FPrimitiveDetails(Params.UVRegion, Params.ArraySlice, StampRange, CullSphere));
 		}
 	}
 
 	virtual void AddMeshBatch(const FMeshBatch& RESTRICT MeshBatch, uint64 BatchElementMask, const FPrimitiveSceneProxy* RESTRICT PrimitiveSceneProxy, int32 StaticMeshId = -1) override final
+	{
+		TryAddMeshBatch(MeshBatch, BatchElementMask, PrimitiveSceneProxy, StaticMeshId);
+	}
+
+	/** Same as AddMeshBatch, returns false when the material has no paint shaders for the vertex factory */
+	bool TryAddMeshBatch(const FMeshBatch& RESTRICT MeshBatch, uint64 BatchElementMask, const FPrimitiveSceneProxy* RESTRICT PrimitiveSceneProxy, int32 StaticMeshId = -1)
 	{
 		const FMaterialRenderProxy* SourceMaterialRenderProxy = MaterialOverride ? MaterialOverride : MeshBatch.MaterialRenderProxy;
 		const FMaterialRenderProxy* FallbackMaterialRenderProxy = nullptr;
@@ -48,22 +87,27 @@ public:
 
 		if (!PrimitiveUVInfo)
 		{
-			return;
+			return false;
 		}
 
 		TMeshProcessorShaders<FMeshPaintShaderVS, FMeshPaintShaderPS> PassShaders;
 
 		FMeshPaintShaderPS::FPermutationDomain PSPremutation;
 		PSPremutation.Set<FMeshPaintShaderPS::FOutputBits>((int32)ActiveOutputs);
+		PSPremutation.Set<FMeshPaintShaderPS::FChannelCount>(NumChannels);
+		PSPremutation.Set<FMeshPaintShaderPS::FBrush>(BrushParameters != nullptr);
+
+		FMeshPaintShaderVS::FPermutationDomain VSPermutation;
+		VSPermutation.Set<FMeshPaintShaderVS::FLayered>(bLayered);
 
 		FMaterialShaderTypes ShaderTypes;
-		ShaderTypes.AddShaderType<FMeshPaintShaderVS>();
+		ShaderTypes.AddShaderType<FMeshPaintShaderVS>(VSPermutation.ToDimensionValueId());
 		ShaderTypes.AddShaderType<FMeshPaintShaderPS>(PSPremutation.ToDimensionValueId());
 
 		FMaterialShaders Shaders;
 		if (!Material.TryGetShaders(ShaderTypes, VertexFactory->GetType(), Shaders))
 		{
-			return;
+			return false;
 		}
 
 		Shaders.TryGetVertexShader(PassShaders.VertexShader);
@@ -79,6 +123,14 @@ public:
 		const FVector2D UVScale = PrimitiveUVInfo->UVRegion.GetSize();
 		const FVector2D UVBias = PrimitiveUVInfo->UVRegion.Min;
 		ShaderElementData.UVTileMapping = FVector4(UVScale * FVector2D(2.0f, -2.0f), UVBias * 2.0f + FVector2D(-1.0f, 1.0f));
+		ShaderElementData.ChannelSources[0] = ChannelSources[0];
+		ShaderElementData.ChannelSources[1] = ChannelSources[1];
+		ShaderElementData.ArraySlice = (uint32)FMath::Max(PrimitiveUVInfo->ArraySlice, 0);
+		ShaderElementData.BrushParameters = BrushParameters;
+		ShaderElementData.StampRange = PrimitiveUVInfo->StampRange;
+		ShaderElementData.ProjectionParameters = ProjectionParameters;
+		ShaderElementData.StampCounterParameters = StampCounterParameters;
+		ShaderElementData.CullSphere = PrimitiveUVInfo->CullSphere;
 
 		FMeshDrawCommandSortKey SortKey = CreateMeshSortKey(MeshBatch, PrimitiveSceneProxy, Material, PassShaders.VertexShader.GetShader(), PassShaders.PixelShader.GetShader());
 
@@ -95,8 +147,14 @@ public:
 			SortKey,
 			EMeshPassFeatures::Default,
 			ShaderElementData);
+
+		NumDraws += MeshBatch.Elements.Num();
+		return true;
 	}
 
+	/** Mesh draw commands built so far */
+	int32 GetNumDraws() const { return NumDraws; }
+
 protected:
 	virtual FMeshDrawCommandSortKey CreateMeshSortKey(const FMeshBatch& RESTRICT MeshBatch,
 		const FPrimitiveSceneProxy* RESTRICT PrimitiveSceneProxy,
@@ -140,13 +198,56 @@ private:
 	const FMaterialRenderProxy* MaterialOverride;
 	FMeshPassProcessorRenderState DrawRenderState;
 	EMeshPaintShaderOutputBits ActiveOutputs;
+	int32 NumChannels;
+	FIntVector4 ChannelSources[2];
+	bool bLayered;
+	FRHIUniformBuffer* BrushParameters;
+	FRHIUniformBuffer* ProjectionParameters;
+	FRHIUniformBuffer* StampCounterParameters;
+	int32 NumDraws = 0;
 	struct FPrimitiveDetails
 	{
 		FBox2D UVRegion;
+		int32 ArraySlice;
+		FUintVector2 StampRange;
+		FVector4f CullSphere;
 	};
 	TMap<FPrimitiveSceneProxy*, FPrimitiveDetails> PrimitiveDetails;
 };
 
+/** Mesh object of a skinned primitive, read from its proxy since components recreate it along with their render state. Render thread */
+static const FSkeletalMeshObject* GetSkinnedMeshObject(const FMeshPaintProxyRenderParameters& PrimitiveInfo)
+{
+	return PrimitiveInfo.bSkinnedMesh ? static_cast<const FSkeletalMeshSceneProxy*>(PrimitiveInfo.PrimitiveProxy)->GetMeshObject() : nullptr;
+}
+
+/** Number of slices of array targets, 0 for 2D targets and INDEX_NONE when targets disagree */
+static int32 GetRenderTargetArraySize(const FMeshPaintRenderTargets& RenderTargets)
+{
+	TArray<FTextureRenderTargetResource*, TInlineAllocator<MESH_PAINT_MAX_CHANNELS>> Resources(RenderTargets.Channels);
+	if (!RenderTargets.HasChannels())
+	{
+		if (RenderTargets.BaseColor) Resources.Add(RenderTargets.BaseColor);
+		if (RenderTargets.Emissive) Resources.Add(RenderTargets.Emissive);
+		if (RenderTargets.NormalMap) Resources.Add(RenderTargets.NormalMap);
+	}
+
+	int32 ArraySize = INDEX_NONE;
+	for (FTextureRenderTargetResource* Resource : Resources)
+	{
+		const FRHITextureDesc& Desc = Resource->GetRenderTargetTexture()->GetDesc();
+		const int32 ResourceArraySize = Desc.IsTextureArray() ? Desc.ArraySize : 0;
+		if (ArraySize != INDEX_NONE && ArraySize != ResourceArraySize) return INDEX_NONE;
+		ArraySize = ResourceArraySize;
+	}
+	return ArraySize;
+}
+
+ERDGPassFlags MeshPaintRender::GetPaintComputePassFlags()
+{
+	return GMeshPaintAsyncCompute != 0 && GSupportsEfficientAsyncCompute ? ERDGPassFlags::AsyncCompute : ERDGPassFlags::Compute;
+}
+
 bool MeshPaintRender::AddMeshPaintPass(FRHICommandListImmediate& RHICmdList, const FMeshPaintRenderTargets& InRenderTargets, const FMeshPaintRenderParameters& InParameters)
 {
 	FRDGBuilder GraphBuilder(RHICmdList);
@@ -158,12 +259,51 @@ bool MeshPaintRender::AddMeshPaintPass(FRHICommandListImmediate& RHICmdList, con
 bool MeshPaintRender::AddMeshPaintPass(FRDGBuilder& GraphBuilder, const FMeshPaintRenderTargets& InRenderTargets, const FMeshPaintRenderParameters& InParameters)
 {
 	check(IsInRenderingThread());
+	MESH_PAINT_TRACE_SCOPE(AddMeshPaintPass);
 
 	if (!InRenderTargets.IsValidForRendering() || InParameters.PrimitivesToRender.IsEmpty())
 	{
 		return false;
 	}
 
+	const int32 ArraySize = GetRenderTargetArraySize(InRenderTargets);
+	if (ArraySize == INDEX_NONE)
+	{
+		UE_LOG(LogMeshPaintRender, Warning, TEXT("Mesh paint targets mix 2D and array render targets or differ in slice count"));
+		return false;
+	}
+	if (ArraySize > 0 && IsMeshPaintBlendModeProgrammable(InParameters.BlendMode))
+	{
+		UE_LOG(LogMeshPaintRender, Warning, TEXT("Programmable mesh paint blend modes are not supported with array render targets"));
+		return false;
+	}
+
+	// Array targets are painted in one layered pass when the vertex shader can select the slice, else with a pass per slice.
+	// The platform check matches the compile condition of the layered permutation, the RHI flag covers devices of the platform without the feature
+	const bool bLayered = ArraySize > 0 && MeshPaintSupportsLayeredDraws(GMaxRHIShaderPlatform) && GRHISupportsArrayIndexFromAnyShader;
+	TArray<int32, TInlineAllocator<16>> PassSlices;
+	if (ArraySize > 0 && !bLayered)
+	{
+		for (const FMeshPaintProxyRenderParameters& PrimitiveInfo : InParameters.PrimitivesToRender)
+		{
+			if (PrimitiveInfo.ArraySlice >= 0 && PrimitiveInfo.ArraySlice < ArraySize)
+			{
+				PassSlices.AddUnique(PrimitiveInfo.ArraySlice);
+			}
+		}
+	}
+	else
+	{
+		PassSlices.Add(INDEX_NONE);
+	}
+	if (PassSlices.IsEmpty())
+	{
+		return false;
+	}
+
+	RDG_EVENT_SCOPE(GraphBuilder, "MeshPaint");
+	RDG_GPU_STAT_SCOPE(GraphBuilder, MeshPaintPass);
+
 #if (!UE_BUILD_SHIPPING && !UE_BUILD_TEST)
 	RenderCaptureInterface::FScopedCapture RenderCapture(RenderCaptureDraws > 0, GraphBuilder);
 	RenderCaptureDraws = FMath::Max(0, RenderCaptureDraws - 1);
@@ -203,80 +343,338 @@ bool MeshPaintRender::AddMeshPaintPass(FRDGBuilder& GraphBuilder, const FMeshPai
 	FScenePrimitiveRenderingContextScopeHelper ScenePrimitiveRenderingContextScopeHelper(GetRendererModule().BeginScenePrimitiveRendering(GraphBuilder, &ViewFamily));
 
 	FIntPoint ViewSize = InRenderTargets.GetPrimaryRenderTarget()->GetSizeXY();
-	
-	FSceneViewInitOptions ViewInitOptions;
-	*static_cast<FSceneViewProjectionData*>(&ViewInitOptions) = InParameters.ViewProjection;
-	ViewInitOptions.ViewFamily = &ViewFamily;
-	ViewInitOptions.SetViewRectangle(FIntRect(FIntPoint::ZeroValue, ViewSize));
-	ViewInitOptions.bIsSceneCapture = true;
+	FSceneView* View = nullptr;
+	{
+		MESH_PAINT_SCOPED_STAGE(CreateView);
 
-	GetRendererModule().CreateAndInitSingleView(GraphBuilder.RHICmdList, &ViewFamily, &ViewInitOptions);
-	FSceneView* View = (FSceneView*)ViewFamily.Views[0];
+		FSceneViewInitOptions ViewInitOptions;
+		*static_cast<FSceneViewProjectionData*>(&ViewInitOptions) = InParameters.ViewProjection;
+		ViewInitOptions.ViewFamily = &ViewFamily;
+		ViewInitOptions.SetViewRectangle(FIntRect(FIntPoint::ZeroValue, ViewSize));
+		ViewInitOptions.bIsSceneCapture = true;
 
-	ViewFamily.EngineShowFlags.SetToneCurve(false);
+		GetRendererModule().CreateAndInitSingleView(GraphBuilder.RHICmdList, &ViewFamily, &ViewInitOptions);
+		View = (FSceneView*)ViewFamily.Views[0];
 
-	// This flags sets tonemapper to output to ETonemapperOutputDevice::LinearNoToneCurve
-	View->FinalPostProcessSettings.bOverride_ToneCurveAmount = 1;
-	View->FinalPostProcessSettings.ToneCurveAmount = 0.0;
+		ViewFamily.EngineShowFlags.SetToneCurve(false);
+
+		// This flags sets tonemapper to output to ETonemapperOutputDevice::LinearNoToneCurve
+		View->FinalPostProcessSettings.bOverride_ToneCurveAmount = 1;
+		View->FinalPostProcessSettings.ToneCurveAmount = 0.0;
+	}
+
+	MESH_PAINT_SCOPED_STAGE(MeshPassSetup);
 
 	FMeshPaintShaderParameters* PassParameters = GraphBuilder.AllocParameters<FMeshPaintShaderParameters>();
 	PassParameters->View = View->ViewUniformBuffer;
 	PassParameters->Scene = GetSceneUniformBufferRef(GraphBuilder, *View);
 	PassParameters->InstanceCulling = FInstanceCullingContext::CreateDummyInstanceCullingUniformBuffer(GraphBuilder);
 
+	// Stamps are uploaded once and evaluated per texel in translated world space. Each draw loops over its range of stamps only
+	const FVector PreViewTranslation = View->ViewMatrices.GetPreViewTranslation();
+	TArray<FUintVector2, TInlineAllocator<16>> StampRanges;
+	StampRanges.SetNumZeroed(InParameters.PrimitivesToRender.Num());
+	if (InParameters.GPUBrushStamps.IsValid() && InParameters.MaxGPUBrushStamps > 0)
+	{
+		for (FUintVector2& StampRange : StampRanges)
+		{
+			StampRange = FUintVector2(0, InParameters.MaxGPUBrushStamps);
+		}
+
+		FMeshPaintBrushParameters* BrushParameters = GraphBuilder.AllocParameters<FMeshPaintBrushParameters>();
+		BrushParameters->Stamps = GraphBuilder.CreateSRV(GraphBuilder.RegisterExternalBuffer(InParameters.GPUBrushStamps));
+		BrushParameters->NumStamps = InParameters.MaxGPUBrushStamps;
+		BrushParameters->bEndAtZeroRadius = 1;
+		BrushParameters->StampOffset = FVector3f(InParameters.GPUBrushStampOrigin + PreViewTranslation);
+		BrushParameters->SurfaceId = InParameters.BrushSurfaceId;
+		BrushParameters->ShapeTextures = GBlackArrayTexture->TextureRHI;
+		BrushParameters->ShapeSampler = TStaticSamplerState<SF_Trilinear, AM_Clamp, AM_Clamp, AM_Clamp>::GetRHI();
+		PassParameters->MeshPaintBrush = GraphBuilder.CreateUniformBuffer(BrushParameters);
+	}
+	else if (!InParameters.BrushStamps.IsEmpty())
+	{
+		// Stamps of every shape go in the same buffer, they only differ by their slice of the shape array
+		const int32 NumShapes = InParameters.BrushShapes && InParameters.BrushShapes->TextureRHI ? InParameters.BrushShapes->TextureRHI->GetDesc().ArraySize : 0;
+
+		// Stamps are grouped per primitive and culled against its bounds, empty ones are dropped. A stamp overlapping several primitives is uploaded once per primitive
+		TArray<FVector4f> StampData;
+		StampData.Reserve(InParameters.BrushStamps.Num() * 3);
+		for (int32 PrimitiveIndex = 0; PrimitiveIndex < InParameters.PrimitivesToRender.Num(); ++PrimitiveIndex)
+		{
+			const FBox PrimitiveBounds = InParameters.PrimitivesToRender[PrimitiveIndex].PrimitiveProxy->GetBounds().GetBox();
+			const uint32 FirstStamp = StampData.Num() / 3;
+			for (const FMeshPaintRenderBrushStamp& Stamp : InParameters.BrushStamps)
+			{
+				if (Stamp.Radius <= 0.0f || !FMath::SphereAABBIntersection(FSphere(Stamp.Location, Stamp.Radius), PrimitiveBounds)) continue;
+
+				const float HardRadius = Stamp.Radius * FMath::Clamp(Stamp.Hardness, 0.0f, 1.0f);
+				const uint32 ShapeId = Stamp.ShapeIndex >= 0 && Stamp.ShapeIndex < NumShapes ? (uint32)Stamp.ShapeIndex + 1 : 0;
+				const FQuat4f Orientation(Stamp.Orientation.GetNormalized());
+				StampData.Emplace(FVector3f(Stamp.Location + PreViewTranslation), Stamp.Radius);
+				StampData.Emplace(1.0f / FMath::Max(Stamp.Radius - HardRadius, UE_SMALL_NUMBER), FMath::Clamp(Stamp.Strength, 0.0f, 1.0f), 0.0f, FMath::AsFloat(ShapeId));
+				StampData.Emplace(Orientation.X, Orientation.Y, Orientation.Z, Orientation.W);
+			}
+			StampRanges[PrimitiveIndex] = FUintVector2(FirstStamp, StampData.Num() / 3 - FirstStamp);
+		}
+
+		if (StampData.IsEmpty())
+		{
+			// No stamp reaches any primitive, a pass clearing the targets still runs without draws
+			if (!InParameters.bClearTargets) return false;
+			StampData.SetNumZeroed(3);
+		}
+
+		FRDGBufferRef StampBuffer = CreateStructuredBuffer(GraphBuilder, TEXT("MeshPaintBrushStamps"), sizeof(FVector4f), StampData.Num(), StampData.GetData(), StampData.Num() * sizeof(FVector4f));
+
+		FMeshPaintBrushParameters* BrushParameters = GraphBuilder.AllocParameters<FMeshPaintBrushParameters>();
+		BrushParameters->Stamps = GraphBuilder.CreateSRV(StampBuffer);
+		BrushParameters->NumStamps = StampData.Num() / 3;
+		BrushParameters->bEndAtZeroRadius = 0;
+		BrushParameters->StampOffset = FVector3f::ZeroVector;
+		BrushParameters->SurfaceId = InParameters.BrushSurfaceId;
+		BrushParameters->ShapeTextures = NumShapes > 0 ? InParameters.BrushShapes->TextureRHI.GetReference() : GBlackArrayTexture->TextureRHI.GetReference();
+		BrushParameters->ShapeSampler = TStaticSamplerState<SF_Trilinear, AM_Clamp, AM_Clamp, AM_Clamp>::GetRHI();
+		PassParameters->MeshPaintBrush = GraphBuilder.CreateUniformBuffer(BrushParameters);
+	}
+
+	// Depth rendered by an earlier command from the same projector
+	if (InParameters.ProjectionDepth.IsValid() && InParameters.ProjectionDepth->Texture.IsValid())
+	{
+		FMeshPaintProjectionParameters* ProjectionParameters = GraphBuilder.AllocParameters<FMeshPaintProjectionParameters>();
+		ProjectionParameters->DepthTexture = GraphBuilder.RegisterExternalTexture(InParameters.ProjectionDepth->Texture);
+		ProjectionParameters->DepthSampler = TStaticSamplerState<SF_Point, AM_Clamp, AM_Clamp, AM_Clamp>::GetRHI();
+		ProjectionParameters->DepthBias = FMath::Max(InParameters.ProjectionDepthBias, 0.0f);
+		ProjectionParameters->bEnabled = 1;
+		PassParameters->MeshPaintProjection = GraphBuilder.CreateUniformBuffer(ProjectionParameters);
+	}
+	else if (InParameters.ProjectionDepth.IsValid())
+	{
+		UE_LOG(LogMeshPaintRender, Warning, TEXT("Occlusion tested mesh paint pass without a projection depth, the pass is skipped"));
+		return false;
+	}
+	else
+	{
+		// The occlusion test is a uniform branch, passes without a projector bind it disabled
+		FMeshPaintProjectionParameters* ProjectionParameters = GraphBuilder.AllocParameters<FMeshPaintProjectionParameters>();
+		ProjectionParameters->DepthTexture = GraphBuilder.RegisterExternalTexture(CreateRenderTarget(GBlackTexture->TextureRHI, TEXT("MeshPaintNoProjectionDepth")));
+		ProjectionParameters->DepthSampler = TStaticSamplerState<SF_Point, AM_Clamp, AM_Clamp, AM_Clamp>::GetRHI();
+		ProjectionParameters->DepthBias = 0.0f;
+		ProjectionParameters->bEnabled = 0;
+		PassParameters->MeshPaintProjection = GraphBuilder.CreateUniformBuffer(ProjectionParameters);
+	}
+
+	// Stamps appended on the GPU cull the draws themselves, nothing about them is known here
+	{
+		FMeshPaintStampCounterParameters* CounterParameters = GraphBuilder.AllocParameters<FMeshPaintStampCounterParameters>();
+		if (InParameters.GPUBrushStamps.IsValid() && InParameters.GPUBrushStampCounter.IsValid())
+		{
+			CounterParameters->Counter = GraphBuilder.CreateSRV(GraphBuilder.RegisterExternalBuffer(InParameters.GPUBrushStampCounter), PF_R32_UINT);
+			CounterParameters->StampOffset = FVector3f(InParameters.GPUBrushStampOrigin + PreViewTranslation);
+			CounterParameters->bEnabled = 1;
+		}
+		else
+		{
+			const uint32 NoStamps = 0;
+			CounterParameters->Counter = GraphBuilder.CreateSRV(CreateVertexBuffer(GraphBuilder, TEXT("MeshPaintNoStampCounter"), FRDGBufferDesc::CreateBufferDesc(sizeof(uint32), 1), &NoStamps, sizeof(NoStamps)), PF_R32_UINT);
+			CounterParameters->StampOffset = FVector3f::ZeroVector;
+			CounterParameters->bEnabled = 0;
+		}
+		PassParameters->MeshPaintStampCounter = GraphBuilder.CreateUniformBuffer(CounterParameters);
+	}
+
+	// Union of the painted parts of the atlas cells, draws are scissored to it and programmable blending only processes texels inside it.
+	// Brush passes skip primitives no stamp reaches
+	const bool bBrushPass = PassParameters->MeshPaintBrush != nullptr;
+	FIntRect DirtyRect(ViewSize, FIntPoint::ZeroValue);
+	int64 NumTexels = 0;
+	for (int32 PrimitiveIndex = 0; PrimitiveIndex < InParameters.PrimitivesToRender.Num(); ++PrimitiveIndex)
+	{
+		const FMeshPaintProxyRenderParameters& PrimitiveInfo = InParameters.PrimitivesToRender[PrimitiveIndex];
+		if (bBrushPass && StampRanges[PrimitiveIndex].Y == 0) continue;
+
+		const FBox2D& PaintRegion = PrimitiveInfo.PaintUVBounds.bIsValid ? PrimitiveInfo.PaintUVBounds : PrimitiveInfo.UVRegion;
+		const FVector2D CellMin = PaintRegion.Min.ComponentMax(FVector2D::Zero()) * FVector2D(ViewSize);
+		const FVector2D CellMax = PaintRegion.Max.ComponentMin(FVector2D::One()) * FVector2D(ViewSize);
+		DirtyRect.Min = DirtyRect.Min.ComponentMin(FIntPoint(FMath::FloorToInt32(CellMin.X), FMath::FloorToInt32(CellMin.Y)));
+		DirtyRect.Max = DirtyRect.Max.ComponentMax(FIntPoint(FMath::CeilToInt32(CellMax.X), FMath::CeilToInt32(CellMax.Y)));
+
+		const FVector2D CellSize = (CellMax - CellMin).ComponentMax(FVector2D::Zero());
+		NumTexels += (int64)CellSize.X * (int64)CellSize.Y;
+	}
+	DirtyRect.Clip(FIntRect(FIntPoint::ZeroValue, ViewSize));
+
 	const bool bClearTargets = InParameters.bClearTargets;
+	const bool bProgrammableBlend = IsMeshPaintBlendModeProgrammable(InParameters.BlendMode);
 	EMeshPaintShaderOutputBits ActiveOutputs = EMeshPaintShaderOutputBits::None;
 	int32 MRTIndex = 0;
-	if (InRenderTargets.HasTargetOfType(FMeshPaintRenderTargets::RT_BaseColor))
+	int32 BytesPerTexel = 0;
+
+	// Programmable blend modes rasterize into scratch targets which are combined with the destinations afterwards
+	TArray<TPair<FRDGTextureRef, FRDGTextureRef>, TInlineAllocator<3>> ScratchToDestination;
+
+	auto AddOutput = [&](FTextureRenderTargetResource* RenderTarget, const TCHAR* Name, EMeshPaintShaderOutputBits OutputBit)
 	{
-		FRDGTextureRef OutputTexture = GraphBuilder.RegisterExternalTexture(CreateRenderTarget(InRenderTargets.BaseColor->GetRenderTargetTexture(), TEXT("MeshPaintBCOutputTexture")));
-		PassParameters->RenderTargets[MRTIndex] = FRenderTargetBinding(OutputTexture, bClearTargets ? ERenderTargetLoadAction::EClear : ERenderTargetLoadAction::ELoad);
-		ActiveOutputs |= EMeshPaintShaderOutputBits::BaseColor;
+		FRDGTextureRef OutputTexture = GraphBuilder.RegisterExternalTexture(CreateRenderTarget(RenderTarget->GetRenderTargetTexture(), Name));
+		BytesPerTexel += GPixelFormats[OutputTexture->Desc.Format].BlockBytes;
+
+		if (bProgrammableBlend)
+		{
+			if (bClearTargets)
+			{
+				AddClearRenderTargetPass(GraphBuilder, OutputTexture);
+			}
+
+			FRDGTextureRef ScratchTexture = FMeshPaintRenderTargetPool::Get().RegisterFreeElement(GraphBuilder, ViewSize, MeshPaintRender::GetProgrammableBlendScratchFormat(OutputTexture->Desc.Format), TexCreate_RenderTargetable | TexCreate_ShaderResource, TEXT("MeshPaintScratchTexture"));
+			ScratchToDestination.Emplace(ScratchTexture, OutputTexture);
+			PassParameters->RenderTargets[MRTIndex] = FRenderTargetBinding(ScratchTexture, ERenderTargetLoadAction::EClear);
+		}
+		else if (bClearTargets && PassSlices[0] != INDEX_NONE)
+		{
+			// Slices without primitives have to be cleared as well
+			AddClearRenderTargetPass(GraphBuilder, OutputTexture);
+			PassParameters->RenderTargets[MRTIndex] = FRenderTargetBinding(OutputTexture, ERenderTargetLoadAction::ELoad);
+		}
+		else
+		{
+			PassParameters->RenderTargets[MRTIndex] = FRenderTargetBinding(OutputTexture, bClearTargets ? ERenderTargetLoadAction::EClear : ERenderTargetLoadAction::ELoad);
+		}
+		ActiveOutputs |= OutputBit;
 		MRTIndex++;
+	};
+
+	if (InRenderTargets.HasChannels())
+	{
+		for (FTextureRenderTargetResource* Channel : InRenderTargets.Channels)
+		{
+			AddOutput(Channel, TEXT("MeshPaintChannelOutputTexture"), EMeshPaintShaderOutputBits::None);
+		}
 	}
-	if (InRenderTargets.HasTargetOfType(FMeshPaintRenderTargets::RT_Emissive))
+	else
 	{
-		FRDGTextureRef OutputTexture = GraphBuilder.RegisterExternalTexture(CreateRenderTarget(InRenderTargets.Emissive->GetRenderTargetTexture(), TEXT("MeshPaintEmissiveOutputTexture")));
-		PassParameters->RenderTargets[MRTIndex] = FRenderTargetBinding(OutputTexture, bClearTargets ? ERenderTargetLoadAction::EClear : ERenderTargetLoadAction::ELoad);
-		ActiveOutputs |= EMeshPaintShaderOutputBits::Emissive;
-		MRTIndex++;
+		if (InRenderTargets.HasTargetOfType(FMeshPaintRenderTargets::RT_BaseColor))
+		{
+			AddOutput(InRenderTargets.BaseColor, TEXT("MeshPaintBCOutputTexture"), EMeshPaintShaderOutputBits::BaseColor);
+		}
+		if (InRenderTargets.HasTargetOfType(FMeshPaintRenderTargets::RT_Emissive))
+		{
+			AddOutput(InRenderTargets.Emissive, TEXT("MeshPaintEmissiveOutputTexture"), EMeshPaintShaderOutputBits::Emissive);
+		}
+		if (InRenderTargets.HasTargetOfType(FMeshPaintRenderTargets::RT_NormalMap))
+		{
+			AddOutput(InRenderTargets.NormalMap, TEXT("MeshPaintNormalOutputTexture"), EMeshPaintShaderOutputBits::Normal);
+		}
 	}
-	if (InRenderTargets.HasTargetOfType(FMeshPaintRenderTargets::RT_NormalMap))
+
+	// Texels touched are estimated from the painted parts of the atlas cells, a cleared target is written in full
+	NumTexels = bClearTargets ? (int64)ViewSize.X * ViewSize.Y : FMath::Min(NumTexels, (int64)ViewSize.X * ViewSize.Y);
+	MeshPaintStats::AddPassCounters(InParameters.PrimitivesToRender.Num(), 0, NumTexels, NumTexels * BytesPerTexel);
+
+	const TArray<EMeshPaintChannelSource, TFixedAllocator<MESH_PAINT_MAX_CHANNELS>> ChannelSources = InRenderTargets.ChannelSources;
+
+	// Reference poses are resolved while the graph is built, the draw lambdas may run on other threads. A LOD streamed out
+	// since the game thread picked it is painted through the regular mesh batches instead
+	TArray<const FMeshPaintReferencePoseMesh*, TInlineAllocator<16>> ReferencePoses;
+	ReferencePoses.SetNumZeroed(InParameters.PrimitivesToRender.Num());
+	for (int32 PrimitiveIndex = 0; PrimitiveIndex < InParameters.PrimitivesToRender.Num(); ++PrimitiveIndex)
 	{
-		FRDGTextureRef OutputTexture = GraphBuilder.RegisterExternalTexture(CreateRenderTarget(InRenderTargets.NormalMap->GetRenderTargetTexture(), TEXT("MeshPaintNormalOutputTexture")));
-		PassParameters->RenderTargets[MRTIndex] = FRenderTargetBinding(OutputTexture, bClearTargets ? ERenderTargetLoadAction::EClear : ERenderTargetLoadAction::ELoad);
-		ActiveOutputs |= EMeshPaintShaderOutputBits::Normal;
-		MRTIndex++;
+		const FMeshPaintProxyRenderParameters& PrimitiveInfo = InParameters.PrimitivesToRender[PrimitiveIndex];
+		const FSkeletalMeshObject* MeshObject = PrimitiveInfo.bReferencePose ? GetSkinnedMeshObject(PrimitiveInfo) : nullptr;
+		if (MeshObject && PrimitiveInfo.TargetLOD >= PrimitiveInfo.PrimitiveProxy->GetCurrentFirstLODIdx_RenderThread())
+		{
+			ReferencePoses[PrimitiveIndex] = FMeshPaintReferencePoseMesh::FindOrCreate(GraphBuilder.RHICmdList, MeshObject->GetSkeletalMeshRenderData(), PrimitiveInfo.TargetLOD);
+		}
 	}
 
-	GraphBuilder.AddPass(RDG_EVENT_NAME("MeshPaintRender::MeshPaintPass %dx%d", ViewSize.X, ViewSize.Y),
-		PassParameters,
-		ERDGPassFlags::Raster | ERDGPassFlags::NeverCull,
-		[=, &InParameters](FRHICommandList& RHICmdList)
+	for (const int32 PassSlice : PassSlices)
+	{
+		FMeshPaintShaderParameters* SlicePassParameters = PassParameters;
+		if (PassSlice != INDEX_NONE)
 		{
-			FIntRect ViewRect = View->UnscaledViewRect;
-			RHICmdList.SetViewport(ViewRect.Min.X, ViewRect.Min.Y, 0.0f, ViewRect.Max.X, ViewRect.Max.Y, 1.0f);
+			SlicePassParameters = GraphBuilder.AllocParameters<FMeshPaintShaderParameters>();
+			*SlicePassParameters = *PassParameters;
+			for (int32 SlotIndex = 0; SlotIndex < MRTIndex; ++SlotIndex)
+			{
+				const FRenderTargetBinding& Binding = PassParameters->RenderTargets[SlotIndex];
+				SlicePassParameters->RenderTargets[SlotIndex] = FRenderTargetBinding(Binding.GetTexture(), Binding.GetLoadAction(), 0, (int16)PassSlice);
+			}
+		}
 
-			DrawDynamicMeshPass(*View, RHICmdList, [=, &InParameters](FDynamicPassMeshDrawListContext* DynamicMeshPassContext)
+		GraphBuilder.AddPass(RDG_EVENT_NAME("MeshPaintRender::MeshPaintPass %dx%d Slice %d", ViewSize.X, ViewSize.Y, PassSlice),
+			SlicePassParameters,
+			ERDGPassFlags::Raster | ERDGPassFlags::NeverCull,
+			[=, &InParameters](FRHICommandList& RHICmdList)
 			{
-				FMeshPaintPassProcessor MeshPassProcessor(View, DynamicMeshPassContext, InParameters.PrimitivesToRender, InParameters.MaterialOverride, ActiveOutputs);
-				for (const FMeshPaintProxyRenderParameters& PrimitiveInfo : InParameters.PrimitivesToRender)
+				FIntRect ViewRect = View->UnscaledViewRect;
+				RHICmdList.SetViewport(ViewRect.Min.X, ViewRect.Min.Y, 0.0f, ViewRect.Max.X, ViewRect.Max.Y, 1.0f);
+				if (DirtyRect.Area() > 0)
 				{
-					//PrimitiveInfo.PrimitiveProxy->DrawStaticElements();
+					RHICmdList.SetScissorRect(true, DirtyRect.Min.X, DirtyRect.Min.Y, DirtyRect.Max.X, DirtyRect.Max.Y);
+				}
+
+				MESH_PAINT_SCOPED_STAGE(DrawCommands);
 
-					FPrimitiveSceneInfo* PrimitiveSceneInfo = PrimitiveInfo.PrimitiveProxy->GetPrimitiveSceneInfo();
-					const uint8 MaxLOD = PrimitiveSceneInfo->StaticMeshes.Num() - 1;
-					const uint8 MinLOD = PrimitiveInfo.PrimitiveProxy->GetCurrentFirstLODIdx_RenderThread();
-					const uint8 RenderLOD = FMath::Clamp(PrimitiveInfo.TargetLOD, MinLOD, MaxLOD);
+				FRHIUniformBuffer* BrushParameters = SlicePassParameters->MeshPaintBrush ? SlicePassParameters->MeshPaintBrush->GetRHI() : nullptr;
+				FRHIUniformBuffer* ProjectionParameters = SlicePassParameters->MeshPaintProjection ? SlicePassParameters->MeshPaintProjection->GetRHI() : nullptr;
+				FRHIUniformBuffer* StampCounterParameters = SlicePassParameters->MeshPaintStampCounter ? SlicePassParameters->MeshPaintStampCounter->GetRHI() : nullptr;
 
-					if (const FMeshBatch* MeshBatch = PrimitiveSceneInfo->GetMeshBatch(RenderLOD))
+				DrawDynamicMeshPass(*View, RHICmdList, [=, &InParameters](FDynamicPassMeshDrawListContext* DynamicMeshPassContext)
+				{
+					FMeshPaintPassProcessor MeshPassProcessor(View, DynamicMeshPassContext, InParameters.PrimitivesToRender, StampRanges, InParameters.MaterialOverride, ActiveOutputs, InParameters.BlendMode, ChannelSources, bLayered, BrushParameters, ProjectionParameters, StampCounterParameters);
+					for (int32 PrimitiveIndex = 0; PrimitiveIndex < InParameters.PrimitivesToRender.Num(); ++PrimitiveIndex)
 					{
-						const uint64 BatchElementMask = ~0ull;
-						MeshPassProcessor.AddMeshBatch(*MeshBatch, BatchElementMask, PrimitiveInfo.PrimitiveProxy);
+						const FMeshPaintProxyRenderParameters& PrimitiveInfo = InParameters.PrimitivesToRender[PrimitiveIndex];
+						if (PassSlice != INDEX_NONE && PrimitiveInfo.ArraySlice != PassSlice) continue;
+						if (ArraySize > 0 && (PrimitiveInfo.ArraySlice < 0 || PrimitiveInfo.ArraySlice >= ArraySize)) continue;
+						if (BrushParameters && StampRanges[PrimitiveIndex].Y == 0) continue;
+
+						//PrimitiveInfo.PrimitiveProxy->DrawStaticElements();
+
+						// Reference pose goes through a local vertex factory, no skinning happens in the paint pass
+						if (const FMeshPaintReferencePoseMesh* ReferencePose = ReferencePoses[PrimitiveIndex])
+						{
+							ReferencePose->ForEachMeshBatch(PrimitiveInfo.PrimitiveProxy, PrimitiveInfo.ReferencePoseMaterials, [&](const FMeshBatch& ReferencePoseBatch)
+							{
+								MeshPassProcessor.AddMeshBatch(ReferencePoseBatch, ~0ull, PrimitiveInfo.PrimitiveProxy);
+							});
+							continue;
+						}
+
+						FPrimitiveSceneInfo* PrimitiveSceneInfo = PrimitiveInfo.PrimitiveProxy->GetPrimitiveSceneInfo();
+						const uint8 MaxLOD = PrimitiveSceneInfo->StaticMeshes.Num() - 1;
+						const uint8 MinLOD = PrimitiveInfo.PrimitiveProxy->GetCurrentFirstLODIdx_RenderThread();
+						const uint8 RenderLOD = FMath::Clamp(PrimitiveInfo.TargetLOD, MinLOD, MaxLOD);
+
+						if (const FMeshBatch* MeshBatch = PrimitiveSceneInfo->GetMeshBatch(RenderLOD))
+						{
+							const uint64 BatchElementMask = ~0ull;
+
+							// With the skin cache the passthrough vertex factory reads positions skinned earlier in the frame
+							const FSkeletalMeshObject* SkinnedMeshObject = GMeshPaintUseSkinCache ? GetSkinnedMeshObject(PrimitiveInfo) : nullptr;
+							if (SkinnedMeshObject)
+							{
+								const FVertexFactory* SkinCacheVertexFactory = SkinnedMeshObject->GetSkinVertexFactory(View, RenderLOD, MeshBatch->SegmentIndex, ESkinVertexFactoryMode::Default);
+								if (SkinCacheVertexFactory && SkinCacheVertexFactory != MeshBatch->VertexFactory)
+								{
+									FMeshBatch SkinCacheBatch(*MeshBatch);
+									SkinCacheBatch.VertexFactory = SkinCacheVertexFactory;
+									if (MeshPassProcessor.TryAddMeshBatch(SkinCacheBatch, BatchElementMask, PrimitiveInfo.PrimitiveProxy)) continue;
+								}
+							}
+
+							MeshPassProcessor.AddMeshBatch(*MeshBatch, BatchElementMask, PrimitiveInfo.PrimitiveProxy);
+						}
 					}
-				}
+
+					MeshPaintStats::AddPassCounters(0, MeshPassProcessor.GetNumDraws(), 0, 0);
+				});
+				RHICmdList.SetScissorRect(false, 0, 0, 0, 0);
 			});
-		});
+	}
+
+	for (const TPair<FRDGTextureRef, FRDGTextureRef>& Pair : ScratchToDestination)
+	{
+		MeshPaintRender::AddProgrammableBlendPass(GraphBuilder, Pair.Key, Pair.Value, DirtyRect, InParameters.BlendMode, InParameters.BlendThreshold);
+	}
 
 	return true;
 }
@@ -0,0 +1,142 @@
+#include "MeshPainterRenderTargetPool.h"
+#include "MeshPainterStats.h"
+#include "RenderGraphBuilder.h"
+#include "RenderTargetPool.h"
+
+static int32 GMeshPaintPoolFramesUntilRelease = 30;
+static FAutoConsoleVariableRef CVarMeshPaintPoolFramesUntilRelease(
+	TEXT("r.MeshPaint.RenderTargetPool.FramesUntilRelease"),
+	GMeshPaintPoolFramesUntilRelease,
+	TEXT("Number of frames an unused intermediate paint buffer stays in the pool"));
+
+static int32 GMeshPaintPoolMinBucketSize = 16;
+static FAutoConsoleVariableRef CVarMeshPaintPoolMinBucketSize(
+	TEXT("r.MeshPaint.RenderTargetPool.MinBucketSize"),
+	GMeshPaintPoolMinBucketSize,
+	TEXT("Smallest extent intermediate paint buffers are rounded up to"));
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Pool targets"), STAT_MeshPaint_PoolElements, STATGROUP_MeshPaint);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Pool targets in use"), STAT_MeshPaint_PoolElementsInUse, STATGROUP_MeshPaint);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Pool targets peak"), STAT_MeshPaint_PoolElementsPeak, STATGROUP_MeshPaint);
+DECLARE_MEMORY_STAT(TEXT("Pool memory"), STAT_MeshPaint_PoolMemory, STATGROUP_MeshPaint);
+DECLARE_MEMORY_STAT(TEXT("Pool memory peak"), STAT_MeshPaint_PoolMemoryPeak, STATGROUP_MeshPaint);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Transient textures"), STAT_MeshPaint_TransientTextures, STATGROUP_MeshPaint);
+
+FMeshPaintRenderTargetPool& FMeshPaintRenderTargetPool::Get()
+{
+	static FMeshPaintRenderTargetPool Pool;
+	return Pool;
+}
+
+FIntPoint FMeshPaintRenderTargetPool::GetBucketExtent(FIntPoint Extent)
+{
+	const uint32 MinSize = (uint32)FMath::Max(GMeshPaintPoolMinBucketSize, 1);
+	return FIntPoint(
+		(int32)FMath::RoundUpToPowerOfTwo(FMath::Max((uint32)FMath::Max(Extent.X, 1), MinSize)),
+		(int32)FMath::RoundUpToPowerOfTwo(FMath::Max((uint32)FMath::Max(Extent.Y, 1), MinSize)));
+}
+
+TRefCountPtr<IPooledRenderTarget> FMeshPaintRenderTargetPool::FindFreeElement(FIntPoint Extent, EPixelFormat Format, ETextureCreateFlags Flags, const TCHAR* Name)
+{
+	check(IsInRenderingThread());
+
+	const FIntPoint BucketExtent = GetBucketExtent(Extent);
+
+	for (FElement& Element : Elements)
+	{
+		// Only the pool holds a reference to free elements
+		if (Element.RenderTarget->GetRefCount() != 1) continue;
+		if (Element.Extent != BucketExtent || Element.Format != Format || Element.Flags != Flags) continue;
+
+		Element.LastUsedFrame = FrameNumber;
+		TRefCountPtr<IPooledRenderTarget> Result = Element.RenderTarget;
+		UpdateStats();
+		return Result;
+	}
+
+	const FRDGTextureDesc Desc = FRDGTextureDesc::Create2D(BucketExtent, Format, FClearValueBinding::Transparent, Flags);
+
+	FElement& Element = Elements.AddDefaulted_GetRef();
+	Element.RenderTarget = AllocatePooledTexture(Desc, Name);
+	Element.Extent = BucketExtent;
+	Element.Format = Format;
+	Element.Flags = Flags;
+	Element.LastUsedFrame = FrameNumber;
+	Element.SizeInBytes = Element.RenderTarget->ComputeMemorySize();
+	TRefCountPtr<IPooledRenderTarget> Result = Element.RenderTarget;
+	UpdateStats();
+	return Result;
+}
+
+FRDGTextureRef FMeshPaintRenderTargetPool::RegisterFreeElement(FRDGBuilder& GraphBuilder, FIntPoint Extent, EPixelFormat Format, ETextureCreateFlags Flags, const TCHAR* Name)
+{
+	return GraphBuilder.RegisterExternalTexture(FindFreeElement(Extent, Format, Flags, Name), Name);
+}
+
+void FMeshPaintRenderTargetPool::TickPoolElements()
+{
+	check(IsInRenderingThread());
+
+	++FrameNumber;
+	for (int32 Index = Elements.Num() - 1; Index >= 0; --Index)
+	{
+		FElement& Element = Elements[Index];
+		if (Element.RenderTarget->GetRefCount() != 1)
+		{
+			Element.LastUsedFrame = FrameNumber;
+		}
+		else if (FrameNumber - Element.LastUsedFrame > (uint32)FMath::Max(GMeshPaintPoolFramesUntilRelease, 0))
+		{
+			Elements.RemoveAtSwap(Index, 1, false);
+		}
+	}
+	UpdateStats();
+}
+
+void FMeshPaintRenderTargetPool::FreeUnusedResources()
+{
+	check(IsInRenderingThread());
+
+	Elements.RemoveAllSwap([](const FElement& Element) { return Element.RenderTarget->GetRefCount() == 1; });
+	UpdateStats();
+}
+
+FMeshPaintRenderTargetPool::FStats FMeshPaintRenderTargetPool::GetStats() const
+{
+	return Stats;
+}
+
+void FMeshPaintRenderTargetPool::ResetPeakStats()
+{
+	Stats.PeakNumElements = Stats.NumElements;
+	Stats.PeakAllocatedBytes = Stats.AllocatedBytes;
+}
+
+void FMeshPaintRenderTargetPool::UpdateStats()
+{
+	Stats.NumElements = Elements.Num();
+	Stats.NumElementsInUse = 0;
+	Stats.AllocatedBytes = 0;
+	for (const FElement& Element : Elements)
+	{
+		Stats.NumElementsInUse += Element.RenderTarget->GetRefCount() != 1 ? 1 : 0;
+		Stats.AllocatedBytes += Element.SizeInBytes;
+	}
+	Stats.PeakNumElements = FMath::Max(Stats.PeakNumElements, Stats.NumElements);
+	Stats.PeakAllocatedBytes = FMath::Max(Stats.PeakAllocatedBytes, Stats.AllocatedBytes);
+
+	SET_DWORD_STAT(STAT_MeshPaint_PoolElements, Stats.NumElements);
+	SET_DWORD_STAT(STAT_MeshPaint_PoolElementsInUse, Stats.NumElementsInUse);
+	SET_DWORD_STAT(STAT_MeshPaint_PoolElementsPeak, Stats.PeakNumElements);
+	SET_MEMORY_STAT(STAT_MeshPaint_PoolMemory, Stats.AllocatedBytes);
+	SET_MEMORY_STAT(STAT_MeshPaint_PoolMemoryPeak, Stats.PeakAllocatedBytes);
+}
+
+FRDGTextureRef MeshPaintRender::CreateTransientTexture(FRDGBuilder& GraphBuilder, FIntPoint Extent, EPixelFormat Format, const TCHAR* Name, ETextureCreateFlags Flags)
+{
+	INC_DWORD_STAT(STAT_MeshPaint_TransientTextures);
+
+	// Bucketed extents let the transient allocator alias the same memory across paint calls of slightly different sizes
+	const FIntPoint BucketExtent = FMeshPaintRenderTargetPool::GetBucketExtent(Extent);
+	return GraphBuilder.CreateTexture(FRDGTextureDesc::Create2D(BucketExtent, Format, FClearValueBinding::Transparent, Flags), Name);
+}
@@ -1,10 +1,15 @@
 #include "MeshPainterShader.h"
 
+IMPLEMENT_GLOBAL_SHADER_PARAMETER_STRUCT(FMeshPaintBrushParameters, "MeshPaintBrush");
+IMPLEMENT_GLOBAL_SHADER_PARAMETER_STRUCT(FMeshPaintProjectionParameters, "MeshPaintProjection");
+IMPLEMENT_GLOBAL_SHADER_PARAMETER_STRUCT(FMeshPaintStampCounterParameters, "MeshPaintStampCounter");
+
 bool CheckMeshPaintVertexFactoryType(const FVertexFactoryType* VertexFactoryType)
 {
 	return 
 		VertexFactoryType == FindVertexFactoryType(TEXT("FLocalVertexFactory")) ||
 		VertexFactoryType == FindVertexFactoryType(TEXT("FSplineMeshVertexFactory")) ||
 		VertexFactoryType == FindVertexFactoryType(FName(TEXT("TGPUSkinVertexFactoryDefault"), FNAME_Find)) ||
-		VertexFactoryType == FindVertexFactoryType(FName(TEXT("TGPUSkinVertexFactoryUnlimited"), FNAME_Find));
+		VertexFactoryType == FindVertexFactoryType(FName(TEXT("TGPUSkinVertexFactoryUnlimited"), FNAME_Find)) ||
+		VertexFactoryType == FindVertexFactoryType(FName(TEXT("FGPUSkinPassthroughVertexFactory"), FNAME_Find));
 }
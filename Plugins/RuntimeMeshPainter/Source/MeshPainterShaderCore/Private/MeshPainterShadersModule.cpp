@@ -1,5 +1,10 @@
 #include "MeshPainterShadersModule.h"
+#include "MeshPainterStats.h"
+#include "MeshPainterRenderTargetPool.h"
+#include "MeshPainterReferencePose.h"
 #include "Interfaces/IPluginManager.h"
+#include "Misc/CoreDelegates.h"
+#include "RenderingThread.h"
 
 #define LOCTEXT_NAMESPACE "MeshPainterShaderCore"
 
@@ -7,10 +12,27 @@ void FMeshPainterShadersModule::StartupModule()
 {
 	FString PluginShaderDir = FPaths::Combine(IPluginManager::Get().FindPlugin(TEXT("RuntimeMeshPainter"))->GetBaseDir(), TEXT("Shaders"));
 	AddShaderSourceDirectoryMapping(TEXT("/Plugin/RuntimeMeshPainter"), PluginShaderDir);
+
+	EndFrameRTHandle = FCoreDelegates::OnEndFrameRT.AddLambda([]()
+	{
+		MeshPaintStats::PublishFrameCounters();
+		FMeshPaintRenderTargetPool::Get().TickPoolElements();
+	});
 }
 
 void FMeshPainterShadersModule::ShutdownModule()
 {
+	FCoreDelegates::OnEndFrameRT.Remove(EndFrameRTHandle);
+
+	if (GIsRHIInitialized)
+	{
+		ENQUEUE_RENDER_COMMAND(MeshPaintFreeRenderTargetPool)([](FRHICommandListImmediate&)
+		{
+			FMeshPaintReferencePoseMesh::ReleaseAll();
+			FMeshPaintRenderTargetPool::Get().FreeUnusedResources();
+		});
+		FlushRenderingCommands();
+	}
 }
 
 #undef LOCTEXT_NAMESPACE
@@ -0,0 +1,111 @@
+#include "MeshPainterStats.h"
+#include "ProfilingDebugging/CountersTrace.h"
+#include <atomic>
+
+UE_TRACE_CHANNEL_DEFINE(MeshPaintChannel);
+
+DEFINE_STAT(STAT_MeshPaint_EnsureIsComplete);
+DEFINE_STAT(STAT_MeshPaint_SetRenderTarget);
+DEFINE_STAT(STAT_MeshPaint_Enqueue);
+DEFINE_STAT(STAT_MeshPaint_UpdateResource);
+DEFINE_STAT(STAT_MeshPaint_FlushDeferredResourceUpdate);
+DEFINE_STAT(STAT_MeshPaint_CreateView);
+DEFINE_STAT(STAT_MeshPaint_MeshPassSetup);
+DEFINE_STAT(STAT_MeshPaint_DrawCommands);
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Primitives painted"), STAT_MeshPaint_Primitives, STATGROUP_MeshPaint);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Draws"), STAT_MeshPaint_Draws, STATGROUP_MeshPaint);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Texels touched"), STAT_MeshPaint_TexelsTouched, STATGROUP_MeshPaint);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Render target bytes written"), STAT_MeshPaint_BytesWritten, STATGROUP_MeshPaint);
+
+TRACE_DECLARE_INT_COUNTER(MeshPaintPrimitives, TEXT("MeshPaint/Primitives"));
+TRACE_DECLARE_INT_COUNTER(MeshPaintDraws, TEXT("MeshPaint/Draws"));
+TRACE_DECLARE_INT_COUNTER(MeshPaintTexelsTouched, TEXT("MeshPaint/TexelsTouched"));
+TRACE_DECLARE_MEMORY_COUNTER(MeshPaintBytesWritten, TEXT("MeshPaint/RenderTargetBytesWritten"));
+
+namespace MeshPaintStats
+{
+	static std::atomic<bool> bStageTimingEnabled(false);
+	static std::atomic<uint64> StageCycles[(int32)EStage::Num];
+	static std::atomic<uint64> StageCounts[(int32)EStage::Num];
+
+	struct FFrameCounters
+	{
+		std::atomic<int64> Primitives;
+		std::atomic<int64> Draws;
+		std::atomic<int64> Texels;
+		std::atomic<int64> BytesWritten;
+	};
+	static FFrameCounters FrameCounters;
+
+	const TCHAR* GetStageName(EStage Stage)
+	{
+		switch (Stage)
+		{
+		case EStage::EnsureIsComplete: return TEXT("EnsureIsComplete");
+		case EStage::SetRenderTarget: return TEXT("SetRenderTarget");
+		case EStage::Enqueue: return TEXT("Enqueue");
+		case EStage::UpdateResource: return TEXT("UpdateResourceImmediate");
+		case EStage::FlushDeferredResourceUpdate: return TEXT("FlushDeferredResourceUpdate");
+		case EStage::CreateView: return TEXT("CreateView");
+		case EStage::MeshPassSetup: return TEXT("MeshPassSetup");
+		case EStage::DrawCommands: return TEXT("DrawCommands");
+		}
+		return TEXT("Unknown");
+	}
+
+	void SetStageTimingEnabled(bool bEnabled)
+	{
+		bStageTimingEnabled = bEnabled;
+	}
+
+	bool IsStageTimingEnabled()
+	{
+		return bStageTimingEnabled.load(std::memory_order_relaxed);
+	}
+
+	void AddStageCycles(EStage Stage, uint64 Cycles)
+	{
+		StageCycles[(int32)Stage].fetch_add(Cycles, std::memory_order_relaxed);
+		StageCounts[(int32)Stage].fetch_add(1, std::memory_order_relaxed);
+	}
+
+	void GetStageTotals(double OutSeconds[(int32)EStage::Num], uint64 OutCounts[(int32)EStage::Num])
+	{
+		for (int32 StageIndex = 0; StageIndex < (int32)EStage::Num; ++StageIndex)
+		{
+			OutSeconds[StageIndex] = FPlatformTime::ToSeconds64(StageCycles[StageIndex].load());
+			OutCounts[StageIndex] = StageCounts[StageIndex].load();
+		}
+	}
+
+	void ResetStageTotals()
+	{
+		for (int32 StageIndex = 0; StageIndex < (int32)EStage::Num; ++StageIndex)
+		{
+			StageCycles[StageIndex] = 0;
+			StageCounts[StageIndex] = 0;
+		}
+	}
+
+	void AddPassCounters(int64 NumPrimitives, int64 NumDraws, int64 NumTexels, int64 NumBytesWritten)
+	{
+		INC_DWORD_STAT_BY(STAT_MeshPaint_Primitives, NumPrimitives);
+		INC_DWORD_STAT_BY(STAT_MeshPaint_Draws, NumDraws);
+		INC_DWORD_STAT_BY(STAT_MeshPaint_TexelsTouched, NumTexels);
+		INC_DWORD_STAT_BY(STAT_MeshPaint_BytesWritten, NumBytesWritten);
+
+		FrameCounters.Primitives.fetch_add(NumPrimitives, std::memory_order_relaxed);
+		FrameCounters.Draws.fetch_add(NumDraws, std::memory_order_relaxed);
+		FrameCounters.Texels.fetch_add(NumTexels, std::memory_order_relaxed);
+		FrameCounters.BytesWritten.fetch_add(NumBytesWritten, std::memory_order_relaxed);
+	}
+
+	void PublishFrameCounters()
+	{
+		TRACE_COUNTER_SET(MeshPaintPrimitives, FrameCounters.Primitives.exchange(0));
+		TRACE_COUNTER_SET(MeshPaintDraws, FrameCounters.Draws.exchange(0));
+		TRACE_COUNTER_SET(MeshPaintTexelsTouched, FrameCounters.Texels.exchange(0));
+		TRACE_COUNTER_SET(MeshPaintBytesWritten, FrameCounters.BytesWritten.exchange(0));
+	}
+}
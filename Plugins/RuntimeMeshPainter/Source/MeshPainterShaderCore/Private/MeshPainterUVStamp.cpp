@@ -0,0 +1,121 @@
+#include "MeshPainterRender.h"
+#include "MeshPainterBlend.h"
+#include "MeshPainterRenderTargetPool.h"
+#include "MeshPainterStats.h"
+#include "GlobalShader.h"
+#include "ShaderParameterStruct.h"
+#include "ShaderPermutation.h"
+#include "DataDrivenShaderPlatformInfo.h"
+#include "PixelShaderUtils.h"
+#include "RenderGraphBuilder.h"
+#include "RenderGraphUtils.h"
+#include "TextureResource.h"
+
+class FMeshPaintUVStampPS : public FGlobalShader
+{
+public:
+	DECLARE_GLOBAL_SHADER(FMeshPaintUVStampPS);
+	SHADER_USE_PARAMETER_STRUCT(FMeshPaintUVStampPS, FGlobalShader);
+
+	class FIslandMask : SHADER_PERMUTATION_BOOL("ISLAND_MASK");
+	using FPermutationDomain = TShaderPermutationDomain<FIslandMask>;
+
+	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+		SHADER_PARAMETER(FVector2f, StampCenter)
+		SHADER_PARAMETER(FVector2f, StampInvRadius)
+		SHADER_PARAMETER(float, StampInvFalloff)
+		SHADER_PARAMETER(float, StampStrength)
+		SHADER_PARAMETER(FVector4f, StampColor)
+		SHADER_PARAMETER(FVector2f, TargetOffset)
+		SHADER_PARAMETER_TEXTURE(Texture2D<float2>, CoverageTexture)
+		SHADER_PARAMETER(FIntPoint, CoverageSize)
+		SHADER_PARAMETER(FVector4f, CellRect)
+		SHADER_PARAMETER(float, IslandId)
+		RENDER_TARGET_BINDING_SLOTS()
+	END_SHADER_PARAMETER_STRUCT()
+
+	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+	{
+		return IsFeatureLevelSupported(Parameters.Platform, ERHIFeatureLevel::SM5);
+	}
+};
+
+IMPLEMENT_GLOBAL_SHADER(FMeshPaintUVStampPS, "/Plugin/RuntimeMeshPainter/Private/MeshPaintUVStamp.usf", "MeshPaintUVStampPS", SF_Pixel);
+
+bool MeshPaintRender::AddUVStampPass(FRHICommandListImmediate& RHICmdList, FTextureRenderTargetResource* RenderTarget, const FMeshPaintUVStampParameters& Parameters)
+{
+	FRDGBuilder GraphBuilder(RHICmdList);
+	bool bResult = AddUVStampPass(GraphBuilder, RenderTarget, Parameters);
+	GraphBuilder.Execute();
+	return bResult;
+}
+
+bool MeshPaintRender::AddUVStampPass(FRDGBuilder& GraphBuilder, FTextureRenderTargetResource* RenderTarget, const FMeshPaintUVStampParameters& Parameters)
+{
+	check(IsInRenderingThread());
+	MESH_PAINT_TRACE_SCOPE(AddUVStampPass);
+
+	if (!RenderTarget || !RenderTarget->GetRenderTargetTexture() || Parameters.Radius.X <= 0.0f || Parameters.Radius.Y <= 0.0f || Parameters.Strength <= 0.0f) return false;
+
+	const bool bIslandMask = Parameters.CoverageTexture != nullptr;
+	if (bIslandMask && (!Parameters.CoverageTexture->TextureRHI || Parameters.IslandIndex == INDEX_NONE)) return false;
+
+	FRDGTextureRef OutputTexture = GraphBuilder.RegisterExternalTexture(CreateRenderTarget(RenderTarget->GetRenderTargetTexture(), TEXT("MeshPaintUVStampOutput")));
+	const FIntPoint TargetSize = OutputTexture->Desc.Extent;
+
+	// Only the texels under the stamp run, a stamp costs the same on any mesh and target size
+	FIntRect DirtyRect(
+		FMath::FloorToInt32(Parameters.Center.X - Parameters.Radius.X),
+		FMath::FloorToInt32(Parameters.Center.Y - Parameters.Radius.Y),
+		FMath::CeilToInt32(Parameters.Center.X + Parameters.Radius.X),
+		FMath::CeilToInt32(Parameters.Center.Y + Parameters.Radius.Y));
+	DirtyRect.Clip(FIntRect(FIntPoint::ZeroValue, TargetSize));
+	if (DirtyRect.IsEmpty()) return false;
+
+	// Programmable modes stamp into a scratch target covering the dirty rect only
+	const bool bProgrammableBlend = IsMeshPaintBlendModeProgrammable(Parameters.BlendMode);
+	FRDGTextureRef StampTexture = bProgrammableBlend
+		? FMeshPaintRenderTargetPool::Get().RegisterFreeElement(GraphBuilder, DirtyRect.Size(), MeshPaintRender::GetProgrammableBlendScratchFormat(OutputTexture->Desc.Format), TexCreate_RenderTargetable | TexCreate_ShaderResource, TEXT("MeshPaintUVStampScratch"))
+		: OutputTexture;
+	const FIntPoint StampOffset = bProgrammableBlend ? DirtyRect.Min : FIntPoint::ZeroValue;
+
+	FMeshPaintUVStampPS::FParameters* PassParameters = GraphBuilder.AllocParameters<FMeshPaintUVStampPS::FParameters>();
+	PassParameters->StampCenter = Parameters.Center;
+	PassParameters->StampInvRadius = FVector2f(1.0f / Parameters.Radius.X, 1.0f / Parameters.Radius.Y);
+	PassParameters->StampInvFalloff = 1.0f / FMath::Max(1.0f - FMath::Clamp(Parameters.Hardness, 0.0f, 1.0f), UE_KINDA_SMALL_NUMBER);
+	PassParameters->StampStrength = FMath::Clamp(Parameters.Strength, 0.0f, 1.0f);
+	PassParameters->StampColor = FVector4f(Parameters.Color);
+	PassParameters->TargetOffset = FVector2f(StampOffset);
+	if (bIslandMask)
+	{
+		FRHITexture* CoverageTexture = Parameters.CoverageTexture->TextureRHI;
+		const FVector2f CellMin = FVector2f(Parameters.UVRegion.Min) * FVector2f(TargetSize);
+		const FVector2f CellSize = FVector2f(Parameters.UVRegion.GetSize()) * FVector2f(TargetSize);
+		PassParameters->CoverageTexture = CoverageTexture;
+		PassParameters->CoverageSize = FIntPoint(CoverageTexture->GetSizeXYZ().X, CoverageTexture->GetSizeXYZ().Y);
+		PassParameters->CellRect = FVector4f(CellMin.X, CellMin.Y, CellSize.X, CellSize.Y);
+		PassParameters->IslandId = (float)(Parameters.IslandIndex + 1);
+	}
+	PassParameters->RenderTargets[0] = FRenderTargetBinding(StampTexture, bProgrammableBlend ? ERenderTargetLoadAction::EClear : ERenderTargetLoadAction::ELoad);
+
+	FMeshPaintUVStampPS::FPermutationDomain Permutation;
+	Permutation.Set<FMeshPaintUVStampPS::FIslandMask>(bIslandMask);
+	TShaderMapRef<FMeshPaintUVStampPS> PixelShader(GetGlobalShaderMap(GMaxRHIFeatureLevel), Permutation);
+	FPixelShaderUtils::AddFullscreenPass(
+		GraphBuilder,
+		GetGlobalShaderMap(GMaxRHIFeatureLevel),
+		RDG_EVENT_NAME("MeshPaintRender::UVStamp %dx%d", DirtyRect.Width(), DirtyRect.Height()),
+		PixelShader,
+		PassParameters,
+		DirtyRect - StampOffset,
+		MeshPaintRender::GetMeshPaintBlendState(Parameters.BlendMode));
+
+	if (bProgrammableBlend)
+	{
+		MeshPaintRender::AddProgrammableBlendPass(GraphBuilder, StampTexture, OutputTexture, DirtyRect, Parameters.BlendMode, Parameters.BlendThreshold, StampOffset);
+	}
+
+	const int64 NumTexels = (int64)DirtyRect.Width() * DirtyRect.Height();
+	MeshPaintStats::AddPassCounters(1, 1, NumTexels, NumTexels * GPixelFormats[OutputTexture->Desc.Format].BlockBytes);
+	return true;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Materials/MaterialExpression.h"
+#include "UObject/ObjectMacros.h"
+#include "MaterialExpressionMeshPaintArrayCoordinates.generated.h"
+
+/**
+ * Coordinates for sampling a paint render target array: UV in xy and the slice of the primitive in z.
+ * The slice is read from custom primitive data, see UMeshPainterFunctionLibrary::SetPaintArraySlice.
+ */
+UCLASS(MinimalAPI, collapsecategories, hidecategories = Object)
+class UMaterialExpressionMeshPaintArrayCoordinates : public UMaterialExpression
+{
+	GENERATED_UCLASS_BODY()
+
+	/** UV used for painting, defaults to texture coordinate ConstCoordinate */
+	UPROPERTY(meta = (RequiredInput = "false"))
+	FExpressionInput Coordinates;
+
+	UPROPERTY(EditAnywhere, Category = "MaterialExpressionMeshPaintArrayCoordinates", meta = (OverridingInputProperty = "Coordinates"))
+	int32 ConstCoordinate;
+
+	/** Custom primitive data index holding the slice */
+	UPROPERTY(EditAnywhere, Category = "MaterialExpressionMeshPaintArrayCoordinates")
+	int32 SliceDataIndex;
+
+public:
+#if WITH_EDITOR
+	//~ Begin UMaterialExpression Interface
+	virtual int32 Compile(class FMaterialCompiler* Compiler, int32 OutputIndex) override;
+	virtual void GetCaption(TArray<FString>& OutCaptions) const override;
+	//~ End UMaterialExpression Interface
+#endif
+};
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Materials/MaterialExpressionCustomOutput.h"
+#include "UObject/ObjectMacros.h"
+#include "MaterialExpressionMeshPaintChannelOutput.generated.h"
+
+/** Material output for paint channels with a Custom source, input N feeds channel N of the painted layout */
+UCLASS(MinimalAPI, collapsecategories, hidecategories = Object)
+class UMaterialExpressionMeshPaintChannelOutput : public UMaterialExpressionCustomOutput
+{
+	GENERATED_UCLASS_BODY()
+
+	UPROPERTY()
+	FExpressionInput Channel0;
+
+	UPROPERTY()
+	FExpressionInput Channel1;
+
+	UPROPERTY()
+	FExpressionInput Channel2;
+
+	UPROPERTY()
+	FExpressionInput Channel3;
+
+	UPROPERTY()
+	FExpressionInput Channel4;
+
+	UPROPERTY()
+	FExpressionInput Channel5;
+
+	UPROPERTY()
+	FExpressionInput Channel6;
+
+	UPROPERTY()
+	FExpressionInput Channel7;
+
+public:
+#if WITH_EDITOR
+	//~ Begin UMaterialExpression Interface
+	virtual int32 Compile(class FMaterialCompiler* Compiler, int32 OutputIndex) override;
+	virtual void GetCaption(TArray<FString>& OutCaptions) const override;
+	//~ End UMaterialExpression Interface
+#endif
+
+	//~ Begin UMaterialExpressionCustomOutput Interface
+	virtual int32 GetNumOutputs() const override;
+	virtual FString GetFunctionName() const override;
+	virtual FString GetDisplayName() const override;
+	//~ End UMaterialExpressionCustomOutput Interface
+
+private:
+	FExpressionInput* GetChannelInput(int32 ChannelIndex);
+};
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Materials/MaterialExpression.h"
+#include "UObject/ObjectMacros.h"
+#include "MaterialExpressionMeshPaintSurfaceCoordinates.generated.h"
+
+/**
+ * Coordinates for sampling the paint of a primitive from its paint surface descriptor in custom primitive data,
+ * so every painted primitive can share one material instance whatever its atlas cell or slice.
+ * Descriptor layout from DescriptorDataIndex: atlas cell min (2), atlas cell size (2), array slice (1).
+ * Written by UMeshPainterFunctionLibrary::SetPaintSurfaceDescriptor or by paint surface components.
+ * Outputs the atlas UV, the atlas UV with the slice in z for render target arrays and the slice alone.
+ */
+UCLASS(MinimalAPI, collapsecategories, hidecategories = Object)
+class UMaterialExpressionMeshPaintSurfaceCoordinates : public UMaterialExpression
+{
+	GENERATED_UCLASS_BODY()
+
+	/** Floats of custom primitive data the descriptor takes */
+	static constexpr int32 DescriptorSize = 5;
+
+	/** UV used for painting, defaults to texture coordinate ConstCoordinate */
+	UPROPERTY(meta = (RequiredInput = "false"))
+	FExpressionInput Coordinates;
+
+	UPROPERTY(EditAnywhere, Category = "MaterialExpressionMeshPaintSurfaceCoordinates", meta = (OverridingInputProperty = "Coordinates"))
+	int32 ConstCoordinate;
+
+	/** Custom primitive data index of the first descriptor float */
+	UPROPERTY(EditAnywhere, Category = "MaterialExpressionMeshPaintSurfaceCoordinates", meta = (ClampMin = "0"))
+	int32 DescriptorDataIndex;
+
+public:
+#if WITH_EDITOR
+	//~ Begin UMaterialExpression Interface
+	virtual int32 Compile(class FMaterialCompiler* Compiler, int32 OutputIndex) override;
+	virtual void GetCaption(TArray<FString>& OutCaptions) const override;
+	//~ End UMaterialExpression Interface
+#endif
+};
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/ObjectMacros.h"
+#include "MeshPaintBlendMode.generated.h"
+
+/** How paint is combined with the content of the render targets */
+UENUM(BlueprintType)
+enum class EMeshPaintBlendMode : uint8
+{
+	/** Paint over existing content using opacity */
+	AlphaBlend,
+	/** Adds paint weighted by opacity */
+	Additive,
+	/** Keeps the larger of paint and existing value per channel */
+	Max,
+	/** Keeps the smaller of paint and existing value per channel */
+	Min,
+	/** Alpha blends only where existing alpha is at most the blend threshold */
+	PaintUnpainted,
+	/** Replaces color where paint opacity reaches the blend threshold, for team ownership */
+	Overwrite,
+	/** Adds paint and opacity, clamped to one */
+	AccumulateSaturate,
+};
+
+/** Modes which cannot be expressed with a blend state and run as a compute read-modify-write */
+inline bool IsMeshPaintBlendModeProgrammable(EMeshPaintBlendMode BlendMode)
+{
+	return BlendMode >= EMeshPaintBlendMode::PaintUnpainted;
+}
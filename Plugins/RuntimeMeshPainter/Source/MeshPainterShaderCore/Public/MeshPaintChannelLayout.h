@@ -0,0 +1,94 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DeveloperSettings.h"
+#include "Engine/TextureRenderTarget2D.h"
+#include "MeshPaintChannelLayout.generated.h"
+
+/** Maximum number of channels painted in a single pass, one per MRT */
+#define MESH_PAINT_MAX_CHANNELS 8
+
+/** Material value written to a paint channel */
+UENUM(BlueprintType)
+enum class EMeshPaintChannelSource : uint8
+{
+	Emissive,
+	BaseColor,
+	Normal,
+	Opacity,
+	/** Input of the Mesh Paint Channels material output with the same index as the channel */
+	Custom,
+};
+
+/** Storage format of a paint channel */
+UENUM(BlueprintType)
+enum class EMeshPaintChannelFormat : uint8
+{
+	R8,
+	RG8,
+	RGBA8,
+	R16F,
+	RG16F,
+	RGBA16F,
+};
+
+USTRUCT(BlueprintType)
+struct MESHPAINTERSHADERCORE_API FMeshPaintChannelDesc
+{
+	GENERATED_BODY()
+
+	FMeshPaintChannelDesc() : Source(EMeshPaintChannelSource::Emissive), Format(EMeshPaintChannelFormat::RGBA8) {}
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Mesh Paint")
+	FName Name;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Mesh Paint")
+	EMeshPaintChannelSource Source;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Mesh Paint")
+	EMeshPaintChannelFormat Format;
+};
+
+/** Named list of channels painted together, channel N is written to MRT N */
+USTRUCT(BlueprintType)
+struct MESHPAINTERSHADERCORE_API FMeshPaintChannelLayout
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Mesh Paint")
+	FName Name;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Mesh Paint", meta = (TitleProperty = "Name"))
+	TArray<FMeshPaintChannelDesc> Channels;
+
+	/** Returns index of a channel by name or INDEX_NONE */
+	int32 FindChannel(FName ChannelName) const;
+};
+
+/**
+ * Channel layouts of the project, each with at most MESH_PAINT_MAX_CHANNELS channels, e.g.
+ *
+ * [/Script/MeshPainterShaderCore.MeshPaintChannelSettings]
+ * +ChannelLayouts=(Name="Surface",Channels=((Name="Color",Source=Emissive,Format=RGBA8),(Name="Wetness",Source=Custom,Format=R8)))
+ */
+UCLASS(config = Engine, defaultconfig, meta = (DisplayName = "Mesh Paint Channels"))
+class MESHPAINTERSHADERCORE_API UMeshPaintChannelSettings : public UDeveloperSettings
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(config, EditAnywhere, Category = "Mesh Paint", meta = (TitleProperty = "Name"))
+	TArray<FMeshPaintChannelLayout> ChannelLayouts;
+
+	const FMeshPaintChannelLayout* FindLayout(FName LayoutName) const;
+
+	//~ Begin UDeveloperSettings Interface
+	virtual FName GetCategoryName() const override { return TEXT("Plugins"); }
+	//~ End UDeveloperSettings Interface
+};
+
+namespace MeshPaintChannels
+{
+	MESHPAINTERSHADERCORE_API EPixelFormat GetPixelFormat(EMeshPaintChannelFormat Format);
+	MESHPAINTERSHADERCORE_API ETextureRenderTargetFormat GetRenderTargetFormat(EMeshPaintChannelFormat Format);
+}
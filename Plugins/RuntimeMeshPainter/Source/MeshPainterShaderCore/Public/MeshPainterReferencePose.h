@@ -0,0 +1,60 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "LocalVertexFactory.h"
+
+class USkinnedMeshComponent;
+class FSkeletalMeshRenderData;
+class FPrimitiveSceneProxy;
+class FMaterialRenderProxy;
+class FIndexBuffer;
+struct FMeshBatch;
+
+/**
+ * Skeletal mesh LOD drawn through a local vertex factory over its bind pose vertex buffers.
+ * The UV layout does not depend on the pose, so painting in reference pose gives the same texels without skinning a vertex.
+ * One instance is shared by every component drawing the render data LOD, created and drawn on the render thread.
+ */
+class MESHPAINTERSHADERCORE_API FMeshPaintReferencePoseMesh
+{
+public:
+	/**
+	 * Returns the reference pose of a render data LOD, nullptr when the LOD has no buffers. The render data must come from a live
+	 * scene proxy, entries whose render data released its buffers are dropped on lookup. Stays valid for graphs of the current render command. Render thread
+	 */
+	static const FMeshPaintReferencePoseMesh* FindOrCreate(FRHICommandListBase& RHICmdList, const FSkeletalMeshRenderData& RenderData, int32 LODIndex);
+
+	/** Drops every cached reference pose. Render thread */
+	static void ReleaseAll();
+
+	/** Render proxies of the component materials for every render section of the LOD, default material for empty slots. Game thread */
+	static void GatherSectionMaterials(USkinnedMeshComponent* Component, int32 LODIndex, TArray<const FMaterialRenderProxy*, TInlineAllocator<4>>& OutMaterials);
+
+	/** Builds a mesh batch per section, drawn with the proxy transform. SectionMaterials come from GatherSectionMaterials. Render thread */
+	void ForEachMeshBatch(const FPrimitiveSceneProxy* PrimitiveProxy, TConstArrayView<const FMaterialRenderProxy*> SectionMaterials, TFunctionRef<void(const FMeshBatch&)> Callback) const;
+
+	int32 GetLODIndex() const { return LODIndex; }
+
+	~FMeshPaintReferencePoseMesh();
+
+private:
+	explicit FMeshPaintReferencePoseMesh(int32 InLODIndex);
+
+	struct FSection
+	{
+		uint32 FirstIndex;
+		uint32 NumTriangles;
+		uint32 MinVertexIndex;
+		uint32 MaxVertexIndex;
+		int32 RenderSectionIndex;
+	};
+
+	int32 LODIndex;
+	const FIndexBuffer* IndexBuffer;
+
+	/** Identifies the buffers the vertex factory was built over, the reference also keeps another buffer from reusing the address */
+	TRefCountPtr<FRHIBuffer> PositionBuffer;
+
+	TArray<FSection, TInlineAllocator<4>> Sections;
+	FLocalVertexFactory VertexFactory;
+};
@@ -2,6 +2,11 @@
 
 #include "CoreMinimal.h"
 #include "Engine/TextureRenderTarget2D.h"
+#include "Engine/TextureRenderTarget2DArray.h"
+#include "RenderGraphResources.h"
+#include "RendererInterface.h"
+#include "MeshPaintBlendMode.h"
+#include "MeshPaintChannelLayout.h"
 
 struct FMeshPaintRenderTargets
 {
@@ -12,11 +17,17 @@ struct FMeshPaintRenderTargets
 	FTextureRenderTargetResource* NormalMap;
 	RTType PrimaryRendertTargetForMRTViews;
 
-	FMeshPaintRenderTargets() : BaseColor(nullptr), Emissive(nullptr), NormalMap(nullptr), PrimaryRendertTargetForMRTViews(RTType::RT_BaseColor) {}
+	/** Generic channel targets bound to MRTs in order, used instead of the fixed slots when not empty */
+	TArray<FTextureRenderTargetResource*, TFixedAllocator<MESH_PAINT_MAX_CHANNELS>> Channels;
+	TArray<EMeshPaintChannelSource, TFixedAllocator<MESH_PAINT_MAX_CHANNELS>> ChannelSources;
+	int32 PrimaryChannel;
 
-	bool SetRenderTarget(UTextureRenderTarget2D* RenderTarget, RTType Type)
+	FMeshPaintRenderTargets() : BaseColor(nullptr), Emissive(nullptr), NormalMap(nullptr), PrimaryRendertTargetForMRTViews(RTType::RT_BaseColor), PrimaryChannel(INDEX_NONE) {}
+
+	/** Accepts 2D targets and 2D array targets, primitives of array targets are routed to their ArraySlice */
+	bool SetRenderTarget(UTextureRenderTarget* RenderTarget, RTType Type)
 	{
-		if (!IsValid(RenderTarget)) return false;
+		if (!IsSupportedRenderTarget(RenderTarget)) return false;
 		if (!RenderTarget->GetResource()) return false;
 		FTextureRenderTargetResource* Result = RenderTarget->GameThread_GetRenderTargetResource();
 		switch(Type)
@@ -37,18 +48,48 @@ struct FMeshPaintRenderTargets
 		return false;
 	}
 
-	bool IsValidForRendering() const { return BaseColor != nullptr || Emissive != nullptr || NormalMap != nullptr; }
+	/** Appends a channel target, every channel has to be set for the channel layout to stay in MRT order */
+	bool AddChannelRenderTarget(UTextureRenderTarget* RenderTarget, EMeshPaintChannelSource Source)
+	{
+		if (Channels.Num() >= MESH_PAINT_MAX_CHANNELS) return false;
+		if (!IsSupportedRenderTarget(RenderTarget)) return false;
+		if (!RenderTarget->GetResource()) return false;
+		FTextureRenderTargetResource* Result = RenderTarget->GameThread_GetRenderTargetResource();
+		if (Result == nullptr) return false;
+
+		FTextureRenderTargetResource* PreviousPrimaryRT = HasChannels() ? Channels[PrimaryChannel] : nullptr;
+		if (PreviousPrimaryRT == nullptr || (PreviousPrimaryRT->GetSizeX() <= Result->GetSizeX() && PreviousPrimaryRT->GetSizeY() <= Result->GetSizeY()))
+		{
+			PrimaryChannel = Channels.Num();
+		}
+		Channels.Add(Result);
+		ChannelSources.Add(Source);
+		return true;
+	}
+
+	bool HasChannels() const { return !Channels.IsEmpty(); }
+
+	static bool IsSupportedRenderTarget(const UTextureRenderTarget* RenderTarget)
+	{
+		return IsValid(RenderTarget) && (RenderTarget->IsA<UTextureRenderTarget2D>() || RenderTarget->IsA<UTextureRenderTarget2DArray>());
+	}
+
+	bool IsValidForRendering() const { return BaseColor != nullptr || Emissive != nullptr || NormalMap != nullptr || HasChannels(); }
 
 	void FlushDeferredResourceUpdate(FRHICommandListImmediate& RHICmdList) const
 	{
 		if (BaseColor) BaseColor->FlushDeferredResourceUpdate(RHICmdList);
 		if (Emissive) Emissive->FlushDeferredResourceUpdate(RHICmdList);
 		if (NormalMap) NormalMap->FlushDeferredResourceUpdate(RHICmdList);
+		for (FTextureRenderTargetResource* Channel : Channels)
+		{
+			Channel->FlushDeferredResourceUpdate(RHICmdList);
+		}
 	}
 
 	FTextureRenderTargetResource* GetPrimaryRenderTarget() const
 	{
-		return GetRenderTargetOfType(PrimaryRendertTargetForMRTViews);
+		return HasChannels() ? Channels[PrimaryChannel] : GetRenderTargetOfType(PrimaryRendertTargetForMRTViews);
 	}
 
 	bool HasTargetOfType(RTType Type) const
@@ -76,7 +117,7 @@ struct FMeshPaintRenderTargets
 
 struct FMeshPaintProxyRenderParameters
 {
-	FMeshPaintProxyRenderParameters() : PrimitiveProxy(nullptr), TargetLOD(0), UVRegion(FVector2D::Zero(), FVector2D::One()) {}
+	FMeshPaintProxyRenderParameters() : PrimitiveProxy(nullptr), TargetLOD(0), UVRegion(FVector2D::Zero(), FVector2D::One()), PaintUVBounds(ForceInit), ArraySlice(0), bSkinnedMesh(false), bReferencePose(false) {}
 
 	/** Primitive scene proxy */
 	FPrimitiveSceneProxy* PrimitiveProxy;
@@ -86,10 +127,53 @@ struct FMeshPaintProxyRenderParameters
 
 	/** Where on the screen we want to render this primitive (for atlasing) */
 	FBox2D UVRegion;
+
+	/** Part of UVRegion the brush stamps of the pass can reach, the pass is scissored to it. Invalid for the whole cell */
+	FBox2D PaintUVBounds;
+
+	/** Slice of array render targets this primitive is painted into, ignored for 2D targets */
+	int32 ArraySlice;
+
+	/** PrimitiveProxy is a skeletal mesh proxy, its mesh object lets the pass draw positions already skinned by the GPU skin cache */
+	bool bSkinnedMesh;
+
+	/** Set to paint a skeletal mesh in reference pose, skinning is skipped entirely. TargetLOD has to be resident */
+	bool bReferencePose;
+
+	/** Materials of the render sections of TargetLOD for the reference pose, the material override takes precedence */
+	TArray<const FMaterialRenderProxy*, TInlineAllocator<4>> ReferencePoseMaterials;
+};
+
+/** Spherical brush in world space, paint opacity is scaled by the coverage accumulated over all stamps of a pass */
+struct FMeshPaintRenderBrushStamp
+{
+	FMeshPaintRenderBrushStamp() : Location(FVector::ZeroVector), Radius(0.0f), Hardness(0.0f), Strength(0.0f), ShapeIndex(INDEX_NONE), Orientation(FQuat::Identity) {}
+
+	FVector Location;
+	float Radius;
+
+	/** Fraction of the radius painted at full strength */
+	float Hardness;
+	float Strength;
+
+	/** Slice of FMeshPaintRenderParameters::BrushShapes masking the sphere, INDEX_NONE for none */
+	int32 ShapeIndex;
+
+	/** Shape frame, the mask is projected along its X axis */
+	FQuat Orientation;
+};
+
+/** Depth of occluders seen from a projector, shared between the depth pass writing it and the paint passes reading it */
+struct FMeshPaintProjectionDepth
+{
+	/** Render thread only, invalid until the depth pass ran */
+	TRefCountPtr<IPooledRenderTarget> Texture;
 };
 
 struct FMeshPaintRenderParameters
 {
+	FMeshPaintRenderParameters() : Scene(nullptr), MaterialOverride(nullptr), bClearTargets(false), BlendMode(EMeshPaintBlendMode::AlphaBlend), BlendThreshold(0.5f), BrushShapes(nullptr), MaxGPUBrushStamps(0), GPUBrushStampOrigin(FVector::ZeroVector), BrushSurfaceId(0), ProjectionDepthBias(2.0f) {}
+
 	/** A list of primitive scene proxies to render */
 	TArray<FMeshPaintProxyRenderParameters> PrimitivesToRender;
 
@@ -103,10 +187,145 @@ struct FMeshPaintRenderParameters
 	const FMaterialRenderProxy* MaterialOverride;
 	
 	bool bClearTargets;
+
+	/** How paint is combined with the targets */
+	EMeshPaintBlendMode BlendMode;
+
+	/** Alpha threshold of PaintUnpainted and Overwrite blend modes */
+	float BlendThreshold;
+
+	/** Restricts paint to these stamps when not empty, all of them are applied in the same pass */
+	TArray<FMeshPaintRenderBrushStamp> BrushStamps;
+
+	/** Texture array of stamp shape masks with their mips, one slice per shape. Stamps of any shape share the pass */
+	FTextureResource* BrushShapes;
+
+	/**
+	 * Stamps written by GPU simulations, used instead of BrushStamps when set. Same layout as FMeshPaintBrushParameters
+	 * with centers relative to GPUBrushStampOrigin, unused records have to be zero unless GPUBrushStampCounter is set
+	 */
+	TRefCountPtr<FRDGPooledBuffer> GPUBrushStamps;
+	uint32 MaxGPUBrushStamps;
+	FVector GPUBrushStampOrigin;
+
+	/** Optional count and bounds of GPUBrushStamps (see FMeshPaintStampCounterParameters), draws are then culled on the GPU */
+	TRefCountPtr<FRDGPooledBuffer> GPUBrushStampCounter;
+
+	/** Skips stamps tagged with another surface id, zero applies all of them */
+	uint32 BrushSurfaceId;
+
+	/** Texels hidden behind this depth or outside the view frustum are not painted, ViewProjection has to be the projector the depth was rendered from */
+	TSharedPtr<FMeshPaintProjectionDepth, ESPMode::ThreadSafe> ProjectionDepth;
+
+	/** World units a texel may lie behind the projection depth and still be painted */
+	float ProjectionDepthBias;
+};
+
+/** Renders occluders into a low resolution depth map from a projector, for occlusion tested paint passes */
+struct FMeshPaintProjectionDepthParameters
+{
+	FMeshPaintProjectionDepthParameters() : Scene(nullptr), Resolution(256, 256) {}
+
+	/** Occluders, only PrimitiveProxy and TargetLOD are used */
+	TArray<FMeshPaintProxyRenderParameters> Occluders;
+
+	FSceneInterface* Scene;
+
+	/** Projector, the paint passes reading the depth use the same view */
+	FSceneViewProjectionData ViewProjection;
+
+	FIntPoint Resolution;
+};
+
+/** Fills one UV island of a primitive with a color, the island is selected by a coverage texture instead of drawing triangles */
+struct FMeshPaintIslandFillParameters
+{
+	FMeshPaintIslandFillParameters() : CoverageTexture(nullptr), IslandIndex(INDEX_NONE), UVRegion(FVector2D::Zero(), FVector2D::One()), DirtyRect(ForceInitToZero), Color(FLinearColor::White), BlendMode(EMeshPaintBlendMode::AlphaBlend), BlendThreshold(0.5f) {}
+
+	/** Coverage map of the primitive at the atlas cell resolution, island index + 1 in green */
+	FTextureResource* CoverageTexture;
+	int32 IslandIndex;
+
+	/** Atlas cell of the primitive, same as FMeshPaintProxyRenderParameters::UVRegion */
+	FBox2D UVRegion;
+
+	/** Target texels the island can touch, the only ones the pass runs on */
+	FIntRect DirtyRect;
+
+	/** Straight alpha, alpha is the paint opacity */
+	FLinearColor Color;
+	EMeshPaintBlendMode BlendMode;
+	float BlendThreshold;
+};
+
+/** Soft round stamp drawn directly in UV space around a point, for paint placed from a CPU UV lookup */
+struct FMeshPaintUVStampParameters
+{
+	FMeshPaintUVStampParameters() : Center(FVector2f::ZeroVector), Radius(FVector2f::ZeroVector), Hardness(0.5f), Strength(1.0f), Color(FLinearColor::White), BlendMode(EMeshPaintBlendMode::AlphaBlend), BlendThreshold(0.5f), CoverageTexture(nullptr), IslandIndex(INDEX_NONE), UVRegion(FVector2D::Zero(), FVector2D::One()) {}
+
+	/** Center in target texels */
+	FVector2f Center;
+
+	/** Radius in target texels per axis, atlas cells and UV layouts are not always square */
+	FVector2f Radius;
+
+	/** Same as FMeshPaintBrushStamp */
+	float Hardness;
+	float Strength;
+
+	/** Straight alpha, alpha is the paint opacity */
+	FLinearColor Color;
+	EMeshPaintBlendMode BlendMode;
+	float BlendThreshold;
+
+	/** Optional coverage map of the primitive at the atlas cell resolution, restricts the stamp to one island so it does not spill over UV seams */
+	FTextureResource* CoverageTexture;
+	int32 IslandIndex;
+	FBox2D UVRegion;
+};
+
+/** Subtracts a constant from tiles of a target, paint decays linearly until it reaches zero */
+struct FMeshPaintDecayParameters
+{
+	FMeshPaintDecayParameters() : TileSize(32), Amount(FVector4f::Zero()) {}
+
+	/** Tiles to fade, in tile coordinates */
+	TArray<FIntPoint> Tiles;
+
+	/** Multiple of 8 */
+	int32 TileSize;
+
+	/** Value subtracted per channel, zero leaves a channel untouched */
+	FVector4f Amount;
 };
 
 namespace MeshPaintRender
 {
 	MESHPAINTERSHADERCORE_API bool AddMeshPaintPass(FRHICommandListImmediate& RHICmdList, const FMeshPaintRenderTargets& InRenderTargets, const FMeshPaintRenderParameters& Parameters);
 	MESHPAINTERSHADERCORE_API bool AddMeshPaintPass(FRDGBuilder& GraphBuilder, const FMeshPaintRenderTargets& InRenderTargets, const FMeshPaintRenderParameters& Parameters);
+
+	/** Depth only pass with the default material, writes OutDepth.Texture */
+	MESHPAINTERSHADERCORE_API bool AddProjectionDepthPass(FRHICommandListImmediate& RHICmdList, const FMeshPaintProjectionDepthParameters& Parameters, FMeshPaintProjectionDepth& OutDepth);
+	MESHPAINTERSHADERCORE_API bool AddProjectionDepthPass(FRDGBuilder& GraphBuilder, const FMeshPaintProjectionDepthParameters& Parameters, FMeshPaintProjectionDepth& OutDepth);
+
+	/** Single screen pass over the dirty rect, cost does not depend on the triangle count of the primitive */
+	MESHPAINTERSHADERCORE_API bool AddIslandFillPass(FRHICommandListImmediate& RHICmdList, FTextureRenderTargetResource* RenderTarget, const FMeshPaintIslandFillParameters& Parameters);
+	MESHPAINTERSHADERCORE_API bool AddIslandFillPass(FRDGBuilder& GraphBuilder, FTextureRenderTargetResource* RenderTarget, const FMeshPaintIslandFillParameters& Parameters);
+
+	/** Single screen pass over the texels under the stamp */
+	MESHPAINTERSHADERCORE_API bool AddUVStampPass(FRHICommandListImmediate& RHICmdList, FTextureRenderTargetResource* RenderTarget, const FMeshPaintUVStampParameters& Parameters);
+	MESHPAINTERSHADERCORE_API bool AddUVStampPass(FRDGBuilder& GraphBuilder, FTextureRenderTargetResource* RenderTarget, const FMeshPaintUVStampParameters& Parameters);
+
+	/** Compute pass over the listed tiles only. Needs a UAV capable target with a format supporting typed UAV loads */
+	MESHPAINTERSHADERCORE_API bool AddDecayPass(FRHICommandListImmediate& RHICmdList, FTextureRenderTargetResource* RenderTarget, const FMeshPaintDecayParameters& Parameters);
+	MESHPAINTERSHADERCORE_API bool AddDecayPass(FRDGBuilder& GraphBuilder, FTextureRenderTargetResource* RenderTarget, const FMeshPaintDecayParameters& Parameters);
+
+	/** True when AddDecayPass can run on a target */
+	MESHPAINTERSHADERCORE_API bool SupportsDecay(EPixelFormat Format, ETextureCreateFlags Flags);
+
+	/**
+	 * Queue of the compute passes working on painted targets, async compute when r.MeshPaint.AsyncCompute is set and the platform runs it efficiently.
+	 * The graph fences them against the raster passes writing their inputs
+	 */
+	MESHPAINTERSHADERCORE_API ERDGPassFlags GetPaintComputePassFlags();
 }
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RenderGraphResources.h"
+
+class FRDGBuilder;
+struct IPooledRenderTarget;
+
+/**
+ * Size bucketed pool for the scratch targets paint passes rasterize into before a programmable blend. Most paint calls build
+ * their own graph, so the targets are kept here between calls instead of being recreated by every graph.
+ * Extents are rounded up to powers of two so requests of similar sizes share targets. A target returns to the pool when the last
+ * reference, held by a caller or a graph, is dropped, like in the engine render target pool. Render thread only.
+ */
+class MESHPAINTERSHADERCORE_API FMeshPaintRenderTargetPool
+{
+public:
+	static FMeshPaintRenderTargetPool& Get();
+
+	/** Extent of the bucket a request falls into */
+	static FIntPoint GetBucketExtent(FIntPoint Extent);
+
+	/** Returns a free target of the bucket, allocating one when none is free. The target extent may be larger than requested */
+	TRefCountPtr<IPooledRenderTarget> FindFreeElement(FIntPoint Extent, EPixelFormat Format, ETextureCreateFlags Flags, const TCHAR* Name);
+
+	/** Same as FindFreeElement, registered in a graph */
+	FRDGTextureRef RegisterFreeElement(FRDGBuilder& GraphBuilder, FIntPoint Extent, EPixelFormat Format, ETextureCreateFlags Flags, const TCHAR* Name);
+
+	/** Releases targets unused for r.MeshPaint.RenderTargetPool.FramesUntilRelease frames and updates stats */
+	void TickPoolElements();
+
+	/** Drops every target not referenced by a caller */
+	void FreeUnusedResources();
+
+	struct FStats
+	{
+		FStats() : NumElements(0), NumElementsInUse(0), AllocatedBytes(0), PeakNumElements(0), PeakAllocatedBytes(0) {}
+
+		int32 NumElements;
+		int32 NumElementsInUse;
+		uint64 AllocatedBytes;
+
+		/** High-water marks since startup or the last ResetPeakStats */
+		int32 PeakNumElements;
+		uint64 PeakAllocatedBytes;
+	};
+
+	FStats GetStats() const;
+	void ResetPeakStats();
+
+private:
+	struct FElement
+	{
+		TRefCountPtr<IPooledRenderTarget> RenderTarget;
+		FIntPoint Extent;
+		EPixelFormat Format;
+		ETextureCreateFlags Flags;
+		uint32 LastUsedFrame;
+		uint32 SizeInBytes;
+	};
+
+	void UpdateStats();
+
+	TArray<FElement> Elements;
+	uint32 FrameNumber = 0;
+	FStats Stats;
+};
+
+namespace MeshPaintRender
+{
+	/** Default flags of intermediate paint buffers */
+	constexpr ETextureCreateFlags IntermediateTextureFlags = TexCreate_RenderTargetable | TexCreate_ShaderResource | TexCreate_UAV;
+
+	/** Graph local scratch texture for compute intermediates, memory is aliased by the RDG transient allocator. Extent is rounded up to the pool bucket */
+	MESHPAINTERSHADERCORE_API FRDGTextureRef CreateTransientTexture(FRDGBuilder& GraphBuilder, FIntPoint Extent, EPixelFormat Format, const TCHAR* Name, ETextureCreateFlags Flags = IntermediateTextureFlags);
+}
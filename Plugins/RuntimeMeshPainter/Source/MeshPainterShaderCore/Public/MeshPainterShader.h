@@ -15,11 +15,53 @@
 #include "SceneTexturesConfig.h"
 #include "MeshDrawShaderBindings.h"
 #include "InstanceCulling/InstanceCullingContext.h"
+#include "MeshPaintChannelLayout.h"
+
+/**
+ * Brush stamps of a pass, three float4 per stamp: center relative to StampOffset and radius, then inverse falloff width, strength,
+ * surface id and shape index + 1, then the rotation of the shape frame as a quaternion. Shapes are slices of ShapeTextures
+ * projected along the frame X axis, zero keeps the stamp spherical.
+ * Draws only loop over the stamps of their StampRange. With bEndAtZeroRadius, set for stamps appended on the GPU, the loop ends at the first zero radius or at the stamp counter. When SurfaceId is not zero stamps tagged with another surface are skipped, untagged ones always apply
+ */
+BEGIN_GLOBAL_SHADER_PARAMETER_STRUCT(FMeshPaintBrushParameters, MESHPAINTERSHADERCORE_API)
+SHADER_PARAMETER_RDG_BUFFER_SRV(StructuredBuffer<float4>, Stamps)
+SHADER_PARAMETER(uint32, NumStamps)
+SHADER_PARAMETER(uint32, bEndAtZeroRadius)
+SHADER_PARAMETER(FVector3f, StampOffset)
+SHADER_PARAMETER(uint32, SurfaceId)
+SHADER_PARAMETER_TEXTURE(Texture2DArray, ShapeTextures)
+SHADER_PARAMETER_SAMPLER(SamplerState, ShapeSampler)
+END_GLOBAL_SHADER_PARAMETER_STRUCT()
+
+/**
+ * Projector depth of occlusion tested passes, device z of the nearest occluder rendered with the pass view. Bound disabled for other passes,
+ * the test is a uniform branch so it does not double the paint shaders compiled for every material
+ */
+BEGIN_GLOBAL_SHADER_PARAMETER_STRUCT(FMeshPaintProjectionParameters, MESHPAINTERSHADERCORE_API)
+SHADER_PARAMETER_RDG_TEXTURE(Texture2D, DepthTexture)
+SHADER_PARAMETER_SAMPLER(SamplerState, DepthSampler)
+SHADER_PARAMETER(float, DepthBias)
+SHADER_PARAMETER(uint32, bEnabled)
+END_GLOBAL_SHADER_PARAMETER_STRUCT()
+
+/**
+ * Counter of stamps appended on the GPU: the count, then the negated minimum and the maximum of their bounds as order preserving uints,
+ * relative to StampOffset. Draws of primitives the bounds miss are collapsed in the vertex shader and stamp loops end at the count, so
+ * nothing is read back to pick the surfaces. Bound disabled for other passes, the test is a uniform branch
+ */
+BEGIN_GLOBAL_SHADER_PARAMETER_STRUCT(FMeshPaintStampCounterParameters, MESHPAINTERSHADERCORE_API)
+SHADER_PARAMETER_RDG_BUFFER_SRV(Buffer<uint>, Counter)
+SHADER_PARAMETER(FVector3f, StampOffset)
+SHADER_PARAMETER(uint32, bEnabled)
+END_GLOBAL_SHADER_PARAMETER_STRUCT()
 
 BEGIN_SHADER_PARAMETER_STRUCT(FMeshPaintShaderParameters, MESHPAINTERSHADERCORE_API)
 SHADER_PARAMETER_STRUCT_REF(FViewUniformShaderParameters, View)
 SHADER_PARAMETER_RDG_UNIFORM_BUFFER(FSceneUniformParameters, Scene)
 SHADER_PARAMETER_RDG_UNIFORM_BUFFER(FInstanceCullingGlobalUniforms, InstanceCulling)
+SHADER_PARAMETER_RDG_UNIFORM_BUFFER(FMeshPaintBrushParameters, MeshPaintBrush)
+SHADER_PARAMETER_RDG_UNIFORM_BUFFER(FMeshPaintProjectionParameters, MeshPaintProjection)
+SHADER_PARAMETER_RDG_UNIFORM_BUFFER(FMeshPaintStampCounterParameters, MeshPaintStampCounter)
 RENDER_TARGET_BINDING_SLOTS()
 END_SHADER_PARAMETER_STRUCT()
 
@@ -27,24 +69,59 @@ class FMeshPaintShaderElementData : public FMeshMaterialShaderElementData
 {
 public:
 	FVector4 UVTileMapping;
+
+	/** Render target array slice written by layered draws */
+	uint32 ArraySlice;
+
+	/** EMeshPaintChannelSource per channel, four channels per vector */
+	FIntVector4 ChannelSources[2];
+
+	/** Stamps of brush passes, null otherwise */
+	FRHIUniformBuffer* BrushParameters;
+
+	/** First stamp and number of stamps of BrushParameters that may reach the primitive */
+	FUintVector2 StampRange;
+
+	/** Projector depth, disabled for passes without occlusion test */
+	FRHIUniformBuffer* ProjectionParameters;
+
+	/** Counter of GPU appended stamps, disabled for passes without one */
+	FRHIUniformBuffer* StampCounterParameters;
+
+	/** Bounding sphere of the primitive in translated world space, tested against the bounds of GPU appended stamps */
+	FVector4f CullSphere;
 };
 
 bool CheckMeshPaintVertexFactoryType(const FVertexFactoryType* VertexFactoryType);
 
+/** Platforms the layered vertex shader permutation is compiled for, layered passes are only recorded when this holds for GMaxRHIShaderPlatform */
+inline bool MeshPaintSupportsLayeredDraws(EShaderPlatform Platform)
+{
+	return RHISupportsVertexShaderLayer(Platform);
+}
+
 class FMeshPaintShaderVS : public FMeshMaterialShader
 {
 public:
+	/** Routes primitives to render target array slices through SV_RenderTargetArrayIndex */
+	class FLayered : SHADER_PERMUTATION_BOOL("MESH_PAINT_LAYERED");
+	using FPermutationDomain = TShaderPermutationDomain<FLayered>;
+
 	DECLARE_SHADER_TYPE(FMeshPaintShaderVS, MeshMaterial);
 
 	FMeshPaintShaderVS() { }
 	FMeshPaintShaderVS(const ShaderMetaType::CompiledShaderInitializerType& Initializer) : FMeshMaterialShader(Initializer)	
 	{
 		UVTileMapping.Bind(Initializer.ParameterMap, TEXT("UVTileMapping"), SPF_Mandatory);
+		ArraySlice.Bind(Initializer.ParameterMap, TEXT("ArraySlice"), SPF_Optional);
+		CullSphere.Bind(Initializer.ParameterMap, TEXT("CullSphere"), SPF_Optional);
 	}
 
 	static bool ShouldCompilePermutation(const FMeshMaterialShaderPermutationParameters& Parameters)
 	{
+		FPermutationDomain Permutation(Parameters.PermutationId);
 		return IsFeatureLevelSupported(Parameters.Platform, ERHIFeatureLevel::SM5)
+			&& (!Permutation.Get<FLayered>() || MeshPaintSupportsLayeredDraws(Parameters.Platform))
 			&& CheckMeshPaintVertexFactoryType(Parameters.VertexFactoryType);
 	}
 
@@ -61,10 +138,18 @@ public:
 		FMeshMaterialShader::GetShaderBindings(Scene, FeatureLevel, PrimitiveSceneProxy, MaterialRenderProxy, Material, DrawRenderState, ShaderElementData, ShaderBindings);
 
 		ShaderBindings.Add(UVTileMapping, FVector4f(ShaderElementData.UVTileMapping));
+		ShaderBindings.Add(ArraySlice, ShaderElementData.ArraySlice);
+		ShaderBindings.Add(CullSphere, ShaderElementData.CullSphere);
+		if (ShaderElementData.StampCounterParameters)
+		{
+			ShaderBindings.Add(GetUniformBufferParameter<FMeshPaintStampCounterParameters>(), ShaderElementData.StampCounterParameters);
+		}
 	}
 
 private:
 	LAYOUT_FIELD(FShaderParameter, UVTileMapping);
+	LAYOUT_FIELD(FShaderParameter, ArraySlice);
+	LAYOUT_FIELD(FShaderParameter, CullSphere);
 };
 
 IMPLEMENT_MATERIAL_SHADER_TYPE(, FMeshPaintShaderVS, TEXT("/Plugin/RuntimeMeshPainter/Private/MeshPaintShaders.usf"), TEXT("MeshPaintShaderVS"), SF_Vertex);
@@ -82,18 +167,32 @@ class FMeshPaintShaderPS : public FMeshMaterialShader
 {
 public:
 	class FOutputBits : SHADER_PERMUTATION_INT("OUTPUT_BITS", 8);
-	using FPermutationDomain = TShaderPermutationDomain<FOutputBits>;
+	class FChannelCount : SHADER_PERMUTATION_RANGE_INT("CHANNEL_COUNT", 0, MESH_PAINT_MAX_CHANNELS + 1);
+
+	/** Scales material opacity by the coverage of the pass brush stamps */
+	class FBrush : SHADER_PERMUTATION_BOOL("MESH_PAINT_BRUSH");
+	using FPermutationDomain = TShaderPermutationDomain<FOutputBits, FChannelCount, FBrush>;
 
 	DECLARE_SHADER_TYPE(FMeshPaintShaderPS, MeshMaterial);
 
 	FMeshPaintShaderPS() { }
-	FMeshPaintShaderPS(const ShaderMetaType::CompiledShaderInitializerType& Initializer) : FMeshMaterialShader(Initializer)	{}
+	FMeshPaintShaderPS(const ShaderMetaType::CompiledShaderInitializerType& Initializer) : FMeshMaterialShader(Initializer)
+	{
+		ChannelSources.Bind(Initializer.ParameterMap, TEXT("ChannelSources"), SPF_Optional);
+		StampRange.Bind(Initializer.ParameterMap, TEXT("StampRange"), SPF_Optional);
+	}
 
 	static bool ShouldCompilePermutation(const FMeshMaterialShaderPermutationParameters& Parameters)
 	{
 		FPermutationDomain Permutation(Parameters.PermutationId);
+
+		// Fixed slots and channel layouts are exclusive. Every channel count is compiled, project settings are not part of the shader map key
+		const bool bValidOutputs = Permutation.Get<FChannelCount>() == 0
+			? Permutation.Get<FOutputBits>() != 0
+			: Permutation.Get<FOutputBits>() == 0;
+
 		return IsFeatureLevelSupported(Parameters.Platform, ERHIFeatureLevel::SM5)
-			&& Permutation.Get<FOutputBits>() != 0
+			&& bValidOutputs
 			&& CheckMeshPaintVertexFactoryType(Parameters.VertexFactoryType);
 	}
 
@@ -117,8 +216,44 @@ public:
 			OutEnvironment.SetDefine(TEXT("MRT_NORMAL"), MRTIndex);
 			MRTIndex++;
 		}
+		if (Permutation.Get<FChannelCount>() > 0)
+		{
+			MRTIndex = Permutation.Get<FChannelCount>();
+		}
 		OutEnvironment.SetDefine(TEXT("MRT_MAX"), MRTIndex);
 	}
+
+	void GetShaderBindings(
+		const FScene* Scene,
+		ERHIFeatureLevel::Type FeatureLevel,
+		const FPrimitiveSceneProxy* PrimitiveSceneProxy,
+		const FMaterialRenderProxy& MaterialRenderProxy,
+		const FMaterial& Material,
+		const FMeshPassProcessorRenderState& DrawRenderState,
+		const FMeshPaintShaderElementData& ShaderElementData,
+		FMeshDrawSingleShaderBindings& ShaderBindings) const
+	{
+		FMeshMaterialShader::GetShaderBindings(Scene, FeatureLevel, PrimitiveSceneProxy, MaterialRenderProxy, Material, DrawRenderState, ShaderElementData, ShaderBindings);
+
+		ShaderBindings.Add(ChannelSources, ShaderElementData.ChannelSources);
+		if (ShaderElementData.BrushParameters)
+		{
+			ShaderBindings.Add(GetUniformBufferParameter<FMeshPaintBrushParameters>(), ShaderElementData.BrushParameters);
+			ShaderBindings.Add(StampRange, ShaderElementData.StampRange);
+		}
+		if (ShaderElementData.ProjectionParameters)
+		{
+			ShaderBindings.Add(GetUniformBufferParameter<FMeshPaintProjectionParameters>(), ShaderElementData.ProjectionParameters);
+		}
+		if (ShaderElementData.StampCounterParameters)
+		{
+			ShaderBindings.Add(GetUniformBufferParameter<FMeshPaintStampCounterParameters>(), ShaderElementData.StampCounterParameters);
+		}
+	}
+
+private:
+	LAYOUT_FIELD(FShaderParameter, ChannelSources);
+	LAYOUT_FIELD(FShaderParameter, StampRange);
 };
 
 IMPLEMENT_MATERIAL_SHADER_TYPE(, FMeshPaintShaderPS, TEXT("/Plugin/RuntimeMeshPainter/Private/MeshPaintShaders.usf"), TEXT("MeshPaintShaderPS"), SF_Pixel);
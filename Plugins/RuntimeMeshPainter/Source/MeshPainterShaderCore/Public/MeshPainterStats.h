@@ -0,0 +1,82 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "Trace/Trace.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+/** Insights channel of the paint pipeline, enable with -trace=MeshPaint */
+UE_TRACE_CHANNEL_EXTERN(MeshPaintChannel, MESHPAINTERSHADERCORE_API);
+
+DECLARE_STATS_GROUP(TEXT("MeshPaint"), STATGROUP_MeshPaint, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("EnsureIsComplete (GT)"), STAT_MeshPaint_EnsureIsComplete, STATGROUP_MeshPaint, MESHPAINTERSHADERCORE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("SetRenderTarget (GT)"), STAT_MeshPaint_SetRenderTarget, STATGROUP_MeshPaint, MESHPAINTERSHADERCORE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Enqueue (GT)"), STAT_MeshPaint_Enqueue, STATGROUP_MeshPaint, MESHPAINTERSHADERCORE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("UpdateResourceImmediate (GT)"), STAT_MeshPaint_UpdateResource, STATGROUP_MeshPaint, MESHPAINTERSHADERCORE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("FlushDeferredResourceUpdate (RT)"), STAT_MeshPaint_FlushDeferredResourceUpdate, STATGROUP_MeshPaint, MESHPAINTERSHADERCORE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Create view (RT)"), STAT_MeshPaint_CreateView, STATGROUP_MeshPaint, MESHPAINTERSHADERCORE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Mesh pass setup (RT)"), STAT_MeshPaint_MeshPassSetup, STATGROUP_MeshPaint, MESHPAINTERSHADERCORE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Draw commands (RT)"), STAT_MeshPaint_DrawCommands, STATGROUP_MeshPaint, MESHPAINTERSHADERCORE_API);
+
+namespace MeshPaintStats
+{
+	/** Stages of a paint call, both game and render thread */
+	enum class EStage : uint8
+	{
+		EnsureIsComplete,
+		SetRenderTarget,
+		Enqueue,
+		UpdateResource,
+		FlushDeferredResourceUpdate,
+		CreateView,
+		MeshPassSetup,
+		DrawCommands,
+		Num
+	};
+
+	MESHPAINTERSHADERCORE_API const TCHAR* GetStageName(EStage Stage);
+
+	/** Stage accumulation is off by default, benchmarks turn it on so they can read timings without the stats system */
+	MESHPAINTERSHADERCORE_API void SetStageTimingEnabled(bool bEnabled);
+	MESHPAINTERSHADERCORE_API bool IsStageTimingEnabled();
+
+	MESHPAINTERSHADERCORE_API void AddStageCycles(EStage Stage, uint64 Cycles);
+
+	/** Returns accumulated seconds and number of scopes per stage */
+	MESHPAINTERSHADERCORE_API void GetStageTotals(double OutSeconds[(int32)EStage::Num], uint64 OutCounts[(int32)EStage::Num]);
+	MESHPAINTERSHADERCORE_API void ResetStageTotals();
+
+	/** Accounts work of a paint pass into the per frame counters */
+	MESHPAINTERSHADERCORE_API void AddPassCounters(int64 NumPrimitives, int64 NumDraws, int64 NumTexels, int64 NumBytesWritten);
+
+	/** Publishes per frame counters to Insights and resets them, called at the end of every render thread frame */
+	void PublishFrameCounters();
+
+	/** Accumulates time spent in a scope into a stage when stage timing is enabled */
+	class FScopedStage
+	{
+	public:
+		explicit FScopedStage(EStage InStage) : Stage(InStage), StartCycles(IsStageTimingEnabled() ? FPlatformTime::Cycles64() : 0) {}
+		~FScopedStage()
+		{
+			if (StartCycles != 0)
+			{
+				AddStageCycles(Stage, FPlatformTime::Cycles64() - StartCycles);
+			}
+		}
+
+	private:
+		EStage Stage;
+		uint64 StartCycles;
+	};
+}
+
+/** CPU scope on the MeshPaint trace channel */
+#define MESH_PAINT_TRACE_SCOPE(Name) TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL_STR("MeshPaint::" #Name, MeshPaintChannel)
+
+/** Scope counted by the trace channel, the cycle stat and the benchmark stage accumulator */
+#define MESH_PAINT_SCOPED_STAGE(Stage) \
+	MESH_PAINT_TRACE_SCOPE(Stage); \
+	SCOPE_CYCLE_COUNTER(STAT_MeshPaint_##Stage); \
+	MeshPaintStats::FScopedStage PREPROCESSOR_JOIN(MeshPaintStage_, __LINE__)(MeshPaintStats::EStage::Stage)